@@ -10,7 +10,11 @@
 #include "qwaylandinputdevice_p.h"
 #include "qwaylandscreen_p.h"
 
+#include <QtCore/QCache>
+#include <QtCore/QMutex>
 #include <QtGui/QImage>
+#include <QtGui/QPainter>
+#include <QtGui/QPicture>
 
 QT_BEGIN_NAMESPACE
 
@@ -27,8 +31,28 @@ public:
     QWindow *m_window = nullptr;
     QWaylandWindow *m_wayland_window = nullptr;
 
+    // The decoration only covers the margins, so it is rendered into one image
+    // per edge instead of one the size of the whole surface. The last images for
+    // the active and the inactive state are kept, so that focus changes don't
+    // need a repaint. They are rendered again when anything the decoration is
+    // painted from changed.
+    struct EdgeImages {
+        QSize surfaceSize;
+        QMargins margins;
+        qreal bufferScale = 0;
+        QString title;
+        qint64 iconKey = 0;
+        Qt::WindowStates windowStates;
+        QImage images[4]; // top, left, right, bottom
+    };
+
+    static int edgeIndex(Qt::Edge edge);
+    void renderEdgeImages();
+
     bool m_isDirty = true;
     QImage m_decorationContentImage;
+    EdgeImages m_edgeImages[2]; // inactive, active
+    bool m_active = false;
 
     Qt::MouseButtons m_mouseButtons = Qt::NoButton;
 };
@@ -42,6 +66,67 @@ QWaylandAbstractDecorationPrivate::~QWaylandAbstractDecorationPrivate()
 {
 }
 
+int QWaylandAbstractDecorationPrivate::edgeIndex(Qt::Edge edge)
+{
+    switch (edge) {
+    case Qt::TopEdge:
+        return 0;
+    case Qt::LeftEdge:
+        return 1;
+    case Qt::RightEdge:
+        return 2;
+    case Qt::BottomEdge:
+        return 3;
+    }
+    Q_UNREACHABLE();
+    return 0;
+}
+
+void QWaylandAbstractDecorationPrivate::renderEdgeImages()
+{
+    Q_Q(QWaylandAbstractDecoration);
+    const qreal bufferScale = m_wayland_window->scale();
+    const QSize surfaceSize = m_wayland_window->surfaceSize();
+    const QMargins margins = q->margins();
+    m_active = m_wayland_window->isActive();
+
+    const QString title = m_window->title();
+    const qint64 iconKey = m_wayland_window->windowIcon().cacheKey();
+    const Qt::WindowStates windowStates = m_window->windowStates();
+
+    EdgeImages &edges = m_edgeImages[m_active];
+    if (edges.surfaceSize == surfaceSize && edges.margins == margins && edges.bufferScale == bufferScale
+            && edges.title == title && edges.iconKey == iconKey && edges.windowStates == windowStates)
+        return;
+
+    // Record the decoration once and replay it into each edge, the decoration
+    // plugins paint in surface coordinates.
+    QPicture picture;
+    q->paint(&picture);
+
+    edges.surfaceSize = surfaceSize;
+    edges.margins = margins;
+    edges.bufferScale = bufferScale;
+    edges.title = title;
+    edges.iconKey = iconKey;
+    edges.windowStates = windowStates;
+    for (Qt::Edge edge : { Qt::TopEdge, Qt::LeftEdge, Qt::RightEdge, Qt::BottomEdge }) {
+        const QRect rect = q->edgeRect(edge);
+        QImage &image = edges.images[edgeIndex(edge)];
+        if (rect.isEmpty()) {
+            image = QImage();
+            continue;
+        }
+        // Only scale by buffer scale, not QT_SCALE_FACTOR etc.
+        image = QImage(rect.size() * bufferScale, QImage::Format_ARGB32_Premultiplied);
+        image.setDevicePixelRatio(bufferScale);
+        image.fill(Qt::transparent);
+        QPainter painter(&image);
+        painter.translate(-rect.topLeft());
+        painter.drawPicture(0, 0, picture);
+    }
+}
+
 QWaylandAbstractDecoration::QWaylandAbstractDecoration()
     : QObject(*new QWaylandAbstractDecorationPrivate)
 {
@@ -104,12 +189,71 @@ const QImage &QWaylandAbstractDecoration::contentImage()
     return d->m_decorationContentImage;
 }
 
+// Returns the decoration of the margin at edge, to be placed at edgeRect(edge)
+// in the surface. The top and bottom edges span the whole width of the surface,
+// the left and right edges the height between them.
+const QImage &QWaylandAbstractDecoration::edgeImage(Qt::Edge edge)
+{
+    Q_D(QWaylandAbstractDecoration);
+    if (d->m_isDirty) {
+        d->renderEdgeImages();
+
+        QRegion damage = marginsRegion(waylandWindow()->surfaceSize(), waylandWindow()->frameMargins());
+        for (QRect r : damage)
+            waylandWindow()->damage(r);
+
+        d->m_isDirty = false;
+    }
+
+    return d->m_edgeImages[d->m_active].images[QWaylandAbstractDecorationPrivate::edgeIndex(edge)];
+}
+
+QRect QWaylandAbstractDecoration::edgeRect(Qt::Edge edge) const
+{
+    const QSize size = waylandWindow()->surfaceSize();
+    const QMargins m = margins();
+    switch (edge) {
+    case Qt::TopEdge:
+        return QRect(0, 0, size.width(), m.top());
+    case Qt::LeftEdge:
+        return QRect(0, m.top(), m.left(), size.height() - m.top() - m.bottom());
+    case Qt::RightEdge:
+        return QRect(size.width() - m.right(), m.top(), m.right(), size.height() - m.top() - m.bottom());
+    case Qt::BottomEdge:
+        return QRect(0, size.height() - m.bottom(), size.width(), m.bottom());
+    }
+    Q_UNREACHABLE();
+    return QRect();
+}
+
+// The edge images are only rendered again if the size, margins, buffer scale,
+// title, icon or window states changed since they were rendered last, so
+// that resizing or retitling a window to a look it already has is cheap.
+// Decorations whose look depends on anything else call invalidate().
 void QWaylandAbstractDecoration::update()
 {
     Q_D(QWaylandAbstractDecoration);
     d->m_isDirty = true;
 }
 
+// Drops the edge images of both the active and the inactive look, so that
+// they are rendered again on the next update.
+void QWaylandAbstractDecoration::invalidate()
+{
+    Q_D(QWaylandAbstractDecoration);
+    d->m_isDirty = true;
+    for (auto &edges : d->m_edgeImages)
+        edges = QWaylandAbstractDecorationPrivate::EdgeImages();
+}
+
+// Like update(), but the decoration only changed between its active and
+// inactive look, so the edge images kept for the other state stay valid.
+void QWaylandAbstractDecoration::updateActiveState()
+{
+    Q_D(QWaylandAbstractDecoration);
+    d->m_isDirty = true;
+}
+
 void QWaylandAbstractDecoration::setMouseButtons(Qt::MouseButtons mb)
 {
     Q_D(QWaylandAbstractDecoration);
@@ -159,6 +303,46 @@ bool QWaylandAbstractDecoration::isLeftReleased(Qt::MouseButtons newMouseButtonS
     return (d->m_mouseButtons & Qt::LeftButton) && !(newMouseButtonState & Qt::LeftButton);
 }
 
+// Parts of decorations that look the same in every window, like backgrounds
+// and button glyphs, are shared by all decorations of the process. EGL windows
+// paint their decorations from the render thread.
+namespace {
+struct DecorationPartCache
+{
+    QMutex mutex;
+    QCache<QByteArray, QImage> images{4096}; // cost in KiB
+};
+}
+Q_GLOBAL_STATIC(DecorationPartCache, decorationPartCache)
+
+// Returns the part called key at the window's buffer scale, rendering it with
+// paintPart into a transparent image of size the first time it is needed.
+// The key has to cover everything paintPart depends on, such as the colors.
+QImage QWaylandAbstractDecoration::cachedPart(const QByteArray &key, const QSize &size, const PartPainter &paintPart) const
+{
+    const qreal bufferScale = waylandWindow() ? waylandWindow()->scale() : 1;
+    const QByteArray cacheKey = key + '@' + QByteArray::number(size.width()) + 'x'
+            + QByteArray::number(size.height()) + '*' + QByteArray::number(bufferScale);
+
+    DecorationPartCache *cache = decorationPartCache();
+    QMutexLocker locker(&cache->mutex);
+    if (const QImage *image = cache->images.object(cacheKey))
+        return *image;
+    locker.unlock();
+
+    QImage image(size * bufferScale, QImage::Format_ARGB32_Premultiplied);
+    image.setDevicePixelRatio(bufferScale);
+    image.fill(Qt::transparent);
+    {
+        QPainter painter(&image);
+        paintPart(&painter, size);
+    }
+
+    locker.relock();
+    cache->images.insert(cacheKey, new QImage(image), qMax<qsizetype>(1, image.sizeInBytes() / 1024));
+    return image;
+}
+
 bool QWaylandAbstractDecoration::isDirty() const
 {
     Q_D(const QWaylandAbstractDecoration);
@@ -29,6 +29,8 @@
 #include <QtCore/QDebug>
 #include <QtCore/private/qglobal_p.h>
 
+#include <functional>
+
 QT_BEGIN_NAMESPACE
 
 class QWindow;
@@ -61,12 +63,16 @@ public:
     QWaylandWindow *waylandWindow() const;
 
     void update();
+    void updateActiveState();
+    void invalidate();
     bool isDirty() const;
 
     virtual QMargins margins(MarginsType marginsType = Full) const = 0;
 
     QWindow *window() const;
     const QImage &contentImage();
+    const QImage &edgeImage(Qt::Edge edge);
+    QRect edgeRect(Qt::Edge edge) const;
 
     virtual bool handleMouse(QWaylandInputDevice *inputDevice, const QPointF &local, const QPointF &global,Qt::MouseButtons b,Qt::KeyboardModifiers mods) = 0;
     virtual bool handleTouch(QWaylandInputDevice *inputDevice, const QPointF &local, const QPointF &global, QEventPoint::State state, Qt::KeyboardModifiers mods) = 0;
@@ -83,6 +89,9 @@ protected:
     bool isLeftClicked(Qt::MouseButtons newMouseButtonState);
     bool isRightClicked(Qt::MouseButtons newMouseButtonState);
     bool isLeftReleased(Qt::MouseButtons newMouseButtonState);
+
+    using PartPainter = std::function<void(QPainter *painter, const QSize &size)>;
+    QImage cachedPart(const QByteArray &key, const QSize &size, const PartPainter &paintPart) const;
 };
 
 }
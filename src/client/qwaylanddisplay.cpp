@@ -50,10 +50,15 @@
 #include <QtWaylandClient/private/qwayland-text-input-unstable-v4-wip.h>
 #include <QtWaylandClient/private/qwayland-wp-primary-selection-unstable-v1.h>
 #include <QtWaylandClient/private/qwayland-qt-text-input-method-unstable-v1.h>
+#include <QtWaylandClient/private/qwayland-viewporter.h>
+#include <QtWaylandClient/private/qwayland-fractional-scale-v1.h>
 
 #include <QtCore/private/qcore_unix_p.h>
 
 #include <QtCore/QAbstractEventDispatcher>
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QSocketNotifier>
 #include <QtGui/qpa/qwindowsysteminterface.h>
 #include <QtGui/private/qguiapplication_p.h>
 
@@ -294,6 +299,18 @@ struct ::wl_region *QWaylandDisplay::createRegion(const QRegion &qregion)
     return mSubCompositor->get_subsurface(window->wlSurface(), parent->wlSurface());
 }
 
+::wp_viewport *QWaylandDisplay::createViewport(QWaylandWindow *window)
+{
+    if (!mViewporter) {
+        qCWarning(lcQpaWayland) << "Can't create wp_viewport, not supported by the compositor.";
+        return nullptr;
+    }
+
+    Q_ASSERT(window->wlSurface());
+
+    return mViewporter->get_viewport(window->wlSurface());
+}
+
 QWaylandShellIntegration *QWaylandDisplay::shellIntegration() const
 {
     return mWaylandIntegration->shellIntegration();
@@ -339,8 +356,10 @@ QWaylandDisplay::~QWaylandDisplay(void)
     if (m_eventThread)
         m_eventThread->stop();
 
-    if (m_frameEventQueueThread)
-        m_frameEventQueueThread->stop();
+    delete m_eventNotifier;
+
+    if (m_inputEventThread)
+        m_inputEventThread->stop();
 
     if (mSyncCallback)
         wl_callback_destroy(mSyncCallback);
@@ -361,10 +380,57 @@ QWaylandDisplay::~QWaylandDisplay(void)
     if (mDisplay)
         wl_display_disconnect(mDisplay);
 
-    if (m_frameEventQueue)
-        wl_event_queue_destroy(m_frameEventQueue);
+    if (m_inputEventQueue)
+        wl_event_queue_destroy(m_inputEventQueue);
+
+#if QT_CONFIG(xkbcommon)
+    for (struct xkb_keymap *keymap : std::as_const(mXkbKeymapCache))
+        xkb_keymap_unref(keymap);
+#endif
 }
 
+#if QT_CONFIG(xkbcommon)
+// Returns a new reference to the keymap compiled from the given source. Every
+// seat gets the same keymap from the compositor, and it is resent unchanged on
+// many occasions, so compiled keymaps are shared instead of compiled again.
+struct xkb_keymap *QWaylandDisplay::keymapFromString(const char *keymap, size_t size)
+{
+    if (!inputXkbContext())
+        return nullptr;
+
+    const QByteArray source = QByteArray::fromRawData(keymap, qstrnlen(keymap, size));
+    const QByteArray key = QCryptographicHash::hash(source, QCryptographicHash::Sha256);
+    if (struct xkb_keymap *cached = mXkbKeymapCache.value(key)) {
+        qCDebug(lcQpaWayland) << "Reusing compiled keymap of" << source.size() << "bytes";
+        return xkb_keymap_ref(cached);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    // xkb_keymap_new_from_buffer() does not need the source to be null-terminated
+    struct xkb_keymap *compiled = xkb_keymap_new_from_buffer(inputXkbContext(), source.constData(),
+                                                             size_t(source.size()),
+                                                             XKB_KEYMAP_FORMAT_TEXT_V1,
+                                                             XKB_KEYMAP_COMPILE_NO_FLAGS);
+    qCDebug(lcQpaWayland) << "Compiled keymap of" << source.size() << "bytes in"
+                          << timer.nsecsElapsed() / 1000000.0 << "ms";
+    if (!compiled)
+        return nullptr;
+
+    QXkbCommon::verifyHasLatinLayout(compiled);
+
+    // Keymaps rarely change, a handful of them covers layout switching
+    static const qsizetype MaxCachedKeymaps = 8;
+    if (mXkbKeymapCache.size() >= MaxCachedKeymaps) {
+        for (struct xkb_keymap *old : std::as_const(mXkbKeymapCache))
+            xkb_keymap_unref(old);
+        mXkbKeymapCache.clear();
+    }
+    mXkbKeymapCache.insert(key, xkb_keymap_ref(compiled));
+    return compiled;
+}
+#endif
+
 // Steps which is called just after constructor. This separates registry_global() out of the constructor
 // so that factory functions in integration can be overridden.
 void QWaylandDisplay::initialize()
@@ -394,7 +460,113 @@ void QWaylandDisplay::ensureScreen()
 // Called in main thread, either from queued signal or directly.
 void QWaylandDisplay::flushRequests()
 {
-    m_eventThread->readAndDispatchEvents();
+    // Input read before the events of the default queue, such as text input, goes first
+    if (m_inputEventQueue) {
+        for (QWaylandInputDevice *inputDevice : std::as_const(mInputDevices))
+            inputDevice->deliverInputEvents();
+    }
+
+    if (m_eventThread)
+        m_eventThread->readAndDispatchEvents();
+    else if (m_eventNotifier)
+        readAndDispatchEvents();
+
+    // Frame callbacks of windows that no render thread is waiting on
+    for (QWaylandWindow *window : std::as_const(mWindows))
+        window->dispatchFrameEvents();
+}
+
+// Dispatches queue on the calling thread, reading from the display until at
+// least one event was dispatched or the deadline expired. Other threads keep
+// reading and dispatching their own queues meanwhile.
+void QWaylandDisplay::dispatchQueue(wl_event_queue *queue, QDeadlineTimer deadline)
+{
+    for (;;) {
+        const int dispatched = wl_display_dispatch_queue_pending(mDisplay, queue);
+        if (dispatched < 0) {
+            checkWaylandError(mDisplay);
+            return;
+        }
+        if (dispatched > 0)
+            return;
+
+        if (wl_display_prepare_read_queue(mDisplay, queue) != 0)
+            continue;
+
+        wl_display_flush(mDisplay);
+
+        pollfd fd = { wl_display_get_fd(mDisplay), POLLIN, 0 };
+        const int ready = poll(&fd, 1, deadline.remainingTime());
+        if (ready <= 0 || !(fd.revents & POLLIN)) {
+            wl_display_cancel_read(mDisplay);
+            if (ready < 0 && errno == EINTR && !deadline.hasExpired())
+                continue;
+            return;
+        }
+
+        if (wl_display_read_events(mDisplay) < 0) {
+            checkWaylandError(mDisplay);
+            return;
+        }
+
+        // Without an event thread the main thread may have missed the fd becoming
+        // readable, as we read the events for the other queues as well.
+        if (m_eventNotifier)
+            QGuiApplicationPrivate::eventDispatcher->wakeUp();
+    }
+}
+
+void QWaylandDisplay::addWindow(QWaylandWindow *window)
+{
+    mWindows.append(window);
+}
+
+void QWaylandDisplay::removeWindow(QWaylandWindow *window)
+{
+    mWindows.removeOne(window);
+}
+
+// Returns surface if it still belongs to one of our windows, for events that
+// were read on another thread before the surface was destroyed.
+::wl_surface *QWaylandDisplay::windowSurface(::wl_surface *surface) const
+{
+    for (QWaylandWindow *window : mWindows) {
+        if (surface && window->wlSurface() == surface)
+            return surface;
+    }
+    return nullptr;
+}
+
+// Reads and dispatches the default queue on the main thread when there is no
+// event thread. Called when the display fd becomes readable and around every
+// wait of the event dispatcher. The read is never kept prepared across a
+// dispatch, so code called from there may freely do roundtrips or spin an
+// event loop.
+void QWaylandDisplay::readAndDispatchEvents()
+{
+    for (;;) {
+        if (wl_display_dispatch_pending(mDisplay) < 0) {
+            checkWaylandError(mDisplay);
+            return;
+        }
+
+        wl_display_flush(mDisplay);
+
+        // Events were queued since the dispatch, read by us or by a render thread
+        if (wl_display_prepare_read(mDisplay) != 0)
+            continue;
+
+        pollfd fd = { wl_display_get_fd(mDisplay), POLLIN, 0 };
+        if (poll(&fd, 1, 0) <= 0 || !(fd.revents & POLLIN)) {
+            wl_display_cancel_read(mDisplay);
+            return;
+        }
+
+        if (wl_display_read_events(mDisplay) < 0) {
+            checkWaylandError(mDisplay);
+            return;
+        }
+    }
 }
 
 // We have to wait until we have an eventDispatcher before creating the eventThread,
@@ -402,17 +574,33 @@ void QWaylandDisplay::flushRequests()
 // polling.
 void QWaylandDisplay::initEventThread()
 {
-    m_eventThread.reset(
-            new EventThread(mDisplay, /* default queue */ nullptr, EventThread::EmitToDispatch));
-    connect(m_eventThread.get(), &EventThread::needReadAndDispatch, this,
-            &QWaylandDisplay::flushRequests, Qt::QueuedConnection);
-    m_eventThread->start();
+    if (qEnvironmentVariableIntValue("QT_WAYLAND_DISPATCHER_EVENT_READING")) {
+        // Saves the event thread's wakeup and the posted event for every batch of
+        // events, at the price of input being handled only when the main thread
+        // gets to it.
+        m_eventNotifier = new QSocketNotifier(wl_display_get_fd(mDisplay), QSocketNotifier::Read, this);
+        connect(m_eventNotifier, &QSocketNotifier::activated, this, &QWaylandDisplay::flushRequests);
+    } else {
+        m_eventThread.reset(
+                new EventThread(mDisplay, /* default queue */ nullptr, EventThread::EmitToDispatch));
+        connect(m_eventThread.get(), &EventThread::needReadAndDispatch, this,
+                &QWaylandDisplay::flushRequests, Qt::QueuedConnection);
+        m_eventThread->start();
+    }
 
-    // wl_display_disconnect() free this.
-    m_frameEventQueue = wl_display_create_queue(mDisplay);
-    m_frameEventQueueThread.reset(
-            new EventThread(mDisplay, m_frameEventQueue, EventThread::SelfDispatch));
-    m_frameEventQueueThread->start();
+    if (qEnvironmentVariableIntValue("QT_WAYLAND_INPUT_THREAD")) {
+        // wl_pointer, wl_keyboard and wl_touch get their own queue, read and decoded
+        // on this thread even while the main thread is busy, see
+        // QWaylandInputDevice::postInputEvent().
+#if QT_CONFIG(xkbcommon)
+        mInputXkbContext.reset(xkb_context_new(XKB_CONTEXT_NO_FLAGS));
+#endif
+        m_inputEventQueue = wl_display_create_queue(mDisplay);
+        m_inputEventThread.reset(
+                new EventThread(mDisplay, m_inputEventQueue, EventThread::SelfDispatch));
+        m_inputEventThread->setObjectName(QStringLiteral("WaylandInputThread"));
+        m_inputEventThread->start();
+    }
 }
 
 void QWaylandDisplay::blockingReadEvents()
@@ -598,6 +786,10 @@ void QWaylandDisplay::registry_global(uint32_t id, const QString &interface, uin
         for (auto *screen : std::as_const(mWaitingScreens))
             screen->initXdgOutput(xdgOutputManager());
         forceRoundTrip();
+    } else if (interface == QLatin1String(QtWayland::wp_viewporter::interface()->name)) {
+        mViewporter.reset(new QtWayland::wp_viewporter(registry, id, qMin(1u, version)));
+    } else if (interface == QLatin1String(QtWayland::wp_fractional_scale_manager_v1::interface()->name)) {
+        mFractionalScaleManager.reset(new QtWayland::wp_fractional_scale_manager_v1(registry, id, 1));
     }
 
     mGlobals.append(RegistryGlobal(id, interface, version, registry));
@@ -742,7 +934,7 @@ void QWaylandDisplay::handleWindowActivated(QWaylandWindow *window)
     requestWaylandSync();
 
     if (auto *decoration = window->decoration())
-        decoration->update();
+        decoration->updateActiveState();
 }
 
 void QWaylandDisplay::handleWindowDeactivated(QWaylandWindow *window)
@@ -755,7 +947,7 @@ void QWaylandDisplay::handleWindowDeactivated(QWaylandWindow *window)
     mActiveWindows.removeOne(window);
 
     if (auto *decoration = window->decoration())
-        decoration->update();
+        decoration->updateActiveState();
 }
 
 void QWaylandDisplay::handleKeyboardFocusChanged(QWaylandInputDevice *inputDevice)
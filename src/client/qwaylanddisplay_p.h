@@ -15,6 +15,8 @@
 // We mean it.
 //
 
+#include <QtCore/QDeadlineTimer>
+#include <QtCore/QHash>
 #include <QtCore/QList>
 #include <QtCore/QObject>
 #include <QtCore/QPointer>
@@ -36,6 +38,7 @@
 #endif
 
 struct wl_cursor_image;
+struct wp_viewport;
 
 QT_BEGIN_NAMESPACE
 
@@ -50,6 +53,8 @@ namespace QtWayland {
     class zwp_text_input_manager_v2;
     class zwp_text_input_manager_v4;
     class qt_text_input_method_manager_v1;
+    class wp_viewporter;
+    class wp_fractional_scale_manager_v1;
 }
 
 namespace QtWaylandClient {
@@ -98,6 +103,10 @@ public:
 
 #if QT_CONFIG(xkbcommon)
     struct xkb_context *xkbContext() const { return mXkbContext.get(); }
+    // For keymaps of the input devices, which may be used on the input thread
+    struct xkb_context *inputXkbContext() const
+    { return mInputXkbContext ? mInputXkbContext.get() : mXkbContext.get(); }
+    struct xkb_keymap *keymapFromString(const char *keymap, size_t size);
 #endif
 
     QList<QWaylandScreen *> screens() const { return mScreens; }
@@ -110,6 +119,7 @@ public:
     struct wl_surface *createSurface(void *handle);
     struct ::wl_region *createRegion(const QRegion &qregion);
     struct ::wl_subsurface *createSubSurface(QWaylandWindow *window, QWaylandWindow *parent);
+    struct ::wp_viewport *createViewport(QWaylandWindow *window);
 
     QWaylandShellIntegration *shellIntegration() const;
     QWaylandClientBufferIntegration *clientBufferIntegration() const;
@@ -146,6 +156,8 @@ public:
     QtWayland::zwp_text_input_manager_v4 *textInputManagerv4() const { return mTextInputManagerv4.data(); }
     QWaylandHardwareIntegration *hardwareIntegration() const { return mHardwareIntegration.data(); }
     QWaylandXdgOutputManagerV1 *xdgOutputManager() const { return mXdgOutputManager.data(); }
+    QtWayland::wp_viewporter *viewporter() const { return mViewporter.data(); }
+    QtWayland::wp_fractional_scale_manager_v1 *fractionalScaleManager() const { return mFractionalScaleManager.data(); }
 
     struct RegistryGlobal {
         uint32_t id;
@@ -182,7 +194,12 @@ public:
     void handleKeyboardFocusChanged(QWaylandInputDevice *inputDevice);
     void handleWindowDestroyed(QWaylandWindow *window);
 
-    wl_event_queue *frameEventQueue() { return m_frameEventQueue; };
+    void addWindow(QWaylandWindow *window);
+    void removeWindow(QWaylandWindow *window);
+    void dispatchQueue(wl_event_queue *queue, QDeadlineTimer deadline);
+    ::wl_surface *windowSurface(::wl_surface *surface) const;
+
+    wl_event_queue *inputEventQueue() const { return m_inputEventQueue; }
 
     bool isKeyboardAvailable() const;
     bool isClientSideInputContextRequested() const;
@@ -202,6 +219,7 @@ private:
     void requestWaylandSync();
 
     void checkTextInputProtocol();
+    void readAndDispatchEvents();
 
     struct Listener {
         Listener() = default;
@@ -215,8 +233,12 @@ private:
 
     struct wl_display *mDisplay = nullptr;
     std::unique_ptr<EventThread> m_eventThread;
-    wl_event_queue *m_frameEventQueue = nullptr;
-    QScopedPointer<EventThread> m_frameEventQueueThread;
+    // Replaces m_eventThread when reading events from the event dispatcher
+    QSocketNotifier *m_eventNotifier = nullptr;
+    // Their frame event queues are dispatched from the main thread as well
+    QList<QWaylandWindow *> mWindows;
+    wl_event_queue *m_inputEventQueue = nullptr;
+    std::unique_ptr<EventThread> m_inputEventThread;
     QtWayland::wl_compositor mCompositor;
     QScopedPointer<QWaylandShm> mShm;
     QList<QWaylandScreen *> mWaitingScreens;
@@ -265,6 +287,8 @@ private:
     QScopedPointer<QtWayland::zwp_text_input_manager_v4> mTextInputManagerv4;
     QScopedPointer<QWaylandHardwareIntegration> mHardwareIntegration;
     QScopedPointer<QWaylandXdgOutputManagerV1> mXdgOutputManager;
+    QScopedPointer<QtWayland::wp_viewporter> mViewporter;
+    QScopedPointer<QtWayland::wp_fractional_scale_manager_v1> mFractionalScaleManager;
     int mFd = -1;
     int mWritableNotificationFd = -1;
     QList<RegistryGlobal> mGlobals;
@@ -288,6 +312,10 @@ private:
 
 #if QT_CONFIG(xkbcommon)
     QXkbCommon::ScopedXKBContext mXkbContext;
+    // xkb contexts aren't thread-safe, the input thread gets its own
+    QXkbCommon::ScopedXKBContext mInputXkbContext;
+    // compiled keymaps, keyed by a hash of their source
+    QHash<QByteArray, struct xkb_keymap *> mXkbKeymapCache;
 #endif
 
     friend class QWaylandIntegration;
@@ -0,0 +1,34 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qwaylandfractionalscale_p.h"
+
+QT_BEGIN_NAMESPACE
+
+namespace QtWaylandClient {
+
+QWaylandFractionalScale::QWaylandFractionalScale(::wp_fractional_scale_v1 *object)
+    : QtWayland::wp_fractional_scale_v1(object)
+{
+}
+
+QWaylandFractionalScale::~QWaylandFractionalScale()
+{
+    destroy();
+}
+
+void QWaylandFractionalScale::wp_fractional_scale_v1_preferred_scale(uint scale)
+{
+    // The scale is the numerator of a fraction with a denominator of 120
+    const qreal preferredScale = scale / qreal(120);
+    if (preferredScale <= 0 || qFuzzyCompare(preferredScale, mPreferredScale))
+        return;
+    mPreferredScale = preferredScale;
+    emit preferredScaleChanged();
+}
+
+}
+
+QT_END_NAMESPACE
+
+#include "moc_qwaylandfractionalscale_p.cpp"
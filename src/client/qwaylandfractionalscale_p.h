@@ -0,0 +1,51 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QWAYLANDFRACTIONALSCALE_P_H
+#define QWAYLANDFRACTIONALSCALE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtWaylandClient/qtwaylandclientglobal.h>
+#include <QtWaylandClient/private/qwayland-fractional-scale-v1.h>
+
+#include <QtCore/QObject>
+
+QT_BEGIN_NAMESPACE
+
+namespace QtWaylandClient {
+
+class Q_WAYLANDCLIENT_EXPORT QWaylandFractionalScale : public QObject, public QtWayland::wp_fractional_scale_v1
+{
+    Q_OBJECT
+public:
+    explicit QWaylandFractionalScale(::wp_fractional_scale_v1 *object);
+    ~QWaylandFractionalScale() override;
+
+    // 0 until the compositor has sent a preferred scale
+    qreal preferredScale() const { return mPreferredScale; }
+
+signals:
+    void preferredScaleChanged();
+
+protected:
+    void wp_fractional_scale_v1_preferred_scale(uint scale) override;
+
+private:
+    qreal mPreferredScale = 0;
+};
+
+}
+
+QT_END_NAMESPACE
+
+#endif // QWAYLANDFRACTIONALSCALE_P_H
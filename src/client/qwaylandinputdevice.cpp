@@ -48,6 +48,7 @@
 
 #include <QtGui/QGuiApplication>
 #include <QtGui/QPointingDevice>
+#include <QtCore/qhashfunctions.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -81,7 +82,7 @@ QWaylandInputDevice::Keyboard::Keyboard(QWaylandInputDevice *p)
 #if QT_CONFIG(xkbcommon)
 bool QWaylandInputDevice::Keyboard::createDefaultKeymap()
 {
-    struct xkb_context *ctx = mParent->mQDisplay->xkbContext();
+    struct xkb_context *ctx = mParent->mQDisplay->inputXkbContext();
     if (!ctx)
         return false;
 
@@ -109,6 +110,14 @@ QWaylandInputDevice::Keyboard::~Keyboard()
 {
     if (mFocus)
         QWindowSystemInterface::handleWindowActivated(nullptr);
+    destroyProxy();
+}
+
+void QWaylandInputDevice::Keyboard::destroyProxy()
+{
+    if (mProxyDestroyed)
+        return;
+    mProxyDestroyed = true;
     if (version() >= 3)
         wl_keyboard_release(object());
     else
@@ -133,6 +142,14 @@ QWaylandInputDevice::Pointer::Pointer(QWaylandInputDevice *seat)
 
 QWaylandInputDevice::Pointer::~Pointer()
 {
+    destroyProxy();
+}
+
+void QWaylandInputDevice::Pointer::destroyProxy()
+{
+    if (mProxyDestroyed)
+        return;
+    mProxyDestroyed = true;
     if (version() >= 3)
         wl_pointer_release(object());
     else
@@ -368,6 +385,14 @@ QWaylandInputDevice::Touch::Touch(QWaylandInputDevice *p)
 
 QWaylandInputDevice::Touch::~Touch()
 {
+    destroyProxy();
+}
+
+void QWaylandInputDevice::Touch::destroyProxy()
+{
+    if (mProxyDestroyed)
+        return;
+    mProxyDestroyed = true;
     if (version() >= 3)
         wl_touch_release(object());
     else
@@ -417,20 +442,110 @@ QWaylandInputDevice::QWaylandInputDevice(QWaylandDisplay *display, int version,
 // Can't be in header because dtors for scoped pointers aren't known there.
 QWaylandInputDevice::~QWaylandInputDevice() = default;
 
+// With QT_WAYLAND_INPUT_THREAD set, the wl_pointer, wl_keyboard and wl_touch events are
+// read and decoded on an input thread as soon as they arrive, instead of waiting for the
+// GUI thread to get to the default queue. What is decoded is posted here and delivered on
+// the GUI thread, where the focus windows live, with the original timestamps. A motion
+// replaces the one right before it for as long as neither was delivered.
+// Without an input thread the event is delivered right away.
+void QWaylandInputDevice::postInputEvent(std::function<void()> deliver, InputEventKind kind,
+                                         size_t motionKey)
+{
+    if (!mQDisplay->inputEventQueue()) {
+        deliver();
+        return;
+    }
+
+    QMutexLocker locker(&mPendingInputMutex);
+    if (kind != InputEventKind::Event && !mPendingInputEvents.isEmpty()) {
+        PendingInputEvent &last = mPendingInputEvents.last();
+        if (last.kind == kind && last.motionKey == motionKey) {
+            last.deliver = std::move(deliver);
+            return;
+        }
+    }
+    mPendingInputEvents.append({ std::move(deliver), kind, motionKey });
+
+    if (!std::exchange(mPendingInputScheduled, true))
+        QMetaObject::invokeMethod(this, &QWaylandInputDevice::deliverInputEvents, Qt::QueuedConnection);
+}
+
+// Delivers the posted events in order, one at a time, so that an event loop spun by one
+// of them carries on with the rest.
+void QWaylandInputDevice::deliverInputEvents()
+{
+    {
+        QMutexLocker locker(&mPendingInputMutex);
+        mPendingInputScheduled = false;
+    }
+
+    for (;;) {
+        std::function<void()> deliver;
+        {
+            QMutexLocker locker(&mPendingInputMutex);
+            if (mPendingInputEvents.isEmpty())
+                return;
+            deliver = mPendingInputEvents.takeFirst().deliver;
+        }
+        deliver();
+    }
+}
+
+// The input thread may be in one of the handlers of an object the seat drops. A sync on the
+// input queue shows when it is done with the object: the proxy is destroyed on the input thread
+// then, so nothing else is dispatched to it, and the object is deleted on the GUI thread after
+// the events it posted, which aren't delivered for a dropped object.
+template <typename T>
+void QWaylandInputDevice::dropInputObject(QScopedPointer<T> &object)
+{
+    auto *inputQueue = mQDisplay->inputEventQueue();
+    if (!inputQueue) {
+        object.reset();
+        return;
+    }
+
+    struct Drop {
+        QWaylandInputDevice *device;
+        T *object;
+    };
+    static const wl_callback_listener dropListener = {
+        [](void *data, wl_callback *callback, uint32_t) {
+            wl_callback_destroy(callback);
+            std::unique_ptr<Drop> drop(static_cast<Drop *>(data));
+            drop->object->destroyProxy();
+            drop->device->postInputEvent([object = drop->object] { delete object; });
+        }
+    };
+
+    auto *display = static_cast<wl_display *>(wl_proxy_create_wrapper(mDisplay));
+    wl_proxy_set_queue(reinterpret_cast<wl_proxy *>(display), inputQueue);
+    wl_callback *callback = wl_display_sync(display);
+    wl_proxy_wrapper_destroy(display);
+    wl_callback_add_listener(callback, &dropListener, new Drop{ this, object.take() });
+}
+
 void QWaylandInputDevice::seat_capabilities(uint32_t caps)
 {
     mCaps = caps;
 
+    // Events that were queued before moving to the input queue are still handled on the
+    // GUI thread right away.
+    auto *inputQueue = mQDisplay->inputEventQueue();
+
     if (caps & WL_SEAT_CAPABILITY_KEYBOARD && !mKeyboard) {
         mKeyboard.reset(createKeyboard(this));
         mKeyboard->init(get_keyboard());
+        if (inputQueue)
+            wl_proxy_set_queue(reinterpret_cast<wl_proxy *>(mKeyboard->wl_keyboard()), inputQueue);
     } else if (!(caps & WL_SEAT_CAPABILITY_KEYBOARD) && mKeyboard) {
-        mKeyboard.reset();
+        dropInputObject(mKeyboard);
     }
 
     if (caps & WL_SEAT_CAPABILITY_POINTER && !mPointer) {
         mPointer.reset(createPointer(this));
         mPointer->init(get_pointer());
+        if (inputQueue)
+            wl_proxy_set_queue(reinterpret_cast<wl_proxy *>(mPointer->wl_pointer()), inputQueue);
 
         auto *pointerGestures = mQDisplay->pointerGestures();
         if (pointerGestures) {
@@ -444,16 +559,25 @@ void QWaylandInputDevice::seat_capabilities(uint32_t caps)
             mPointerGesturePinch->init(pointerGestures->get_pinch_gesture(get_pointer()));
             mPointerGestureSwipe.reset(pointerGestures->createPointerGestureSwipe(this));
             mPointerGestureSwipe->init(pointerGestures->get_swipe_gesture(get_pointer()));
+            if (inputQueue) {
+                // Along with the pointer, so that their events stay in order
+                wl_proxy_set_queue(reinterpret_cast<wl_proxy *>(mPointerGesturePinch->zwp_pointer_gesture_pinch_v1()), inputQueue);
+                wl_proxy_set_queue(reinterpret_cast<wl_proxy *>(mPointerGestureSwipe->zwp_pointer_gesture_swipe_v1()), inputQueue);
+            }
         }
     } else if (!(caps & WL_SEAT_CAPABILITY_POINTER) && mPointer) {
-        mPointer.reset();
-        mPointerGesturePinch.reset();
-        mPointerGestureSwipe.reset();
+        dropInputObject(mPointer);
+        if (mPointerGesturePinch)
+            dropInputObject(mPointerGesturePinch);
+        if (mPointerGestureSwipe)
+            dropInputObject(mPointerGestureSwipe);
     }
 
     if (caps & WL_SEAT_CAPABILITY_TOUCH && !mTouch) {
         mTouch.reset(createTouch(this));
         mTouch->init(get_touch());
+        if (inputQueue)
+            wl_proxy_set_queue(reinterpret_cast<wl_proxy *>(mTouch->wl_touch()), inputQueue);
 
         if (!mTouchDevice) {
             // TODO number of touchpoints, actual name and ID
@@ -464,7 +588,7 @@ void QWaylandInputDevice::seat_capabilities(uint32_t caps)
             QWindowSystemInterface::registerInputDevice(mTouchDevice);
         }
     } else if (!(caps & WL_SEAT_CAPABILITY_TOUCH) && mTouch) {
-        mTouch.reset();
+        dropInputObject(mTouch);
     }
 }
 
@@ -589,8 +713,11 @@ QPointF QWaylandInputDevice::pointerSurfacePosition() const
 QList<int> QWaylandInputDevice::possibleKeys(const QKeyEvent *event) const
 {
 #if QT_CONFIG(xkbcommon)
-    if (mKeyboard && mKeyboard->mXkbState)
-        return QXkbCommon::possibleKeys(mKeyboard->mXkbState.get(), event);
+    if (mKeyboard) {
+        QMutexLocker locker(&mKeyboard->mXkbMutex);
+        if (mKeyboard->mXkbState)
+            return QXkbCommon::possibleKeys(mKeyboard->mXkbState.get(), event);
+    }
 #else
     Q_UNUSED(event);
 #endif
@@ -602,7 +729,7 @@ Qt::KeyboardModifiers QWaylandInputDevice::modifiers() const
     if (!mKeyboard)
         return Qt::NoModifier;
 
-    return mKeyboard->modifiers();
+    return Qt::KeyboardModifiers::fromInt(mModifiers.loadRelaxed());
 }
 
 Qt::KeyboardModifiers QWaylandInputDevice::Keyboard::modifiers() const
@@ -610,6 +737,7 @@ Qt::KeyboardModifiers QWaylandInputDevice::Keyboard::modifiers() const
     Qt::KeyboardModifiers ret = Qt::NoModifier;
 
 #if QT_CONFIG(xkbcommon)
+    QMutexLocker locker(&mXkbMutex);
     if (!mXkbState)
         return ret;
 
@@ -651,6 +779,14 @@ void QWaylandInputDevice::setCursor(const QCursor *cursor, const QSharedPointer<
 }
 #endif
 
+// The window of a surface an event was read for. Events read on the input thread may refer
+// to a surface that was destroyed meanwhile, see QWaylandDisplay::windowSurface().
+static QWaylandWindow *inputWindow(QWaylandDisplay *display, ::wl_surface *surface)
+{
+    surface = display->windowSurface(surface);
+    return surface ? QWaylandWindow::fromWlSurface(surface) : nullptr;
+}
+
 class EnterEvent : public QWaylandPointerEvent
 {
 public:
@@ -666,34 +802,14 @@ void QWaylandInputDevice::Pointer::pointer_enter(uint32_t serial, struct wl_surf
     if (!surface)
         return;
 
-    QWaylandWindow *window = QWaylandWindow::fromWlSurface(surface);
+    mInputFocus = surface;
 
-    if (!window)
-        return; // Ignore foreign surfaces
-
-    if (mFocus) {
-        qCWarning(lcQpaWayland) << "The compositor sent a wl_pointer.enter event before sending a"
-                                << "leave event first, this is not allowed by the wayland protocol"
-                                << "attempting to work around it by invalidating the current focus";
-        invalidateFocus();
-    }
-    mFocus = window->waylandSurface();
-    connect(mFocus.data(), &QObject::destroyed, this, &Pointer::handleFocusDestroyed);
-
-    mSurfacePos = QPointF(wl_fixed_to_double(sx), wl_fixed_to_double(sy));
-    mGlobalPos = window->mapToGlobal(mSurfacePos.toPoint());
-
-    mParent->mSerial = serial;
-    mEnterSerial = serial;
-
-#if QT_CONFIG(cursor)
-    // Depends on mEnterSerial being updated
-    updateCursor();
-#endif
-
-    QWaylandWindow *grab = QWaylandWindow::mouseGrab();
-    if (!grab)
-        setFrameEvent(new EnterEvent(window, mSurfacePos, mGlobalPos));
+    InputEvent event;
+    event.type = QEvent::Enter;
+    event.surface = surface;
+    event.serial = serial;
+    event.surfacePos = QPointF(wl_fixed_to_double(sx), wl_fixed_to_double(sy));
+    setFrameEvent(event);
 }
 
 class LeaveEvent : public QWaylandPointerEvent
@@ -707,22 +823,13 @@ public:
 
 void QWaylandInputDevice::Pointer::pointer_leave(uint32_t time, struct wl_surface *surface)
 {
-    invalidateFocus();
-    mButtons = Qt::NoButton;
-
-    mParent->mTime = time;
-
-    // The event may arrive after destroying the window, indicated by
-    // a null surface.
-    if (!surface)
-        return;
-
-    auto *window = QWaylandWindow::fromWlSurface(surface);
-    if (!window)
-        return; // Ignore foreign surfaces
+    mInputFocus = nullptr;
 
-    if (!QWaylandWindow::mouseGrab())
-        setFrameEvent(new LeaveEvent(window, mSurfacePos, mGlobalPos));
+    InputEvent event;
+    event.type = QEvent::Leave;
+    event.surface = surface;
+    event.timestamp = time;
+    setFrameEvent(event);
 }
 
 class MotionEvent : public QWaylandPointerEvent
@@ -738,31 +845,17 @@ public:
 
 void QWaylandInputDevice::Pointer::pointer_motion(uint32_t time, wl_fixed_t surface_x, wl_fixed_t surface_y)
 {
-    QWaylandWindow *window = focusWindow();
-    if (!window) {
-        // We destroyed the pointer focus surface, but the server didn't get the message yet...
-        // or the server didn't send an enter event first. In either case, ignore the event.
+    if (!mInputFocus) {
+        // The server didn't send an enter event first, ignore the event.
         return;
     }
 
-    QPointF pos(wl_fixed_to_double(surface_x), wl_fixed_to_double(surface_y));
-    QPointF delta = pos - pos.toPoint();
-    QPointF global = window->mapToGlobal(pos.toPoint());
-    global += delta;
-
-    mSurfacePos = pos;
-    mGlobalPos = global;
-    mParent->mTime = time;
-
-    QWaylandWindow *grab = QWaylandWindow::mouseGrab();
-    if (grab && grab != window) {
-        // We can't know the true position since we're getting events for another surface,
-        // so we just set it outside of the window boundaries.
-        pos = QPointF(-1, -1);
-        global = grab->mapToGlobal(pos.toPoint());
-        window = grab;
-    }
-    setFrameEvent(new MotionEvent(window, time, pos, global, mButtons, mParent->modifiers()));
+    InputEvent event;
+    event.type = QEvent::MouseMove;
+    event.timestamp = time;
+    event.surfacePos = QPointF(wl_fixed_to_double(surface_x), wl_fixed_to_double(surface_y));
+    event.modifiers = Qt::KeyboardModifiers::fromInt(mParent->mModifiers.loadRelaxed());
+    setFrameEvent(event);
 }
 
 class PressEvent : public QWaylandPointerEvent
@@ -792,10 +885,8 @@ public:
 void QWaylandInputDevice::Pointer::pointer_button(uint32_t serial, uint32_t time,
                                                   uint32_t button, uint32_t state)
 {
-    QWaylandWindow *window = focusWindow();
-    if (!window) {
-        // We destroyed the pointer focus surface, but the server didn't get the message yet...
-        // or the server didn't send an enter event first. In either case, ignore the event.
+    if (!mInputFocus) {
+        // The server didn't send an enter event first, ignore the event.
         return;
     }
 
@@ -823,31 +914,13 @@ void QWaylandInputDevice::Pointer::pointer_button(uint32_t serial, uint32_t time
     default: return; // invalid button number (as far as Qt is concerned)
     }
 
-    if (state)
-        mButtons |= qt_button;
-    else
-        mButtons &= ~qt_button;
-
-    mParent->mTime = time;
-    mParent->mSerial = serial;
-    if (state)
-        mParent->mQDisplay->setLastInputDevice(mParent, serial, window);
-
-    QWaylandWindow *grab = QWaylandWindow::mouseGrab();
-
-    QPointF pos = mSurfacePos;
-    QPointF global = mGlobalPos;
-    if (grab && grab != focusWindow()) {
-        pos = QPointF(-1, -1);
-        global = grab->mapToGlobal(pos.toPoint());
-
-        window = grab;
-    }
-
-    if (state)
-        setFrameEvent(new PressEvent(window, time, pos, global, mButtons, qt_button, mParent->modifiers()));
-    else
-        setFrameEvent(new ReleaseEvent(window, time, pos, global, mButtons, qt_button, mParent->modifiers()));
+    InputEvent event;
+    event.type = state ? QEvent::MouseButtonPress : QEvent::MouseButtonRelease;
+    event.serial = serial;
+    event.timestamp = time;
+    event.button = qt_button;
+    event.modifiers = Qt::KeyboardModifiers::fromInt(mParent->mModifiers.loadRelaxed());
+    setFrameEvent(event);
 }
 
 void QWaylandInputDevice::Pointer::invalidateFocus()
@@ -883,9 +956,8 @@ public:
 
 void QWaylandInputDevice::Pointer::pointer_axis(uint32_t time, uint32_t axis, int32_t value)
 {
-    if (!focusWindow()) {
-        // We destroyed the pointer focus surface, but the server didn't get the message yet...
-        // or the server didn't send an enter event first. In either case, ignore the event.
+    if (!mInputFocus) {
+        // The server didn't send an enter event first, ignore the event.
         return;
     }
 
@@ -905,7 +977,7 @@ void QWaylandInputDevice::Pointer::pointer_axis(uint32_t time, uint32_t axis, in
         return;
     }
 
-    mParent->mTime = time;
+    mFrameData.axisTimestamp = time;
 
     if (version() < WL_POINTER_FRAME_SINCE_VERSION) {
         qCDebug(lcQpaWaylandInput) << "Flushing new event; no frame event in this version";
@@ -938,10 +1010,10 @@ void QWaylandInputDevice::Pointer::pointer_axis_source(uint32_t source)
 
 void QWaylandInputDevice::Pointer::pointer_axis_stop(uint32_t time, uint32_t axis)
 {
-    if (!focusWindow())
+    if (!mInputFocus)
         return;
 
-    mParent->mTime = time;
+    mFrameData.axisTimestamp = time;
     switch (axis) {
     case axis_vertical_scroll:
         qCDebug(lcQpaWaylandInput) << "Received vertical wl_pointer.axis_stop";
@@ -966,20 +1038,19 @@ void QWaylandInputDevice::Pointer::pointer_axis_stop(uint32_t time, uint32_t axi
         return;
     }
 
-    QWaylandWindow *target = QWaylandWindow::mouseGrab();
-    if (!target)
-        target = focusWindow();
-    Qt::KeyboardModifiers mods = mParent->modifiers();
-    WheelEvent wheelEvent(focusWindow(), Qt::ScrollEnd, mParent->mTime, mSurfacePos, mGlobalPos,
-                          QPoint(), QPoint(), Qt::MouseEventNotSynthesized, mods);
-    target->handleMouse(mParent, wheelEvent);
+    InputEvent event;
+    event.type = QEvent::Wheel;
+    event.timestamp = time;
+    event.phase = Qt::ScrollEnd;
+    event.modifiers = Qt::KeyboardModifiers::fromInt(mParent->mModifiers.loadRelaxed());
+    postEvent(event);
     mScrollBeginSent = false;
     mScrollDeltaRemainder = QPointF();
 }
 
 void QWaylandInputDevice::Pointer::pointer_axis_discrete(uint32_t axis, int32_t value)
 {
-    if (!focusWindow())
+    if (!mInputFocus)
         return;
 
     switch (axis) {
@@ -998,11 +1069,13 @@ void QWaylandInputDevice::Pointer::pointer_axis_discrete(uint32_t axis, int32_t
     }
 }
 
-void QWaylandInputDevice::Pointer::setFrameEvent(QWaylandPointerEvent *event)
+void QWaylandInputDevice::Pointer::setFrameEvent(const InputEvent &event)
 {
-    qCDebug(lcQpaWaylandInput) << "Setting frame event " << event->type;
-    if (mFrameData.event && mFrameData.event->type != event->type) {
-        qCDebug(lcQpaWaylandInput) << "Flushing; previous was " << mFrameData.event->type;
+    qCDebug(lcQpaWaylandInput) << "Setting frame event " << event.type;
+    // Only the last position of a frame ends up in a QMouseEvent
+    if (mFrameData.event.type != QEvent::None
+            && (mFrameData.event.type != event.type || event.type != QEvent::MouseMove)) {
+        qCDebug(lcQpaWaylandInput) << "Flushing; previous was " << mFrameData.event.type;
         flushFrameEvent();
     }
 
@@ -1090,27 +1163,26 @@ void QWaylandInputDevice::Pointer::flushScrollEvent()
 
     // Angle delta is required for Qt wheel events, so don't try to send events if it's zero
     if (!angleDelta.isNull()) {
-        QWaylandWindow *target = QWaylandWindow::mouseGrab();
-        if (!target)
-            target = focusWindow();
+        InputEvent event;
+        event.type = QEvent::Wheel;
+        event.timestamp = mFrameData.axisTimestamp;
+        event.modifiers = Qt::KeyboardModifiers::fromInt(mParent->mModifiers.loadRelaxed());
 
         if (isDefinitelyTerminated(mFrameData.axisSource) && !mScrollBeginSent) {
             qCDebug(lcQpaWaylandInput) << "Flushing scroll event sending ScrollBegin";
-            target->handleMouse(mParent, WheelEvent(focusWindow(), Qt::ScrollBegin, mParent->mTime,
-                                                    mSurfacePos, mGlobalPos, QPoint(), QPoint(),
-                                                    Qt::MouseEventNotSynthesized,
-                                                    mParent->modifiers()));
+            event.phase = Qt::ScrollBegin;
+            postEvent(event);
             mScrollBeginSent = true;
             mScrollDeltaRemainder = QPointF();
         }
 
-        Qt::ScrollPhase phase = mScrollBeginSent ? Qt::ScrollUpdate : Qt::NoScrollPhase;
-        QPoint pixelDelta = mFrameData.pixelDeltaAndError(&mScrollDeltaRemainder);
-        Qt::MouseEventSource source = mFrameData.wheelEventSource();
+        event.phase = mScrollBeginSent ? Qt::ScrollUpdate : Qt::NoScrollPhase;
+        event.pixelDelta = mFrameData.pixelDeltaAndError(&mScrollDeltaRemainder);
+        event.angleDelta = angleDelta;
+        event.source = mFrameData.wheelEventSource();
 
-        qCDebug(lcQpaWaylandInput) << "Flushing scroll event" << phase << pixelDelta << angleDelta;
-        target->handleMouse(mParent, WheelEvent(focusWindow(), phase, mParent->mTime, mSurfacePos, mGlobalPos,
-                                                pixelDelta, angleDelta, source, mParent->modifiers()));
+        qCDebug(lcQpaWaylandInput) << "Flushing scroll event" << event.phase << event.pixelDelta << angleDelta;
+        postEvent(event);
     }
 
     mFrameData.resetScrollData();
@@ -1118,23 +1190,158 @@ void QWaylandInputDevice::Pointer::flushScrollEvent()
 
 void QWaylandInputDevice::Pointer::flushFrameEvent()
 {
-    if (auto *event = mFrameData.event) {
-        if (auto window = event->surface) {
-            window->handleMouse(mParent, *event);
-        } else if (mFrameData.event->type == QEvent::MouseButtonRelease) {
+    if (mFrameData.event.type != QEvent::None) {
+        postEvent(mFrameData.event);
+        mFrameData.event = InputEvent();
+    }
+
+    //TODO: do modifiers get passed correctly here?
+    flushScrollEvent();
+}
+
+void QWaylandInputDevice::Pointer::postEvent(const InputEvent &event)
+{
+    const auto kind = event.type == QEvent::MouseMove ? InputEventKind::PointerMotion
+                                                      : InputEventKind::Event;
+    mParent->postInputEvent([device = mParent, pointer = this, event] {
+        if (device->pointer() == pointer)
+            pointer->handleEvent(event);
+    }, kind);
+}
+
+// Delivers an event decoded by the handlers above on the GUI thread, where the focus window
+// and the global position are known.
+void QWaylandInputDevice::Pointer::handleEvent(const InputEvent &event)
+{
+    if (event.type == QEvent::Enter) {
+        QWaylandWindow *window = inputWindow(mParent->mQDisplay, event.surface);
+        if (!window)
+            return; // Ignore foreign surfaces
+
+        if (mFocus) {
+            qCWarning(lcQpaWayland) << "The compositor sent a wl_pointer.enter event before sending a"
+                                    << "leave event first, this is not allowed by the wayland protocol"
+                                    << "attempting to work around it by invalidating the current focus";
+            invalidateFocus();
+        }
+        mFocus = window->waylandSurface();
+        connect(mFocus.data(), &QObject::destroyed, this, &Pointer::handleFocusDestroyed);
+
+        mSurfacePos = event.surfacePos;
+        mGlobalPos = window->mapToGlobal(mSurfacePos.toPoint());
+
+        mParent->mSerial = event.serial;
+        mEnterSerial = event.serial;
+
+#if QT_CONFIG(cursor)
+        // Depends on mEnterSerial being updated
+        updateCursor();
+#endif
+
+        if (!QWaylandWindow::mouseGrab())
+            window->handleMouse(mParent, EnterEvent(window, mSurfacePos, mGlobalPos));
+        return;
+    }
+
+    if (event.type == QEvent::Leave) {
+        invalidateFocus();
+        mButtons = Qt::NoButton;
+
+        mParent->mTime = event.timestamp;
+
+        // The event may arrive after destroying the window, indicated by
+        // a null surface.
+        auto *window = inputWindow(mParent->mQDisplay, event.surface);
+        if (!window)
+            return; // Ignore foreign surfaces
+
+        if (!QWaylandWindow::mouseGrab())
+            window->handleMouse(mParent, LeaveEvent(window, mSurfacePos, mGlobalPos));
+        return;
+    }
+
+    QWaylandWindow *window = focusWindow();
+    if (!window) {
+        if (event.type == QEvent::MouseButtonRelease && mButtons.testFlag(event.button)) {
             // If the window has been destroyed, we still need to report an up event, but it can't
             // be handled by the destroyed window (obviously), so send the event here instead.
-            QWindowSystemInterface::handleMouseEvent(nullptr, event->timestamp, event->local,
-                                 event->global, event->buttons,
-                                 event->button, event->type,
-                                 event->modifiers);// , Qt::MouseEventSource source = Qt::MouseEventNotSynthesized);
+            mButtons &= ~event.button;
+            QWindowSystemInterface::handleMouseEvent(nullptr, event.timestamp, mSurfacePos,
+                                                     mGlobalPos, mButtons, event.button,
+                                                     event.type, event.modifiers);
         }
-        delete mFrameData.event;
-        mFrameData.event = nullptr;
+        // We destroyed the pointer focus surface, but the server didn't get the message yet...
+        // or the server didn't send an enter event first. In either case, ignore the event.
+        return;
     }
 
-    //TODO: do modifiers get passed correctly here?
-    flushScrollEvent();
+    mParent->mTime = event.timestamp;
+
+    switch (event.type) {
+    case QEvent::MouseMove: {
+        QPointF pos = event.surfacePos;
+        QPointF delta = pos - pos.toPoint();
+        QPointF global = window->mapToGlobal(pos.toPoint());
+        global += delta;
+
+        mSurfacePos = pos;
+        mGlobalPos = global;
+
+        QWaylandWindow *grab = QWaylandWindow::mouseGrab();
+        if (grab && grab != window) {
+            // We can't know the true position since we're getting events for another surface,
+            // so we just set it outside of the window boundaries.
+            pos = QPointF(-1, -1);
+            global = grab->mapToGlobal(pos.toPoint());
+            window = grab;
+        }
+        window->handleMouse(mParent, MotionEvent(window, event.timestamp, pos, global, mButtons,
+                                                 event.modifiers));
+        break;
+    }
+    case QEvent::MouseButtonPress:
+    case QEvent::MouseButtonRelease: {
+        const bool pressed = event.type == QEvent::MouseButtonPress;
+        if (pressed)
+            mButtons |= event.button;
+        else
+            mButtons &= ~event.button;
+
+        mParent->mSerial = event.serial;
+        if (pressed)
+            mParent->mQDisplay->setLastInputDevice(mParent, event.serial, window);
+
+        QWaylandWindow *grab = QWaylandWindow::mouseGrab();
+
+        QPointF pos = mSurfacePos;
+        QPointF global = mGlobalPos;
+        if (grab && grab != window) {
+            pos = QPointF(-1, -1);
+            global = grab->mapToGlobal(pos.toPoint());
+
+            window = grab;
+        }
+
+        if (pressed)
+            window->handleMouse(mParent, PressEvent(window, event.timestamp, pos, global, mButtons,
+                                                    event.button, event.modifiers));
+        else
+            window->handleMouse(mParent, ReleaseEvent(window, event.timestamp, pos, global, mButtons,
+                                                      event.button, event.modifiers));
+        break;
+    }
+    case QEvent::Wheel: {
+        QWaylandWindow *target = QWaylandWindow::mouseGrab();
+        if (!target)
+            target = window;
+        target->handleMouse(mParent, WheelEvent(window, event.phase, event.timestamp, mSurfacePos,
+                                                mGlobalPos, event.pixelDelta, event.angleDelta,
+                                                event.source, event.modifiers));
+        break;
+    }
+    default:
+        break;
+    }
 }
 
 bool QWaylandInputDevice::Pointer::isDefinitelyTerminated(QtWayland::wl_pointer::axis_source source) const
@@ -1158,18 +1365,20 @@ void QWaylandInputDevice::Keyboard::keyboard_keymap(uint32_t format, int32_t fd,
         return;
     }
 
-    mXkbKeymap.reset(xkb_keymap_new_from_string(mParent->mQDisplay->xkbContext(), map_str,
-                                                XKB_KEYMAP_FORMAT_TEXT_V1,
-                                                XKB_KEYMAP_COMPILE_NO_FLAGS));
-    QXkbCommon::verifyHasLatinLayout(mXkbKeymap.get());
+    struct xkb_keymap *keymap = mParent->mQDisplay->keymapFromString(map_str, size);
 
     munmap(map_str, size);
     close(fd);
 
-    if (mXkbKeymap)
-        mXkbState.reset(xkb_state_new(mXkbKeymap.get()));
-    else
-        mXkbState.reset(nullptr);
+    {
+        QMutexLocker locker(&mXkbMutex);
+        mXkbKeymap.reset(keymap);
+        if (mXkbKeymap)
+            mXkbState.reset(xkb_state_new(mXkbKeymap.get()));
+        else
+            mXkbState.reset(nullptr);
+    }
+    updateModifiers();
 #else
     Q_UNUSED(fd);
     Q_UNUSED(size);
@@ -1181,6 +1390,14 @@ void QWaylandInputDevice::Keyboard::keyboard_enter(uint32_t time, struct wl_surf
     Q_UNUSED(time);
     Q_UNUSED(keys);
 
+    mParent->postInputEvent([device = mParent, keyboard = this, surface] {
+        if (device->keyboard() == keyboard)
+            keyboard->handleEnter(device->mQDisplay->windowSurface(surface));
+    });
+}
+
+void QWaylandInputDevice::Keyboard::handleEnter(::wl_surface *surface)
+{
     if (!surface) {
         // Ignoring wl_keyboard.enter event with null surface. This is either a compositor bug,
         // or it's a race with a wl_surface.destroy request. In either case, ignore the event.
@@ -1202,6 +1419,14 @@ void QWaylandInputDevice::Keyboard::keyboard_leave(uint32_t time, struct wl_surf
 {
     Q_UNUSED(time);
 
+    mParent->postInputEvent([device = mParent, keyboard = this, surface] {
+        if (device->keyboard() == keyboard)
+            keyboard->handleLeave(device->mQDisplay->windowSurface(surface));
+    });
+}
+
+void QWaylandInputDevice::Keyboard::handleLeave(::wl_surface *surface)
+{
     if (!surface) {
         // Either a compositor bug, or a race condition with wl_surface.destroy, ignore the event.
         return;
@@ -1256,52 +1481,40 @@ void QWaylandInputDevice::Keyboard::keyboard_key(uint32_t serial, uint32_t time,
         return;
     }
 
-    auto *window = focusWindow();
-    if (!window) {
-        // We destroyed the keyboard focus surface, but the server didn't get the message yet...
-        // or the server didn't send an enter event first. In either case, ignore the event.
-        return;
-    }
-
-    mParent->mSerial = serial;
-
-    const bool isDown = state != WL_KEYBOARD_KEY_STATE_RELEASED;
-    if (isDown)
-        mParent->mQDisplay->setLastInputDevice(mParent, serial, window);
-
     if (mKeymapFormat == WL_KEYBOARD_KEYMAP_FORMAT_XKB_V1) {
 #if QT_CONFIG(xkbcommon)
-        if ((!mXkbKeymap || !mXkbState) && !createDefaultKeymap())
-            return;
-
-        auto code = key + 8; // map to wl_keyboard::keymap_format::keymap_format_xkb_v1
-
-        xkb_keysym_t sym = xkb_state_key_get_one_sym(mXkbState.get(), code);
-
-        Qt::KeyboardModifiers modifiers = mParent->modifiers();
-
-        int qtkey = keysymToQtKey(sym, modifiers, mXkbState.get(), code);
-        QString text = QXkbCommon::lookupString(mXkbState.get(), code);
-
-        QEvent::Type type = isDown ? QEvent::KeyPress : QEvent::KeyRelease;
-        handleKey(time, type, qtkey, modifiers, code, sym, mNativeModifiers, text);
-
-        if (state == WL_KEYBOARD_KEY_STATE_PRESSED && xkb_keymap_key_repeats(mXkbKeymap.get(), code) && mRepeatRate > 0) {
-            mRepeatKey.key = qtkey;
-            mRepeatKey.code = code;
-            mRepeatKey.time = time;
-            mRepeatKey.text = text;
-            mRepeatKey.modifiers = modifiers;
-            mRepeatKey.nativeModifiers = mNativeModifiers;
-            mRepeatKey.nativeVirtualKey = sym;
-            mRepeatTimer.setInterval(mRepeatDelay);
-            mRepeatTimer.start();
-        } else if (mRepeatKey.code == code) {
-            mRepeatTimer.stop();
+        KeyEvent event;
+        event.serial = serial;
+        event.timestamp = time;
+        event.type = state != WL_KEYBOARD_KEY_STATE_RELEASED ? QEvent::KeyPress : QEvent::KeyRelease;
+        event.nativeScanCode = key + 8; // map to wl_keyboard::keymap_format::keymap_format_xkb_v1
+        event.nativeModifiers = mNativeModifiers;
+
+        {
+            QMutexLocker locker(&mXkbMutex);
+            if ((!mXkbKeymap || !mXkbState) && !createDefaultKeymap())
+                return;
+
+            const xkb_keycode_t code = event.nativeScanCode;
+            xkb_keysym_t sym = xkb_state_key_get_one_sym(mXkbState.get(), code);
+
+            event.modifiers = QXkbCommon::modifiers(mXkbState.get());
+            event.key = keysymToQtKey(sym, event.modifiers, mXkbState.get(), code);
+            event.nativeVirtualKey = sym;
+            event.text = QXkbCommon::lookupString(mXkbState.get(), code);
+            event.startsRepeat = state == WL_KEYBOARD_KEY_STATE_PRESSED
+                    && xkb_keymap_key_repeats(mXkbKeymap.get(), code);
         }
+
+        mParent->postInputEvent([device = mParent, keyboard = this, event] {
+            if (device->keyboard() == keyboard)
+                keyboard->handleKeyEvent(event);
+        });
 #else
+        Q_UNUSED(serial);
         Q_UNUSED(time);
         Q_UNUSED(key);
+        Q_UNUSED(state);
         qCWarning(lcQpaWayland, "xkbcommon not available on this build, not performing key mapping");
         return;
 #endif
@@ -1311,6 +1524,39 @@ void QWaylandInputDevice::Keyboard::keyboard_key(uint32_t serial, uint32_t time,
     }
 }
 
+// Delivers a key translated by keyboard_key() on the GUI thread
+void QWaylandInputDevice::Keyboard::handleKeyEvent(const KeyEvent &event)
+{
+    auto *window = focusWindow();
+    if (!window) {
+        // We destroyed the keyboard focus surface, but the server didn't get the message yet...
+        // or the server didn't send an enter event first. In either case, ignore the event.
+        return;
+    }
+
+    mParent->mSerial = event.serial;
+
+    if (event.type == QEvent::KeyPress)
+        mParent->mQDisplay->setLastInputDevice(mParent, event.serial, window);
+
+    handleKey(event.timestamp, event.type, event.key, event.modifiers, event.nativeScanCode,
+              event.nativeVirtualKey, event.nativeModifiers, event.text);
+
+    if (event.startsRepeat && mRepeatRate > 0) {
+        mRepeatKey.key = event.key;
+        mRepeatKey.code = event.nativeScanCode;
+        mRepeatKey.time = event.timestamp;
+        mRepeatKey.text = event.text;
+        mRepeatKey.modifiers = event.modifiers;
+        mRepeatKey.nativeModifiers = event.nativeModifiers;
+        mRepeatKey.nativeVirtualKey = event.nativeVirtualKey;
+        mRepeatTimer.setInterval(mRepeatDelay);
+        mRepeatTimer.start();
+    } else if (mRepeatKey.code == event.nativeScanCode) {
+        mRepeatTimer.stop();
+    }
+}
+
 void QWaylandInputDevice::Keyboard::handleFocusDestroyed()
 {
     // The signal is emitted by QWaylandWindow, which is not necessarily destroyed along with the
@@ -1336,11 +1582,15 @@ void QWaylandInputDevice::Keyboard::keyboard_modifiers(uint32_t serial,
 {
     Q_UNUSED(serial);
 #if QT_CONFIG(xkbcommon)
-    if (mXkbState)
-        xkb_state_update_mask(mXkbState.get(),
-                              mods_depressed, mods_latched, mods_locked,
-                              0, 0, group);
+    {
+        QMutexLocker locker(&mXkbMutex);
+        if (mXkbState)
+            xkb_state_update_mask(mXkbState.get(),
+                                  mods_depressed, mods_latched, mods_locked,
+                                  0, 0, group);
+    }
     mNativeModifiers = mods_depressed | mods_latched | mods_locked;
+    updateModifiers();
 #else
     Q_UNUSED(mods_depressed);
     Q_UNUSED(mods_latched);
@@ -1349,10 +1599,26 @@ void QWaylandInputDevice::Keyboard::keyboard_modifiers(uint32_t serial,
 #endif
 }
 
+// Publishes the modifiers for QWaylandInputDevice::modifiers() and the other decoders
+void QWaylandInputDevice::Keyboard::updateModifiers()
+{
+    mParent->mModifiers.storeRelaxed(modifiers().toInt());
+}
+
 void QWaylandInputDevice::Keyboard::keyboard_repeat_info(int32_t rate, int32_t delay)
 {
-    mRepeatRate = rate;
-    mRepeatDelay = delay;
+    mParent->postInputEvent([device = mParent, keyboard = this, rate, delay] {
+        if (device->keyboard() != keyboard)
+            return;
+        keyboard->mRepeatRate = rate;
+        keyboard->mRepeatDelay = delay;
+    });
+}
+
+// releasePoints() changes the touch points on the GUI thread while the input thread decodes
+QMutex *QWaylandInputDevice::Touch::pointsMutex()
+{
+    return mParent->mQDisplay->inputEventQueue() ? &mPointsMutex : nullptr;
 }
 
 void QWaylandInputDevice::Touch::touch_down(uint32_t serial,
@@ -1365,26 +1631,23 @@ void QWaylandInputDevice::Touch::touch_down(uint32_t serial,
     if (!surface)
         return;
 
-    auto *window = QWaylandWindow::fromWlSurface(surface);
-    if (!window)
-        return; // Ignore foreign surfaces
-
-    mParent->mTime = time;
-    mParent->mSerial = serial;
-    mFocus = window;
-    mParent->mQDisplay->setLastInputDevice(mParent, serial, mFocus);
+    QMutexLocker locker(pointsMutex());
+    mInputFocus = surface;
+    mInputSerial = serial;
+    mInputTimestamp = time;
     QPointF position(wl_fixed_to_double(x), wl_fixed_to_double(y));
-    mParent->handleTouchPoint(id, QEventPoint::Pressed, position);
+    handleTouchPoint(id, QEventPoint::Pressed, position);
 }
 
 void QWaylandInputDevice::Touch::touch_up(uint32_t serial, uint32_t time, int32_t id)
 {
     Q_UNUSED(serial);
-    mParent->mTime = time;
-    mParent->handleTouchPoint(id, QEventPoint::Released);
+    QMutexLocker locker(pointsMutex());
+    mInputTimestamp = time;
+    handleTouchPoint(id, QEventPoint::Released);
 
     if (allTouchPointsReleased()) {
-        mFocus = nullptr;
+        mInputFocus = nullptr;
 
         // As of Weston 7.0.0 there is no touch_frame after the last touch_up
         // (i.e. when the last finger is released). To accommodate for this, issue a
@@ -1393,66 +1656,58 @@ void QWaylandInputDevice::Touch::touch_up(uint32_t serial, uint32_t time, int32_
         // See: https://gitlab.freedesktop.org/wayland/weston/issues/44
         // TODO: change logging category to lcQpaWaylandInput in newer versions.
         qCDebug(lcQpaWayland, "Generating fake frame event to work around Weston bug");
-        touch_frame();
+        flushFrame();
     }
 }
 
 void QWaylandInputDevice::Touch::touch_motion(uint32_t time, int32_t id, wl_fixed_t x, wl_fixed_t y)
 {
+    QMutexLocker locker(pointsMutex());
     QPointF position(wl_fixed_to_double(x), wl_fixed_to_double(y));
-    mParent->mTime = time;
-    mParent->handleTouchPoint(id, QEventPoint::Updated, position);
+    mInputTimestamp = time;
+    handleTouchPoint(id, QEventPoint::Updated, position);
 }
 
 void QWaylandInputDevice::Touch::touch_cancel()
 {
+    QMutexLocker locker(pointsMutex());
     mPendingTouchPoints.clear();
 
-    QWaylandTouchExtension *touchExt = mParent->mQDisplay->touchExtension();
-    if (touchExt)
-        touchExt->touchCanceled();
+    mParent->postInputEvent([device = mParent, touch = this] {
+        if (device->touch() != touch)
+            return;
 
-    QWindowSystemInterface::handleTouchCancelEvent(nullptr, mParent->mTouchDevice);
+        QWaylandTouchExtension *touchExt = device->mQDisplay->touchExtension();
+        if (touchExt)
+            touchExt->touchCanceled();
+
+        QWindowSystemInterface::handleTouchCancelEvent(nullptr, device->mTouchDevice);
+    });
 }
 
-void QWaylandInputDevice::handleTouchPoint(int id, QEventPoint::State state, const QPointF &surfacePosition)
+void QWaylandInputDevice::Touch::handleTouchPoint(int id, QEventPoint::State state, const QPointF &surfacePosition)
 {
-    auto end = mTouch->mPendingTouchPoints.end();
-    auto it = std::find_if(mTouch->mPendingTouchPoints.begin(), end, [id](const QWindowSystemInterface::TouchPoint &tp){ return tp.id == id; });
+    auto end = mPendingTouchPoints.end();
+    auto it = std::find_if(mPendingTouchPoints.begin(), end, [id](const QWindowSystemInterface::TouchPoint &tp){ return tp.id == id; });
     if (it == end) {
-        it = mTouch->mPendingTouchPoints.insert(end, QWindowSystemInterface::TouchPoint());
+        it = mPendingTouchPoints.insert(end, QWindowSystemInterface::TouchPoint());
         it->id = id;
     }
     // If the touch points were up and down in same frame, send out frame right away
     else if ((it->state == QEventPoint::Pressed && state == QEventPoint::Released)
             || (it->state == QEventPoint::Released && state == QEventPoint::Pressed)) {
-        mTouch->touch_frame();
-        it = mTouch->mPendingTouchPoints.insert(mTouch->mPendingTouchPoints.end(), QWindowSystemInterface::TouchPoint());
+        flushFrame();
+        it = mPendingTouchPoints.insert(mPendingTouchPoints.end(), QWindowSystemInterface::TouchPoint());
         it->id = id;
     }
 
     QWindowSystemInterface::TouchPoint &tp = *it;
 
-    // Only moved and pressed needs to update/set position
+    // Only moved and pressed needs to update/set position. It stays in surface coordinates
+    // until the frame is delivered, see handleFrame().
     if (state == QEventPoint::Updated || state == QEventPoint::Pressed) {
-        // We need a global (screen) position.
-        QWaylandWindow *win = mTouch->mFocus;
-
-        //is it possible that mTouchFocus is null;
-        if (!win && mPointer)
-            win = mPointer->focusWindow();
-        if (!win && mKeyboard)
-            win = mKeyboard->focusWindow();
-        if (!win || !win->window())
-            return;
-
         tp.area = QRectF(0, 0, 8, 8);
-        QPointF localPosition = win->mapFromWlSurface(surfacePosition);
-        // TODO: This doesn't account for high dpi scaling for the delta, but at least it matches
-        // what we have for mouse input.
-        QPointF delta = localPosition - localPosition.toPoint();
-        QPointF globalPosition = win->mapToGlobal(localPosition.toPoint()) + delta;
-        tp.area.moveCenter(globalPosition);
+        tp.area.moveCenter(surfacePosition);
     }
 
     // If the touch point was pressed earlier this frame, we don't want to overwrite its state.
@@ -1473,33 +1728,47 @@ bool QWaylandInputDevice::Touch::allTouchPointsReleased()
 
 void QWaylandInputDevice::Touch::releasePoints()
 {
+    QMutexLocker locker(pointsMutex());
     if (mPendingTouchPoints.empty())
         return;
 
     for (QWindowSystemInterface::TouchPoint &tp : mPendingTouchPoints)
         tp.state = QEventPoint::Released;
 
-    touch_frame();
+    flushFrame();
 }
 
 void QWaylandInputDevice::Touch::touch_frame()
 {
-    // TODO: early return if no events?
+    QMutexLocker locker(pointsMutex());
+    flushFrame();
+}
 
-    QWindow *window = mFocus ? mFocus->window() : nullptr;
+void QWaylandInputDevice::Touch::flushFrame()
+{
+    if (mPendingTouchPoints.isEmpty())
+        return;
 
-    if (mFocus) {
-        const QWindowSystemInterface::TouchPoint &tp = mPendingTouchPoints.last();
-        // When the touch event is received, the global pos is calculated with the margins
-        // in mind. Now we need to adjust again to get the correct local pos back.
-        QMargins margins = window->frameMargins();
-        QPoint p = tp.area.center().toPoint();
-        QPointF localPos(window->mapFromGlobal(QPoint(p.x() + margins.left(), p.y() + margins.top())));
-        if (mFocus->touchDragDecoration(mParent, localPos, tp.area.center(), tp.state, mParent->modifiers()))
-            return;
-    }
+    InputFrame frame;
+    frame.surface = mInputFocus;
+    frame.serial = mInputSerial;
+    frame.timestamp = mInputTimestamp;
+    frame.points = mPendingTouchPoints;
+    frame.modifiers = Qt::KeyboardModifiers::fromInt(mParent->mModifiers.loadRelaxed());
+
+    // Only the last positions of the same moving touch points end up in a QTouchEvent
+    const bool motion = std::all_of(frame.points.cbegin(), frame.points.cend(),
+                                    [](const QWindowSystemInterface::TouchPoint &tp) {
+        return tp.state == QEventPoint::Updated;
+    });
+    size_t motionKey = 0;
+    for (const auto &tp : std::as_const(frame.points))
+        motionKey = qHashMulti(motionKey, tp.id);
 
-    QWindowSystemInterface::handleTouchEvent(window, mParent->mTime, mParent->mTouchDevice, mPendingTouchPoints, mParent->modifiers());
+    mParent->postInputEvent([device = mParent, touch = this, frame] {
+        if (device->touch() == touch)
+            touch->handleFrame(frame);
+    }, motion ? InputEventKind::TouchMotion : InputEventKind::Event, motionKey);
 
     // Prepare state for next frame
     const auto prevTouchPoints = mPendingTouchPoints;
@@ -1512,7 +1781,57 @@ void QWaylandInputDevice::Touch::touch_frame()
             mPendingTouchPoints.append(tp);
         }
     }
+}
+
+// Delivers a frame assembled by flushFrame() on the GUI thread, where the touch points
+// can be mapped to global positions.
+void QWaylandInputDevice::Touch::handleFrame(const InputFrame &frame)
+{
+    QWaylandWindow *window = inputWindow(mParent->mQDisplay, frame.surface);
+
+    mParent->mTime = frame.timestamp;
+    const bool pressed = std::any_of(frame.points.cbegin(), frame.points.cend(),
+                                     [](const QWindowSystemInterface::TouchPoint &tp) {
+        return tp.state == QEventPoint::Pressed;
+    });
+    if (pressed && window) {
+        mParent->mSerial = frame.serial;
+        mParent->mQDisplay->setLastInputDevice(mParent, frame.serial, window);
+    }
+
+    // We need a global (screen) position. The last points are released after the focus is gone.
+    QWaylandWindow *win = window ? window : mFocus.data();
+    if (!win)
+        win = mParent->pointerFocus();
+    if (!win)
+        win = mParent->keyboardFocus();
+    mFocus = window;
+
+    QList<QWindowSystemInterface::TouchPoint> points = frame.points;
+    if (win && win->window()) {
+        for (QWindowSystemInterface::TouchPoint &tp : points) {
+            QPointF localPosition = win->mapFromWlSurface(tp.area.center());
+            // TODO: This doesn't account for high dpi scaling for the delta, but at least it matches
+            // what we have for mouse input.
+            QPointF delta = localPosition - localPosition.toPoint();
+            QPointF globalPosition = win->mapToGlobal(localPosition.toPoint()) + delta;
+            tp.area.moveCenter(globalPosition);
+        }
+    }
+
+    if (window) {
+        const QWindowSystemInterface::TouchPoint &tp = points.last();
+        // When the touch event is received, the global pos is calculated with the margins
+        // in mind. Now we need to adjust again to get the correct local pos back.
+        QMargins margins = window->window()->frameMargins();
+        QPoint p = tp.area.center().toPoint();
+        QPointF localPos(window->window()->mapFromGlobal(QPoint(p.x() + margins.left(), p.y() + margins.top())));
+        if (window->touchDragDecoration(mParent, localPos, tp.area.center(), tp.state, frame.modifiers))
+            return;
+    }
 
+    QWindowSystemInterface::handleTouchEvent(window ? window->window() : nullptr, frame.timestamp,
+                                             mParent->mTouchDevice, points, frame.modifiers);
 }
 
 }
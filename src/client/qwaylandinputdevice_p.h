@@ -35,8 +35,11 @@
 
 #include <QtCore/QDebug>
 #include <QtCore/QElapsedTimer>
+#include <QtCore/QMutex>
 #include <QtCore/QPointer>
 
+#include <functional>
+
 #if QT_CONFIG(cursor)
 struct wl_cursor_image;
 #endif
@@ -136,6 +139,8 @@ public:
     QWaylandPointerGesturePinch *pointerGesturePinch() const;
     Touch *touch() const;
 
+    void deliverInputEvents();
+
 protected:
     QWaylandDisplay *mQDisplay = nullptr;
     struct wl_display *mDisplay = nullptr;
@@ -176,8 +181,29 @@ protected:
     uint32_t mTime = 0;
     uint32_t mSerial = 0;
 
+    // Modifiers of the keyboard as last decoded, read from any thread
+    QAtomicInt mModifiers;
+
     void seat_capabilities(uint32_t caps) override;
-    void handleTouchPoint(int id, QEventPoint::State state, const QPointF &surfacePosition = QPoint());
+
+    enum class InputEventKind {
+        Event,
+        PointerMotion, // replaces a pointer motion right before it
+        TouchMotion // replaces a touch frame right before it that moved the same points
+    };
+    void postInputEvent(std::function<void()> deliver, InputEventKind kind = InputEventKind::Event,
+                        size_t motionKey = 0);
+    template <typename T>
+    void dropInputObject(QScopedPointer<T> &object);
+
+    struct PendingInputEvent {
+        std::function<void()> deliver;
+        InputEventKind kind = InputEventKind::Event;
+        size_t motionKey = 0;
+    };
+    QMutex mPendingInputMutex;
+    QList<PendingInputEvent> mPendingInputEvents; // guarded by mPendingInputMutex
+    bool mPendingInputScheduled = false; // guarded by mPendingInputMutex
 
     QPointingDevice *mTouchDevice = nullptr;
     QPointingDevice *mTouchPadDevice = nullptr;
@@ -202,6 +228,7 @@ class Q_WAYLANDCLIENT_EXPORT QWaylandInputDevice::Keyboard : public QObject, pub
 public:
     Keyboard(QWaylandInputDevice *p);
     ~Keyboard() override;
+    void destroyProxy();
 
     QWaylandWindow *focusWindow() const;
 
@@ -225,6 +252,7 @@ public:
     QWaylandInputDevice *mParent = nullptr;
     ::wl_surface *mFocus = nullptr;
 
+    // Only used where the wl_keyboard is dispatched
     uint32_t mNativeModifiers = 0;
 
     struct repeatKey {
@@ -241,6 +269,7 @@ public:
     int mRepeatRate = 25;
     int mRepeatDelay = 400;
 
+    // Only used where the wl_keyboard is dispatched
     uint32_t mKeymapFormat = WL_KEYBOARD_KEYMAP_FORMAT_XKB_V1;
 
     Qt::KeyboardModifiers modifiers() const;
@@ -258,17 +287,38 @@ private slots:
     void handleFocusLost();
 
 private:
+    // A wl_keyboard.key as translated with the keymap where the wl_keyboard is dispatched
+    struct KeyEvent {
+        uint32_t serial = 0;
+        ulong timestamp = 0;
+        QEvent::Type type = QEvent::None;
+        int key = 0;
+        Qt::KeyboardModifiers modifiers;
+        quint32 nativeScanCode = 0;
+        quint32 nativeVirtualKey = 0;
+        quint32 nativeModifiers = 0;
+        QString text;
+        bool startsRepeat = false;
+    };
+
 #if QT_CONFIG(xkbcommon)
     bool createDefaultKeymap();
 #endif
+    void updateModifiers();
+    void handleEnter(::wl_surface *surface);
+    void handleLeave(::wl_surface *surface);
+    void handleKeyEvent(const KeyEvent &event);
     void handleKey(ulong timestamp, QEvent::Type type, int key, Qt::KeyboardModifiers modifiers,
                    quint32 nativeScanCode, quint32 nativeVirtualKey, quint32 nativeModifiers,
                    const QString &text, bool autorepeat = false, ushort count = 1);
 
 #if QT_CONFIG(xkbcommon)
+    // Updated where the wl_keyboard is dispatched, also read on the GUI thread
+    mutable QMutex mXkbMutex;
     QXkbCommon::ScopedXKBKeymap mXkbKeymap;
     QXkbCommon::ScopedXKBState mXkbState;
 #endif
+    bool mProxyDestroyed = false;
     friend class QWaylandInputDevice;
 };
 
@@ -278,6 +328,7 @@ class Q_WAYLANDCLIENT_EXPORT QWaylandInputDevice::Pointer : public QObject, publ
 public:
     explicit Pointer(QWaylandInputDevice *seat);
     ~Pointer() override;
+    void destroyProxy();
     QWaylandWindow *focusWindow() const;
 #if QT_CONFIG(cursor)
     QString cursorThemeName() const;
@@ -339,9 +390,29 @@ public:
     Qt::CursorShape mCursorShape = Qt::BitmapCursor;
 #endif
 
+    // A wl_pointer event as decoded where the wl_pointer is dispatched. It is mapped to
+    // the focus window when it is delivered on the GUI thread.
+    struct InputEvent {
+        QEvent::Type type = QEvent::None;
+        ::wl_surface *surface = nullptr; // enter and leave only
+        uint32_t serial = 0;
+        ulong timestamp = 0;
+        QPointF surfacePos; // enter and motion only
+        Qt::MouseButton button = Qt::NoButton;
+        Qt::KeyboardModifiers modifiers;
+        Qt::ScrollPhase phase = Qt::NoScrollPhase;
+        QPoint pixelDelta;
+        QPoint angleDelta;
+        Qt::MouseEventSource source = Qt::MouseEventNotSynthesized;
+    };
+
+    // Only used where the wl_pointer is dispatched
+    ::wl_surface *mInputFocus = nullptr;
+
     struct FrameData {
-        QWaylandPointerEvent *event = nullptr;
+        InputEvent event;
 
+        ulong axisTimestamp = 0;
         QPointF delta;
         QPoint discreteDelta;
         axis_source axisSource = axis_source_wheel;
@@ -357,11 +428,15 @@ public:
     bool mScrollBeginSent = false;
     QPointF mScrollDeltaRemainder;
 
-    void setFrameEvent(QWaylandPointerEvent *event);
+    void setFrameEvent(const InputEvent &event);
+    void postEvent(const InputEvent &event);
     void flushScrollEvent();
     void flushFrameEvent();
+    void handleEvent(const InputEvent &event);
 private: //TODO: should other methods be private as well?
     bool isDefinitelyTerminated(axis_source source) const;
+
+    bool mProxyDestroyed = false;
 };
 
 class Q_WAYLANDCLIENT_EXPORT QWaylandInputDevice::Touch : public QtWayland::wl_touch
@@ -369,6 +444,7 @@ class Q_WAYLANDCLIENT_EXPORT QWaylandInputDevice::Touch : public QtWayland::wl_t
 public:
     Touch(QWaylandInputDevice *p);
     ~Touch() override;
+    void destroyProxy();
 
     void touch_down(uint32_t serial,
                     uint32_t time,
@@ -393,7 +469,31 @@ public:
 
     QWaylandInputDevice *mParent = nullptr;
     QPointer<QWaylandWindow> mFocus;
+
+    // The touch points as decoded where the wl_touch is dispatched, with their
+    // areas in surface coordinates. releasePoints() changes them on the GUI thread.
     QList<QWindowSystemInterface::TouchPoint> mPendingTouchPoints;
+
+private:
+    // A wl_touch.frame as decoded where the wl_touch is dispatched
+    struct InputFrame {
+        ::wl_surface *surface = nullptr;
+        uint32_t serial = 0; // of the last touch down
+        ulong timestamp = 0;
+        QList<QWindowSystemInterface::TouchPoint> points;
+        Qt::KeyboardModifiers modifiers;
+    };
+
+    QMutex *pointsMutex();
+    void handleTouchPoint(int id, QEventPoint::State state, const QPointF &surfacePosition = QPoint());
+    void flushFrame();
+    void handleFrame(const InputFrame &frame);
+
+    QMutex mPointsMutex;
+    ::wl_surface *mInputFocus = nullptr; // guarded by pointsMutex()
+    uint32_t mInputSerial = 0; // guarded by pointsMutex()
+    ulong mInputTimestamp = 0; // guarded by pointsMutex()
+    bool mProxyDestroyed = false;
 };
 
 class QWaylandPointerEvent
@@ -33,17 +33,62 @@ QWaylandPointerGestureSwipe::QWaylandPointerGestureSwipe(QWaylandInputDevice *p)
 
 QWaylandPointerGestureSwipe::~QWaylandPointerGestureSwipe()
 {
+    destroyProxy();
+}
+
+void QWaylandPointerGestureSwipe::destroyProxy()
+{
+    if (mProxyDestroyed)
+        return;
+    mProxyDestroyed = true;
     destroy();
 }
 
+// The gestures are dispatched along with the wl_pointer, see QWaylandInputDevice::postInputEvent()
 void QWaylandPointerGestureSwipe::zwp_pointer_gesture_swipe_v1_begin(uint32_t serial, uint32_t time,
                                                                      struct ::wl_surface *surface,
                                                                      uint32_t fingers)
 {
+#ifndef QT_NO_GESTURES
+    mParent->postInputEvent([device = mParent, swipe = this, serial, time, surface, fingers] {
+        if (device->pointerGestureSwipe() == swipe)
+            swipe->handleBegin(serial, time, device->mQDisplay->windowSurface(surface), fingers);
+    });
+#endif
+}
+
+void QWaylandPointerGestureSwipe::zwp_pointer_gesture_swipe_v1_update(uint32_t time,
+                                                                      wl_fixed_t dx, wl_fixed_t dy)
+{
+#ifndef QT_NO_GESTURES
+    const QPointF delta = QPointF(wl_fixed_to_double(dx), wl_fixed_to_double(dy));
+    mParent->postInputEvent([device = mParent, swipe = this, time, delta] {
+        if (device->pointerGestureSwipe() == swipe)
+            swipe->handleUpdate(time, delta);
+    });
+#endif
+}
+
+void QWaylandPointerGestureSwipe::zwp_pointer_gesture_swipe_v1_end(uint32_t serial, uint32_t time,
+                                                                   int32_t cancelled)
+{
+#ifndef QT_NO_GESTURES
+    mParent->postInputEvent([device = mParent, swipe = this, serial, time, cancelled] {
+        if (device->pointerGestureSwipe() == swipe)
+            swipe->handleEnd(serial, time, cancelled);
+    });
+#endif
+}
+
+void QWaylandPointerGestureSwipe::handleBegin(uint32_t serial, uint32_t time,
+                                              ::wl_surface *surface, uint32_t fingers)
+{
 #ifndef QT_NO_GESTURES
     mParent->mSerial = serial;
-    mFocus = QWaylandWindow::fromWlSurface(surface);
+    mFocus = surface ? QWaylandWindow::fromWlSurface(surface) : nullptr;
     mFingers = fingers;
+    if (!mFocus)
+        return;
 
     const auto* pointer = mParent->pointer();
 
@@ -58,13 +103,14 @@ void QWaylandPointerGestureSwipe::zwp_pointer_gesture_swipe_v1_begin(uint32_t se
 #endif
 }
 
-void QWaylandPointerGestureSwipe::zwp_pointer_gesture_swipe_v1_update(uint32_t time,
-                                                                      wl_fixed_t dx, wl_fixed_t dy)
+void QWaylandPointerGestureSwipe::handleUpdate(uint32_t time, const QPointF &delta)
 {
 #ifndef QT_NO_GESTURES
+    if (!mFocus)
+        return;
+
     const auto* pointer = mParent->pointer();
 
-    const QPointF delta = QPointF(wl_fixed_to_double(dx), wl_fixed_to_double(dy));
     qCDebug(lcQpaWaylandInput) << "zwp_pointer_gesture_swipe_v1_update @ "
                                << pointer->mSurfacePos << "delta" << delta;
 
@@ -75,11 +121,13 @@ void QWaylandPointerGestureSwipe::zwp_pointer_gesture_swipe_v1_update(uint32_t t
 #endif
 }
 
-void QWaylandPointerGestureSwipe::zwp_pointer_gesture_swipe_v1_end(uint32_t serial, uint32_t time,
-                                                                   int32_t cancelled)
+void QWaylandPointerGestureSwipe::handleEnd(uint32_t serial, uint32_t time, int32_t cancelled)
 {
 #ifndef QT_NO_GESTURES
     mParent->mSerial = serial;
+    if (!mFocus)
+        return;
+
     const auto* pointer = mParent->pointer();
 
     qCDebug(lcQpaWaylandInput) << "zwp_pointer_gesture_swipe_v1_end @ "
@@ -105,6 +153,14 @@ QWaylandPointerGesturePinch::QWaylandPointerGesturePinch(QWaylandInputDevice *p)
 
 QWaylandPointerGesturePinch::~QWaylandPointerGesturePinch()
 {
+    destroyProxy();
+}
+
+void QWaylandPointerGesturePinch::destroyProxy()
+{
+    if (mProxyDestroyed)
+        return;
+    mProxyDestroyed = true;
     destroy();
 }
 
@@ -112,11 +168,51 @@ void QWaylandPointerGesturePinch::zwp_pointer_gesture_pinch_v1_begin(uint32_t se
                                                                      struct ::wl_surface *surface,
                                                                      uint32_t fingers)
 {
+#ifndef QT_NO_GESTURES
+    mParent->postInputEvent([device = mParent, pinch = this, serial, time, surface, fingers] {
+        if (device->pointerGesturePinch() == pinch)
+            pinch->handleBegin(serial, time, device->mQDisplay->windowSurface(surface), fingers);
+    });
+#endif
+}
+
+void QWaylandPointerGesturePinch::zwp_pointer_gesture_pinch_v1_update(uint32_t time,
+                                                                      wl_fixed_t dx, wl_fixed_t dy,
+                                                                      wl_fixed_t scale,
+                                                                      wl_fixed_t rotation)
+{
+#ifndef QT_NO_GESTURES
+    const QPointF delta = QPointF(wl_fixed_to_double(dx), wl_fixed_to_double(dy));
+    const qreal rscale = wl_fixed_to_double(scale);
+    const qreal rot = wl_fixed_to_double(rotation);
+    mParent->postInputEvent([device = mParent, pinch = this, time, delta, rscale, rot] {
+        if (device->pointerGesturePinch() == pinch)
+            pinch->handleUpdate(time, delta, rscale, rot);
+    });
+#endif
+}
+
+void QWaylandPointerGesturePinch::zwp_pointer_gesture_pinch_v1_end(uint32_t serial, uint32_t time,
+                                                                   int32_t cancelled)
+{
+#ifndef QT_NO_GESTURES
+    mParent->postInputEvent([device = mParent, pinch = this, serial, time, cancelled] {
+        if (device->pointerGesturePinch() == pinch)
+            pinch->handleEnd(serial, time, cancelled);
+    });
+#endif
+}
+
+void QWaylandPointerGesturePinch::handleBegin(uint32_t serial, uint32_t time,
+                                              ::wl_surface *surface, uint32_t fingers)
+{
 #ifndef QT_NO_GESTURES
     mParent->mSerial = serial;
-    mFocus = QWaylandWindow::fromWlSurface(surface);
+    mFocus = surface ? QWaylandWindow::fromWlSurface(surface) : nullptr;
     mFingers = fingers;
     mLastScale = 1;
+    if (!mFocus)
+        return;
 
     const auto* pointer = mParent->pointer();
 
@@ -131,37 +227,37 @@ void QWaylandPointerGesturePinch::zwp_pointer_gesture_pinch_v1_begin(uint32_t se
 #endif
 }
 
-void QWaylandPointerGesturePinch::zwp_pointer_gesture_pinch_v1_update(uint32_t time,
-                                                                      wl_fixed_t dx, wl_fixed_t dy,
-                                                                      wl_fixed_t scale,
-                                                                      wl_fixed_t rotation)
+void QWaylandPointerGesturePinch::handleUpdate(uint32_t time, const QPointF &delta,
+                                               qreal scale, qreal rotation)
 {
 #ifndef QT_NO_GESTURES
+    if (!mFocus)
+        return;
+
     const auto* pointer = mParent->pointer();
 
-    const qreal rscale = wl_fixed_to_double(scale);
-    const qreal rot = wl_fixed_to_double(rotation);
-    const QPointF delta = QPointF(wl_fixed_to_double(dx), wl_fixed_to_double(dy));
     qCDebug(lcQpaWaylandInput) << "zwp_pointer_gesture_pinch_v1_update @ "
                                << pointer->mSurfacePos << "delta" << delta
-                               << "scale" << mLastScale << "->" << rscale
-                               << "delta" << rscale - mLastScale << "rot" << rot;
+                               << "scale" << mLastScale << "->" << scale
+                               << "delta" << scale - mLastScale << "rot" << rotation;
 
     auto e = QWaylandPointerGesturePinchEvent(mFocus, Qt::GestureUpdated, time,
                                               pointer->mSurfacePos, pointer->mGlobalPos, mFingers,
-                                              delta, rscale - mLastScale, rot);
+                                              delta, scale - mLastScale, rotation);
 
     mFocus->handlePinchGesture(mParent, e);
 
-    mLastScale = rscale;
+    mLastScale = scale;
 #endif
 }
 
-void QWaylandPointerGesturePinch::zwp_pointer_gesture_pinch_v1_end(uint32_t serial, uint32_t time,
-                                                                   int32_t cancelled)
+void QWaylandPointerGesturePinch::handleEnd(uint32_t serial, uint32_t time, int32_t cancelled)
 {
 #ifndef QT_NO_GESTURES
     mParent->mSerial = serial;
+    if (!mFocus)
+        return;
+
     const auto* pointer = mParent->pointer();
 
     qCDebug(lcQpaWaylandInput) << "zwp_pointer_gesture_swipe_v1_end @ "
@@ -20,6 +20,7 @@
 #include <QtWaylandClient/private/qtwaylandclientglobal_p.h>
 
 #include <QtCore/QObject>
+#include <QtCore/QPointF>
 #include <QtCore/QPointer>
 
 QT_BEGIN_NAMESPACE
@@ -47,6 +48,7 @@ class Q_WAYLANDCLIENT_EXPORT QWaylandPointerGestureSwipe :
 public:
     QWaylandPointerGestureSwipe(QWaylandInputDevice *p);
     ~QWaylandPointerGestureSwipe() override;
+    void destroyProxy();
 
     void zwp_pointer_gesture_swipe_v1_begin(uint32_t serial,
                                             uint32_t time,
@@ -69,6 +71,13 @@ public:
     QWaylandInputDevice *mParent = nullptr;
     QPointer<QWaylandWindow> mFocus;
     uint mFingers = 0;
+
+private:
+    void handleBegin(uint32_t serial, uint32_t time, ::wl_surface *surface, uint32_t fingers);
+    void handleUpdate(uint32_t time, const QPointF &delta);
+    void handleEnd(uint32_t serial, uint32_t time, int32_t cancelled);
+
+    bool mProxyDestroyed = false;
 };
 
 class Q_WAYLANDCLIENT_EXPORT QWaylandPointerGesturePinch :
@@ -77,6 +86,7 @@ class Q_WAYLANDCLIENT_EXPORT QWaylandPointerGesturePinch :
 public:
     QWaylandPointerGesturePinch(QWaylandInputDevice *p);
     ~QWaylandPointerGesturePinch() override;
+    void destroyProxy();
 
     void zwp_pointer_gesture_pinch_v1_begin(uint32_t serial,
                                             uint32_t time,
@@ -105,6 +115,13 @@ public:
     // We need to convert between absolute scale provided by wayland/libinput and zoom deltas
     // that Qt expects. This stores the scale of the last pinch event or 1.0 if there was none.
     qreal mLastScale = 1;
+
+private:
+    void handleBegin(uint32_t serial, uint32_t time, ::wl_surface *surface, uint32_t fingers);
+    void handleUpdate(uint32_t time, const QPointF &delta, qreal scale, qreal rotation);
+    void handleEnd(uint32_t serial, uint32_t time, int32_t cancelled);
+
+    bool mProxyDestroyed = false;
 };
 
 } // namespace QtWaylandClient
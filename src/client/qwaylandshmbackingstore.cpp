@@ -288,38 +288,13 @@ void QWaylandShmBackingStore::updateDecorations()
 {
     QPainter decorationPainter(entireSurface());
     decorationPainter.setCompositionMode(QPainter::CompositionMode_Source);
-    QImage sourceImage = windowDecoration()->contentImage();
-
-    qreal dp = sourceImage.devicePixelRatio();
-    int dpWidth = int(sourceImage.width() / dp);
-    int dpHeight = int(sourceImage.height() / dp);
-    QTransform sourceMatrix;
-    sourceMatrix.scale(dp, dp);
-    QRect target; // needs to be in device independent pixels
-
-    //Top
-    target.setX(0);
-    target.setY(0);
-    target.setWidth(dpWidth);
-    target.setHeight(windowDecorationMargins().top());
-    decorationPainter.drawImage(target, sourceImage, sourceMatrix.mapRect(target));
-
-    //Left
-    target.setWidth(windowDecorationMargins().left());
-    target.setHeight(dpHeight);
-    decorationPainter.drawImage(target, sourceImage, sourceMatrix.mapRect(target));
-
-    //Right
-    target.setX(dpWidth - windowDecorationMargins().right());
-    target.setWidth(windowDecorationMargins().right());
-    decorationPainter.drawImage(target, sourceImage, sourceMatrix.mapRect(target));
-
-    //Bottom
-    target.setX(0);
-    target.setY(dpHeight - windowDecorationMargins().bottom());
-    target.setWidth(dpWidth);
-    target.setHeight(windowDecorationMargins().bottom());
-    decorationPainter.drawImage(target, sourceImage, sourceMatrix.mapRect(target));
+
+    QWaylandAbstractDecoration *decoration = windowDecoration();
+    for (Qt::Edge edge : { Qt::TopEdge, Qt::LeftEdge, Qt::RightEdge, Qt::BottomEdge }) {
+        const QImage &edgeImage = decoration->edgeImage(edge);
+        if (!edgeImage.isNull())
+            decorationPainter.drawImage(decoration->edgeRect(edge), edgeImage);
+    }
 }
 
 QWaylandAbstractDecoration *QWaylandShmBackingStore::windowDecoration() const
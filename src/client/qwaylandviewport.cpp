@@ -0,0 +1,43 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qwaylandviewport_p.h"
+
+QT_BEGIN_NAMESPACE
+
+namespace QtWaylandClient {
+
+QWaylandViewport::QWaylandViewport(::wp_viewport *viewport)
+    : QtWayland::wp_viewport(viewport)
+{
+}
+
+QWaylandViewport::~QWaylandViewport()
+{
+    destroy();
+}
+
+// An empty or invalid rectangle unsets the source, i.e. the whole buffer is used
+void QWaylandViewport::setSource(const QRectF &source)
+{
+    const QRectF effective = source.isValid() ? source : QRectF(-1, -1, -1, -1);
+    if (effective == m_source)
+        return;
+    m_source = effective;
+    set_source(wl_fixed_from_double(effective.x()), wl_fixed_from_double(effective.y()),
+               wl_fixed_from_double(effective.width()), wl_fixed_from_double(effective.height()));
+}
+
+// An empty size unsets the destination, i.e. the surface size follows the source or buffer
+void QWaylandViewport::setDestination(const QSize &destination)
+{
+    const QSize effective = destination.isEmpty() ? QSize(-1, -1) : destination;
+    if (effective == m_destination)
+        return;
+    m_destination = effective;
+    set_destination(effective.width(), effective.height());
+}
+
+}
+
+QT_END_NAMESPACE
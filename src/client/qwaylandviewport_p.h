@@ -0,0 +1,46 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QWAYLANDVIEWPORT_P_H
+#define QWAYLANDVIEWPORT_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtWaylandClient/qtwaylandclientglobal.h>
+#include <QtWaylandClient/private/qwayland-viewporter.h>
+
+#include <QtCore/QRectF>
+#include <QtCore/QSize>
+
+QT_BEGIN_NAMESPACE
+
+namespace QtWaylandClient {
+
+class Q_WAYLANDCLIENT_EXPORT QWaylandViewport : public QtWayland::wp_viewport
+{
+public:
+    explicit QWaylandViewport(::wp_viewport *viewport);
+    ~QWaylandViewport() override;
+
+    void setSource(const QRectF &source);
+    void setDestination(const QSize &destination);
+
+private:
+    QRectF m_source = QRectF(-1, -1, -1, -1);
+    QSize m_destination = QSize(-1, -1);
+};
+
+}
+
+QT_END_NAMESPACE
+
+#endif // QWAYLANDVIEWPORT_P_H
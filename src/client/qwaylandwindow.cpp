@@ -10,6 +10,8 @@
 #include "qwaylandscreen_p.h"
 #include "qwaylandshellsurface_p.h"
 #include "qwaylandsubsurface_p.h"
+#include "qwaylandviewport_p.h"
+#include "qwaylandfractionalscale_p.h"
 #include "qwaylandabstractdecoration_p.h"
 #include "qwaylandwindowmanagerintegration_p.h"
 #include "qwaylandnativeinterface_p.h"
@@ -26,6 +28,8 @@
 #include <qpa/qwindowsysteminterface.h>
 #include <QtGui/private/qwindow_p.h>
 
+#include <QtWaylandClient/private/qwayland-fractional-scale-v1.h>
+
 #include <QtCore/QDebug>
 #include <QtCore/QThread>
 
@@ -55,6 +59,9 @@ QWaylandWindow::QWaylandWindow(QWindow *window, QWaylandDisplay *display)
     static WId id = 1;
     mWindowId = id++;
     initializeWlSurface();
+
+    mFrameQueue = wl_display_create_queue(mDisplay->wl_display());
+    mDisplay->addWindow(this);
 }
 
 QWaylandWindow::~QWaylandWindow()
@@ -64,6 +71,9 @@ QWaylandWindow::~QWaylandWindow()
     if (mSurface)
         reset();
 
+    mDisplay->removeWindow(this);
+    wl_event_queue_destroy(mFrameQueue);
+
     const QWindow *parent = window();
     const auto tlw = QGuiApplication::topLevelWindows();
     for (QWindow *w : tlw) {
@@ -149,8 +159,10 @@ void QWaylandWindow::initWindow()
     // Enable high-dpi rendering. Scale() returns the screen scale factor and will
     // typically be integer 1 (normal-dpi) or 2 (high-dpi). Call set_buffer_scale()
     // to inform the compositor that high-resolution buffers will be provided.
-    if (mSurface->version() >= 3)
-        mSurface->set_buffer_scale(mScale);
+    // If the window uses a viewport, the buffer scale is 1 and the viewport
+    // destination maps the buffer to the surface size instead.
+    updateViewport();
+    updateBufferScale();
 
     setWindowFlags(window()->flags());
     QRect geometry = windowGeometry();
@@ -178,6 +190,18 @@ void QWaylandWindow::initializeWlSurface()
                 this, &QWaylandWindow::handleScreensChanged);
         mSurface->m_window = this;
     }
+
+    // Fractional scales are presented through a viewport. Only use them if the application
+    // doesn't ask for device pixel ratios to be rounded to integers.
+    if (mDisplay->fractionalScaleManager() && mDisplay->viewporter()
+            && QGuiApplication::highDpiScaleFactorRoundingPolicy() == Qt::HighDpiScaleFactorRoundingPolicy::PassThrough) {
+        mFractionalScale.reset(new QWaylandFractionalScale(
+                mDisplay->fractionalScaleManager()->get_fractional_scale(mSurface->object())));
+        connect(mFractionalScale.data(), &QWaylandFractionalScale::preferredScaleChanged,
+                this, &QWaylandWindow::handleFractionalScaleChanged);
+    }
+
+    updateViewport();
     emit wlSurfaceCreated();
 }
 
@@ -225,6 +249,8 @@ void QWaylandWindow::reset()
         emit wlSurfaceDestroyed();
         QWriteLocker lock(&mSurfaceLock);
         invalidateSurface();
+        mFractionalScale.reset();
+        mViewport.reset();
         mSurface.reset();
     }
 
@@ -357,6 +383,9 @@ void QWaylandWindow::setGeometry(const QRect &r)
     if (isExposed() && !mInResizeFromApplyConfigure && exposeGeometry != mLastExposeGeometry)
         sendExposeEvent(exposeGeometry);
 
+    if (mViewport)
+        updateViewport();
+
     if (mShellSurface && isExposed()) {
         mShellSurface->setWindowGeometry(windowContentGeometry());
         if (!qt_window_private(window())->positionAutomatic)
@@ -680,7 +709,6 @@ void QWaylandWindow::handleFrameCallback()
         // in the single-threaded case.
         QMetaObject::invokeMethod(this, &QWaylandWindow::doHandleFrameCallback, Qt::QueuedConnection);
     }
-    mFrameSyncWait.notify_all();
 }
 
 void QWaylandWindow::doHandleFrameCallback()
@@ -695,12 +723,22 @@ void QWaylandWindow::doHandleFrameCallback()
 
 }
 
+// Called from the render thread, which dispatches the window's frame event
+// queue itself while waiting, so that it doesn't depend on any other thread.
 bool QWaylandWindow::waitForFrameSync(int timeout)
 {
+    QDeadlineTimer deadline(timeout);
+    QMutexLocker queueLocker(&mFrameQueueMutex);
     QMutexLocker locker(&mFrameSyncMutex);
 
-    QDeadlineTimer deadline(timeout);
-    while (mWaitingForFrameCallback && mFrameSyncWait.wait(&mFrameSyncMutex, deadline)) { }
+    while (mWaitingForFrameCallback) {
+        locker.unlock();
+        mDisplay->dispatchQueue(mFrameQueue, deadline);
+        locker.relock();
+        if (deadline.hasExpired())
+            break;
+    }
+    queueLocker.unlock();
 
     if (mWaitingForFrameCallback) {
         qCDebug(lcWaylandBackingstore) << "Didn't receive frame callback in time, window should now be inexposed";
@@ -712,6 +750,17 @@ bool QWaylandWindow::waitForFrameSync(int timeout)
     return !mWaitingForFrameCallback;
 }
 
+// Dispatches frame callbacks that arrived while no thread was waiting for them
+void QWaylandWindow::dispatchFrameEvents()
+{
+    // A thread in waitForFrameSync() is already dispatching them
+    if (!mFrameQueueMutex.tryLock())
+        return;
+
+    wl_display_dispatch_queue_pending(mDisplay->wl_display(), mFrameQueue);
+    mFrameQueueMutex.unlock();
+}
+
 QMargins QWaylandWindow::frameMargins() const
 {
     if (mWindowDecorationEnabled)
@@ -1234,8 +1283,9 @@ void QWaylandWindow::handleScreensChanged()
     int scale = newScreen->isPlaceholder() ? 1 : static_cast<QWaylandScreen *>(newScreen)->scale();
     if (scale != mScale) {
         mScale = scale;
-        if (mSurface && mSurface->version() >= 3)
-            mSurface->set_buffer_scale(mScale);
+        updateBufferScale();
+        if (mViewport)
+            updateViewport();
         ensureSize();
     }
 }
@@ -1243,7 +1293,7 @@ void QWaylandWindow::handleScreensChanged()
 #if QT_CONFIG(cursor)
 void QWaylandWindow::setMouseCursor(QWaylandInputDevice *device, const QCursor &cursor)
 {
-    int fallbackBufferScale = int(devicePixelRatio());
+    int fallbackBufferScale = qCeil(devicePixelRatio());
     device->setCursor(&cursor, {}, fallbackBufferScale);
 }
 
@@ -1291,9 +1341,110 @@ qreal QWaylandWindow::scale() const
 
 qreal QWaylandWindow::devicePixelRatio() const
 {
+    if (!mViewport)
+        return qreal(mScale);
+    const qreal scale = preferredScale();
+    return mViewportBufferScale > 0 ? scale * mViewportBufferScale : scale;
+}
+
+// The fractional scale preferred by the compositor if there is one, the integer
+// scale of the screen otherwise
+qreal QWaylandWindow::preferredScale() const
+{
+    if (mFractionalScale && mFractionalScale->preferredScale() > 0)
+        return mFractionalScale->preferredScale();
     return qreal(mScale);
 }
 
+void QWaylandWindow::updateBufferScale()
+{
+    if (mSurface && mSurface->version() >= 3)
+        mSurface->set_buffer_scale(mViewport ? 1 : mScale);
+}
+
+/*!
+    Creates or destroys the wp_viewport of this window depending on the preferred fractional
+    scale and the viewport window properties, and updates its source and destination.
+
+    Once the compositor has sent a preferred fractional scale, the window renders at exactly
+    that scale and the viewport maps the buffer to the surface size.
+
+    The "viewportBufferScale" property (qreal) makes the window render into a buffer which is
+    this factor of the normal buffer size, e.g. 0.5 for a buffer with a quarter of the pixels.
+    The compositor scales it back up to the window size. The "viewportSource" property (QRectF,
+    in surface coordinates) crops the buffer, and the cropped part is scaled to fill the window.
+*/
+void QWaylandWindow::updateViewport()
+{
+    const bool fractional = mFractionalScale && mFractionalScale->preferredScale() > 0;
+    const bool needed = fractional || mViewportBufferScale > 0 || mViewportSource.isValid();
+    if (!needed || !mSurface) {
+        mViewport.reset();
+        return;
+    }
+
+    if (!mViewport) {
+        if (!mDisplay->viewporter())
+            return;
+        mViewport.reset(new QWaylandViewport(mDisplay->createViewport(this)));
+    }
+
+    const qreal bufferScale = devicePixelRatio();
+    const QRectF source = mViewportSource;
+    mViewport->setSource(QRectF(source.topLeft() * bufferScale, source.size() * bufferScale));
+    if (!surfaceSize().isEmpty())
+        mViewport->setDestination(surfaceSize());
+}
+
+bool QWaylandWindow::handleViewportProperty(const QString &name, const QVariant &value)
+{
+    if (name == QLatin1String("viewportBufferScale")) {
+        bool ok = false;
+        qreal bufferScale = value.toReal(&ok);
+        if (!ok || bufferScale <= 0)
+            bufferScale = 0;
+        if (qFuzzyCompare(bufferScale, mViewportBufferScale))
+            return true;
+        mViewportBufferScale = bufferScale;
+    } else if (name == QLatin1String("viewportSource")) {
+        const QRectF source = value.toRectF();
+        if (source == mViewportSource)
+            return true;
+        mViewportSource = source;
+    } else {
+        return false;
+    }
+
+    if (!mDisplay->viewporter())
+        qCDebug(lcQpaWayland) << "wp_viewporter is not supported by the compositor, ignoring" << name;
+    handleScaleChange();
+    return true;
+}
+
+void QWaylandWindow::handleFractionalScaleChanged()
+{
+    qCDebug(lcQpaWayland) << "Preferred fractional scale of" << window() << "changed to"
+                          << mFractionalScale->preferredScale();
+    handleScaleChange();
+}
+
+// Called when the device pixel ratio may have changed because of the viewport or the
+// preferred scale
+void QWaylandWindow::handleScaleChange()
+{
+    const bool hadViewport = !mViewport.isNull();
+    updateViewport();
+    if (hadViewport != !mViewport.isNull())
+        updateBufferScale();
+
+    ensureSize();
+    if (isExposed()) {
+        // redraw at the new buffer size
+        window()->requestUpdate();
+        sendExposeEvent(QRect(QPoint(), geometry().size()));
+    }
+}
+
 bool QWaylandWindow::setMouseGrabEnabled(bool grab)
 {
     if (window()->type() != Qt::Popup) {
@@ -1336,6 +1487,8 @@ void QWaylandWindow::sendProperty(const QString &name, const QVariant &value)
     QWaylandNativeInterface *nativeInterface = static_cast<QWaylandNativeInterface *>(
                 QGuiApplication::platformNativeInterface());
     nativeInterface->emitWindowPropertyChanged(this, name);
+    if (handleViewportProperty(name, value))
+        return;
     if (mShellSurface)
         mShellSurface->sendProperty(name, value);
 }
@@ -1434,7 +1587,7 @@ void QWaylandWindow::handleUpdate()
     QMutexLocker locker(&mFrameSyncMutex);
 
     struct ::wl_surface *wrappedSurface = reinterpret_cast<struct ::wl_surface *>(wl_proxy_create_wrapper(mSurface->object()));
-    wl_proxy_set_queue(reinterpret_cast<wl_proxy *>(wrappedSurface), mDisplay->frameEventQueue());
+    wl_proxy_set_queue(reinterpret_cast<wl_proxy *>(wrappedSurface), mFrameQueue);
     mFrameCallback = wl_surface_frame(wrappedSurface);
     wl_proxy_wrapper_destroy(wrappedSurface);
     wl_callback_add_listener(mFrameCallback, &QWaylandWindow::callbackListener, this);
@@ -45,6 +45,8 @@ class QWaylandDisplay;
 class QWaylandBuffer;
 class QWaylandShellSurface;
 class QWaylandSubSurface;
+class QWaylandViewport;
+class QWaylandFractionalScale;
 class QWaylandAbstractDecoration;
 class QWaylandInputDevice;
 class QWaylandScreen;
@@ -110,6 +112,7 @@ public:
     void commit();
 
     bool waitForFrameSync(int timeout);
+    void dispatchFrameEvents();
 
     QMargins frameMargins() const override;
     QMargins customMargins() const;
@@ -145,6 +148,7 @@ public:
 
     qreal scale() const;
     qreal devicePixelRatio() const override;
+    QWaylandViewport *viewport() const { return mViewport.data(); }
 
     void requestActivateWindow() override;
     bool isExposed() const override;
@@ -230,6 +234,8 @@ protected:
     // mSurface can be written by the main thread. Other threads should claim a read lock for access
     mutable QReadWriteLock mSurfaceLock;
     QScopedPointer<QWaylandSurface> mSurface;
+    QScopedPointer<QWaylandViewport> mViewport;
+    QScopedPointer<QWaylandFractionalScale> mFractionalScale;
 
     QWaylandShellSurface *mShellSurface = nullptr;
     QWaylandSubSurface *mSubSurfaceWindow = nullptr;
@@ -265,7 +271,9 @@ protected:
     QElapsedTimer mFrameCallbackElapsedTimer;
     struct ::wl_callback *mFrameCallback = nullptr;
     QMutex mFrameSyncMutex;
-    QWaitCondition mFrameSyncWait;
+    // Only frame callbacks go through it. Held by whoever dispatches it.
+    struct ::wl_event_queue *mFrameQueue = nullptr;
+    QMutex mFrameQueueMutex;
 
     // True when we have called deliverRequestUpdate, but the client has not yet attached a new buffer
     bool mWaitingForUpdate = false;
@@ -281,6 +289,9 @@ protected:
     bool mSentInitialResize = false;
     QPoint mOffset;
     int mScale = 1;
+    // Set through the "viewportBufferScale" and "viewportSource" window properties
+    qreal mViewportBufferScale = 0;
+    QRectF mViewportSource;
     QPlatformScreen *mLastReportedScreen = nullptr;
 
     QIcon mWindowIcon;
@@ -314,6 +325,12 @@ private:
     void handleMouseEventWithDecoration(QWaylandInputDevice *inputDevice, const QWaylandPointerEvent &e);
     void handleScreensChanged();
     void sendRecursiveExposeEvent();
+    bool handleViewportProperty(const QString &name, const QVariant &value);
+    void handleFractionalScaleChanged();
+    void handleScaleChange();
+    qreal preferredScale() const;
+    void updateViewport();
+    void updateBufferScale();
 
     bool mInResizeFromApplyConfigure = false;
     bool lastVisible = false;
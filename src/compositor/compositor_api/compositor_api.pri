@@ -21,12 +21,14 @@ HEADERS += \
     compositor_api/qwaylandoutputmode.h \
     compositor_api/qwaylandoutputmode_p.h \
     compositor_api/qwaylandbufferref.h \
+    compositor_api/qwaylandbufferref_p.h \
     compositor_api/qwaylanddestroylistener.h \
     compositor_api/qwaylanddestroylistener_p.h \
     compositor_api/qwaylandview.h \
     compositor_api/qwaylandview_p.h \
     compositor_api/qwaylandresource.h \
     compositor_api/qwaylandsurfacegrabber.h \
+    compositor_api/qwaylandsurfacegrabber_p.h \
     compositor_api/qwaylandoutputmode_p.h
 
 SOURCES += \
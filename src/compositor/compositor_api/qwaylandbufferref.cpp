@@ -5,7 +5,7 @@
 #include <QAtomicInt>
 
 #include "qwaylandbufferref.h"
-#include "wayland_wrapper/qwlclientbuffer_p.h"
+#include "qwaylandbufferref_p.h"
 
 #include <type_traits>
 
@@ -35,16 +35,6 @@ CHECK(, const);
 #undef CHECK2
 #undef CHECK1
 
-class QWaylandBufferRefPrivate
-{
-public:
-    QtWayland::ClientBuffer *buffer = nullptr;
-
-    bool nullOrDestroyed() {
-        return !buffer || buffer->isDestroyed();
-    }
-};
-
 /*!
  * \class QWaylandBufferRef
  * \inmodule QtWaylandCompositor
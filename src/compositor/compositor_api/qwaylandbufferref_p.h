@@ -0,0 +1,37 @@
+// Copyright (C) 2017 Jolla Ltd, author: <giulio.camuffo@jollamobile.com>
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#ifndef QWAYLANDBUFFERREF_P_H
+#define QWAYLANDBUFFERREF_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtWaylandCompositor/qwaylandbufferref.h>
+#include <QtWaylandCompositor/private/qwlclientbuffer_p.h>
+
+QT_BEGIN_NAMESPACE
+
+class Q_WAYLANDCOMPOSITOR_EXPORT QWaylandBufferRefPrivate
+{
+public:
+    static QtWayland::ClientBuffer *get(const QWaylandBufferRef &ref) { return ref.d->buffer; }
+
+    QtWayland::ClientBuffer *buffer = nullptr;
+
+    bool nullOrDestroyed() {
+        return !buffer || buffer->isDestroyed();
+    }
+};
+
+QT_END_NAMESPACE
+
+#endif // QWAYLANDBUFFERREF_P_H
@@ -18,6 +18,7 @@
 
 #include <QtWaylandCompositor/private/qwaylandkeyboard_p.h>
 #include <QtWaylandCompositor/private/qwaylandsurface_p.h>
+#include <QtWaylandCompositor/private/qwaylandsurfacegrabber_p.h>
 
 #if QT_CONFIG(wayland_datadevice)
 #include "wayland_wrapper/qwldatadevice_p.h"
@@ -357,16 +358,18 @@ void SharedMemoryClientBufferIntegration::initializeHardware(wl_display *)
 QtWayland::ClientBuffer *SharedMemoryClientBufferIntegration::createBufferFor(wl_resource *buffer)
 {
     if (wl_shm_buffer_get(buffer))
-        return new QtWayland::SharedMemoryBuffer(buffer);
+        return new QtWayland::SharedMemoryBuffer(buffer, compositor());
     return nullptr;
 }
 
 void QWaylandCompositorPrivate::initializeHardwareIntegration()
 {
-    client_buffer_integrations.prepend(new SharedMemoryClientBufferIntegration); // TODO: clean up the opengl dependency
+    Q_Q(QWaylandCompositor);
+    auto *shmIntegration = new SharedMemoryClientBufferIntegration;
+    shmIntegration->setCompositor(q);
+    client_buffer_integrations.prepend(shmIntegration); // TODO: clean up the opengl dependency
 
 #if QT_CONFIG(opengl)
-    Q_Q(QWaylandCompositor);
     if (use_hw_integration_extension)
         hw_integration.reset(new QtWayland::HardwareIntegration(q));
 
@@ -898,6 +901,90 @@ bool QWaylandCompositor::retainedSelectionEnabled() const
     return d->retainSelection;
 }
 
+/*!
+ * \qmlproperty int QtWaylandCompositor::WaylandCompositor::retainedSelectionMaximumSize
+ *
+ * This property holds how many bytes of a selection are retained at most,
+ * summed up over all its MIME types.
+ *
+ * Text types are retained first, then images and then all other types. A type
+ * that would exceed the limit is not retained, and is not offered once the
+ * client that set the selection is gone. The default is \c 0, which means
+ * there is no limit.
+ *
+ * \sa retainedSelection, retainedSelectionMaximumTypeSize
+ * \since 6.5
+ */
+
+/*!
+ * \property QWaylandCompositor::retainedSelectionMaximumSize
+ *
+ * This property holds how many bytes of a selection are retained at most,
+ * summed up over all its MIME types.
+ *
+ * Text types are retained first, then images and then all other types. A type
+ * that would exceed the limit is not retained, and is not offered once the
+ * client that set the selection is gone. The default is \c 0, which means
+ * there is no limit.
+ *
+ * \sa retainedSelection, retainedSelectionMaximumTypeSize
+ * \since 6.5
+ */
+qint64 QWaylandCompositor::retainedSelectionMaximumSize() const
+{
+    Q_D(const QWaylandCompositor);
+    return d->retainedSelectionMaximumSize;
+}
+
+void QWaylandCompositor::setRetainedSelectionMaximumSize(qint64 bytes)
+{
+    Q_D(QWaylandCompositor);
+    bytes = qMax<qint64>(bytes, 0);
+    if (d->retainedSelectionMaximumSize == bytes)
+        return;
+
+    d->retainedSelectionMaximumSize = bytes;
+    emit retainedSelectionMaximumSizeChanged();
+}
+
+/*!
+ * \qmlproperty int QtWaylandCompositor::WaylandCompositor::retainedSelectionMaximumTypeSize
+ *
+ * This property holds how many bytes of a single MIME type of a selection are
+ * retained at most. A larger type is not retained. The default is \c 0, which
+ * means there is no limit.
+ *
+ * \sa retainedSelection, retainedSelectionMaximumSize
+ * \since 6.5
+ */
+
+/*!
+ * \property QWaylandCompositor::retainedSelectionMaximumTypeSize
+ *
+ * This property holds how many bytes of a single MIME type of a selection are
+ * retained at most. A larger type is not retained. The default is \c 0, which
+ * means there is no limit.
+ *
+ * \sa retainedSelection, retainedSelectionMaximumSize
+ * \since 6.5
+ */
+qint64 QWaylandCompositor::retainedSelectionMaximumTypeSize() const
+{
+    Q_D(const QWaylandCompositor);
+    return d->retainedSelectionMaximumTypeSize;
+}
+
+void QWaylandCompositor::setRetainedSelectionMaximumTypeSize(qint64 bytes)
+{
+    Q_D(QWaylandCompositor);
+    bytes = qMax<qint64>(bytes, 0);
+    if (d->retainedSelectionMaximumTypeSize == bytes)
+        return;
+
+    d->retainedSelectionMaximumTypeSize = bytes;
+    emit retainedSelectionMaximumTypeSizeChanged();
+}
+
 /*!
  * \internal
  */
@@ -1000,10 +1087,55 @@ void QWaylandCompositor::setUseHardwareIntegrationExtension(bool use)
  * to implement custom logic.
  * The default implementation only grabs shared memory and OpenGL buffers, reimplement this in your
  * compositor subclass to handle more buffer types.
+ * For a \l {QWaylandSurfaceGrabber::setStreaming()}{streaming} grabber, the read back of
+ * OpenGL buffers is asynchronous where possible. As there is no render loop to come back to,
+ * such a frame is delivered when the next grab is requested.
  * \note You should not call this manually, but rather use QWaylandSurfaceGrabber (\a grabber).
  */
 void QWaylandCompositor::grabSurface(QWaylandSurfaceGrabber *grabber, const QWaylandBufferRef &buffer)
 {
+    QWaylandSurfaceGrabberPrivate *grabberPrivate = QWaylandSurfaceGrabberPrivate::get(grabber);
+    if (grabberPrivate->streaming) {
+        if (buffer.isSharedMemory()) {
+            grabberPrivate->updateFrame(buffer.image(), grabberPrivate->grabDamage);
+            return;
+        }
+#if QT_CONFIG(opengl)
+        if (QOpenGLContext::currentContext()) {
+            if (!grabberPrivate->readback) {
+                auto readback = std::make_shared<QWaylandSurfaceGrabberReadback>();
+                grabberPrivate->readback = readback;
+                // the grabs run on the thread of the grabber
+                grabberPrivate->releaseReadback = [readback]() { readback->release(); };
+            }
+            QWaylandSurfaceGrabberReadback *readback = grabberPrivate->readback.get();
+            QWaylandSurfaceGrabberReadback::Result result;
+            auto deliver = [&]() {
+                grabberPrivate->updateFrame(result.pixels, result.rect, result.size, result.damage);
+            };
+
+            // Deliver what earlier grabs read back
+            while (readback->takeResult(&result, false))
+                deliver();
+            if (readback->isFull() && readback->takeResult(&result, true))
+                deliver();
+
+            if (!readback->start(buffer, grabberPrivate->grabDamage)) {
+                emit grabber->failed(QWaylandSurfaceGrabber::UnknownBufferType);
+                return;
+            }
+            // Nobody is waiting for the first frame otherwise
+            if (!readback->isAsynchronous() || grabberPrivate->frame.isNull()) {
+                while (readback->takeResult(&result, true))
+                    deliver();
+            }
+            return;
+        }
+#endif
+        emit grabber->failed(QWaylandSurfaceGrabber::UnknownBufferType);
+        return;
+    }
+
     if (buffer.isSharedMemory()) {
         emit grabber->success(buffer.image());
     } else {
@@ -1080,6 +1212,51 @@ QVector<QWaylandCompositor::ShmFormat> QWaylandCompositor::additionalShmFormats(
     return d->shmFormats;
 }
 
+/*!
+ * \qmlproperty bool QtWaylandCompositor::WaylandCompositor::retainSharedMemoryBuffers
+ *
+ * This property holds whether shared memory buffers stay with the compositor
+ * until a newer buffer replaces them.
+ *
+ * By default, a shared memory buffer is released back to the client as soon
+ * as its contents have been copied for rendering, whichever graphics backend
+ * is used. This lets clients get by with two buffers. Set this property to
+ * \c true if the compositor needs to access the pixels of a buffer after it
+ * has been rendered, for instance through WaylandBufferRef::image().
+ *
+ * \since 6.5
+ */
+
+/*!
+ * \property QWaylandCompositor::retainSharedMemoryBuffers
+ *
+ * This property holds whether shared memory buffers stay with the compositor
+ * until a newer buffer replaces them.
+ *
+ * By default, a shared memory buffer is released back to the client as soon
+ * as its contents have been copied for rendering, whichever graphics backend
+ * is used. This lets clients get by with two buffers. Set this property to
+ * \c true if the compositor needs to access the pixels of a buffer after it
+ * has been rendered, for instance through QWaylandBufferRef::image().
+ *
+ * \since 6.5
+ */
+bool QWaylandCompositor::retainSharedMemoryBuffers() const
+{
+    Q_D(const QWaylandCompositor);
+    return d->retainShmBuffers;
+}
+
+void QWaylandCompositor::setRetainSharedMemoryBuffers(bool retain)
+{
+    Q_D(QWaylandCompositor);
+    if (d->retainShmBuffers == retain)
+        return;
+
+    d->retainShmBuffers = retain;
+    emit retainSharedMemoryBuffersChanged();
+}
+
 void QWaylandCompositor::applicationStateChanged(Qt::ApplicationState state)
 {
 #if QT_CONFIG(xkbcommon)
@@ -50,6 +50,9 @@ class Q_WAYLANDCOMPOSITOR_EXPORT QWaylandCompositor : public QWaylandObject
     Q_PROPERTY(bool useHardwareIntegrationExtension READ useHardwareIntegrationExtension WRITE setUseHardwareIntegrationExtension NOTIFY useHardwareIntegrationExtensionChanged)
     Q_PROPERTY(QWaylandSeat *defaultSeat READ defaultSeat NOTIFY defaultSeatChanged)
     Q_PROPERTY(QVector<ShmFormat> additionalShmFormats READ additionalShmFormats WRITE setAdditionalShmFormats NOTIFY additionalShmFormatsChanged REVISION(6, 0))
+    Q_PROPERTY(bool retainSharedMemoryBuffers READ retainSharedMemoryBuffers WRITE setRetainSharedMemoryBuffers NOTIFY retainSharedMemoryBuffersChanged REVISION(6, 5))
+    Q_PROPERTY(qint64 retainedSelectionMaximumSize READ retainedSelectionMaximumSize WRITE setRetainedSelectionMaximumSize NOTIFY retainedSelectionMaximumSizeChanged REVISION(6, 5))
+    Q_PROPERTY(qint64 retainedSelectionMaximumTypeSize READ retainedSelectionMaximumTypeSize WRITE setRetainedSelectionMaximumTypeSize NOTIFY retainedSelectionMaximumTypeSizeChanged REVISION(6, 5))
     Q_MOC_INCLUDE("qwaylandseat.h")
     QML_NAMED_ELEMENT(WaylandCompositorBase)
     QML_UNCREATABLE("Cannot create instance of WaylandCompositorBase, use WaylandCompositor instead")
@@ -105,6 +108,10 @@ public:
 
     void setRetainedSelectionEnabled(bool enabled);
     bool retainedSelectionEnabled() const;
+    qint64 retainedSelectionMaximumSize() const;
+    void setRetainedSelectionMaximumSize(qint64 bytes);
+    qint64 retainedSelectionMaximumTypeSize() const;
+    void setRetainedSelectionMaximumTypeSize(qint64 bytes);
     void overrideSelection(const QMimeData *data);
 
     QWaylandSeat *defaultSeat() const;
@@ -117,6 +124,9 @@ public:
     QVector<ShmFormat> additionalShmFormats() const;
     void setAdditionalShmFormats(const QVector<ShmFormat> &additionalShmFormats);
 
+    bool retainSharedMemoryBuffers() const;
+    void setRetainSharedMemoryBuffers(bool retain);
+
     virtual void grabSurface(QWaylandSurfaceGrabber *grabber, const QWaylandBufferRef &buffer);
 
 public Q_SLOTS:
@@ -144,6 +154,9 @@ Q_SIGNALS:
     void outputRemoved(QWaylandOutput *output);
 
     void additionalShmFormatsChanged();
+    Q_REVISION(6, 5) void retainSharedMemoryBuffersChanged();
+    Q_REVISION(6, 5) void retainedSelectionMaximumSizeChanged();
+    Q_REVISION(6, 5) void retainedSelectionMaximumTypeSizeChanged();
 
 protected:
     virtual void retainedSelectionReceived(QMimeData *mimeData);
@@ -21,6 +21,8 @@
 #include <QtCore/private/qobject_p.h>
 #include <QtCore/QSet>
 #include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QWeakPointer>
 
 #include <QtWaylandCompositor/private/qwayland-server-wayland.h>
 
@@ -42,6 +44,9 @@ namespace QtWayland {
 
 class QWindowSystemEventHandler;
 class QWaylandSurface;
+#if QT_CONFIG(xkbcommon)
+struct QWaylandXkbKeymap;
+#endif
 
 class Q_WAYLANDCOMPOSITOR_EXPORT QWaylandCompositorPrivate : public QObjectPrivate, public QtWaylandServer::wl_compositor, public QtWaylandServer::wl_subcompositor
 {
@@ -138,12 +143,18 @@ protected:
     QScopedPointer<QWindowSystemEventHandler> eventHandler;
 
     bool retainSelection = false;
+    // 0 means unlimited
+    qint64 retainedSelectionMaximumSize = 0;
+    qint64 retainedSelectionMaximumTypeSize = 0;
+    bool retainShmBuffers = false;
     bool preInitialized = false;
     bool initialized = false;
     std::vector<QPointer<QObject> > polish_objects;
 
 #if QT_CONFIG(xkbcommon)
     QXkbCommon::ScopedXKBContext mXkbContext;
+    // compiled keymaps in use by keyboards, keyed by their rule names
+    QHash<QByteArray, QWeakPointer<const QWaylandXkbKeymap>> xkbKeymaps;
 #endif
 
     Q_DECLARE_PUBLIC(QWaylandCompositor)
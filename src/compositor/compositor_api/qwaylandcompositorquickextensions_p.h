@@ -29,6 +29,8 @@
 #endif // QT_WAYLAND_TEXT_INPUT_V4_WIP
 #include <QtWaylandCompositor/qwaylandqttextinputmethodmanager.h>
 #include <QtWaylandCompositor/qwaylandidleinhibitv1.h>
+#include <QtWaylandCompositor/qwaylandfractionalscalev1.h>
+#include <QtWaylandCompositor/qwaylandscreencopyv1.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -84,6 +86,8 @@ private:
 // Note: These have to be in a header with a Q_OBJECT macro, otherwise we won't run moc on it
 Q_COMPOSITOR_DECLARE_QUICK_EXTENSION_NAMED_CLASS(QWaylandQtWindowManager, QtWindowManager)
 Q_COMPOSITOR_DECLARE_QUICK_EXTENSION_NAMED_CLASS(QWaylandIdleInhibitManagerV1, IdleInhibitManagerV1)
+Q_COMPOSITOR_DECLARE_QUICK_EXTENSION_NAMED_CLASS(QWaylandFractionalScaleManagerV1, FractionalScaleManagerV1)
+Q_COMPOSITOR_DECLARE_QUICK_EXTENSION_NAMED_CLASS(QWaylandScreencopyManagerV1, ScreencopyManagerV1)
 Q_COMPOSITOR_DECLARE_QUICK_EXTENSION_NAMED_CLASS(QWaylandTextInputManager, TextInputManager)
 #if QT_WAYLAND_TEXT_INPUT_V4_WIP
 Q_COMPOSITOR_DECLARE_QUICK_EXTENSION_NAMED_CLASS(QWaylandTextInputManagerV4, TextInputManagerV4)
@@ -19,6 +19,9 @@
 #if QT_CONFIG(xkbcommon)
 #include <sys/mman.h>
 #include <sys/types.h>
+
+#include <algorithm>
+#include <tuple>
 #include <xkbcommon/xkbcommon-names.h>
 #endif
 
@@ -147,32 +150,128 @@ void QWaylandKeyboardPrivate::sendKeyEvent(uint code, uint32_t state)
 }
 
 #if QT_CONFIG(xkbcommon)
-void QWaylandKeyboardPrivate::maybeUpdateXkbScanCodeTable()
+QSharedPointer<const QWaylandXkbKeymap> QWaylandXkbKeymap::fromNames(QWaylandCompositor *compositor,
+                                                                    const xkb_rule_names &names)
+{
+    QWaylandCompositorPrivate *cd = QWaylandCompositorPrivate::get(compositor);
+    if (!cd->xkbContext())
+        return {};
+
+    const QByteArray cacheKey = QByteArray(names.rules) + '\n' + names.model + '\n' + names.layout
+            + '\n' + names.variant + '\n' + names.options;
+    if (auto cached = cd->xkbKeymaps.value(cacheKey).toStrongRef())
+        return cached;
+
+    QSharedPointer<QWaylandXkbKeymap> xkbKeymap(new QWaylandXkbKeymap);
+    xkbKeymap->keymap.reset(xkb_keymap_new_from_names(cd->xkbContext(), &names,
+                                                      XKB_KEYMAP_COMPILE_NO_FLAGS));
+    if (!xkbKeymap->keymap)
+        return {};
+
+    char *keymapString = xkb_keymap_get_as_string(xkbKeymap->keymap.get(), XKB_KEYMAP_FORMAT_TEXT_V1);
+    if (!keymapString) {
+        qWarning("Failed to compile global XKB keymap");
+        return {};
+    }
+    xkbKeymap->string = QByteArray(keymapString);
+    free(keymapString);
+
+    xkbKeymap->buildScanCodeTables();
+
+    // Drop the entries of keymaps no keyboard uses anymore
+    for (auto it = cd->xkbKeymaps.begin(); it != cd->xkbKeymaps.end(); ) {
+        if (it->isNull())
+            it = cd->xkbKeymaps.erase(it);
+        else
+            ++it;
+    }
+    cd->xkbKeymaps.insert(cacheKey, xkbKeymap);
+    return xkbKeymap;
+}
+
+// Finds the key code for every key sym the keymap produces without modifiers
+// or with Shift, so that synthetic key events never need to query xkbcommon.
+void QWaylandXkbKeymap::buildScanCodeTables()
 {
-    if (!scanCodesByQtKey.isEmpty() || !xkbState())
+    xkb_keymap *km = keymap.get();
+    shiftIndex = xkb_keymap_mod_get_index(km, XKB_MOD_NAME_SHIFT);
+    controlIndex = xkb_keymap_mod_get_index(km, XKB_MOD_NAME_CTRL);
+    altIndex = xkb_keymap_mod_get_index(km, XKB_MOD_NAME_ALT);
+
+    QXkbCommon::ScopedXKBState state(xkb_state_new(km));
+    if (!state)
         return;
 
-    if (xkb_keymap *keymap = xkb_state_get_keymap(xkbState())) {
-        xkb_keymap_key_for_each(keymap, [](xkb_keymap *keymap, xkb_keycode_t keycode, void *d){
-            auto *scanCodesByQtKey = static_cast<QMap<ScanCodeKey, uint>*>(d);
-            uint numLayouts = xkb_keymap_num_layouts_for_key(keymap, keycode);
-            for (uint layout = 0; layout < numLayouts; ++layout) {
+    // The first entry wins over the ones with more modifiers, and the last
+    // key code over earlier ones with the same modifiers
+    using TableKey = std::pair<uint, uint>;
+    QHash<TableKey, ScanCode> byQtKey;
+    QHash<TableKey, ScanCode> byText;
+    auto insert = [](QHash<TableKey, ScanCode> &table, const ScanCode &scanCode) {
+        auto it = table.find({scanCode.layout, scanCode.key});
+        if (it == table.end())
+            table.insert({scanCode.layout, scanCode.key}, scanCode);
+        else if (scanCode.modifiers == Qt::NoModifier || it->modifiers != Qt::NoModifier)
+            *it = scanCode;
+    };
+
+    const xkb_layout_index_t numLayouts = xkb_keymap_num_layouts(km);
+    const xkb_keycode_t minKeycode = xkb_keymap_min_keycode(km);
+    const xkb_keycode_t maxKeycode = xkb_keymap_max_keycode(km);
+    const Qt::KeyboardModifiers levelModifiers[] = { Qt::NoModifier, Qt::ShiftModifier };
+
+    for (xkb_layout_index_t layout = 0; layout < numLayouts; ++layout) {
+        for (Qt::KeyboardModifiers modifiers : levelModifiers) {
+            const bool shifted = modifiers == Qt::ShiftModifier;
+            if (shifted && shiftIndex == XKB_MOD_INVALID)
+                continue;
+            const xkb_mod_mask_t mask = shifted ? 1u << shiftIndex : 0;
+            xkb_state_update_mask(state.get(), mask, 0, 0, 0, 0, layout);
+
+            for (xkb_keycode_t code = minKeycode; code <= maxKeycode; ++code) {
+                if (layout >= xkb_keymap_num_layouts_for_key(km, code))
+                    continue;
+                const xkb_level_index_t level = xkb_state_key_get_level(state.get(), code, layout);
+                if (mask && level == 0)
+                    continue;
+
                 const xkb_keysym_t *syms = nullptr;
-                xkb_keymap_key_get_syms_by_level(keymap, keycode, layout, 0, &syms);
-                if (!syms)
+                if (xkb_keymap_key_get_syms_by_level(km, code, layout, level, &syms) < 1 || !syms)
                     continue;
 
-                Qt::KeyboardModifiers mods = {};
-                int qtKey = QXkbCommon::keysymToQtKey(syms[0], mods);
-                if (qtKey != 0)
-                    scanCodesByQtKey->insert({layout, qtKey}, keycode);
+                if (!mask) {
+                    if (int qtKey = QXkbCommon::keysymToQtKey(syms[0], modifiers))
+                        insert(byQtKey, {layout, uint(qtKey), code, modifiers});
+                }
+                if (char32_t ucs4 = xkb_keysym_to_utf32(syms[0]))
+                    insert(byText, {layout, uint(ucs4), code, modifiers});
             }
-        }, &scanCodesByQtKey);
-
-        shiftIndex = xkb_keymap_mod_get_index(keymap, XKB_MOD_NAME_SHIFT);
-        controlIndex = xkb_keymap_mod_get_index(keymap, XKB_MOD_NAME_CTRL);
-        altIndex = xkb_keymap_mod_get_index(keymap, XKB_MOD_NAME_ALT);
+        }
     }
+
+    auto flatten = [](const QHash<TableKey, ScanCode> &table) {
+        QList<ScanCode> list;
+        list.reserve(table.size());
+        for (const ScanCode &scanCode : table)
+            list.append(scanCode);
+        std::sort(list.begin(), list.end(), [](const ScanCode &a, const ScanCode &b) {
+            return std::tie(a.layout, a.key) < std::tie(b.layout, b.key);
+        });
+        return list;
+    };
+    scanCodesByQtKey = flatten(byQtKey);
+    scanCodesByText = flatten(byText);
+}
+
+const QWaylandXkbKeymap::ScanCode *QWaylandXkbKeymap::find(const QList<ScanCode> &table, uint layout, uint key)
+{
+    auto it = std::lower_bound(table.cbegin(), table.cend(), std::make_pair(layout, key),
+                               [](const ScanCode &scanCode, const std::pair<uint, uint> &value) {
+        return std::tie(scanCode.layout, scanCode.key) < std::tie(value.first, value.second);
+    });
+    if (it == table.cend() || it->layout != layout || it->key != key)
+        return nullptr;
+    return &*it;
 }
 
 void QWaylandKeyboardPrivate::resetKeyboardState()
@@ -324,15 +423,12 @@ static int createAnonymousFile(size_t size)
     return fd;
 }
 
-void QWaylandKeyboardPrivate::createXKBState(xkb_keymap *keymap)
+void QWaylandKeyboardPrivate::createXKBState()
 {
-    char *keymap_str = xkb_keymap_get_as_string(keymap, XKB_KEYMAP_FORMAT_TEXT_V1);
-    if (!keymap_str) {
-        qWarning("Failed to compile global XKB keymap");
-        return;
-    }
-
-    keymap_size = strlen(keymap_str) + 1;
+    if (keymap_area)
+        munmap(keymap_area, keymap_size);
+    keymap_area = nullptr;
+    keymap_size = size_t(mXkbKeymap->string.size()) + 1;
     if (keymap_fd >= 0)
         close(keymap_fd);
     keymap_fd = createAnonymousFile(keymap_size);
@@ -343,16 +439,20 @@ void QWaylandKeyboardPrivate::createXKBState(xkb_keymap *keymap)
 
     keymap_area = static_cast<char *>(mmap(nullptr, keymap_size, PROT_READ | PROT_WRITE, MAP_SHARED, keymap_fd, 0));
     if (keymap_area == MAP_FAILED) {
+        keymap_area = nullptr;
         close(keymap_fd);
         keymap_fd = -1;
         qWarning("Failed to map shared memory segment");
         return;
     }
 
-    strcpy(keymap_area, keymap_str);
-    free(keymap_str);
+    memcpy(keymap_area, mXkbKeymap->string.constData(), keymap_size);
 
-    mXkbState.reset(xkb_state_new(keymap));
+    shiftIndex = mXkbKeymap->shiftIndex;
+    controlIndex = mXkbKeymap->controlIndex;
+    altIndex = mXkbKeymap->altIndex;
+
+    mXkbState.reset(xkb_state_new(mXkbKeymap->keymap.get()));
     if (!mXkbState)
         qWarning("Failed to create XKB state");
 }
@@ -384,11 +484,9 @@ void QWaylandKeyboardPrivate::createXKBKeymap()
         options.constData()
     };
 
-    QXkbCommon::ScopedXKBKeymap xkbKeymap(xkb_keymap_new_from_names(xkbContext(), &rule_names,
-                                                                    XKB_KEYMAP_COMPILE_NO_FLAGS));
-    if (xkbKeymap) {
-        scanCodesByQtKey.clear();
-        createXKBState(xkbKeymap.get());
+    if (auto xkbKeymap = QWaylandXkbKeymap::fromNames(compositor(), rule_names)) {
+        mXkbKeymap = xkbKeymap;
+        createXKBState();
     } else {
         qWarning("Failed to load the '%s' XKB keymap.", qPrintable(keymap->layout()));
     }
@@ -523,9 +621,6 @@ void QWaylandKeyboardPrivate::checkAndRepairModifierState(QKeyEvent *ke)
             // key event is delivered
             uint32_t mods = 0;
 
-            if (shiftIndex == 0 && controlIndex == 0)
-                maybeUpdateXkbScanCodeTable();
-
             if (ke->modifiers() & Qt::ShiftModifier)
                 mods |= 1 << shiftIndex;
             if (ke->modifiers() & Qt::ControlModifier)
@@ -622,15 +717,63 @@ void QWaylandKeyboard::addClient(QWaylandClient *client, uint32_t id, uint32_t v
 
 uint QWaylandKeyboard::keyToScanCode(int qtKey) const
 {
-    uint scanCode = 0;
-#if QT_CONFIG(xkbcommon)
     Q_D(const QWaylandKeyboard);
-    const_cast<QWaylandKeyboardPrivate *>(d)->maybeUpdateXkbScanCodeTable();
-    scanCode = d->scanCodesByQtKey.value({d->group, qtKey}, 0);
+    return d->keyToScanCode(qtKey);
+}
+
+uint QWaylandKeyboardPrivate::keyToScanCode(int qtKey) const
+{
+#if QT_CONFIG(xkbcommon)
+    if (mXkbKeymap) {
+        if (const auto *scanCode = mXkbKeymap->scanCodeForKey(group, qtKey))
+            return scanCode->code;
+    }
 #else
     Q_UNUSED(qtKey);
 #endif
-    return scanCode;
+    return 0;
+}
+
+// Sends a press and a release for every character of the text, pressing Shift
+// around the characters that need it, and flushes the client once at the end.
+bool QWaylandKeyboardPrivate::typeText(const QString &text)
+{
+#if QT_CONFIG(xkbcommon)
+    if (!focusResource || !mXkbKeymap)
+        return false;
+
+    const uint shiftCode = keyToScanCode(Qt::Key_Shift);
+    bool typedAll = true;
+    const auto codePoints = text.toUcs4();
+    for (char32_t ucs4 : codePoints) {
+        if (ucs4 == '\n')
+            ucs4 = '\r'; // what Return produces
+        const auto *scanCode = mXkbKeymap->scanCodeForText(group, ucs4);
+        const bool shift = scanCode && scanCode->modifiers.testFlag(Qt::ShiftModifier);
+        if (!scanCode || (shift && !shiftCode)) {
+            qWarning() << "Can't type" << QString::fromUcs4(&ucs4, 1) << "with the current keymap";
+            typedAll = false;
+            continue;
+        }
+
+        if (shift) {
+            sendKeyEvent(shiftCode, WL_KEYBOARD_KEY_STATE_PRESSED);
+            updateModifierState(shiftCode, WL_KEYBOARD_KEY_STATE_PRESSED);
+        }
+        sendKeyEvent(scanCode->code, WL_KEYBOARD_KEY_STATE_PRESSED);
+        sendKeyEvent(scanCode->code, WL_KEYBOARD_KEY_STATE_RELEASED);
+        if (shift) {
+            sendKeyEvent(shiftCode, WL_KEYBOARD_KEY_STATE_RELEASED);
+            updateModifierState(shiftCode, WL_KEYBOARD_KEY_STATE_RELEASED);
+        }
+    }
+
+    wl_client_flush(focusResource->client());
+    return typedAll;
+#else
+    Q_UNUSED(text);
+    return false;
+#endif
 }
 
 QT_END_NAMESPACE
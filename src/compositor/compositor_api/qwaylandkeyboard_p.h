@@ -26,6 +26,7 @@
 #include <QtWaylandCompositor/private/qwayland-server-wayland.h>
 
 #include <QtCore/QList>
+#include <QtCore/QSharedPointer>
 
 #if QT_CONFIG(xkbcommon)
 #include <xkbcommon/xkbcommon.h>
@@ -35,6 +36,41 @@
 
 QT_BEGIN_NAMESPACE
 
+#if QT_CONFIG(xkbcommon)
+// A compiled keymap together with everything derived from it, shared by all
+// keyboards using the same rule names.
+struct QWaylandXkbKeymap
+{
+    struct ScanCode {
+        uint layout;
+        uint key; // Qt::Key or UCS-4 code point, depending on the table
+        uint code;
+        Qt::KeyboardModifiers modifiers;
+    };
+
+    static QSharedPointer<const QWaylandXkbKeymap> fromNames(QWaylandCompositor *compositor,
+                                                             const xkb_rule_names &names);
+
+    const ScanCode *scanCodeForKey(uint layout, int qtKey) const { return find(scanCodesByQtKey, layout, uint(qtKey)); }
+    const ScanCode *scanCodeForText(uint layout, char32_t ucs4) const { return find(scanCodesByText, layout, ucs4); }
+
+    QXkbCommon::ScopedXKBKeymap keymap;
+    QByteArray string;
+    uint32_t shiftIndex = 0;
+    uint32_t controlIndex = 0;
+    uint32_t altIndex = 0;
+
+private:
+    void buildScanCodeTables();
+    static const ScanCode *find(const QList<ScanCode> &table, uint layout, uint key);
+
+    // Both sorted by layout and key. Keys produced without modifiers map
+    // to scanCodesByQtKey, scanCodesByText also has the shifted levels.
+    QList<ScanCode> scanCodesByQtKey;
+    QList<ScanCode> scanCodesByText;
+};
+#endif
+
 class Q_WAYLANDCOMPOSITOR_EXPORT QWaylandKeyboardPrivate : public QObjectPrivate
                                                   , public QtWaylandServer::wl_keyboard
 {
@@ -56,9 +92,10 @@ public:
         return QWaylandCompositorPrivate::get(seat->compositor())->xkbContext();
     }
     uint32_t xkbModsMask() const { return modsDepressed | modsLatched | modsLocked; }
-    void maybeUpdateXkbScanCodeTable();
     void resetKeyboardState();
 #endif
+    uint keyToScanCode(int qtKey) const;
+    bool typeText(const QString &text);
 
     void keyEvent(uint code, uint32_t state);
     void sendKeyEvent(uint code, uint32_t state);
@@ -77,7 +114,7 @@ protected:
 private:
 #if QT_CONFIG(xkbcommon)
     void createXKBKeymap();
-    void createXKBState(xkb_keymap *keymap);
+    void createXKBState();
 #endif
     static uint toWaylandKey(const uint nativeScanCode);
     static uint fromWaylandKey(const uint key);
@@ -107,8 +144,7 @@ private:
     size_t keymap_size;
     int keymap_fd = -1;
     char *keymap_area = nullptr;
-    using ScanCodeKey = std::pair<uint,int>; // group/layout and QtKey
-    QMap<ScanCodeKey, uint> scanCodesByQtKey;
+    QSharedPointer<const QWaylandXkbKeymap> mXkbKeymap;
     QXkbCommon::ScopedXKBState mXkbState;
 #endif
 
@@ -11,8 +11,10 @@
 #include <QtWaylandCompositor/private/qwaylandsurface_p.h>
 #include <QtWaylandCompositor/private/qwaylandcompositor_p.h>
 #include <QtWaylandCompositor/private/qwaylandview_p.h>
+#include <QtWaylandCompositor/private/qwaylandpointer_p.h>
 #include <QtWaylandCompositor/private/qwaylandutils_p.h>
 #include <QtWaylandCompositor/private/qwaylandxdgoutputv1_p.h>
+#include <QtWaylandCompositor/private/qwaylandfractionalscalev1_p.h>
 
 #include <QtCore/QCoreApplication>
 #include <QtCore/QtMath>
@@ -819,6 +821,87 @@ void QWaylandOutput::setScaleFactor(int scale)
 
     if (d->xdgOutput)
         QWaylandXdgOutputV1Private::get(d->xdgOutput)->sendDone();
+
+    if (d->fractionalScaleFactor <= 0) {
+        Q_EMIT fractionalScaleFactorChanged();
+        d->updatePreferredFractionalScales();
+    }
+}
+
+/*!
+ * \qmlproperty real QtWaylandCompositor::WaylandOutput::fractionalScaleFactor
+ * \since 6.5
+ *
+ * This property holds the scale factor which clients are asked to render their surfaces at
+ * if they support the fractional scale extension, FractionalScaleManagerV1. Unlike
+ * \l scaleFactor, it can be a non-integer value such as 1.25 or 1.5. Clients present buffers
+ * rendered at this scale through a viewport, so the compositor does not have to scale
+ * down buffers that were rendered at the next integer scale.
+ *
+ * Only multiples of 1/120 can be sent to clients. Setting a value of 0 or less makes this
+ * property follow \l scaleFactor, which is the default.
+ */
+
+/*!
+ * \property QWaylandOutput::fractionalScaleFactor
+ * \since 6.5
+ *
+ * This property holds the scale factor which clients are asked to render their surfaces at
+ * if they support the fractional scale extension, QWaylandFractionalScaleManagerV1. Unlike
+ * \l scaleFactor, it can be a non-integer value such as 1.25 or 1.5. Clients present buffers
+ * rendered at this scale through a viewport, so the compositor does not have to scale
+ * down buffers that were rendered at the next integer scale.
+ *
+ * Only multiples of 1/120 can be sent to clients. Setting a value of 0 or less makes this
+ * property follow \l scaleFactor, which is the default.
+ */
+qreal QWaylandOutput::fractionalScaleFactor() const
+{
+    Q_D(const QWaylandOutput);
+    return d->fractionalScaleFactor > 0 ? d->fractionalScaleFactor : qreal(d->scaleFactor);
+}
+
+void QWaylandOutput::setFractionalScaleFactor(qreal scale)
+{
+    Q_D(QWaylandOutput);
+    if (scale <= 0)
+        scale = 0;
+    if (qFuzzyCompare(d->fractionalScaleFactor, scale))
+        return;
+
+    const qreal oldScale = fractionalScaleFactor();
+    d->fractionalScaleFactor = scale;
+    if (qFuzzyCompare(oldScale, fractionalScaleFactor()))
+        return;
+
+    Q_EMIT fractionalScaleFactorChanged();
+    d->updatePreferredFractionalScales();
+}
+
+void QWaylandOutputPrivate::updatePreferredFractionalScales()
+{
+    Q_Q(QWaylandOutput);
+    if (!compositor)
+        return;
+
+    // Surfaces which aren't on any output yet follow the default output, so check all of
+    // them if this is the default output. Surfaces whose preferred scale doesn't change
+    // don't get an event.
+    if (compositor->defaultOutput() == q) {
+        const auto surfaces = QWaylandCompositorPrivate::get(compositor)->all_surfaces;
+        for (QWaylandSurface *surface : surfaces) {
+            if (auto *fractionalScale = QWaylandSurfacePrivate::get(surface)->fractionalScale)
+                fractionalScale->updatePreferredScale();
+        }
+        return;
+    }
+
+    for (const QWaylandSurfaceViewMapper &surfacemapper : std::as_const(surfaceViews)) {
+        if (!surfacemapper.surface || !surfacemapper.has_entered)
+            continue;
+        if (auto *fractionalScale = QWaylandSurfacePrivate::get(surfacemapper.surface)->fractionalScale)
+            fractionalScale->updatePreferredScale();
+    }
 }
 
 /*!
@@ -906,6 +989,10 @@ void QWaylandOutput::frameStarted()
 
 /*!
  * Sends pending frame callbacks.
+ *
+ * Pointer motion that was held back for this output is sent as well.
+ *
+ * \sa QWaylandPointer::motionCompressionEnabled
  */
 void QWaylandOutput::sendFrameCallbacks()
 {
@@ -923,6 +1010,11 @@ void QWaylandOutput::sendFrameCallbacks()
             }
         }
     }
+    for (QWaylandSeat *seat : std::as_const(QWaylandCompositorPrivate::get(d->compositor)->seats)) {
+        QWaylandPointer *pointer = seat->pointer();
+        if (pointer && (!pointer->output() || pointer->output() == this))
+            QWaylandPointerPrivate::get(pointer)->flushPendingMotion();
+    }
     wl_display_flush_clients(d->compositor->display());
 }
 
@@ -937,6 +1029,9 @@ void QWaylandOutput::surfaceEnter(QWaylandSurface *surface)
     auto clientResource = resourceForClient(surface->client());
     if (clientResource)
         QWaylandSurfacePrivate::get(surface)->send_enter(clientResource);
+
+    if (auto *fractionalScale = QWaylandSurfacePrivate::get(surface)->fractionalScale)
+        fractionalScale->outputEntered(this);
 }
 
 /*!
@@ -950,6 +1045,9 @@ void QWaylandOutput::surfaceLeave(QWaylandSurface *surface)
     auto *clientResource = resourceForClient(surface->client());
     if (clientResource)
         QWaylandSurfacePrivate::get(surface)->send_leave(clientResource);
+
+    if (auto *fractionalScale = QWaylandSurfacePrivate::get(surface)->fractionalScale)
+        fractionalScale->outputLeft(this);
 }
 
 /*!
@@ -40,6 +40,7 @@ class Q_WAYLANDCOMPOSITOR_EXPORT QWaylandOutput : public QWaylandObject
     Q_PROPERTY(QWaylandOutput::Subpixel subpixel READ subpixel WRITE setSubpixel NOTIFY subpixelChanged)
     Q_PROPERTY(QWaylandOutput::Transform transform READ transform WRITE setTransform NOTIFY transformChanged)
     Q_PROPERTY(int scaleFactor READ scaleFactor WRITE setScaleFactor NOTIFY scaleFactorChanged)
+    Q_PROPERTY(qreal fractionalScaleFactor READ fractionalScaleFactor WRITE setFractionalScaleFactor NOTIFY fractionalScaleFactorChanged REVISION(6, 5))
     Q_PROPERTY(bool sizeFollowsWindow READ sizeFollowsWindow WRITE setSizeFollowsWindow NOTIFY sizeFollowsWindowChanged)
 
     QML_NAMED_ELEMENT(WaylandOutputBase)
@@ -114,6 +115,9 @@ public:
     int scaleFactor() const;
     void setScaleFactor(int scale);
 
+    qreal fractionalScaleFactor() const;
+    void setFractionalScaleFactor(qreal scale);
+
     bool sizeFollowsWindow() const;
     void setSizeFollowsWindow(bool follow);
 
@@ -138,6 +142,7 @@ Q_SIGNALS:
     void availableGeometryChanged();
     void physicalSizeChanged();
     void scaleFactorChanged();
+    Q_REVISION(6, 5) void fractionalScaleFactorChanged();
     void subpixelChanged();
     void transformChanged();
     void sizeFollowsWindowChanged();
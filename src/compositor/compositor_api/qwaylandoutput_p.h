@@ -83,6 +83,7 @@ protected:
     void output_bind_resource(Resource *resource) override;
 
 private:
+    void updatePreferredFractionalScales();
     void _q_handleMaybeWindowPixelSizeChanged();
     void _q_handleWindowDestroyed();
 
@@ -100,6 +101,7 @@ private:
     QWaylandOutput::Subpixel subpixel = QWaylandOutput::SubpixelUnknown;
     QWaylandOutput::Transform transform = QWaylandOutput::TransformNormal;
     int scaleFactor = 1;
+    qreal fractionalScaleFactor = 0; // 0 means it follows scaleFactor
     bool sizeFollowsWindow = false;
     bool initialized = false;
     QSize windowPixelSize;
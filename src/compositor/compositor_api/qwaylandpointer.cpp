@@ -5,6 +5,9 @@
 #include "qwaylandpointer_p.h"
 #include <QtWaylandCompositor/QWaylandClient>
 #include <QtWaylandCompositor/QWaylandCompositor>
+#include <QtWaylandCompositor/QWaylandOutput>
+
+#include <QtCore/QtMath>
 
 QT_BEGIN_NAMESPACE
 
@@ -14,6 +17,8 @@ QWaylandPointerPrivate::QWaylandPointerPrivate(QWaylandPointer *pointer, QWaylan
     : seat(seat)
 {
     Q_UNUSED(pointer);
+    motionFlushTimer.setSingleShot(true);
+    QObject::connect(&motionFlushTimer, &QTimer::timeout, &motionFlushTimer, [this]() { flushPendingMotion(); });
 }
 
 uint QWaylandPointerPrivate::sendButton(Qt::MouseButton button, uint32_t state)
@@ -22,22 +27,79 @@ uint QWaylandPointerPrivate::sendButton(Qt::MouseButton button, uint32_t state)
     if (!q->mouseFocus() || !q->mouseFocus()->surface())
         return 0;
 
+    // The client has to see where the button was pressed
+    if (motionPending && enteredSurface)
+        sendMotion();
+
     wl_client *client = q->mouseFocus()->surface()->waylandClient();
     uint32_t time = compositor()->currentTimeMsecs();
     uint32_t serial = compositor()->nextSerial();
     for (auto resource : resourceMap().values(client))
         send_button(resource->handle, serial, time, q->toWaylandButton(button), state);
+    frameNeeded(client);
+    sendFrames();
     return serial;
 }
 
 void QWaylandPointerPrivate::sendMotion()
 {
     Q_ASSERT(enteredSurface);
+    motionPending = false;
+    motionFlushTimer.stop();
+
     uint32_t time = compositor()->currentTimeMsecs();
     wl_fixed_t x = wl_fixed_from_double(localPosition.x());
     wl_fixed_t y = wl_fixed_from_double(localPosition.y());
     for (auto resource : resourceMap().values(enteredSurface->waylandClient()))
         wl_pointer_send_motion(resource->handle, time, x, y);
+    frameNeeded(enteredSurface->waylandClient());
+}
+
+// Holds the motion back until the output shows the next frame. Only the
+// latest position is sent then, however often the pointer moved.
+void QWaylandPointerPrivate::queueMotion()
+{
+    if (motionPending)
+        return;
+
+    motionPending = true;
+    int interval = 16;
+    if (output && output->currentMode().refreshRate() > 0)
+        interval = qCeil(1000000.0 / output->currentMode().refreshRate());
+    motionFlushTimer.start(interval);
+}
+
+void QWaylandPointerPrivate::flushPendingMotion()
+{
+    if (!motionPending)
+        return;
+
+    if (enteredSurface) {
+        sendMotion();
+        sendFrames();
+    } else {
+        motionPending = false;
+        motionFlushTimer.stop();
+    }
+}
+
+void QWaylandPointerPrivate::frameNeeded(wl_client *client)
+{
+    if (!frameClients.contains(client))
+        frameClients.append(client);
+}
+
+// Groups the events sent since the last call into one logical event for
+// the clients, which only exists since version 5 of wl_pointer.
+void QWaylandPointerPrivate::sendFrames()
+{
+    const auto clients = std::exchange(frameClients, {});
+    for (wl_client *client : clients) {
+        for (auto resource : resourceMap().values(client)) {
+            if (resource->version() >= WL_POINTER_FRAME_SINCE_VERSION)
+                send_frame(resource->handle);
+        }
+    }
 }
 
 void QWaylandPointerPrivate::sendEnter(QWaylandSurface *surface)
@@ -53,6 +115,7 @@ void QWaylandPointerPrivate::sendEnter(QWaylandSurface *surface)
     wl_fixed_t y = wl_fixed_from_double(localPosition.y());
     for (auto resource : resourceMap().values(surface->waylandClient()))
         send_enter(resource->handle, enterSerial, surface->resource(), x, y);
+    frameNeeded(surface->waylandClient());
 
     enteredSurface = surface;
     enteredSurfaceDestroyListener.listenForDestruction(surface->resource());
@@ -64,7 +127,10 @@ void QWaylandPointerPrivate::sendLeave()
     uint32_t serial = compositor()->nextSerial();
     for (auto resource : resourceMap().values(enteredSurface->waylandClient()))
         send_leave(resource->handle, serial, enteredSurface->resource());
+    frameNeeded(enteredSurface->waylandClient());
     localPosition = QPointF();
+    motionPending = false;
+    motionFlushTimer.stop();
     enteredSurfaceDestroyListener.reset();
     enteredSurface = nullptr;
 }
@@ -118,6 +184,9 @@ void QWaylandPointerPrivate::pointer_set_cursor(wl_pointer::Resource *resource,
  *
  * This class provides access to the pointer device in a QWaylandSeat. It corresponds to
  * the Wayland interface wl_pointer.
+ *
+ * Events that belong together, such as leaving one surface and entering another, are
+ * grouped into one wl_pointer.frame for clients supporting version 5 of the interface.
  */
 
 /*!
@@ -209,7 +278,13 @@ void QWaylandPointer::sendMouseMoveEvent(QWaylandView *view, const QPointF &loca
     Q_D(QWaylandPointer);
     if (view && (!view->surface() || view->surface()->isCursorSurface()))
         view = nullptr;
+    // A motion held back for the surface that is about to be left goes out first
+    if (d->motionPending && (!view || view->surface() != d->enteredSurface))
+        d->flushPendingMotion();
+    // the leave is sent in the same frame as the enter
+    d->movingFocus = true;
     d->seat->setMouseFocus(view);
+    d->movingFocus = false;
     d->localPosition = localPos;
     d->spacePosition = outputSpacePos;
 
@@ -223,11 +298,15 @@ void QWaylandPointer::sendMouseMoveEvent(QWaylandView *view, const QPointF &loca
             d->localPosition.ry() -= 0.01;
 
         d->ensureEntered(view->surface());
-        d->sendMotion();
+        if (d->motionCompression)
+            d->queueMotion();
+        else
+            d->sendMotion();
 
         if (view->output())
             setOutput(view->output());
     }
+    d->sendFrames();
 }
 
 /*!
@@ -239,12 +318,17 @@ void QWaylandPointer::sendMouseWheelEvent(Qt::Orientation orientation, int delta
     if (!d->enteredSurface)
         return;
 
+    if (d->motionPending)
+        d->sendMotion();
+
     uint32_t time = d->compositor()->currentTimeMsecs();
     uint32_t axis = orientation == Qt::Horizontal ? WL_POINTER_AXIS_HORIZONTAL_SCROLL
                                                   : WL_POINTER_AXIS_VERTICAL_SCROLL;
 
     for (auto resource : d->resourceMap().values(d->enteredSurface->waylandClient()))
         d->send_axis(resource->handle, time, axis, wl_fixed_from_int(-delta / 12));
+    d->frameNeeded(d->enteredSurface->waylandClient());
+    d->sendFrames();
 }
 
 /*!
@@ -283,6 +367,39 @@ bool QWaylandPointer::isButtonPressed() const
     return d->buttonCount > 0;
 }
 
+/*!
+ * \property QWaylandPointer::motionCompressionEnabled
+ * \since 6.5
+ *
+ * This property holds whether pointer motion is compressed.
+ *
+ * When enabled, sendMouseMoveEvent() doesn't send the motion right away. Only the latest
+ * position is sent to the client once per frame of the pointer's output, when
+ * QWaylandOutput::sendFrameCallbacks() is called, or after the refresh interval of the output
+ * if it doesn't render. High rate mice then no longer wake clients up for every single move.
+ * Pending motion is always sent before button and axis events, and before the pointer leaves
+ * the surface.
+ *
+ * The default is \c false.
+ */
+bool QWaylandPointer::isMotionCompressionEnabled() const
+{
+    Q_D(const QWaylandPointer);
+    return d->motionCompression;
+}
+
+void QWaylandPointer::setMotionCompressionEnabled(bool enabled)
+{
+    Q_D(QWaylandPointer);
+    if (d->motionCompression == enabled)
+        return;
+
+    d->motionCompression = enabled;
+    if (!enabled)
+        d->flushPendingMotion();
+    emit motionCompressionEnabledChanged();
+}
+
 /*!
  * \internal
  */
@@ -368,6 +485,9 @@ void QWaylandPointer::enteredSurfaceDestroyed(void *data)
     Q_UNUSED(data);
     d->enteredSurfaceDestroyListener.reset();
     d->enteredSurface = nullptr;
+    d->motionPending = false;
+    d->motionFlushTimer.stop();
+    d->frameClients.clear();
 
     d->seat->setMouseFocus(nullptr);
 
@@ -385,8 +505,12 @@ void QWaylandPointer::pointerFocusChanged(QWaylandView *newFocus, QWaylandView *
     Q_D(QWaylandPointer);
     Q_UNUSED(oldFocus);
     bool wasSameSurface = newFocus && newFocus->surface() == d->enteredSurface;
-    if (d->enteredSurface && !wasSameSurface)
+    if (d->enteredSurface && !wasSameSurface) {
+        d->flushPendingMotion();
         d->sendLeave();
+        if (!d->movingFocus)
+            d->sendFrames();
+    }
 }
 
 QT_END_NAMESPACE
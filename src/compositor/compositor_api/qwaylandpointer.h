@@ -22,6 +22,7 @@ class Q_WAYLANDCOMPOSITOR_EXPORT QWaylandPointer : public QWaylandObject
     Q_OBJECT
     Q_DECLARE_PRIVATE(QWaylandPointer)
     Q_PROPERTY(bool isButtonPressed READ isButtonPressed NOTIFY buttonPressedChanged)
+    Q_PROPERTY(bool motionCompressionEnabled READ isMotionCompressionEnabled WRITE setMotionCompressionEnabled NOTIFY motionCompressionEnabledChanged REVISION(6, 5))
 public:
     QWaylandPointer(QWaylandSeat *seat, QObject *parent = nullptr);
 
@@ -42,6 +43,9 @@ public:
 
     bool isButtonPressed() const;
 
+    bool isMotionCompressionEnabled() const;
+    void setMotionCompressionEnabled(bool enabled);
+
     virtual void addClient(QWaylandClient *client, uint32_t id, uint32_t version);
 
     wl_resource *focusResource() const;
@@ -51,6 +55,7 @@ public:
 Q_SIGNALS:
     void outputChanged();
     void buttonPressedChanged();
+    Q_REVISION(6, 5) void motionCompressionEnabledChanged();
 
 private:
     void enteredSurfaceDestroyed(void *data);
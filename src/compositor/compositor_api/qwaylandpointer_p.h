@@ -23,6 +23,7 @@
 #include <QtCore/QList>
 #include <QtCore/QPoint>
 #include <QtCore/QObject>
+#include <QtCore/QTimer>
 #include <QtCore/private/qobject_p.h>
 
 #include <QtWaylandCompositor/private/qwayland-server-wayland.h>
@@ -45,6 +46,10 @@ public:
 
     QWaylandCompositor *compositor() const { return seat->compositor(); }
 
+    static QWaylandPointerPrivate *get(QWaylandPointer *pointer) { return pointer->d_func(); }
+
+    void flushPendingMotion();
+
 protected:
     void pointer_set_cursor(Resource *resource, uint32_t serial, wl_resource *surface, int32_t hotspot_x, int32_t hotspot_y) override;
     void pointer_release(Resource *resource) override;
@@ -52,9 +57,12 @@ protected:
 private:
     uint sendButton(Qt::MouseButton button, uint32_t state);
     void sendMotion();
+    void queueMotion();
     void sendEnter(QWaylandSurface *surface);
     void sendLeave();
     void ensureEntered(QWaylandSurface *surface);
+    void frameNeeded(wl_client *client);
+    void sendFrames();
 
     QWaylandSeat *seat = nullptr;
     QWaylandOutput *output = nullptr;
@@ -67,6 +75,14 @@ private:
 
     int buttonCount = 0;
 
+    bool motionCompression = false;
+    bool motionPending = false;
+    bool movingFocus = false;
+    // fallback for outputs that don't send frame callbacks
+    QTimer motionFlushTimer;
+    // clients that were sent events since the last wl_pointer.frame
+    QList<wl_client *> frameClients;
+
     QWaylandDestroyListener enteredSurfaceDestroyListener;
 
     static QWaylandSurfaceRole s_role;
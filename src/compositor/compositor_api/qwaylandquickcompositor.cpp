@@ -21,6 +21,10 @@
 #include <QtWaylandCompositor/private/qwaylandcompositor_p.h>
 #include <QtWaylandCompositor/QWaylandViewporter>
 #include "qwaylandsurfacegrabber.h"
+#include "qwaylandsurfacegrabber_p.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QPointer>
 
 QT_BEGIN_NAMESPACE
 
@@ -83,6 +87,62 @@ void QWaylandQuickCompositor::componentComplete()
     create();
 }
 
+#if QT_CONFIG(opengl)
+// Runs the read backs of a streaming grabber on the render thread. Unfinished
+// read backs are checked again after the next frame instead of waiting for them.
+class StreamingGrabJob : public QRunnable
+{
+public:
+    // only dereferenced on the thread of the grabber
+    QPointer<QWaylandSurfaceGrabber> grabber;
+    std::shared_ptr<QWaylandSurfaceGrabberReadback> readback;
+    QQuickWindow *window = nullptr;
+    QWaylandBufferRef buffer;
+    QRegion damage;
+
+    void run() override
+    {
+        deliverFinished(false);
+        if (buffer.hasBuffer()) {
+            if (readback->isFull())
+                deliverFinished(true);
+            if (!readback->start(buffer, damage)) {
+                QMetaObject::invokeMethod(QCoreApplication::instance(), [grabber = grabber]() {
+                    if (grabber)
+                        emit grabber->failed(QWaylandSurfaceGrabber::UnknownBufferType);
+                }, Qt::QueuedConnection);
+            }
+            buffer = QWaylandBufferRef();
+        }
+        deliverFinished(false);
+
+        if (readback->hasPendingTransfers()) {
+            auto *job = new StreamingGrabJob;
+            job->grabber = grabber;
+            job->readback = readback;
+            job->window = window;
+            window->scheduleRenderJob(job, QQuickWindow::AfterRenderingStage);
+            QMetaObject::invokeMethod(window, &QQuickWindow::update, Qt::QueuedConnection);
+        }
+    }
+
+private:
+    void deliverFinished(bool wait)
+    {
+        QWaylandSurfaceGrabberReadback::Result result;
+        while (readback->takeResult(&result, wait)) {
+            QMetaObject::invokeMethod(QCoreApplication::instance(), [grabber = grabber, result]() {
+                if (grabber) {
+                    QWaylandSurfaceGrabberPrivate::get(grabber)->updateFrame(result.pixels, result.rect,
+                                                                             result.size, result.damage);
+                }
+            }, Qt::QueuedConnection);
+            wait = false;
+        }
+    }
+};
+#endif
+
 /*!
  * Grab the surface content from the given \a buffer.
  * Reimplemented from QWaylandCompositor::grabSurface.
@@ -101,6 +161,32 @@ void QWaylandQuickCompositor::grabSurface(QWaylandSurfaceGrabber *grabber, const
         return;
     }
 
+    QQuickWindow *window = static_cast<QQuickWindow *>(output->window());
+    QWaylandSurfaceGrabberPrivate *grabberPrivate = QWaylandSurfaceGrabberPrivate::get(grabber);
+    if (grabberPrivate->streaming) {
+        if (!grabberPrivate->readback) {
+            auto readback = std::make_shared<QWaylandSurfaceGrabberReadback>();
+            grabberPrivate->readback = readback;
+            // the GL resources have to be released on the render thread
+            grabberPrivate->releaseReadback = [window = QPointer<QQuickWindow>(window), readback]() {
+                if (window) {
+                    window->scheduleRenderJob(QRunnable::create([readback]() {}),
+                                              QQuickWindow::AfterRenderingStage);
+                }
+            };
+        }
+
+        auto *job = new StreamingGrabJob;
+        job->grabber = grabber;
+        job->readback = grabberPrivate->readback;
+        job->window = window;
+        job->buffer = buffer;
+        job->damage = grabberPrivate->grabDamage;
+        window->scheduleRenderJob(job, QQuickWindow::AfterRenderingStage);
+        window->update();
+        return;
+    }
+
     // We cannot grab the surface now, we need to have a current opengl context, so we
     // need to be in the render thread
     class GrabState : public QRunnable
@@ -135,7 +221,7 @@ void QWaylandQuickCompositor::grabSurface(QWaylandSurfaceGrabber *grabber, const
     GrabState *state = new GrabState;
     state->grabber = grabber;
     state->buffer = buffer;
-    static_cast<QQuickWindow *>(output->window())->scheduleRenderJob(state, QQuickWindow::AfterRenderingStage);
+    window->scheduleRenderJob(state, QQuickWindow::AfterRenderingStage);
 #else
     emit grabber->failed(QWaylandSurfaceGrabber::UnknownBufferType);
 #endif
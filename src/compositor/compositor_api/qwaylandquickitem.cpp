@@ -19,6 +19,8 @@
 #endif
 #include <QtWaylandCompositor/private/qwlclientbufferintegration_p.h>
 #include <QtWaylandCompositor/private/qwaylandsurface_p.h>
+#include <QtWaylandCompositor/private/qwlclientbuffer_p.h>
+#include <QtWaylandCompositor/private/qwaylandbufferref_p.h>
 
 #if QT_CONFIG(opengl)
 #  include <QtOpenGL/QOpenGLTexture>
@@ -34,8 +36,6 @@
 #include <QtQuick/qsgtexture.h>
 
 #include <QtCore/QFile>
-#include <QtCore/QMutexLocker>
-#include <QtCore/QMutex>
 
 #include <wayland-server-core.h>
 #include <QThread>
@@ -369,8 +369,6 @@ void QWaylandBufferMaterial::setBufferRef(QWaylandQuickItem *surfaceItem, const
 }
 #endif // QT_CONFIG(opengl)
 
-QMutex *QWaylandQuickItemPrivate::mutex = nullptr;
-
 class QWaylandSurfaceTextureProvider : public QSGTextureProvider
 {
 public:
@@ -391,7 +389,15 @@ public:
         m_sgTex = nullptr;
         if (m_ref.hasBuffer()) {
             if (buffer.isSharedMemory()) {
-                m_sgTex = surfaceItem->window()->createTextureFromImage(buffer.image());
+                QWaylandCompositor *compositor = surfaceItem->compositor();
+                if (compositor && !compositor->retainSharedMemoryBuffers()) {
+                    // The texture is only uploaded while rendering, give it its own
+                    // copy of the pixels so the client can have the buffer back now.
+                    m_sgTex = surfaceItem->window()->createTextureFromImage(buffer.image().copy());
+                    QWaylandBufferRefPrivate::get(buffer)->contentsCopied();
+                } else {
+                    m_sgTex = surfaceItem->window()->createTextureFromImage(buffer.image());
+                }
             } else {
 #if QT_CONFIG(opengl)
                 QQuickWindow::CreateTextureOptions opt;
@@ -474,7 +480,6 @@ QWaylandQuickItem::~QWaylandQuickItem()
 {
     Q_D(QWaylandQuickItem);
     disconnect(this, &QQuickItem::windowChanged, this, &QWaylandQuickItem::updateWindow);
-    QMutexLocker locker(d->mutex);
     if (d->provider)
         d->provider->deleteLater();
 }
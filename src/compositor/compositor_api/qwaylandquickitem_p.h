@@ -25,7 +25,6 @@
 QT_BEGIN_NAMESPACE
 
 class QWaylandSurfaceTextureProvider;
-class QMutex;
 class QOpenGLTexture;
 
 #if QT_CONFIG(opengl)
@@ -78,9 +77,6 @@ public:
     void init()
     {
         Q_Q(QWaylandQuickItem);
-        if (!mutex)
-            mutex = new QMutex;
-
         view.reset(new QWaylandView(q));
         q->setFlag(QQuickItem::ItemHasContents);
 
@@ -128,8 +124,6 @@ public:
     virtual void raise();
     virtual void lower();
 
-    static QMutex *mutex;
-
     QScopedPointer<QWaylandView> view;
     QPointer<QWaylandSurface> oldSurface;
     mutable QWaylandSurfaceTextureProvider *provider = nullptr;
@@ -113,6 +113,11 @@ void QWaylandSeatPrivate::seat_get_touch(wl_seat::Resource *resource, uint32_t i
     }
 }
 
+void QWaylandSeatPrivate::seat_release(wl_seat::Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
 /*!
  * \qmltype WaylandSeat
  * \instantiates QWaylandSeat
@@ -180,7 +185,7 @@ QWaylandSeat::~QWaylandSeat()
 void QWaylandSeat::initialize()
 {
     Q_D(QWaylandSeat);
-    d->init(d->compositor->display(), 4);
+    d->init(d->compositor->display(), 5);
 
     if (d->capabilities & QWaylandSeat::Pointer)
         d->pointer.reset(QWaylandCompositorPrivate::get(d->compositor)->callCreatePointerDevice(this));
@@ -533,6 +538,36 @@ void QWaylandSeat::sendKeyEvent(int qtKey, bool pressed)
     }
 }
 
+/*!
+ * \qmlmethod bool QtWaylandCompositor::WaylandSeat::typeText(string text)
+ * \since 6.5
+ *
+ * Sends key press and release events that type \a text to the keyboard focus,
+ * holding Shift for the characters that need it. Returns \c true if the current
+ * keymap could produce every character of \a text.
+ */
+
+/*!
+ * Sends key press and release events that type \a text to the keyboard focus,
+ * holding Shift for the characters that need it. All events are sent before
+ * the client is flushed once.
+ *
+ * Characters the current keymap cannot produce are skipped. Returns \c true
+ * if every character of \a text was typed.
+ *
+ * \since 6.5
+ */
+bool QWaylandSeat::typeText(const QString &text)
+{
+    Q_D(QWaylandSeat);
+    if (!keyboardFocus()) {
+        qWarning("Cannot send Wayland key event, no keyboard focus, fix the compositor");
+        return false;
+    }
+
+    return QWaylandKeyboardPrivate::get(d->keyboard.data())->typeText(text);
+}
+
 /*!
  * Returns the keyboard for this input device.
  */
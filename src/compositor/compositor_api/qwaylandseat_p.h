@@ -74,6 +74,7 @@ protected:
                            uint32_t id) override;
     void seat_get_touch(wl_seat::Resource *resource,
                         uint32_t id) override;
+    void seat_release(wl_seat::Resource *resource) override;
 
     void seat_destroy_resource(wl_seat::Resource *resource) override;
 
@@ -32,6 +32,7 @@
 
 #include <QtCore/QDebug>
 #include <QtCore/QtMath>
+#include <QtCore/QSocketNotifier>
 
 QT_BEGIN_NAMESPACE
 
@@ -101,6 +102,12 @@ QWaylandSurfacePrivate::~QWaylandSurfacePrivate()
 
     bufferRef = QWaylandBufferRef();
 
+    delete acquireFenceNotifier;
+    for (const DeferredCommit &commit : std::as_const(deferredCommits)) {
+        for (QtWayland::FrameCallback *c : commit.frameCallbacks)
+            c->destroy();
+    }
+    deferredCommits.clear();
     for (QtWayland::FrameCallback *c : std::as_const(pendingFrameCallbacks))
         c->destroy();
     for (QtWayland::FrameCallback *c : std::as_const(frameCallbacks))
@@ -111,6 +118,8 @@ void QWaylandSurfacePrivate::removeFrameCallback(QtWayland::FrameCallback *callb
 {
     pendingFrameCallbacks.removeOne(callback);
     frameCallbacks.removeOne(callback);
+    for (DeferredCommit &commit : deferredCommits)
+        commit.frameCallbacks.removeOne(callback);
 }
 
 void QWaylandSurfacePrivate::notifyViewsAboutDestruction()
@@ -213,6 +222,67 @@ void QWaylandSurfacePrivate::surface_set_input_region(Resource *, struct wl_reso
 }
 
 void QWaylandSurfacePrivate::surface_commit(Resource *)
+{
+    PendingState state = pending;
+    QList<QtWayland::FrameCallback *> callbacks = pendingFrameCallbacks;
+
+    // Clear per-commit state
+    pending.buffer = QWaylandBufferRef();
+    pending.offset = QPoint();
+    pending.newlyAttached = false;
+    pending.damage = QRegion();
+    pending.damageInBufferCoordinates = false;
+    pending.acquireFence.reset();
+    pending.releaseFence.reset();
+    pendingFrameCallbacks.clear();
+
+    // Commits are applied in order, so everything behind a commit that still
+    // waits for its buffer to be ready has to wait as well.
+    if (!deferredCommits.isEmpty() || (state.acquireFence && !state.acquireFence->isSignaled())) {
+        deferredCommits.append({state, callbacks});
+        watchAcquireFence();
+        return;
+    }
+
+    applyCommit(state, callbacks);
+}
+
+void QWaylandSurfacePrivate::watchAcquireFence()
+{
+    if (acquireFenceNotifier || deferredCommits.isEmpty())
+        return;
+
+    Q_Q(QWaylandSurface);
+    const auto &fence = deferredCommits.constFirst().state.acquireFence;
+    if (!fence || !fence->isValid() || fence->isSignaled()) {
+        QMetaObject::invokeMethod(q, [this]() { applyDeferredCommits(); }, Qt::QueuedConnection);
+        return;
+    }
+
+    acquireFenceNotifier = new QSocketNotifier(fence->fd(), QSocketNotifier::Read);
+    QObject::connect(acquireFenceNotifier, &QSocketNotifier::activated, q, [this]() {
+        // the notifier can't be deleted from inside its own signal
+        acquireFenceNotifier->setEnabled(false);
+        acquireFenceNotifier->deleteLater();
+        acquireFenceNotifier = nullptr;
+        applyDeferredCommits();
+    });
+}
+
+void QWaylandSurfacePrivate::applyDeferredCommits()
+{
+    while (!deferredCommits.isEmpty()) {
+        const auto &fence = deferredCommits.constFirst().state.acquireFence;
+        if (fence && !fence->isSignaled()) {
+            watchAcquireFence();
+            return;
+        }
+        const DeferredCommit commit = deferredCommits.takeFirst();
+        applyCommit(commit.state, commit.frameCallbacks);
+    }
+}
+
+void QWaylandSurfacePrivate::applyCommit(const PendingState &state, const QList<QtWayland::FrameCallback *> &callbacks)
 {
     Q_Q(QWaylandSurface);
 
@@ -224,19 +294,19 @@ void QWaylandSurfacePrivate::surface_commit(Resource *)
     int oldBufferScale = bufferScale;
 
     // Update all internal state
-    if (pending.buffer.hasBuffer() || pending.newlyAttached)
-        bufferRef = pending.buffer;
-    bufferScale = pending.bufferScale;
+    if (state.buffer.hasBuffer() || state.newlyAttached)
+        bufferRef = state.buffer;
+    bufferScale = state.bufferScale;
     bufferSize = bufferRef.size();
     QSize surfaceSize = bufferSize / bufferScale;
-    sourceGeometry = !pending.sourceGeometry.isValid() ? QRect(QPoint(), surfaceSize) : pending.sourceGeometry;
-    destinationSize = pending.destinationSize.isEmpty() ? sourceGeometry.size().toSize() : pending.destinationSize;
+    sourceGeometry = !state.sourceGeometry.isValid() ? QRect(QPoint(), surfaceSize) : state.sourceGeometry;
+    destinationSize = state.destinationSize.isEmpty() ? sourceGeometry.size().toSize() : state.destinationSize;
     QRect destinationRect(QPoint(), destinationSize);
-    if (!pending.damageInBufferCoordinates || pending.bufferScale == 1) {
-        // pending.damage is already in surface coordinates
-        damage = pending.damage.intersected(QRect(QPoint(), destinationSize));
+    if (!state.damageInBufferCoordinates || state.bufferScale == 1) {
+        // state.damage is already in surface coordinates
+        damage = state.damage.intersected(QRect(QPoint(), destinationSize));
     } else {
-        // We must transform pending.damage from buffer coordinate system to surface coordinates
+        // We must transform state.damage from buffer coordinate system to surface coordinates
         // TODO(QTBUG-85461): Also support wp_viewport setting more complex transformations
         auto xform = [](const QRect &r, int scale) -> QRect {
             QRect res{
@@ -246,36 +316,33 @@ void QWaylandSurfacePrivate::surface_commit(Resource *)
             return res;
         };
         damage = {};
-        for (const QRect &r : pending.damage) {
+        for (const QRect &r : state.damage) {
             damage |= xform(r, bufferScale).intersected(destinationRect);
         }
     }
     hasContent = bufferRef.hasContent();
-    frameCallbacks << pendingFrameCallbacks;
-    inputRegion = pending.inputRegion.intersected(destinationRect);
-    opaqueRegion = pending.opaqueRegion.intersected(destinationRect);
+    frameCallbacks << callbacks;
+    inputRegion = state.inputRegion.intersected(destinationRect);
+    opaqueRegion = state.opaqueRegion.intersected(destinationRect);
     bool becameOpaque = opaqueRegion.boundingRect().contains(destinationRect);
     if (becameOpaque != isOpaque) {
         isOpaque = becameOpaque;
         emit q->isOpaqueChanged();
     }
 
-    QPoint offsetForNextFrame = pending.offset;
+    QPoint offsetForNextFrame = state.offset;
 
     if (viewport)
-        viewport->checkCommittedState();
-
-    // Clear per-commit state
-    pending.buffer = QWaylandBufferRef();
-    pending.offset = QPoint();
-    pending.newlyAttached = false;
-    pending.damage = QRegion();
-    pending.damageInBufferCoordinates = false;
-    pendingFrameCallbacks.clear();
+        viewport->checkCommittedState(state.destinationSize, state.sourceGeometry);
 
     // Notify buffers and views
-    if (auto *buffer = bufferRef.buffer())
+    if (auto *buffer = bufferRef.buffer()) {
+        if (state.buffer.hasBuffer())
+            buffer->setReleaseFence(state.releaseFence);
         buffer->setCommitted(damage);
+    }
+    if (state.releaseFence && !state.buffer.hasBuffer())
+        state.releaseFence->signal();
     for (auto *view : std::as_const(views))
         view->bufferCommitted(bufferRef, damage);
 
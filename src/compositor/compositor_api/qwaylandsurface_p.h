@@ -33,12 +33,15 @@
 
 #include <QtCore/QTextStream>
 #include <QtCore/QMetaType>
+#include <QtCore/QSharedPointer>
 
 #include <wayland-util.h>
 
 #include <QtWaylandCompositor/private/qwayland-server-wayland.h>
 #include <QtWaylandCompositor/private/qwaylandviewporter_p.h>
 #include <QtWaylandCompositor/private/qwaylandidleinhibitv1_p.h>
+#include <QtWaylandCompositor/private/qwaylandfractionalscalev1_p.h>
+#include <QtWaylandCompositor/private/qwlfence_p.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -46,6 +49,7 @@ class QWaylandCompositor;
 class QWaylandSurface;
 class QWaylandView;
 class QWaylandInputMethodControl;
+class QSocketNotifier;
 
 namespace QtWayland {
 class FrameCallback;
@@ -81,6 +85,33 @@ public:
     bool isSubsurface() const { return subsurface; }
     QWaylandSurfacePrivate *parentSurface() const { return subsurface ? subsurface->parentSurface : nullptr; }
 
+    // Explicit synchronization: the next commit is not applied before the
+    // acquire fence signals, and the release fence is signalled once the
+    // compositor is done with the committed buffer.
+    void setAcquireFence(const QSharedPointer<QtWayland::Fence> &fence) { pending.acquireFence = fence; }
+    void setReleaseFence(const QSharedPointer<QtWayland::Fence> &fence) { pending.releaseFence = fence; }
+    bool hasDeferredCommits() const { return !deferredCommits.isEmpty(); }
+
+    struct PendingState {
+        QWaylandBufferRef buffer;
+        QRegion damage;
+        bool damageInBufferCoordinates = false;
+        QPoint offset;
+        bool newlyAttached = false;
+        QRegion inputRegion;
+        int bufferScale = 1;
+        QRectF sourceGeometry;
+        QSize destinationSize;
+        QRegion opaqueRegion;
+        QSharedPointer<QtWayland::Fence> acquireFence;
+        QSharedPointer<QtWayland::Fence> releaseFence;
+    };
+
+    struct DeferredCommit {
+        PendingState state;
+        QList<QtWayland::FrameCallback *> frameCallbacks;
+    };
+
 protected:
     void surface_destroy_resource(Resource *resource) override;
 
@@ -102,6 +133,10 @@ protected:
 
     QtWayland::ClientBuffer *getBuffer(struct ::wl_resource *buffer);
 
+    void applyCommit(const PendingState &state, const QList<QtWayland::FrameCallback *> &callbacks);
+    void watchAcquireFence();
+    void applyDeferredCommits();
+
 public: //member variables
     QWaylandCompositor *compositor = nullptr;
     int refCount = 1;
@@ -111,19 +146,12 @@ public: //member variables
     QWaylandBufferRef bufferRef;
     QWaylandSurfaceRole *role = nullptr;
     QWaylandViewporterPrivate::Viewport *viewport = nullptr;
+    QWaylandFractionalScaleManagerV1Private::FractionalScale *fractionalScale = nullptr;
 
-    struct {
-        QWaylandBufferRef buffer;
-        QRegion damage;
-        bool damageInBufferCoordinates = false;
-        QPoint offset;
-        bool newlyAttached = false;
-        QRegion inputRegion;
-        int bufferScale = 1;
-        QRectF sourceGeometry;
-        QSize destinationSize;
-        QRegion opaqueRegion;
-    } pending;
+    PendingState pending;
+    // commits waiting for their acquire fence, applied in order
+    QList<DeferredCommit> deferredCommits;
+    QSocketNotifier *acquireFenceNotifier = nullptr;
 
     QPoint lastLocalMousePos;
     QPoint lastGlobalMousePos;
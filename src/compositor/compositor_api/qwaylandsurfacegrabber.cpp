@@ -2,12 +2,46 @@
 // SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
 
 #include "qwaylandsurfacegrabber.h"
+#include "qwaylandsurfacegrabber_p.h"
 
 #include <QtCore/private/qobject_p.h>
 #include <QtWaylandCompositor/qwaylandsurface.h>
 #include <QtWaylandCompositor/qwaylandcompositor.h>
 #include <QtWaylandCompositor/private/qwaylandsurface_p.h>
 
+#if QT_CONFIG(opengl)
+#include <QtGui/QOffscreenSurface>
+#include <QtGui/QOpenGLContext>
+#include <QtGui/QOpenGLExtraFunctions>
+#include <QtGui/QMatrix4x4>
+#include <QtOpenGL/QOpenGLFramebufferObject>
+#include <QtOpenGL/QOpenGLTexture>
+
+#ifndef GL_PIXEL_PACK_BUFFER
+#define GL_PIXEL_PACK_BUFFER 0x88EB
+#endif
+#ifndef GL_STREAM_READ
+#define GL_STREAM_READ 0x88E1
+#endif
+#ifndef GL_MAP_READ_BIT
+#define GL_MAP_READ_BIT 0x0001
+#endif
+#ifndef GL_SYNC_GPU_COMMANDS_COMPLETE
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#endif
+#ifndef GL_SYNC_FLUSH_COMMANDS_BIT
+#define GL_SYNC_FLUSH_COMMANDS_BIT 0x00000001
+#endif
+#ifndef GL_TIMEOUT_EXPIRED
+#define GL_TIMEOUT_EXPIRED 0x911B
+#endif
+#ifndef GL_TIMEOUT_IGNORED
+#define GL_TIMEOUT_IGNORED 0xFFFFFFFFFFFFFFFFull
+#endif
+#endif
+
+#include <cstring>
+
 QT_BEGIN_NAMESPACE
 
 /*!
@@ -20,6 +54,11 @@ QT_BEGIN_NAMESPACE
     to the user. The QWaylandSurfaceGrabber class provides a simple method to do so, without
     having to care what type of buffer backs the surface, be it shared memory, OpenGL or something
     else.
+
+    By default every grab reads back the whole surface and delivers a new image through
+    success(). A grabber that is set to \l {setStreaming()}{streaming} instead keeps its resources
+    between grabs, only updates the parts of the surface that were damaged since the last grab,
+    and delivers the result through frameReady().
 */
 
 /*!
@@ -33,12 +72,289 @@ QT_BEGIN_NAMESPACE
     \value RendererNotReady The compositor renderer is not ready to grab the surface content.
  */
 
-class QWaylandSurfaceGrabberPrivate : public QObjectPrivate
+QWaylandSurfaceGrabberPrivate::~QWaylandSurfaceGrabberPrivate()
+{
+#if QT_CONFIG(opengl)
+    if (readback && releaseReadback)
+        releaseReadback();
+#endif
+}
+
+void QWaylandSurfaceGrabberPrivate::surfaceDamaged(const QRegion &damage)
 {
-    Q_DECLARE_PUBLIC(QWaylandSurfaceGrabber)
+    const int scale = surface->bufferScale();
+    // With a viewport the damage can't simply be scaled into the buffer
+    if (surface->destinationSize() * scale != surface->bufferSize()) {
+        needsFullFrame = true;
+        return;
+    }
+
+    if (scale == 1) {
+        pendingDamage += damage;
+        return;
+    }
+    for (const QRect &rect : damage)
+        pendingDamage += QRect(rect.topLeft() * scale, rect.size() * scale);
+}
+
+QRegion QWaylandSurfaceGrabberPrivate::takeDamage(const QWaylandBufferRef &buffer)
+{
+    const QRect bufferRect(QPoint(), buffer.size());
+    QRegion damage;
+    if (needsFullFrame || grabbedSize != buffer.size())
+        damage = bufferRect;
+    else
+        damage = pendingDamage.intersected(bufferRect);
+
+    pendingDamage = QRegion();
+    needsFullFrame = false;
+    grabbedSize = buffer.size();
+    return damage;
+}
+
+void QWaylandSurfaceGrabberPrivate::updateFrame(const QImage &source, const QRegion &damage)
+{
+    Q_Q(QWaylandSurfaceGrabber);
+    if (frame.size() != source.size() || frame.format() != source.format() || source.depth() < 8) {
+        frame = source.copy();
+        emit q->frameReady(frame, QRegion(frame.rect()));
+        return;
+    }
+
+    const int bytesPerPixel = source.depth() / 8;
+    for (const QRect &damageRect : damage) {
+        const QRect rect = damageRect.intersected(source.rect());
+        const int offset = rect.x() * bytesPerPixel;
+        const int length = rect.width() * bytesPerPixel;
+        for (int y = rect.top(); y <= rect.bottom(); ++y)
+            memcpy(frame.scanLine(y) + offset, source.constScanLine(y) + offset, length);
+    }
+    emit q->frameReady(frame, damage);
+}
+
+void QWaylandSurfaceGrabberPrivate::updateFrame(const QImage &pixels, const QRect &rect, const QSize &size, const QRegion &damage)
+{
+    Q_Q(QWaylandSurfaceGrabber);
+    if (!streaming)
+        return;
 
-    QWaylandSurface *surface = nullptr;
-};
+    if (frame.size() != size || frame.format() != QImage::Format_RGBA8888_Premultiplied) {
+        frame = QImage(size, QImage::Format_RGBA8888_Premultiplied);
+        frame.fill(Qt::transparent);
+    }
+
+    const int offset = rect.x() * 4;
+    const int length = rect.width() * 4;
+    for (int y = 0; y < rect.height(); ++y)
+        memcpy(frame.scanLine(rect.y() + y) + offset, pixels.constScanLine(rect.height() - 1 - y), length);
+    emit q->frameReady(frame, damage);
+}
+
+#if QT_CONFIG(opengl)
+QWaylandSurfaceGrabberReadback::QWaylandSurfaceGrabberReadback() = default;
+
+QWaylandSurfaceGrabberReadback::~QWaylandSurfaceGrabberReadback()
+{
+    QObject::disconnect(m_contextDestroyedConnection);
+    if (m_context && QOpenGLContext::currentContext() == m_context)
+        releaseResources();
+    delete m_fbo;
+}
+
+void QWaylandSurfaceGrabberReadback::release()
+{
+    if (!m_context)
+        return;
+
+    QObject::disconnect(m_contextDestroyedConnection);
+    QOpenGLContext *previousContext = QOpenGLContext::currentContext();
+    if (previousContext == m_context) {
+        releaseResources();
+        return;
+    }
+
+    QSurface *previousSurface = previousContext ? previousContext->surface() : nullptr;
+    QOffscreenSurface surface;
+    surface.setFormat(m_context->format());
+    surface.create();
+    if (m_context->makeCurrent(&surface)) {
+        releaseResources();
+        m_context->doneCurrent();
+    } else {
+        // The objects go away together with the context
+        qWarning("QWaylandSurfaceGrabber: Could not make the context current to release the read back");
+        m_context = nullptr;
+        for (Transfer &transfer : m_transfers)
+            transfer = Transfer();
+    }
+    if (previousContext)
+        previousContext->makeCurrent(previousSurface);
+}
+
+void QWaylandSurfaceGrabberReadback::releaseResources()
+{
+    QOpenGLExtraFunctions *f = m_context->extraFunctions();
+    for (Transfer &transfer : m_transfers) {
+        if (transfer.fence)
+            f->glDeleteSync(transfer.fence);
+        if (transfer.pbo)
+            f->glDeleteBuffers(1, &transfer.pbo);
+        transfer = Transfer();
+    }
+    m_blitter.destroy();
+    delete m_fbo;
+    m_fbo = nullptr;
+    m_context = nullptr;
+    m_nextTransfer = 0;
+    m_oldestTransfer = 0;
+}
+
+bool QWaylandSurfaceGrabberReadback::hasPendingTransfers() const
+{
+    return m_hasSynchronousResult || m_transfers[0].pending || m_transfers[1].pending;
+}
+
+bool QWaylandSurfaceGrabberReadback::isFull() const
+{
+    return m_hasSynchronousResult || m_transfers[m_nextTransfer].pending;
+}
+
+bool QWaylandSurfaceGrabberReadback::ensureInitialized()
+{
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    if (!context)
+        return false;
+    if (m_context)
+        return m_context == context;
+
+    m_context = context;
+    // a context going away takes the read backs in flight with it
+    m_contextDestroyedConnection = QObject::connect(context, &QOpenGLContext::aboutToBeDestroyed,
+                                                    [this]() { release(); });
+    const QSurfaceFormat format = context->format();
+    // pixel buffer objects, glMapBufferRange and fence syncs
+    m_asynchronous = context->isOpenGLES() ? format.majorVersion() >= 3
+                                           : format.version() >= qMakePair(3, 2);
+    return m_blitter.create();
+}
+
+bool QWaylandSurfaceGrabberReadback::start(const QWaylandBufferRef &buffer, const QRegion &damage)
+{
+    if (isFull() || !ensureInitialized())
+        return false;
+
+    QOpenGLTexture *texture = buffer.toOpenGLTexture();
+    if (!texture)
+        return false;
+
+    const QSize size = buffer.size();
+    if (!m_fbo || m_fbo->size() != size) {
+        delete m_fbo;
+        m_fbo = new QOpenGLFramebufferObject(size);
+    }
+
+    QOpenGLExtraFunctions *f = m_context->extraFunctions();
+    m_fbo->bind();
+    f->glViewport(0, 0, size.width(), size.height());
+
+    QOpenGLTextureBlitter::Origin surfaceOrigin =
+        buffer.origin() == QWaylandSurface::OriginTopLeft
+        ? QOpenGLTextureBlitter::OriginTopLeft
+        : QOpenGLTextureBlitter::OriginBottomLeft;
+
+    m_blitter.bind(texture->target());
+    m_blitter.blit(texture->textureId(), QMatrix4x4(), surfaceOrigin);
+    m_blitter.release();
+
+    // Only the bounding rect of the damage is read back, GL counts rows from the bottom
+    const QRect rect = damage.boundingRect().intersected(QRect(QPoint(), size));
+    const int glY = size.height() - rect.y() - rect.height();
+    const int byteCount = rect.width() * rect.height() * 4;
+
+    if (!m_asynchronous) {
+        QImage pixels(rect.size(), QImage::Format_RGBA8888_Premultiplied);
+        if (byteCount > 0)
+            f->glReadPixels(rect.x(), glY, rect.width(), rect.height(), GL_RGBA, GL_UNSIGNED_BYTE, pixels.bits());
+        m_fbo->release();
+        m_synchronousResult = { pixels, rect, size, damage };
+        m_hasSynchronousResult = true;
+        return true;
+    }
+
+    Transfer &transfer = m_transfers[m_nextTransfer];
+    if (byteCount > 0) {
+        if (!transfer.pbo)
+            f->glGenBuffers(1, &transfer.pbo);
+        f->glBindBuffer(GL_PIXEL_PACK_BUFFER, transfer.pbo);
+        if (transfer.pboSize < byteCount) {
+            f->glBufferData(GL_PIXEL_PACK_BUFFER, byteCount, nullptr, GL_STREAM_READ);
+            transfer.pboSize = byteCount;
+        }
+        f->glReadPixels(rect.x(), glY, rect.width(), rect.height(), GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        f->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+    transfer.fence = f->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    // make sure the fence gets signalled even if nobody waits for it
+    f->glFlush();
+    m_fbo->release();
+
+    transfer.pending = true;
+    transfer.rect = rect;
+    transfer.size = size;
+    transfer.damage = damage;
+    m_nextTransfer = (m_nextTransfer + 1) % 2;
+    return true;
+}
+
+bool QWaylandSurfaceGrabberReadback::takeResult(Result *result, bool wait)
+{
+    if (m_hasSynchronousResult) {
+        *result = m_synchronousResult;
+        m_synchronousResult = Result();
+        m_hasSynchronousResult = false;
+        return true;
+    }
+
+    Transfer &transfer = m_transfers[m_oldestTransfer];
+    if (!transfer.pending || QOpenGLContext::currentContext() != m_context)
+        return false;
+
+    QOpenGLExtraFunctions *f = m_context->extraFunctions();
+    const GLenum status = f->glClientWaitSync(transfer.fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0,
+                                              wait ? GL_TIMEOUT_IGNORED : 0);
+    if (status == GL_TIMEOUT_EXPIRED)
+        return false;
+
+    finishTransfer(&transfer, result);
+    m_oldestTransfer = (m_oldestTransfer + 1) % 2;
+    return true;
+}
+
+void QWaylandSurfaceGrabberReadback::finishTransfer(Transfer *transfer, Result *result)
+{
+    QOpenGLExtraFunctions *f = m_context->extraFunctions();
+    f->glDeleteSync(transfer->fence);
+    transfer->fence = nullptr;
+
+    QImage pixels(transfer->rect.size(), QImage::Format_RGBA8888_Premultiplied);
+    const int byteCount = transfer->rect.width() * transfer->rect.height() * 4;
+    if (byteCount > 0) {
+        f->glBindBuffer(GL_PIXEL_PACK_BUFFER, transfer->pbo);
+        if (void *data = f->glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, byteCount, GL_MAP_READ_BIT)) {
+            memcpy(pixels.bits(), data, byteCount);
+            f->glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        } else {
+            qWarning("QWaylandSurfaceGrabber: Could not map the pixel buffer");
+            pixels.fill(Qt::transparent);
+        }
+        f->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    *result = { pixels, transfer->rect, transfer->size, transfer->damage };
+    transfer->pending = false;
+    transfer->damage = QRegion();
+}
+#endif
 
 /*!
  * Create a QWaylandSurfaceGrabber object with the given \a surface and \a parent
@@ -48,6 +364,9 @@ QWaylandSurfaceGrabber::QWaylandSurfaceGrabber(QWaylandSurface *surface, QObject
 {
     Q_D(QWaylandSurfaceGrabber);
     d->surface = surface;
+
+    // the damage that was taken for a failed grab has to be read again
+    connect(this, &QWaylandSurfaceGrabber::failed, this, [d]() { d->needsFullFrame = true; });
 }
 
 /*!
@@ -59,6 +378,64 @@ QWaylandSurface *QWaylandSurfaceGrabber::surface() const
     return d->surface;
 }
 
+/*!
+ * \since 6.5
+ *
+ * Returns whether this grabber streams the surface content.
+ *
+ * \sa setStreaming()
+ */
+bool QWaylandSurfaceGrabber::isStreaming() const
+{
+    Q_D(const QWaylandSurfaceGrabber);
+    return d->streaming;
+}
+
+/*!
+ * \since 6.5
+ *
+ * Sets whether this grabber streams the surface content to \a streaming.
+ *
+ * A streaming grabber is meant to be used for grabbing the same surface over and over,
+ * for instance to share it remotely. It keeps the framebuffer objects and pixel buffers used
+ * for reading the content of OpenGL buffers around between grabs, and only reads back the
+ * region the client damaged since the previous grab. Where the OpenGL implementation allows it,
+ * the read back is asynchronous, so a frame can be delivered after the following grab was
+ * requested.
+ *
+ * The content is kept in a persistent image, which is delivered together with the region
+ * that changed through frameReady() rather than success(). Keeping a copy of the image
+ * around will make the next frame detach from it.
+ */
+void QWaylandSurfaceGrabber::setStreaming(bool streaming)
+{
+    Q_D(QWaylandSurfaceGrabber);
+    if (d->streaming == streaming)
+        return;
+
+    d->streaming = streaming;
+    disconnect(d->damageConnection);
+    d->pendingDamage = QRegion();
+    d->needsFullFrame = true;
+    if (streaming && d->surface) {
+        d->damageConnection = connect(d->surface, &QWaylandSurface::damaged, this,
+                                      [d](const QRegion &damage) { d->surfaceDamaged(damage); });
+    } else {
+        d->frame = QImage();
+    }
+}
+
+/*!
+ * \fn void QWaylandSurfaceGrabber::frameReady(const QImage &frame, const QRegion &damage)
+ * \since 6.5
+ *
+ * This signal is emitted by a streaming grabber when the content of the surface was grabbed.
+ * \a frame holds the complete surface content and \a damage the region, in buffer
+ * coordinates, which changed since the previous frame.
+ *
+ * \sa setStreaming()
+ */
+
 /*!
  * Grab the content of the surface set on this object.
  * It may not be possible to do that immediately so the success and failed signals
@@ -79,6 +456,9 @@ void QWaylandSurfaceGrabber::grab()
         return;
     }
 
+    if (d->streaming)
+        d->grabDamage = d->takeDamage(buf);
+
     d->surface->compositor()->grabSurface(this, buf);
 }
 
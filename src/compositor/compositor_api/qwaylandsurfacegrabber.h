@@ -11,6 +11,7 @@ QT_BEGIN_NAMESPACE
 
 class QWaylandSurface;
 class QWaylandSurfaceGrabberPrivate;
+class QRegion;
 
 class Q_WAYLANDCOMPOSITOR_EXPORT QWaylandSurfaceGrabber : public QObject
 {
@@ -29,9 +30,13 @@ public:
     QWaylandSurface *surface() const;
     void grab();
 
+    bool isStreaming() const;
+    void setStreaming(bool streaming);
+
 Q_SIGNALS:
     void success(const QImage &image);
     void failed(Error error);
+    void frameReady(const QImage &frame, const QRegion &damage);
 };
 
 QT_END_NAMESPACE
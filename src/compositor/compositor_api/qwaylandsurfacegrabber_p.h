@@ -0,0 +1,146 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#ifndef QWAYLANDSURFACEGRABBER_P_H
+#define QWAYLANDSURFACEGRABBER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtWaylandCompositor/qtwaylandcompositorglobal.h>
+#include <QtWaylandCompositor/qwaylandsurfacegrabber.h>
+#include <QtWaylandCompositor/qwaylandbufferref.h>
+
+#include <QtCore/private/qobject_p.h>
+#include <QtCore/QPointer>
+#include <QtGui/QImage>
+#include <QtGui/QRegion>
+
+#if QT_CONFIG(opengl)
+#include <QtGui/QOpenGLExtraFunctions>
+#include <QtOpenGL/QOpenGLTextureBlitter>
+#endif
+
+#include <functional>
+#include <memory>
+
+QT_BEGIN_NAMESPACE
+
+class QWaylandSurface;
+#if QT_CONFIG(opengl)
+class QOpenGLContext;
+class QOpenGLFramebufferObject;
+class QWaylandSurfaceGrabberReadback;
+#endif
+
+class Q_WAYLANDCOMPOSITOR_EXPORT QWaylandSurfaceGrabberPrivate : public QObjectPrivate
+{
+    Q_DECLARE_PUBLIC(QWaylandSurfaceGrabber)
+public:
+    static QWaylandSurfaceGrabberPrivate *get(QWaylandSurfaceGrabber *grabber) { return grabber->d_func(); }
+
+    ~QWaylandSurfaceGrabberPrivate() override;
+
+    void surfaceDamaged(const QRegion &damage);
+    QRegion takeDamage(const QWaylandBufferRef &buffer);
+
+    // Copies the damaged parts of a shared memory buffer into the frame
+    void updateFrame(const QImage &source, const QRegion &damage);
+    // Copies pixels read back from the GPU into the frame. The pixels cover
+    // rect, with the bottom row first.
+    void updateFrame(const QImage &pixels, const QRect &rect, const QSize &size, const QRegion &damage);
+
+    QPointer<QWaylandSurface> surface;
+    bool streaming = false;
+    QMetaObject::Connection damageConnection;
+
+    // persistent image handed out by frameReady()
+    QImage frame;
+    // damage in buffer coordinates since the last streaming grab
+    QRegion pendingDamage;
+    bool needsFullFrame = true;
+    QSize grabbedSize;
+    // damage of the grab currently being handed to the compositor
+    QRegion grabDamage;
+
+#if QT_CONFIG(opengl)
+    // used by the thread with the GL context the grabs run in
+    std::shared_ptr<QWaylandSurfaceGrabberReadback> readback;
+    // hands the last reference to the read back over to that thread
+    std::function<void()> releaseReadback;
+#endif
+};
+
+#if QT_CONFIG(opengl)
+// Renders a buffer into a reused framebuffer object and reads the damaged
+// part back. Where pixel buffer objects and fence syncs are available the
+// read back is asynchronous, so the GPU pipeline does not stall.
+class Q_WAYLANDCOMPOSITOR_EXPORT QWaylandSurfaceGrabberReadback
+{
+public:
+    struct Result {
+        QImage pixels;
+        QRect rect;
+        QSize size;
+        QRegion damage;
+    };
+
+    QWaylandSurfaceGrabberReadback();
+    ~QWaylandSurfaceGrabberReadback();
+
+    // Releases the GL resources. Makes the context the read backs were
+    // started in current on an offscreen surface if it is not current, so
+    // it has to be called on the thread of that context.
+    void release();
+
+    bool isAsynchronous() const { return m_asynchronous; }
+    bool hasPendingTransfers() const;
+    // true if a result has to be taken before the next start()
+    bool isFull() const;
+
+    // Returns false if the buffer can't be rendered
+    bool start(const QWaylandBufferRef &buffer, const QRegion &damage);
+    // Collects the oldest finished transfer, waiting for it if wait is true
+    bool takeResult(Result *result, bool wait);
+
+private:
+    struct Transfer {
+        GLuint pbo = 0;
+        int pboSize = 0;
+        GLsync fence = nullptr;
+        bool pending = false;
+        QRect rect;
+        QSize size;
+        QRegion damage;
+    };
+
+    bool ensureInitialized();
+    void finishTransfer(Transfer *transfer, Result *result);
+    // needs m_context to be current
+    void releaseResources();
+
+    QOpenGLContext *m_context = nullptr;
+    QMetaObject::Connection m_contextDestroyedConnection;
+    QOpenGLFramebufferObject *m_fbo = nullptr;
+    QOpenGLTextureBlitter m_blitter;
+    bool m_asynchronous = false;
+    Transfer m_transfers[2];
+    int m_nextTransfer = 0;
+    int m_oldestTransfer = 0;
+    // read back synchronously when there are no pixel buffer objects
+    Result m_synchronousResult;
+    bool m_hasSynchronousResult = false;
+};
+#endif
+
+QT_END_NAMESPACE
+
+#endif // QWAYLANDSURFACEGRABBER_P_H
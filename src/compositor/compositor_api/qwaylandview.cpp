@@ -10,8 +10,6 @@
 #include <QtWaylandCompositor/private/qwaylandsurface_p.h>
 #include <QtWaylandCompositor/private/qwaylandoutput_p.h>
 
-#include <QtCore/QMutex>
-
 QT_BEGIN_NAMESPACE
 
 void QWaylandViewPrivate::markSurfaceAsDestroyed(QWaylandSurface *surface)
@@ -112,9 +110,8 @@ void QWaylandViewPrivate::setSurface(QWaylandSurface *newSurface)
 
     surface = newSurface;
 
-    nextBuffer = QWaylandBufferRef();
-    nextBufferCommitted = false;
-    nextDamage = QRegion();
+    // drop whatever the old surface committed but was not rendered yet
+    publishBufferState(QWaylandBufferRef(), QRegion(), false);
 
     if (surface) {
         QWaylandSurfacePrivate::get(surface)->refView(q);
@@ -126,11 +123,34 @@ void QWaylandViewPrivate::setSurface(QWaylandSurface *newSurface)
 void QWaylandViewPrivate::clearFrontBuffer()
 {
     if (!bufferLocked) {
-        currentBuffer = QWaylandBufferRef();
-        currentDamage = QRegion();
+        frontBufferState() = BufferState();
+        discardedBufferState = BufferState();
     }
 }
 
+// Called by the committing side only
+void QWaylandViewPrivate::publishBufferState(const QWaylandBufferRef &buffer, const QRegion &damage, bool fresh)
+{
+    bufferStates[backStateIndex] = { buffer, damage };
+    const int published = backStateIndex | (fresh ? FreshBufferStateFlag : 0);
+    backStateIndex = pendingBufferState.fetchAndStoreAcqRel(published) & BufferStateIndexMask;
+    // Either an old front state or one that was never rendered, release it
+    // right away so the client gets its buffer back.
+    bufferStates[backStateIndex] = BufferState();
+}
+
+// Called by the rendering side only. Only this side clears the flag, so a
+// fresh state can't disappear between the check and the swap.
+bool QWaylandViewPrivate::takeFreshBufferState()
+{
+    if (!hasFreshBufferState())
+        return false;
+
+    bufferStates[frontStateIndex] = BufferState();
+    frontStateIndex = pendingBufferState.fetchAndStoreAcqRel(frontStateIndex) & BufferStateIndexMask;
+    return true;
+}
+
 void QWaylandView::setSurface(QWaylandSurface *newSurface)
 {
     Q_D(QWaylandView);
@@ -182,15 +202,16 @@ void QWaylandView::setOutput(QWaylandOutput *newOutput)
  * region that needs to be updated.
  * The new \a buffer will become current on the next call to advance().
  *
+ * This function does not block: it may be called while another thread, for
+ * instance a scene graph render thread, calls advance(), currentBuffer() and
+ * currentDamage().
+ *
  * Subclasses that reimplement this function \e must call the base implementation.
  */
 void QWaylandView::bufferCommitted(const QWaylandBufferRef &buffer, const QRegion &damage)
 {
     Q_D(QWaylandView);
-    QMutexLocker locker(&d->bufferMutex);
-    d->nextBuffer = buffer;
-    d->nextDamage = damage;
-    d->nextBufferCommitted = true;
+    d->publishBufferState(buffer, damage, true);
 }
 
 /*!
@@ -198,13 +219,17 @@ void QWaylandView::bufferCommitted(const QWaylandBufferRef &buffer, const QRegio
  * Returns true if new content was committed since the previous call to advance().
  * Otherwise returns false.
  *
+ * advance(), currentBuffer(), currentDamage() and discardCurrentBuffer() must be
+ * called from the same thread, which may be different from the one calling
+ * bufferCommitted().
+ *
  * \sa currentBuffer(), currentDamage()
  */
 bool QWaylandView::advance()
 {
     Q_D(QWaylandView);
 
-    if (!d->nextBufferCommitted && !d->forceAdvanceSucceed)
+    if (!d->hasFreshBufferState() && !d->forceAdvanceSucceed)
         return false;
 
     if (d->bufferLocked)
@@ -213,27 +238,33 @@ bool QWaylandView::advance()
     if (d->surface && d->surface->primaryView() == this) {
         const auto views = d->surface->views();
         for (QWaylandView *view : views) {
-            if (view != this && view->allowDiscardFrontBuffer() && view->d_func()->currentBuffer == d->currentBuffer)
+            if (view != this && view->allowDiscardFrontBuffer()
+                    && view->d_func()->frontBufferState().buffer == d->frontBufferState().buffer)
                 view->discardCurrentBuffer();
         }
     }
 
-    QMutexLocker locker(&d->bufferMutex);
     d->forceAdvanceSucceed = false;
-    d->nextBufferCommitted = false;
-    d->currentBuffer = d->nextBuffer;
-    d->currentDamage = d->nextDamage;
+    if (!d->takeFreshBufferState() && !d->discardedBufferState.buffer.isNull())
+        d->frontBufferState() = d->discardedBufferState;
+    d->discardedBufferState = BufferState();
     return true;
 }
 
 /*!
  * Force the view to discard its current buffer, to allow it to be reused on the client side.
+ *
+ * The next call to advance() returns \c true. If the client has not committed
+ * anything since, it makes the discarded buffer current again.
  */
 void QWaylandView::discardCurrentBuffer()
 {
     Q_D(QWaylandView);
-    QMutexLocker locker(&d->bufferMutex);
-    d->currentBuffer = QWaylandBufferRef();
+    // Without a newer commit the discarded buffer is still the latest one, so
+    // it is kept for advance(). Otherwise it is released right away.
+    if (!d->hasFreshBufferState() && !d->frontBufferState().buffer.isNull())
+        d->discardedBufferState = d->frontBufferState();
+    d->frontBufferState().buffer = QWaylandBufferRef();
     d->forceAdvanceSucceed = true;
 }
 
@@ -243,8 +274,7 @@ void QWaylandView::discardCurrentBuffer()
 QWaylandBufferRef QWaylandView::currentBuffer()
 {
     Q_D(QWaylandView);
-    QMutexLocker locker(&d->bufferMutex);
-    return d->currentBuffer;
+    return d->frontBufferState().buffer;
 }
 
 /*!
@@ -253,8 +283,7 @@ QWaylandBufferRef QWaylandView::currentBuffer()
 QRegion QWaylandView::currentDamage()
 {
     Q_D(QWaylandView);
-    QMutexLocker locker(&d->bufferMutex);
-    return d->currentDamage;
+    return d->frontBufferState().damage;
 }
 
 /*!
@@ -7,7 +7,7 @@
 #include "qwaylandview.h"
 
 #include <QtCore/QPoint>
-#include <QtCore/QMutex>
+#include <QtCore/QAtomicInt>
 #include <QtCore/private/qobject_p.h>
 
 #include <QtWaylandCompositor/QWaylandBufferRef>
@@ -37,20 +37,39 @@ public:
     QWaylandViewPrivate()
     { }
 
+    struct BufferState {
+        QWaylandBufferRef buffer;
+        QRegion damage;
+    };
+
     void markSurfaceAsDestroyed(QWaylandSurface *surface);
     void setSurface(QWaylandSurface *newSurface);
     void clearFrontBuffer();
 
+    void publishBufferState(const QWaylandBufferRef &buffer, const QRegion &damage, bool fresh);
+    bool hasFreshBufferState() const { return pendingBufferState.loadAcquire() & FreshBufferStateFlag; }
+    bool takeFreshBufferState();
+    BufferState &frontBufferState() { return bufferStates[frontStateIndex]; }
+
     QObject *renderObject = nullptr;
     QWaylandSurface *surface = nullptr;
     QWaylandOutput *output = nullptr;
     QPointF requestedPos;
-    QMutex bufferMutex;
-    QWaylandBufferRef currentBuffer;
-    QRegion currentDamage;
-    QWaylandBufferRef nextBuffer;
-    QRegion nextDamage;
-    bool nextBufferCommitted = false;
+
+    // Triple buffered handoff between the thread committing buffers and the
+    // one rendering them: the committing side owns the back slot, the
+    // rendering side owns the front slot, and the third one is swapped
+    // in and out atomically together with a flag telling whether it holds a
+    // state that has not been rendered yet.
+    enum { BufferStateIndexMask = 0x3, FreshBufferStateFlag = 0x4 };
+    BufferState bufferStates[3];
+    QAtomicInt pendingBufferState = 2;
+    int backStateIndex = 1;
+    int frontStateIndex = 0;
+    // Owned by the rendering side: the latest state, kept after
+    // discardCurrentBuffer() for a forced advance() when nothing newer came in
+    BufferState discardedBufferState;
+
     bool bufferLocked = false;
     bool broadcastRequestedPositionChanged = false;
     bool forceAdvanceSucceed = false;
@@ -11,6 +11,7 @@ WAYLANDSERVERSOURCES += \
     ../extensions/qt-text-input-method-unstable-v1.xml \
     ../3rdparty/protocol/text-input-unstable-v2.xml \
     ../3rdparty/protocol/viewporter.xml \
+    ../3rdparty/protocol/fractional-scale-v1.xml \
     ../3rdparty/protocol/scaler.xml \
     ../3rdparty/protocol/xdg-shell.xml \
     ../3rdparty/protocol/xdg-decoration-unstable-v1.xml \
@@ -19,10 +20,13 @@ WAYLANDSERVERSOURCES += \
     ../3rdparty/protocol/idle-inhibit-unstable-v1.xml \
     ../extensions/qt-texture-sharing-unstable-v1.xml \
     ../3rdparty/protocol/presentation-time.xml \
+    ../3rdparty/protocol/wlr-screencopy-unstable-v1.xml \
 
 HEADERS += \
     extensions/qwlqttouch_p.h \
     extensions/qwlqtkey_p.h \
+    extensions/qwltextureatlaspacker_p.h \
+    extensions/qwltexturesharingcache_p.h \
     extensions/qwaylandshell.h \
     extensions/qwaylandshell_p.h \
     extensions/qwaylandwlshell.h \
@@ -35,8 +39,12 @@ HEADERS += \
     extensions/qwaylandqttextinputmethodmanager_p.h \
     extensions/qwaylandqttextinputmethod.h \
     extensions/qwaylandqttextinputmethod_p.h \
+    extensions/qwaylandfractionalscalev1.h \
+    extensions/qwaylandfractionalscalev1_p.h \
     extensions/qwaylandqtwindowmanager.h \
     extensions/qwaylandqtwindowmanager_p.h \
+    extensions/qwaylandscreencopyv1.h \
+    extensions/qwaylandscreencopyv1_p.h \
     extensions/qwaylandviewporter.h \
     extensions/qwaylandviewporter_p.h \
     extensions/qwaylandxdgshell.h \
@@ -56,13 +64,17 @@ HEADERS += \
 SOURCES += \
     extensions/qwlqttouch.cpp \
     extensions/qwlqtkey.cpp \
+    extensions/qwltextureatlaspacker.cpp \
+    extensions/qwltexturesharingcache.cpp \
     extensions/qwaylandshell.cpp \
     extensions/qwaylandwlshell.cpp \
     extensions/qwaylandtextinput.cpp \
     extensions/qwaylandtextinputmanager.cpp \
     extensions/qwaylandqttextinputmethodmanager.cpp \
     extensions/qwaylandqttextinputmethod.cpp \
+    extensions/qwaylandfractionalscalev1.cpp \
     extensions/qwaylandqtwindowmanager.cpp \
+    extensions/qwaylandscreencopyv1.cpp \
     extensions/qwaylandviewporter.cpp \
     extensions/qwaylandxdgshell.cpp \
     extensions/qwaylandxdgdecorationv1.cpp \
@@ -85,6 +97,7 @@ qtConfig(wayland-compositor-quick) {
         extensions/qwaylandxdgshellintegration_p.h \
         extensions/qwaylandpresentationtime_p.h \
         extensions/qwaylandpresentationtime_p_p.h \
+        extensions/qwaylandquickscreencopyv1_p.h \
 
     SOURCES += \
         extensions/qwaylandquickshellintegration.cpp \
@@ -94,6 +107,7 @@ qtConfig(wayland-compositor-quick) {
         extensions/qwaylandquickxdgoutputv1.cpp \
         extensions/qwaylandxdgshellintegration.cpp \
         extensions/qwaylandpresentationtime.cpp \
+        extensions/qwaylandquickscreencopyv1.cpp \
 
     qtConfig(opengl) {
         HEADERS += \
@@ -0,0 +1,208 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#include <QtWaylandCompositor/QWaylandCompositor>
+#include <QtWaylandCompositor/QWaylandOutput>
+#include <QtWaylandCompositor/private/qwaylandsurface_p.h>
+
+#include "qwaylandfractionalscalev1_p.h"
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \class QWaylandFractionalScaleManagerV1
+    \inmodule QtWaylandCompositor
+    \since 6.5
+    \brief Provides an extension that tells clients the fractional scale to render surfaces at.
+    \sa QWaylandOutput::fractionalScaleFactor
+
+    The QWaylandFractionalScaleManagerV1 extension lets the compositor suggest a fractional
+    scale for each surface, so that clients can render at exactly the pixel density of the
+    output instead of rendering at the next integer scale and having the compositor scale
+    the result down. Clients present the scaled buffers through a viewport, so the
+    compositor should also provide QWaylandViewporter.
+
+    The preferred scale of a surface is the highest QWaylandOutput::fractionalScaleFactor of
+    the outputs the surface is on, or of the default output if it isn't on any output yet.
+
+    QWaylandFractionalScaleManagerV1 corresponds to the Wayland interface,
+    \c wp_fractional_scale_manager_v1.
+*/
+
+/*!
+    \qmltype FractionalScaleManagerV1
+    \instantiates QWaylandFractionalScaleManagerV1
+    \inqmlmodule QtWayland.Compositor
+    \since 6.5
+    \brief Provides an extension that tells clients the fractional scale to render surfaces at.
+    \sa WaylandOutput::fractionalScaleFactor
+
+    The FractionalScaleManagerV1 extension lets the compositor suggest a fractional scale for
+    each surface, so that clients can render at exactly the pixel density of the output.
+
+    FractionalScaleManagerV1 corresponds to the Wayland interface,
+    \c wp_fractional_scale_manager_v1.
+
+    To provide the functionality of the extension in a compositor, create an instance of the
+    FractionalScaleManagerV1 component and add it to the list of extensions supported by the
+    compositor:
+
+    \qml
+    import QtWayland.Compositor
+
+    WaylandCompositor {
+        FractionalScaleManagerV1 {
+            // ...
+        }
+    }
+    \endqml
+*/
+
+/*!
+    Constructs a QWaylandFractionalScaleManagerV1 object.
+*/
+QWaylandFractionalScaleManagerV1::QWaylandFractionalScaleManagerV1()
+    : QWaylandCompositorExtensionTemplate<QWaylandFractionalScaleManagerV1>(*new QWaylandFractionalScaleManagerV1Private())
+{
+}
+
+/*!
+    Constructs a QWaylandFractionalScaleManagerV1 object for the provided \a compositor.
+*/
+QWaylandFractionalScaleManagerV1::QWaylandFractionalScaleManagerV1(QWaylandCompositor *compositor)
+    : QWaylandCompositorExtensionTemplate<QWaylandFractionalScaleManagerV1>(compositor, *new QWaylandFractionalScaleManagerV1Private())
+{
+}
+
+/*!
+    Destructs a QWaylandFractionalScaleManagerV1 object.
+*/
+QWaylandFractionalScaleManagerV1::~QWaylandFractionalScaleManagerV1() = default;
+
+/*!
+    Initializes the extension.
+*/
+void QWaylandFractionalScaleManagerV1::initialize()
+{
+    Q_D(QWaylandFractionalScaleManagerV1);
+
+    QWaylandCompositorExtensionTemplate::initialize();
+    QWaylandCompositor *compositor = static_cast<QWaylandCompositor *>(extensionContainer());
+    if (!compositor) {
+        qCWarning(qLcWaylandCompositor) << "Failed to find QWaylandCompositor when initializing QWaylandFractionalScaleManagerV1";
+        return;
+    }
+    d->init(compositor->display(), d->interfaceVersion());
+}
+
+/*!
+    Returns the Wayland interface for the QWaylandFractionalScaleManagerV1.
+*/
+const wl_interface *QWaylandFractionalScaleManagerV1::interface()
+{
+    return QWaylandFractionalScaleManagerV1Private::interface();
+}
+
+void QWaylandFractionalScaleManagerV1Private::wp_fractional_scale_manager_v1_destroy(Resource *resource)
+{
+    // Fractional scale objects are allowed to outlive the manager
+    wl_resource_destroy(resource->handle);
+}
+
+void QWaylandFractionalScaleManagerV1Private::wp_fractional_scale_manager_v1_get_fractional_scale(Resource *resource, uint id, wl_resource *surfaceResource)
+{
+    auto *surface = QWaylandSurface::fromResource(surfaceResource);
+    if (!surface) {
+        qCWarning(qLcWaylandCompositor) << "Couldn't find surface requested for creating a fractional scale";
+        wl_resource_post_error(resource->handle, WL_DISPLAY_ERROR_INVALID_OBJECT,
+                               "invalid wl_surface@%d", wl_resource_get_id(surfaceResource));
+        return;
+    }
+
+    auto *surfacePrivate = QWaylandSurfacePrivate::get(surface);
+    if (surfacePrivate->fractionalScale) {
+        wl_resource_post_error(resource->handle, error_fractional_scale_exists,
+                               "fractional scale already exists for surface");
+        return;
+    }
+
+    surfacePrivate->fractionalScale = new FractionalScale(surface, resource->client(), id, resource->version());
+    surfacePrivate->fractionalScale->updatePreferredScale();
+}
+
+QWaylandFractionalScaleManagerV1Private::FractionalScale::FractionalScale(QWaylandSurface *surface,
+                                                                          wl_client *client,
+                                                                          quint32 id, quint32 version)
+    : QtWaylandServer::wp_fractional_scale_v1(client, id, qMin<quint32>(version, interfaceVersion()))
+    , m_surface(surface)
+{
+    Q_ASSERT(surface);
+}
+
+QWaylandFractionalScaleManagerV1Private::FractionalScale::~FractionalScale()
+{
+    if (m_surface) {
+        auto *surfacePrivate = QWaylandSurfacePrivate::get(m_surface);
+        Q_ASSERT(surfacePrivate->fractionalScale == this);
+        surfacePrivate->fractionalScale = nullptr;
+    }
+}
+
+void QWaylandFractionalScaleManagerV1Private::FractionalScale::outputEntered(QWaylandOutput *output)
+{
+    if (!m_outputs.contains(output))
+        m_outputs.append(output);
+    updatePreferredScale();
+}
+
+void QWaylandFractionalScaleManagerV1Private::FractionalScale::outputLeft(QWaylandOutput *output)
+{
+    m_outputs.removeAll(output);
+    updatePreferredScale();
+}
+
+qreal QWaylandFractionalScaleManagerV1Private::FractionalScale::preferredScale() const
+{
+    qreal scale = 0;
+    for (const QPointer<QWaylandOutput> &output : m_outputs) {
+        if (output)
+            scale = qMax(scale, output->fractionalScaleFactor());
+    }
+
+    if (scale <= 0 && m_surface) {
+        if (QWaylandOutput *output = m_surface->compositor()->defaultOutput())
+            scale = output->fractionalScaleFactor();
+    }
+
+    return scale > 0 ? scale : 1;
+}
+
+// Sends the preferred scale if it has changed since it was last sent
+void QWaylandFractionalScaleManagerV1Private::FractionalScale::updatePreferredScale()
+{
+    if (!m_surface)
+        return;
+
+    // The scale is sent as the numerator of a fraction with a denominator of 120
+    const uint scale = uint(qRound(preferredScale() * 120));
+    if (scale == m_sentScale)
+        return;
+
+    m_sentScale = scale;
+    send_preferred_scale(scale);
+}
+
+void QWaylandFractionalScaleManagerV1Private::FractionalScale::wp_fractional_scale_v1_destroy_resource(Resource *resource)
+{
+    Q_UNUSED(resource);
+    delete this;
+}
+
+void QWaylandFractionalScaleManagerV1Private::FractionalScale::wp_fractional_scale_v1_destroy(Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
+QT_END_NAMESPACE
+
+#include "moc_qwaylandfractionalscalev1.cpp"
@@ -0,0 +1,68 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#ifndef QWAYLANDFRACTIONALSCALEV1_P_H
+#define QWAYLANDFRACTIONALSCALEV1_P_H
+
+#include <QtWaylandCompositor/QWaylandSurface>
+#include <QtWaylandCompositor/QWaylandFractionalScaleManagerV1>
+#include <QtWaylandCompositor/private/qwaylandcompositorextension_p.h>
+#include <QtWaylandCompositor/private/qwayland-server-fractional-scale-v1.h>
+
+#include <QtCore/QPointer>
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+QT_BEGIN_NAMESPACE
+
+class QWaylandOutput;
+
+class Q_WAYLANDCOMPOSITOR_EXPORT QWaylandFractionalScaleManagerV1Private
+        : public QWaylandCompositorExtensionPrivate
+        , public QtWaylandServer::wp_fractional_scale_manager_v1
+{
+    Q_DECLARE_PUBLIC(QWaylandFractionalScaleManagerV1)
+public:
+    explicit QWaylandFractionalScaleManagerV1Private() = default;
+
+    class Q_WAYLANDCOMPOSITOR_EXPORT FractionalScale
+            : public QtWaylandServer::wp_fractional_scale_v1
+    {
+    public:
+        explicit FractionalScale(QWaylandSurface *surface, wl_client *client, quint32 id, quint32 version);
+        ~FractionalScale() override;
+
+        void outputEntered(QWaylandOutput *output);
+        void outputLeft(QWaylandOutput *output);
+        void updatePreferredScale();
+        qreal preferredScale() const;
+
+    protected:
+        void wp_fractional_scale_v1_destroy_resource(Resource *resource) override;
+        void wp_fractional_scale_v1_destroy(Resource *resource) override;
+
+    private:
+        QPointer<QWaylandSurface> m_surface;
+        QList<QPointer<QWaylandOutput>> m_outputs;
+        uint m_sentScale = 0;
+    };
+
+    static QWaylandFractionalScaleManagerV1Private *get(QWaylandFractionalScaleManagerV1 *manager) { return manager ? manager->d_func() : nullptr; }
+
+protected:
+    void wp_fractional_scale_manager_v1_destroy(Resource *resource) override;
+    void wp_fractional_scale_manager_v1_get_fractional_scale(Resource *resource, uint32_t id, wl_resource *surfaceResource) override;
+};
+
+QT_END_NAMESPACE
+
+#endif // QWAYLANDFRACTIONALSCALEV1_P_H
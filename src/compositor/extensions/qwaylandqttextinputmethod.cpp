@@ -20,6 +20,43 @@ QWaylandQtTextInputMethodPrivate::QWaylandQtTextInputMethodPrivate(QWaylandCompo
 {
 }
 
+void QWaylandQtTextInputMethodPrivate::setFocus(QWaylandSurface *surface)
+{
+    Q_Q(QWaylandQtTextInputMethod);
+
+    Resource *resource = surface != nullptr ? resourceMap().value(surface->waylandClient()) : nullptr;
+    if (this->resource == resource)
+        return;
+
+    if (this->resource != nullptr && focusedSurface != nullptr) {
+        send_leave(this->resource->handle, focusedSurface->resource());
+        focusDestroyListener.reset();
+    }
+
+    this->resource = resource;
+    focusedSurface = surface;
+
+    if (this->resource != nullptr && focusedSurface != nullptr) {
+        surroundingText.clear();
+        cursorPosition = 0;
+        anchorPosition = 0;
+        absolutePosition = 0;
+        cursorRectangle = QRect();
+        preferredLanguage.clear();
+        hints = Qt::InputMethodHints();
+        // The input method still knows the values of the previous focus, so
+        // the first update must pass all of them on even if they match
+        changedQueries = TrackedQueries;
+        send_enter(this->resource->handle, focusedSurface->resource());
+        q->sendInputDirectionChanged();
+        q->sendLocaleChanged();
+        q->sendInputDirectionChanged();
+        focusDestroyListener.listenForDestruction(surface->resource());
+        if (inputPanelVisible && enabledSurfaces.values().contains(surface))
+            qGuiApp->inputMethod()->show();
+    }
+}
+
 void QWaylandQtTextInputMethodPrivate::text_input_method_v1_enable(Resource *resource, struct ::wl_resource *surface)
 {
     Q_Q(QWaylandQtTextInputMethod);
@@ -84,8 +121,13 @@ void QWaylandQtTextInputMethodPrivate::text_input_method_v1_invoke_action(Resour
 
 void QWaylandQtTextInputMethodPrivate::text_input_method_v1_update_cursor_rectangle(Resource *resource, int32_t x, int32_t y, int32_t width, int32_t height)
 {
-    if (this->resource == resource)
-        cursorRectangle = QRect(x, y, width, height);
+    if (this->resource == resource) {
+        const QRect rect(x, y, width, height);
+        if (cursorRectangle != rect) {
+            cursorRectangle = rect;
+            changedQueries |= Qt::ImCursorRectangle;
+        }
+    }
 }
 
 void QWaylandQtTextInputMethodPrivate::text_input_method_v1_start_update(Resource *resource, int32_t queries)
@@ -96,49 +138,69 @@ void QWaylandQtTextInputMethodPrivate::text_input_method_v1_start_update(Resourc
 
 void QWaylandQtTextInputMethodPrivate::text_input_method_v1_update_hints(Resource *resource, int32_t hints)
 {
-    if (this->resource == resource)
+    if (this->resource == resource && this->hints != Qt::InputMethodHints(hints)) {
         this->hints = Qt::InputMethodHints(hints);
+        changedQueries |= Qt::ImHints;
+    }
 }
 
 void QWaylandQtTextInputMethodPrivate::text_input_method_v1_update_anchor_position(Resource *resource, int32_t anchorPosition)
 {
-    if (this->resource == resource)
+    if (this->resource == resource && this->anchorPosition != anchorPosition) {
         this->anchorPosition = anchorPosition;
+        changedQueries |= Qt::ImAnchorPosition;
+    }
 }
 
 void QWaylandQtTextInputMethodPrivate::text_input_method_v1_update_cursor_position(Resource *resource, int32_t cursorPosition)
 {
-    if (this->resource == resource)
+    if (this->resource == resource && this->cursorPosition != cursorPosition) {
         this->cursorPosition = cursorPosition;
+        changedQueries |= Qt::ImCursorPosition;
+    }
 }
 
 void QWaylandQtTextInputMethodPrivate::text_input_method_v1_update_surrounding_text(Resource *resource, const QString &surroundingText, int32_t surroundingTextOffset)
 {
-    if (this->resource == resource) {
+    if (this->resource == resource && (this->surroundingTextOffset != surroundingTextOffset
+                                       || this->surroundingText != surroundingText)) {
         this->surroundingText = surroundingText;
         this->surroundingTextOffset = surroundingTextOffset;
+        changedQueries |= Qt::ImSurroundingText;
     }
 }
 
 void QWaylandQtTextInputMethodPrivate::text_input_method_v1_update_absolute_position(Resource *resource, int32_t absolutePosition)
 {
-    if (this->resource == resource)
+    if (this->resource == resource && this->absolutePosition != absolutePosition) {
         this->absolutePosition = absolutePosition;
+        changedQueries |= Qt::ImAbsolutePosition;
+    }
 }
 
 void QWaylandQtTextInputMethodPrivate::text_input_method_v1_update_preferred_language(Resource *resource, const QString &preferredLanguage)
 {
-    if (this->resource == resource)
+    if (this->resource == resource && this->preferredLanguage != preferredLanguage) {
         this->preferredLanguage = preferredLanguage;
+        changedQueries |= Qt::ImPreferredLanguage;
+    }
 }
 
 void QWaylandQtTextInputMethodPrivate::text_input_method_v1_end_update(Resource *resource)
 {
     Q_Q(QWaylandQtTextInputMethod);
     if (this->resource == resource && updatingQueries != 0) {
-        Qt::InputMethodQueries queries = updatingQueries;
+        // The client resends every property it was asked about, only pass on
+        // the ones that changed. The others are not tracked here and always are.
+        Qt::InputMethodQueries changed = changedQueries;
+        if (changed & (Qt::ImSurroundingText | Qt::ImCursorPosition | Qt::ImAnchorPosition))
+            changed |= Qt::ImCurrentSelection | Qt::ImTextBeforeCursor | Qt::ImTextAfterCursor;
+
+        const Qt::InputMethodQueries queries = (updatingQueries & ~TrackedQueries) | (updatingQueries & changed);
         updatingQueries = Qt::InputMethodQueries();
-        emit q->updateInputMethod(queries);
+        changedQueries = Qt::InputMethodQueries();
+        if (queries != 0)
+            emit q->updateInputMethod(queries);
     }
 }
 
@@ -342,35 +404,7 @@ bool QWaylandQtTextInputMethod::isSurfaceEnabled(QWaylandSurface *surface) const
 void QWaylandQtTextInputMethod::setFocus(QWaylandSurface *surface)
 {
     Q_D(QWaylandQtTextInputMethod);
-
-    QWaylandQtTextInputMethodPrivate::Resource *resource = surface != nullptr ? d->resourceMap().value(surface->waylandClient()) : nullptr;
-    if (d->resource == resource)
-        return;
-
-    if (d->resource != nullptr && d->focusedSurface != nullptr) {
-        d->send_leave(d->resource->handle, d->focusedSurface->resource());
-        d->focusDestroyListener.reset();
-    }
-
-    d->resource = resource;
-    d->focusedSurface = surface;
-
-    if (d->resource != nullptr && d->focusedSurface != nullptr) {
-        d->surroundingText.clear();
-        d->cursorPosition = 0;
-        d->anchorPosition = 0;
-        d->absolutePosition = 0;
-        d->cursorRectangle = QRect();
-        d->preferredLanguage.clear();
-        d->hints = Qt::InputMethodHints();
-        d->send_enter(d->resource->handle, d->focusedSurface->resource());
-        sendInputDirectionChanged();
-        sendLocaleChanged();
-        sendInputDirectionChanged();
-        d->focusDestroyListener.listenForDestruction(surface->resource());
-        if (d->inputPanelVisible && d->enabledSurfaces.values().contains(surface))
-            qGuiApp->inputMethod()->show();
-    }
+    d->setFocus(surface);
 }
 
 void QWaylandQtTextInputMethod::sendLocaleChanged()
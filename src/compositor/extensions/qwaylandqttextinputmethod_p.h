@@ -36,6 +36,14 @@ class Q_WAYLANDCOMPOSITOR_EXPORT QWaylandQtTextInputMethodPrivate : public QWayl
 public:
     explicit QWaylandQtTextInputMethodPrivate(QWaylandCompositor *compositor);
 
+    void setFocus(QWaylandSurface *surface);
+
+    // The properties whose values are compared with the ones the client sends
+    static constexpr Qt::InputMethodQueries TrackedQueries = Qt::ImHints | Qt::ImCursorRectangle
+            | Qt::ImSurroundingText | Qt::ImCursorPosition | Qt::ImAnchorPosition
+            | Qt::ImAbsolutePosition | Qt::ImPreferredLanguage
+            | Qt::ImCurrentSelection | Qt::ImTextBeforeCursor | Qt::ImTextAfterCursor;
+
     QWaylandCompositor *compositor;
     QWaylandSurface *focusedSurface = nullptr;
     Resource *resource = nullptr;
@@ -45,6 +53,8 @@ public:
     bool waitingForSync = false;
 
     Qt::InputMethodQueries updatingQueries;
+    // what actually changed since the last end_update
+    Qt::InputMethodQueries changedQueries;
     Qt::InputMethodHints hints;
     QString surroundingText;
     QString preferredLanguage;
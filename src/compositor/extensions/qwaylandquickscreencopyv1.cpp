@@ -0,0 +1,96 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#include "qwaylandquickscreencopyv1_p.h"
+
+#include <QtWaylandCompositor/QWaylandQuickOutput>
+#include <QtWaylandCompositor/QWaylandScreencopyManagerV1>
+
+#include <QtCore/QCoreApplication>
+#include <QtGui/QImage>
+#include <QtGui/private/qrhi_p.h>
+#include <QtQuick/QQuickWindow>
+
+QT_BEGIN_NAMESPACE
+
+QWaylandQuickScreencopyCapture *QWaylandQuickScreencopyCapture::create(QWaylandScreencopyManagerV1 *manager,
+                                                                       QWaylandQuickOutput *output)
+{
+    auto *window = qobject_cast<QQuickWindow *>(output->window());
+    if (!window)
+        return nullptr;
+    return new QWaylandQuickScreencopyCapture(manager, output, window);
+}
+
+QWaylandQuickScreencopyCapture::QWaylandQuickScreencopyCapture(QWaylandScreencopyManagerV1 *manager,
+                                                               QWaylandQuickOutput *output, QQuickWindow *window)
+    : m_manager(manager)
+    , m_output(output)
+    , m_window(window)
+{
+    // afterRendering is emitted on the render thread, still inside the frame
+    connect(window, &QQuickWindow::afterRendering, this, [this]() { readBack(); }, Qt::DirectConnection);
+    connect(window, &QQuickWindow::frameSwapped, this, [this]() { grabWindow(); }, Qt::QueuedConnection);
+}
+
+void QWaylandQuickScreencopyCapture::arm(bool forceRender)
+{
+    m_armed.storeRelease(1);
+    if (forceRender && m_window)
+        m_window->update();
+}
+
+// Called on the render thread. The swap chain's back buffer is read back as
+// part of the frame that was just recorded, without waiting for the GPU.
+void QWaylandQuickScreencopyCapture::readBack()
+{
+    QQuickWindow *window = m_window;
+    QRhi *rhi = window ? window->rhi() : nullptr;
+    QRhiSwapChain *swapChain = window ? window->swapChain() : nullptr;
+    if (!rhi || !swapChain || !m_armed.testAndSetOrdered(1, 0))
+        return;
+
+    auto *result = new QRhiReadbackResult;
+    const bool yUp = rhi->isYUpInFramebuffer();
+    QPointer<QWaylandQuickScreencopyCapture> self(this);
+    result->completed = [result, yUp, self]() {
+        const QImage::Format format = result->format == QRhiTexture::BGRA8
+                ? QImage::Format_ARGB32_Premultiplied
+                : QImage::Format_RGBA8888_Premultiplied;
+        const QImage pixels(reinterpret_cast<const uchar *>(result->data.constData()),
+                            result->pixelSize.width(), result->pixelSize.height(), format);
+        const QImage image = yUp ? pixels.mirrored() : pixels.copy();
+        // the result can't be deleted from inside its own callback
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [result, self, image]() {
+            delete result;
+            if (self)
+                self->submit(image);
+        }, Qt::QueuedConnection);
+    };
+
+    QRhiResourceUpdateBatch *batch = rhi->nextResourceUpdateBatch();
+    batch->readBackTexture(QRhiReadbackDescription(), result);
+    swapChain->currentFrameCommandBuffer()->resourceUpdate(batch);
+}
+
+// The software renderer has no QRhi, its frames are grabbed after they were
+// shown instead.
+void QWaylandQuickScreencopyCapture::grabWindow()
+{
+    if (!m_window || (m_window->rhi() && m_window->swapChain()))
+        return;
+    if (!m_armed.testAndSetOrdered(1, 0))
+        return;
+
+    submit(m_window->grabWindow());
+}
+
+void QWaylandQuickScreencopyCapture::submit(const QImage &image)
+{
+    if (m_manager && m_output)
+        m_manager->submitFrame(m_output, image);
+}
+
+QT_END_NAMESPACE
+
+#include "moc_qwaylandquickscreencopyv1_p.cpp"
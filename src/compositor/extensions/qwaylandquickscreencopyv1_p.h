@@ -0,0 +1,59 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#ifndef QWAYLANDQUICKSCREENCOPYV1_P_H
+#define QWAYLANDQUICKSCREENCOPYV1_P_H
+
+#include <QtWaylandCompositor/qtwaylandcompositorglobal.h>
+#include <QtCore/QObject>
+#include <QtCore/QPointer>
+#include <QtCore/QAtomicInt>
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+QT_REQUIRE_CONFIG(wayland_compositor_quick);
+
+QT_BEGIN_NAMESPACE
+
+class QImage;
+class QQuickWindow;
+class QWaylandQuickOutput;
+class QWaylandScreencopyManagerV1;
+
+// Reads back the window of a QWaylandQuickOutput after it rendered, on the
+// render thread where there is a QRhi, and hands the contents over to the
+// screencopy manager.
+class QWaylandQuickScreencopyCapture : public QObject
+{
+    Q_OBJECT
+public:
+    static QWaylandQuickScreencopyCapture *create(QWaylandScreencopyManagerV1 *manager, QWaylandQuickOutput *output);
+
+    // Reads back the next frame, rendering one if forceRender is true
+    void arm(bool forceRender);
+
+private:
+    QWaylandQuickScreencopyCapture(QWaylandScreencopyManagerV1 *manager, QWaylandQuickOutput *output, QQuickWindow *window);
+
+    void readBack();
+    void grabWindow();
+    void submit(const QImage &image);
+
+    QPointer<QWaylandScreencopyManagerV1> m_manager;
+    QPointer<QWaylandQuickOutput> m_output;
+    QPointer<QQuickWindow> m_window;
+    QAtomicInt m_armed = 0;
+};
+
+QT_END_NAMESPACE
+
+#endif // QWAYLANDQUICKSCREENCOPYV1_P_H
@@ -0,0 +1,576 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#include <QtWaylandCompositor/QWaylandCompositor>
+#include <QtWaylandCompositor/QWaylandClient>
+#include <QtWaylandCompositor/QWaylandDestroyListener>
+#include <QtWaylandCompositor/QWaylandOutputMode>
+
+#include "qwaylandscreencopyv1_p.h"
+#if QT_CONFIG(wayland_compositor_quick)
+#include "qwaylandquickscreencopyv1_p.h"
+#include <QtWaylandCompositor/QWaylandQuickOutput>
+#endif
+
+#include <QtCore/QTimer>
+#include <QtCore/QtMath>
+
+#include <wayland-server-core.h>
+
+#include <cstring>
+#include <time.h>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \class QWaylandScreencopyManagerV1
+    \inmodule QtWaylandCompositor
+    \since 6.5
+    \brief Provides an extension that lets clients capture the contents of outputs.
+
+    The QWaylandScreencopyManagerV1 extension lets clients, such as screen recorders or remote
+    desktop servers, have the compositor copy the contents of an output into shared memory
+    buffers they provide.
+
+    QWaylandScreencopyManagerV1 corresponds to the Wayland interface, \c zwlr_screencopy_manager_v1.
+
+    Outputs are captured on demand. A QWaylandQuickOutput is read back automatically after it
+    rendered a frame. For other outputs, the compositor is asked for the output contents through
+    captureRequested(), and hands them over with submitFrame().
+
+    Clients copying with damage are only served once the output contents changed, and are told
+    which parts of the output changed since their previous copy. The rate at which outputs are
+    captured can be limited with maximumFrameRate.
+*/
+
+/*!
+    \qmltype ScreencopyManagerV1
+    \instantiates QWaylandScreencopyManagerV1
+    \inqmlmodule QtWayland.Compositor
+    \since 6.5
+    \brief Provides an extension that lets clients capture the contents of outputs.
+
+    The ScreencopyManagerV1 extension lets clients, such as screen recorders or remote
+    desktop servers, have the compositor copy the contents of an output into shared memory
+    buffers they provide. The contents of a WaylandOutput are read back after it rendered a frame.
+
+    ScreencopyManagerV1 corresponds to the Wayland interface, \c zwlr_screencopy_manager_v1.
+
+    To provide the functionality of the extension in a compositor, create an instance of the
+    ScreencopyManagerV1 component and add it to the list of extensions supported by the compositor:
+
+    \qml
+    import QtWayland.Compositor
+
+    WaylandCompositor {
+        ScreencopyManagerV1 {
+            maximumFrameRate: 30
+        }
+    }
+    \endqml
+*/
+
+/*!
+    Constructs a QWaylandScreencopyManagerV1 object.
+*/
+QWaylandScreencopyManagerV1::QWaylandScreencopyManagerV1()
+    : QWaylandCompositorExtensionTemplate<QWaylandScreencopyManagerV1>(*new QWaylandScreencopyManagerV1Private())
+{
+}
+
+/*!
+    Constructs a QWaylandScreencopyManagerV1 object for the provided \a compositor.
+*/
+QWaylandScreencopyManagerV1::QWaylandScreencopyManagerV1(QWaylandCompositor *compositor)
+    : QWaylandCompositorExtensionTemplate<QWaylandScreencopyManagerV1>(compositor, *new QWaylandScreencopyManagerV1Private())
+{
+}
+
+/*!
+    Destructs a QWaylandScreencopyManagerV1 object.
+*/
+QWaylandScreencopyManagerV1::~QWaylandScreencopyManagerV1() = default;
+
+/*!
+    Initializes the extension.
+*/
+void QWaylandScreencopyManagerV1::initialize()
+{
+    Q_D(QWaylandScreencopyManagerV1);
+
+    QWaylandCompositorExtensionTemplate::initialize();
+    QWaylandCompositor *compositor = static_cast<QWaylandCompositor *>(extensionContainer());
+    if (!compositor) {
+        qCWarning(qLcWaylandCompositor) << "Failed to find QWaylandCompositor when initializing QWaylandScreencopyManagerV1";
+        return;
+    }
+    d->init(compositor->display(), d->interfaceVersion());
+}
+
+/*!
+    \qmlproperty real QtWayland.Compositor::ScreencopyManagerV1::maximumFrameRate
+
+    This property holds the maximum number of times per second an output is captured.
+    Clients asking for frames more often have to wait.
+
+    The default is \c 0, which does not limit the frame rate.
+*/
+
+/*!
+    \property QWaylandScreencopyManagerV1::maximumFrameRate
+
+    This property holds the maximum number of times per second an output is captured.
+    Clients asking for frames more often have to wait.
+
+    The default is \c 0, which does not limit the frame rate.
+*/
+qreal QWaylandScreencopyManagerV1::maximumFrameRate() const
+{
+    Q_D(const QWaylandScreencopyManagerV1);
+    return d->maximumFrameRate;
+}
+
+void QWaylandScreencopyManagerV1::setMaximumFrameRate(qreal frameRate)
+{
+    Q_D(QWaylandScreencopyManagerV1);
+    frameRate = qMax(qreal(0), frameRate);
+    if (qFuzzyCompare(d->maximumFrameRate, frameRate))
+        return;
+
+    d->maximumFrameRate = frameRate;
+    emit maximumFrameRateChanged();
+}
+
+/*!
+    Returns \c true if clients are waiting for the contents of \a output.
+*/
+bool QWaylandScreencopyManagerV1::hasPendingCaptures(QWaylandOutput *output) const
+{
+    Q_D(const QWaylandScreencopyManagerV1);
+    auto it = d->outputs.constFind(output);
+    return it != d->outputs.cend() && !it->frames.isEmpty();
+}
+
+/*!
+    Hands the current contents of \a output over as \a frame.
+
+    The frame is copied into the buffers of the clients waiting for the output, and compared
+    against the previously submitted one to find the damaged region. It is scaled to the size
+    of the output's current mode if necessary.
+
+    \sa captureRequested()
+*/
+void QWaylandScreencopyManagerV1::submitFrame(QWaylandOutput *output, const QImage &frame)
+{
+    Q_D(QWaylandScreencopyManagerV1);
+    auto it = d->outputs.find(output);
+    if (it == d->outputs.end() || frame.isNull())
+        return;
+
+    QWaylandScreencopyManagerV1Private::OutputState &state = *it;
+    state.captureRequested = false;
+    state.lastCapture.start();
+
+    // wl_shm's xrgb8888 is laid out like QImage::Format_RGB32
+    QImage image = frame;
+    const QSize outputSize = output->currentMode().size();
+    if (outputSize.isValid() && image.size() != outputSize)
+        image = image.scaled(outputSize, Qt::IgnoreAspectRatio, Qt::FastTransformation);
+    if (image.format() != QImage::Format_RGB32 && image.format() != QImage::Format_ARGB32
+            && image.format() != QImage::Format_ARGB32_Premultiplied) {
+        image = image.convertToFormat(QImage::Format_RGB32);
+    }
+
+    const QRegion damage = QWaylandScreencopyManagerV1Private::changedRegion(state.lastFrame, image);
+    state.lastFrame = image;
+    for (QRegion &clientDamage : state.clientDamage)
+        clientDamage += damage;
+
+    const auto frames = state.frames;
+    for (QWaylandScreencopyManagerV1Private::Frame *screencopyFrame : frames) {
+        if (d->isWaitingForDamage(state, screencopyFrame))
+            continue;
+
+        QRegion frameDamage = screencopyFrame->region();
+        if (screencopyFrame->withDamage() && state.clientDamage.contains(screencopyFrame->client()))
+            frameDamage = state.clientDamage.value(screencopyFrame->client()).intersected(screencopyFrame->region());
+        // this also starts tracking the damage for clients copying for the first time
+        d->trackClient(screencopyFrame->client());
+        state.clientDamage[screencopyFrame->client()] -= screencopyFrame->region();
+
+        state.frames.removeOne(screencopyFrame);
+        screencopyFrame->copy(image, frameDamage);
+    }
+
+    d->scheduleCapture(output);
+}
+
+/*!
+    \fn void QWaylandScreencopyManagerV1::captureRequested(QWaylandOutput *output)
+
+    This signal is emitted when clients wait for the contents of \a output, and the output is
+    not a QWaylandQuickOutput which is read back automatically. The compositor should call
+    submitFrame() once it rendered the next frame.
+
+    While clients are only waiting for damage, the signal is emitted again after every submitted
+    frame, at most at the refresh rate of the output or maximumFrameRate.
+*/
+
+/*!
+    Returns the Wayland interface for the QWaylandScreencopyManagerV1.
+*/
+const wl_interface *QWaylandScreencopyManagerV1::interface()
+{
+    return QWaylandScreencopyManagerV1Private::interface();
+}
+
+QWaylandScreencopyManagerV1Private::~QWaylandScreencopyManagerV1Private()
+{
+    for (Frame *frame : std::as_const(liveFrames))
+        frame->detachManager();
+    for (OutputState &state : outputs) {
+        delete state.rateLimitTimer;
+#if QT_CONFIG(wayland_compositor_quick)
+        delete state.quickCapture;
+#endif
+    }
+}
+
+// Compares the images in tiles, which is a lot cheaper than reading them back.
+QRegion QWaylandScreencopyManagerV1Private::changedRegion(const QImage &previous, const QImage &current)
+{
+    if (previous.size() != current.size() || previous.format() != current.format())
+        return current.rect();
+
+    const int tileSize = 64;
+    const int bytesPerPixel = current.depth() / 8;
+    QRegion damage;
+    for (int tileY = 0; tileY < current.height(); tileY += tileSize) {
+        const int rows = qMin(tileSize, current.height() - tileY);
+        for (int tileX = 0; tileX < current.width(); tileX += tileSize) {
+            const int columns = qMin(tileSize, current.width() - tileX);
+            const int offset = tileX * bytesPerPixel;
+            for (int y = tileY; y < tileY + rows; ++y) {
+                if (memcmp(previous.constScanLine(y) + offset, current.constScanLine(y) + offset,
+                           columns * bytesPerPixel) != 0) {
+                    damage += QRect(tileX, tileY, columns, rows);
+                    break;
+                }
+            }
+        }
+    }
+    return damage;
+}
+
+QWaylandScreencopyManagerV1Private::OutputState &QWaylandScreencopyManagerV1Private::outputState(QWaylandOutput *output)
+{
+    Q_Q(QWaylandScreencopyManagerV1);
+    auto it = outputs.find(output);
+    if (it != outputs.end())
+        return *it;
+
+    OutputState &state = outputs[output];
+    state.rateLimitTimer = new QTimer;
+    state.rateLimitTimer->setSingleShot(true);
+    QObject::connect(state.rateLimitTimer, &QTimer::timeout, q, [this, output]() {
+        requestCapture(output);
+    });
+    QObject::connect(output, &QObject::destroyed, q, [this, output]() {
+        removeOutput(output);
+    });
+#if QT_CONFIG(wayland_compositor_quick)
+    if (auto *quickOutput = qobject_cast<QWaylandQuickOutput *>(output))
+        state.quickCapture = QWaylandQuickScreencopyCapture::create(q, quickOutput);
+#endif
+    return state;
+}
+
+void QWaylandScreencopyManagerV1Private::removeOutput(QWaylandOutput *output)
+{
+    auto it = outputs.find(output);
+    if (it == outputs.end())
+        return;
+
+    OutputState state = *it;
+    outputs.erase(it);
+    delete state.rateLimitTimer;
+#if QT_CONFIG(wayland_compositor_quick)
+    delete state.quickCapture;
+#endif
+    for (Frame *frame : std::as_const(state.frames))
+        frame->fail();
+}
+
+void QWaylandScreencopyManagerV1Private::trackClient(QWaylandClient *client)
+{
+    Q_Q(QWaylandScreencopyManagerV1);
+    if (!client || trackedClients.contains(client))
+        return;
+
+    trackedClients.insert(client);
+    QObject::connect(client, &QObject::destroyed, q, [this, client]() {
+        trackedClients.remove(client);
+        for (OutputState &state : outputs)
+            state.clientDamage.remove(client);
+    });
+}
+
+bool QWaylandScreencopyManagerV1Private::isWaitingForDamage(const OutputState &state, const Frame *frame) const
+{
+    if (!frame->withDamage())
+        return false;
+    auto it = state.clientDamage.constFind(frame->client());
+    // the first copy of a client is never held back
+    return it != state.clientDamage.cend() && !it->intersects(frame->region());
+}
+
+void QWaylandScreencopyManagerV1Private::queueFrame(Frame *frame)
+{
+    QWaylandOutput *output = frame->output();
+    if (!output) {
+        frame->fail();
+        return;
+    }
+
+    outputState(output).frames.append(frame);
+    scheduleCapture(output);
+}
+
+void QWaylandScreencopyManagerV1Private::removeFrame(Frame *frame)
+{
+    liveFrames.removeOne(frame);
+    for (OutputState &state : outputs)
+        state.frames.removeOne(frame);
+}
+
+void QWaylandScreencopyManagerV1Private::scheduleCapture(QWaylandOutput *output)
+{
+    OutputState &state = outputState(output);
+    if (state.frames.isEmpty() || state.captureRequested || state.rateLimitTimer->isActive())
+        return;
+
+    bool onlyWaitingForDamage = true;
+    for (const Frame *frame : std::as_const(state.frames))
+        onlyWaitingForDamage = onlyWaitingForDamage && isWaitingForDamage(state, frame);
+
+    qint64 interval = maximumFrameRate > 0 ? qCeil(1000 / maximumFrameRate) : 0;
+    // Outputs that are not read back automatically have to be polled for damage,
+    // there is no point in doing that faster than the output refreshes.
+    if (onlyWaitingForDamage && !state.quickCapture) {
+        const int refreshRate = output->currentMode().refreshRate();
+        interval = qMax(interval, qint64(refreshRate > 0 ? qCeil(1000000.0 / refreshRate) : 16));
+    }
+
+    const qint64 elapsed = state.lastCapture.isValid() ? state.lastCapture.elapsed() : interval;
+    if (elapsed < interval) {
+        state.rateLimitTimer->start(int(interval - elapsed));
+        return;
+    }
+    requestCapture(output);
+}
+
+void QWaylandScreencopyManagerV1Private::requestCapture(QWaylandOutput *output)
+{
+    Q_Q(QWaylandScreencopyManagerV1);
+    auto it = outputs.find(output);
+    if (it == outputs.end() || it->frames.isEmpty() || it->captureRequested)
+        return;
+
+    it->captureRequested = true;
+#if QT_CONFIG(wayland_compositor_quick)
+    if (it->quickCapture) {
+        // Waiting for damage means waiting for the output to render something new
+        bool needsNewFrame = false;
+        for (const Frame *frame : std::as_const(it->frames))
+            needsNewFrame = needsNewFrame || !isWaitingForDamage(*it, frame);
+        it->quickCapture->arm(needsNewFrame);
+        return;
+    }
+#endif
+    emit q->captureRequested(output);
+}
+
+void QWaylandScreencopyManagerV1Private::zwlr_screencopy_manager_v1_capture_output(Resource *resource, uint32_t frame,
+                                                                                 int32_t overlay_cursor, wl_resource *output)
+{
+    Q_UNUSED(overlay_cursor);
+    createFrame(resource, frame, output, QRect());
+}
+
+void QWaylandScreencopyManagerV1Private::zwlr_screencopy_manager_v1_capture_output_region(Resource *resource, uint32_t frame,
+                                                                                        int32_t overlay_cursor, wl_resource *output,
+                                                                                        int32_t x, int32_t y,
+                                                                                        int32_t width, int32_t height)
+{
+    Q_UNUSED(overlay_cursor);
+    createFrame(resource, frame, output, QRect(x, y, qMax(0, width), qMax(0, height)));
+}
+
+void QWaylandScreencopyManagerV1Private::zwlr_screencopy_manager_v1_destroy(Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
+void QWaylandScreencopyManagerV1Private::createFrame(Resource *resource, uint32_t id, wl_resource *outputResource,
+                                                     const QRect &logicalRegion)
+{
+    QWaylandOutput *output = QWaylandOutput::fromResource(outputResource);
+    QRect region;
+    if (output) {
+        const QRect outputRect(QPoint(), output->currentMode().size());
+        region = outputRect;
+        if (!logicalRegion.isNull()) {
+            // the region is in logical coordinates
+            const qreal scale = output->fractionalScaleFactor();
+            const QRectF scaled(logicalRegion.x() * scale, logicalRegion.y() * scale,
+                                logicalRegion.width() * scale, logicalRegion.height() * scale);
+            region = scaled.toAlignedRect().intersected(outputRect);
+        }
+    }
+
+    auto *frame = new Frame(this, output, region, resource->client(), id, resource->version());
+    liveFrames.append(frame);
+
+    if (!output || region.isEmpty()) {
+        frame->fail();
+        return;
+    }
+
+    frame->send_buffer(QtWaylandServer::wl_shm::format_xrgb8888, region.width(), region.height(),
+                       region.width() * 4);
+    if (resource->version() >= 3)
+        frame->send_buffer_done();
+}
+
+QWaylandScreencopyManagerV1Private::Frame::Frame(QWaylandScreencopyManagerV1Private *manager, QWaylandOutput *output,
+                                                 const QRect &region, wl_client *client, quint32 id, quint32 version)
+    : QtWaylandServer::zwlr_screencopy_frame_v1(client, id, version)
+    , m_manager(manager)
+    , m_output(output)
+    , m_region(region)
+{
+    if (output)
+        m_client = QWaylandClient::fromWlClient(output->compositor(), client);
+}
+
+QWaylandScreencopyManagerV1Private::Frame::~Frame()
+{
+    if (m_manager)
+        m_manager->removeFrame(this);
+    releaseBuffer();
+    delete m_bufferDestroyListener;
+}
+
+void QWaylandScreencopyManagerV1Private::Frame::copy(const QImage &image, const QRegion &damage)
+{
+    wl_shm_buffer *shmBuffer = m_buffer ? wl_shm_buffer_get(m_buffer) : nullptr;
+    if (!shmBuffer) {
+        fail();
+        return;
+    }
+
+    const QRect sourceRect = m_region.intersected(image.rect());
+    const int stride = wl_shm_buffer_get_stride(shmBuffer);
+    wl_shm_buffer_begin_access(shmBuffer);
+    uchar *data = static_cast<uchar *>(wl_shm_buffer_get_data(shmBuffer));
+    for (int y = 0; y < sourceRect.height(); ++y) {
+        memcpy(data + y * stride, image.constScanLine(sourceRect.y() + y) + sourceRect.x() * 4,
+               sourceRect.width() * 4);
+    }
+    wl_shm_buffer_end_access(shmBuffer);
+    releaseBuffer();
+
+    if (m_withDamage) {
+        for (const QRect &rect : damage)
+            send_damage(rect.x() - m_region.x(), rect.y() - m_region.y(), rect.width(), rect.height());
+    }
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    const quint64 seconds = quint64(ts.tv_sec);
+    send_flags(0);
+    send_ready(seconds >> 32, seconds & 0xffffffff, ts.tv_nsec);
+}
+
+void QWaylandScreencopyManagerV1Private::Frame::fail()
+{
+    if (m_manager)
+        m_manager->removeFrame(this);
+    releaseBuffer();
+    send_failed();
+}
+
+void QWaylandScreencopyManagerV1Private::Frame::releaseBuffer()
+{
+    m_buffer = nullptr;
+    if (m_bufferDestroyListener)
+        m_bufferDestroyListener->reset();
+}
+
+void QWaylandScreencopyManagerV1Private::Frame::requestCopy(Resource *resource, wl_resource *buffer, bool withDamage)
+{
+    if (m_used) {
+        wl_resource_post_error(resource->handle, error_already_used,
+                               "frame was already used to copy into a buffer");
+        return;
+    }
+    m_used = true;
+
+    wl_shm_buffer *shmBuffer = wl_shm_buffer_get(buffer);
+    if (!shmBuffer) {
+        wl_resource_post_error(resource->handle, error_invalid_buffer, "only wl_shm buffers are supported");
+        return;
+    }
+
+    const uint32_t format = wl_shm_buffer_get_format(shmBuffer);
+    if ((format != QtWaylandServer::wl_shm::format_xrgb8888 && format != QtWaylandServer::wl_shm::format_argb8888)
+            || wl_shm_buffer_get_width(shmBuffer) != m_region.width()
+            || wl_shm_buffer_get_height(shmBuffer) != m_region.height()
+            || wl_shm_buffer_get_stride(shmBuffer) != m_region.width() * 4) {
+        wl_resource_post_error(resource->handle, error_invalid_buffer, "invalid buffer attributes");
+        return;
+    }
+
+    if (!m_manager || !m_output) {
+        fail();
+        return;
+    }
+
+    m_buffer = buffer;
+    m_withDamage = withDamage;
+    if (!m_bufferDestroyListener) {
+        m_bufferDestroyListener = new QWaylandDestroyListener;
+        QObject::connect(m_bufferDestroyListener, &QWaylandDestroyListener::fired,
+                         m_bufferDestroyListener, [this]() {
+            m_buffer = nullptr;
+            fail();
+        });
+    }
+    m_bufferDestroyListener->listenForDestruction(buffer);
+    m_manager->queueFrame(this);
+}
+
+void QWaylandScreencopyManagerV1Private::Frame::zwlr_screencopy_frame_v1_copy(Resource *resource, wl_resource *buffer)
+{
+    requestCopy(resource, buffer, false);
+}
+
+void QWaylandScreencopyManagerV1Private::Frame::zwlr_screencopy_frame_v1_copy_with_damage(Resource *resource, wl_resource *buffer)
+{
+    requestCopy(resource, buffer, true);
+}
+
+void QWaylandScreencopyManagerV1Private::Frame::zwlr_screencopy_frame_v1_destroy(Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
+void QWaylandScreencopyManagerV1Private::Frame::zwlr_screencopy_frame_v1_destroy_resource(Resource *resource)
+{
+    Q_UNUSED(resource);
+    delete this;
+}
+
+QT_END_NAMESPACE
+
+#include "moc_qwaylandscreencopyv1.cpp"
@@ -0,0 +1,42 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#ifndef QWAYLANDSCREENCOPYV1_H
+#define QWAYLANDSCREENCOPYV1_H
+
+#include <QtWaylandCompositor/QWaylandCompositorExtension>
+
+QT_BEGIN_NAMESPACE
+
+class QImage;
+class QWaylandOutput;
+class QWaylandScreencopyManagerV1Private;
+
+class Q_WAYLANDCOMPOSITOR_EXPORT QWaylandScreencopyManagerV1 : public QWaylandCompositorExtensionTemplate<QWaylandScreencopyManagerV1>
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(QWaylandScreencopyManagerV1)
+    Q_PROPERTY(qreal maximumFrameRate READ maximumFrameRate WRITE setMaximumFrameRate NOTIFY maximumFrameRateChanged)
+public:
+    QWaylandScreencopyManagerV1();
+    explicit QWaylandScreencopyManagerV1(QWaylandCompositor *compositor);
+    ~QWaylandScreencopyManagerV1();
+
+    void initialize() override;
+
+    qreal maximumFrameRate() const;
+    void setMaximumFrameRate(qreal frameRate);
+
+    bool hasPendingCaptures(QWaylandOutput *output) const;
+    void submitFrame(QWaylandOutput *output, const QImage &frame);
+
+    static const struct wl_interface *interface();
+
+Q_SIGNALS:
+    void maximumFrameRateChanged();
+    void captureRequested(QWaylandOutput *output);
+};
+
+QT_END_NAMESPACE
+
+#endif // QWAYLANDSCREENCOPYV1_H
@@ -0,0 +1,129 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#ifndef QWAYLANDSCREENCOPYV1_P_H
+#define QWAYLANDSCREENCOPYV1_P_H
+
+#include <QtWaylandCompositor/QWaylandOutput>
+#include <QtWaylandCompositor/QWaylandScreencopyManagerV1>
+#include <QtWaylandCompositor/private/qwaylandcompositorextension_p.h>
+#include <QtWaylandCompositor/private/qwayland-server-wlr-screencopy-unstable-v1.h>
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QPointer>
+#include <QtCore/QSet>
+#include <QtGui/QImage>
+#include <QtGui/QRegion>
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+QT_BEGIN_NAMESPACE
+
+class QTimer;
+class QWaylandClient;
+class QWaylandDestroyListener;
+class QWaylandQuickScreencopyCapture;
+
+class Q_WAYLANDCOMPOSITOR_EXPORT QWaylandScreencopyManagerV1Private
+        : public QWaylandCompositorExtensionPrivate
+        , public QtWaylandServer::zwlr_screencopy_manager_v1
+{
+    Q_DECLARE_PUBLIC(QWaylandScreencopyManagerV1)
+public:
+    explicit QWaylandScreencopyManagerV1Private() = default;
+    ~QWaylandScreencopyManagerV1Private() override;
+
+    class Q_WAYLANDCOMPOSITOR_EXPORT Frame
+            : public QtWaylandServer::zwlr_screencopy_frame_v1
+    {
+    public:
+        Frame(QWaylandScreencopyManagerV1Private *manager, QWaylandOutput *output, const QRect &region,
+              wl_client *client, quint32 id, quint32 version);
+        ~Frame() override;
+
+        QWaylandOutput *output() const { return m_output; }
+        QRect region() const { return m_region; }
+        QWaylandClient *client() const { return m_client; }
+        bool isWaitingForCopy() const { return m_buffer; }
+        bool withDamage() const { return m_withDamage; }
+
+        void copy(const QImage &image, const QRegion &damage);
+        void fail();
+        void detachManager() { m_manager = nullptr; }
+
+    protected:
+        void zwlr_screencopy_frame_v1_copy(Resource *resource, wl_resource *buffer) override;
+        void zwlr_screencopy_frame_v1_copy_with_damage(Resource *resource, wl_resource *buffer) override;
+        void zwlr_screencopy_frame_v1_destroy(Resource *resource) override;
+        void zwlr_screencopy_frame_v1_destroy_resource(Resource *resource) override;
+
+    private:
+        void requestCopy(Resource *resource, wl_resource *buffer, bool withDamage);
+        void releaseBuffer();
+
+        QWaylandScreencopyManagerV1Private *m_manager = nullptr;
+        QPointer<QWaylandOutput> m_output;
+        QRect m_region;
+        QPointer<QWaylandClient> m_client;
+        wl_resource *m_buffer = nullptr;
+        QWaylandDestroyListener *m_bufferDestroyListener = nullptr;
+        bool m_used = false;
+        bool m_withDamage = false;
+    };
+
+    struct OutputState {
+        // frames with a buffer to copy into, oldest first
+        QList<Frame *> frames;
+        QImage lastFrame;
+        // damage accumulated since each client's last copy
+        QHash<QWaylandClient *, QRegion> clientDamage;
+        QElapsedTimer lastCapture;
+        QTimer *rateLimitTimer = nullptr;
+        // reads back QWaylandQuickOutputs after they rendered
+        QWaylandQuickScreencopyCapture *quickCapture = nullptr;
+        bool captureRequested = false;
+    };
+
+    static QWaylandScreencopyManagerV1Private *get(QWaylandScreencopyManagerV1 *manager) { return manager ? manager->d_func() : nullptr; }
+
+    static QRegion changedRegion(const QImage &previous, const QImage &current);
+
+    void queueFrame(Frame *frame);
+    void removeFrame(Frame *frame);
+    void scheduleCapture(QWaylandOutput *output);
+    void requestCapture(QWaylandOutput *output);
+    bool isWaitingForDamage(const OutputState &state, const Frame *frame) const;
+    void removeOutput(QWaylandOutput *output);
+    void trackClient(QWaylandClient *client);
+
+    qreal maximumFrameRate = 0;
+    QList<Frame *> liveFrames;
+    QSet<QWaylandClient *> trackedClients;
+    QHash<QWaylandOutput *, OutputState> outputs;
+
+protected:
+    void zwlr_screencopy_manager_v1_capture_output(Resource *resource, uint32_t frame, int32_t overlay_cursor,
+                                                   wl_resource *output) override;
+    void zwlr_screencopy_manager_v1_capture_output_region(Resource *resource, uint32_t frame, int32_t overlay_cursor,
+                                                          wl_resource *output, int32_t x, int32_t y,
+                                                          int32_t width, int32_t height) override;
+    void zwlr_screencopy_manager_v1_destroy(Resource *resource) override;
+
+private:
+    void createFrame(Resource *resource, uint32_t id, wl_resource *outputResource, const QRect &logicalRegion);
+    OutputState &outputState(QWaylandOutput *output);
+};
+
+QT_END_NAMESPACE
+
+#endif // QWAYLANDSCREENCOPYV1_P_H
@@ -102,20 +102,14 @@ QWaylandViewporterPrivate::Viewport::~Viewport()
     }
 }
 
-// This function has to be called immediately after a surface is committed, before no
-// other client events have been dispatched, or we may incorrectly error out on an
-// incomplete pending state. See comment below.
-void QWaylandViewporterPrivate::Viewport::checkCommittedState()
+// Checks the source and destination of a commit against the buffer it
+// attached. The surface's current state can't be used for this, as that has
+// fallbacks to the buffer size, so we couldn't distinguish between the set
+// and unset case. The caller passes the values of the committed state
+// instead, which may be applied later than the commit if it waits for a
+// fence, when the pending state already holds the client's next requests.
+void QWaylandViewporterPrivate::Viewport::checkCommittedState(const QSize &destination, const QRectF &source)
 {
-    auto *surfacePrivate = QWaylandSurfacePrivate::get(m_surface);
-
-    // We can't use the current state for destination/source when checking,
-    // as that has fallbacks to the buffer size so we can't distinguish
-    // between the set/unset case. We use the pending state because no other
-    // requests has modified it yet.
-    QSize destination = surfacePrivate->pending.destinationSize;
-    QRectF source = surfacePrivate->pending.sourceGeometry;
-
     if (!destination.isValid() && source.size() != source.size().toSize()) {
         wl_resource_post_error(resource()->handle, error_bad_size,
                                "non-integer size (%fx%f) with unset destination",
@@ -9,6 +9,9 @@
 #include <QtWaylandCompositor/private/qwaylandcompositorextension_p.h>
 #include <QtWaylandCompositor/private/qwayland-server-viewporter.h>
 
+#include <QtCore/QRectF>
+#include <QtCore/QSize>
+
 //
 //  W A R N I N G
 //  -------------
@@ -38,7 +41,7 @@ public:
     public:
         explicit Viewport(QWaylandSurface *surface, wl_client *client, int id);
         ~Viewport() override;
-        void checkCommittedState();
+        void checkCommittedState(const QSize &destination, const QRectF &source);
 
     protected:
         void wp_viewport_destroy_resource(Resource *resource) override;
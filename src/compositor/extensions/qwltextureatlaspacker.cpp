@@ -0,0 +1,102 @@
+// Copyright (C) 2019 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#include "qwltextureatlaspacker_p.h"
+
+#include <QtGui/QPainter>
+
+#include <algorithm>
+
+QT_BEGIN_NAMESPACE
+
+namespace QtWayland {
+
+static void drawWithGutter(QPainter *p, const QRect &rect, const QImage &image)
+{
+    const int x = rect.x();
+    const int y = rect.y();
+    const int w = rect.width();
+    const int h = rect.height();
+    const int l = TextureAtlasPacker::Gutter;
+
+    p->drawImage(rect.topLeft(), image);
+
+    // Edges
+    p->drawImage(QRect(x - l, y, l, h), image, QRect(0, 0, 1, h));
+    p->drawImage(QRect(x + w, y, l, h), image, QRect(w - 1, 0, 1, h));
+    p->drawImage(QRect(x, y - l, w, l), image, QRect(0, 0, w, 1));
+    p->drawImage(QRect(x, y + h, w, l), image, QRect(0, h - 1, w, 1));
+
+    // Corners
+    p->drawImage(QRect(x - l, y - l, l, l), image, QRect(0, 0, 1, 1));
+    p->drawImage(QRect(x + w, y - l, l, l), image, QRect(w - 1, 0, 1, 1));
+    p->drawImage(QRect(x - l, y + h, l, l), image, QRect(0, h - 1, 1, 1));
+    p->drawImage(QRect(x + w, y + h, l, l), image, QRect(w - 1, h - 1, 1, 1));
+}
+
+// Packs the images into as few atlases of at most atlasSize x atlasSize pixels
+// as possible, using rows ("shelves") of images sorted by height. Images that
+// do not fit into an empty atlas, or are empty, are not packed; their keys are
+// added to rejectedKeys.
+QList<TextureAtlasPacker::Atlas> TextureAtlasPacker::pack(const QList<QPair<QString, QImage>> &images, int atlasSize,
+                                                          QStringList *rejectedKeys)
+{
+    constexpr int border = 2 * Gutter;
+
+    QList<QPair<QString, QImage>> pending;
+    for (const auto &image : images) {
+        const QSize size = image.second.size();
+        if (size.isEmpty() || size.width() + border > atlasSize || size.height() + border > atlasSize) {
+            if (rejectedKeys)
+                rejectedKeys->append(image.first);
+        } else {
+            pending.append(image);
+        }
+    }
+
+    std::stable_sort(pending.begin(), pending.end(), [](const auto &a, const auto &b) {
+        return a.second.height() > b.second.height();
+    });
+
+    QList<Atlas> atlases;
+    while (!pending.isEmpty()) {
+        Atlas atlas;
+        int x = 0;
+        int y = 0;
+        int shelfHeight = 0;
+        int usedWidth = 0;
+        qsizetype i = 0;
+        for (; i < pending.size(); ++i) {
+            const QSize size = pending.at(i).second.size() + QSize(border, border);
+            if (x + size.width() > atlasSize) {
+                x = 0;
+                y += shelfHeight;
+                shelfHeight = 0;
+            }
+            if (y + size.height() > atlasSize)
+                break;
+            atlas.regions.append(qMakePair(pending.at(i).first,
+                                           QRect(QPoint(x + Gutter, y + Gutter), pending.at(i).second.size())));
+            x += size.width();
+            usedWidth = qMax(usedWidth, x);
+            shelfHeight = qMax(shelfHeight, size.height());
+        }
+
+        atlas.image = QImage(usedWidth, y + shelfHeight, QImage::Format_RGBA8888_Premultiplied);
+        atlas.image.fill(Qt::transparent);
+        {
+            QPainter p(&atlas.image);
+            p.setCompositionMode(QPainter::CompositionMode_Source);
+            for (qsizetype j = 0; j < atlas.regions.size(); ++j)
+                drawWithGutter(&p, atlas.regions.at(j).second, pending.at(j).second);
+        }
+        pending.remove(0, i);
+        atlases.append(atlas);
+    }
+
+    return atlases;
+}
+
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,53 @@
+// Copyright (C) 2019 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#ifndef QWLTEXTUREATLASPACKER_P_H
+#define QWLTEXTUREATLASPACKER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtWaylandCompositor/qtwaylandcompositorglobal.h>
+
+#include <QtCore/QList>
+#include <QtCore/QPair>
+#include <QtCore/QRect>
+#include <QtCore/QStringList>
+#include <QtGui/QImage>
+
+QT_BEGIN_NAMESPACE
+
+namespace QtWayland {
+
+// Packs small images into texture atlases for the texture sharing extension
+class Q_WAYLANDCOMPOSITOR_EXPORT TextureAtlasPacker
+{
+public:
+    // Every image is surrounded by a gutter of this many pixels, filled with
+    // copies of its edge pixels so that linear filtering at the edges of a
+    // region does not pick up its neighbours.
+    static constexpr int Gutter = 1;
+
+    struct Atlas
+    {
+        QImage image;
+        QList<QPair<QString, QRect>> regions;
+    };
+
+    static QList<Atlas> pack(const QList<QPair<QString, QImage>> &images, int atlasSize,
+                             QStringList *rejectedKeys = nullptr);
+};
+
+}
+
+QT_END_NAMESPACE
+
+#endif // QWLTEXTUREATLASPACKER_P_H
@@ -0,0 +1,105 @@
+// Copyright (C) 2019 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#include "qwltexturesharingcache_p.h"
+
+#include <QtCore/QList>
+
+#include <algorithm>
+
+QT_BEGIN_NAMESPACE
+
+namespace QtWayland {
+
+// Parses the value of QT_WAYLAND_SHAREDTEXTURE_MEMORY_BUDGET, a number of bytes
+bool TextureSharingCache::parseMemoryBudget(const QByteArray &value, qint64 *budget)
+{
+    bool ok = false;
+    const qint64 bytes = value.toLongLong(&ok);
+    if (!ok || bytes < 0)
+        return false;
+    *budget = bytes;
+    return true;
+}
+
+bool TextureSharingCache::setMemoryBudget(qint64 bytes)
+{
+    bytes = qMax<qint64>(bytes, 0);
+    if (m_memory_budget == bytes)
+        return false;
+    m_memory_budget = bytes;
+    return true;
+}
+
+void TextureSharingCache::insert(const QString &key, qint64 byteCount)
+{
+    Entry &entry = m_entries[key];
+    m_memory_usage += byteCount - entry.byteCount;
+    entry.byteCount = byteCount;
+    entry.lastUsed = ++m_use_counter;
+}
+
+void TextureSharingCache::touch(const QString &key)
+{
+    auto it = m_entries.find(key);
+    if (it == m_entries.end())
+        return;
+    ++m_hits;
+    it->lastUsed = ++m_use_counter;
+}
+
+void TextureSharingCache::evict(const QString &key)
+{
+    auto it = m_entries.constFind(key);
+    if (it == m_entries.constEnd())
+        return;
+    m_memory_usage -= it->byteCount;
+    ++m_evictions;
+    m_entries.erase(it);
+}
+
+// Returns the keys to evict, least recently used first, to get back within the
+// budget. Keys that are not evictable and protectedKey are never returned, so
+// the result may not be enough to get within the budget.
+QStringList TextureSharingCache::keysToEvict(const std::function<bool(const QString &)> &isEvictable,
+                                             const QString &protectedKey) const
+{
+    if (!isOverBudget())
+        return QStringList();
+
+    QList<QHash<QString, Entry>::const_iterator> candidates;
+    for (auto it = m_entries.cbegin(); it != m_entries.cend(); ++it) {
+        if (it.key() != protectedKey && isEvictable(it.key()))
+            candidates.append(it);
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [](const auto &a, const auto &b) {
+        return a->lastUsed < b->lastUsed;
+    });
+
+    QStringList keys;
+    qint64 usage = m_memory_usage;
+    for (const auto &it : std::as_const(candidates)) {
+        if (usage <= m_memory_budget)
+            break;
+        usage -= it->byteCount;
+        keys.append(it.key());
+    }
+    return keys;
+}
+
+TextureSharingCache::Statistics TextureSharingCache::statistics() const
+{
+    Statistics stats;
+    stats.entryCount = m_entries.size();
+    stats.memoryUsage = m_memory_usage;
+    stats.memoryBudget = m_memory_budget;
+    stats.hits = m_hits;
+    stats.misses = m_misses;
+    stats.evictions = m_evictions;
+    return stats;
+}
+
+}
+
+QT_END_NAMESPACE
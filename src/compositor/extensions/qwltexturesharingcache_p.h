@@ -0,0 +1,85 @@
+// Copyright (C) 2019 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#ifndef QWLTEXTURESHARINGCACHE_P_H
+#define QWLTEXTURESHARINGCACHE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtWaylandCompositor/qtwaylandcompositorglobal.h>
+
+#include <QtCore/QHash>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+
+#include <functional>
+
+QT_BEGIN_NAMESPACE
+
+namespace QtWayland {
+
+// Memory accounting for the buffers of the texture sharing extension. Keeps
+// track of the size and last use of every buffer and decides which of them to
+// evict, least recently used first, when the memory budget is exceeded. The
+// buffers themselves are owned by the extension.
+class Q_WAYLANDCOMPOSITOR_EXPORT TextureSharingCache
+{
+public:
+    struct Statistics
+    {
+        int entryCount = 0;
+        qint64 memoryUsage = 0;
+        qint64 memoryBudget = 0;
+        quint64 hits = 0;
+        quint64 misses = 0;
+        quint64 evictions = 0;
+    };
+
+    static bool parseMemoryBudget(const QByteArray &value, qint64 *budget);
+
+    qint64 memoryBudget() const { return m_memory_budget; }
+    bool setMemoryBudget(qint64 bytes);
+    qint64 memoryUsage() const { return m_memory_usage; }
+    bool isOverBudget() const { return m_memory_budget > 0 && m_memory_usage > m_memory_budget; }
+
+    bool contains(const QString &key) const { return m_entries.contains(key); }
+    void insert(const QString &key, qint64 byteCount);
+    void touch(const QString &key);
+    void evict(const QString &key);
+    void recordMisses(int count = 1) { m_misses += count; }
+
+    QStringList keysToEvict(const std::function<bool(const QString &)> &isEvictable,
+                            const QString &protectedKey = QString()) const;
+
+    Statistics statistics() const;
+
+private:
+    struct Entry
+    {
+        qint64 byteCount = 0;
+        quint64 lastUsed = 0;
+    };
+
+    QHash<QString, Entry> m_entries;
+    qint64 m_memory_budget = 0; // 0 means unlimited
+    qint64 m_memory_usage = 0;
+    quint64 m_use_counter = 0;
+    quint64 m_hits = 0;
+    quint64 m_misses = 0;
+    quint64 m_evictions = 0;
+};
+
+}
+
+QT_END_NAMESPACE
+
+#endif // QWLTEXTURESHARINGCACHE_P_H
@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
 
 #include "qwltexturesharingextension_p.h"
+#include "qwltextureatlaspacker_p.h"
 
 #include <QWaylandSurface>
 
@@ -170,6 +171,8 @@ QWaylandTextureSharingExtension::~QWaylandTextureSharingExtension()
 
     for (auto b : m_server_buffers)
         delete b.buffer;
+    for (auto b : m_atlas_buffers)
+        delete b.buffer;
 
     if (s_self == this)
         s_self = nullptr;
@@ -188,12 +191,24 @@ void QWaylandTextureSharingExtension::initialize()
 {
     QWaylandCompositorExtensionTemplate::initialize();
     QWaylandCompositor *compositor = static_cast<QWaylandCompositor *>(extensionContainer());
-    init(compositor->display(), 1);
+    init(compositor->display(), 3);
 
     QString image_search_path = qEnvironmentVariable("QT_WAYLAND_SHAREDTEXTURE_SEARCH_PATH");
     if (!image_search_path.isEmpty())
         setImageSearchPath(image_search_path);
 
+    QByteArray memory_budget = qgetenv("QT_WAYLAND_SHAREDTEXTURE_MEMORY_BUDGET");
+    if (!memory_budget.isEmpty()) {
+        qint64 budget = 0;
+        if (QtWayland::TextureSharingCache::parseMemoryBudget(memory_budget, &budget))
+            setMemoryBudget(budget);
+        else
+            qWarning() << "QWaylandTextureSharingExtension: invalid QT_WAYLAND_SHAREDTEXTURE_MEMORY_BUDGET" << memory_budget;
+    }
+
+    if (qEnvironmentVariableIsSet("QT_WAYLAND_SHAREDTEXTURE_ATLAS_THRESHOLD"))
+        setAtlasThreshold(qEnvironmentVariableIntValue("QT_WAYLAND_SHAREDTEXTURE_ATLAS_THRESHOLD"));
+
     if (m_image_dirs.isEmpty())
         m_image_dirs << QLatin1String(":/") << QLatin1String("./");
 
@@ -250,18 +265,25 @@ QtWayland::ServerBuffer *QWaylandTextureSharingExtension::getBuffer(const QStrin
 
     QtWayland::ServerBuffer *buffer = nullptr;
 
-    if ((buffer = m_server_buffers.value(key).buffer))
-        return buffer;
+    auto existing = m_server_buffers.constFind(key);
+    if (existing != m_server_buffers.constEnd()) {
+        m_cache.touch(key);
+        return existing->buffer;
+    }
+
+    m_cache.recordMisses();
 
     QByteArray pixelData;
     QSize size;
     uint glInternalFormat = GL_NONE;
+    qint64 byteCount = 0;
 
     if (customPixelData(key, &pixelData, &size, &glInternalFormat)) {
         if (!pixelData.isEmpty()) {
             buffer = m_server_buffer_integration->createServerBufferFromData(pixelData, size, glInternalFormat);
             if (!buffer)
                 qWarning() << "QWaylandTextureSharingExtension: could not create buffer from custom data for key:" << key;
+            byteCount = pixelData.size();
         }
     } else {
         QString pathName = getExistingFilePath(key);
@@ -269,7 +291,7 @@ QtWayland::ServerBuffer *QWaylandTextureSharingExtension::getBuffer(const QStrin
         if (pathName.isEmpty())
             return nullptr;
 
-        buffer = getCompressedBuffer(pathName);
+        buffer = getCompressedBuffer(pathName, &byteCount);
         //qDebug() << "getCompressedBuffer" << buffer;
 
         if (!buffer) {
@@ -277,12 +299,16 @@ QtWayland::ServerBuffer *QWaylandTextureSharingExtension::getBuffer(const QStrin
             if (!img.isNull()) {
                 img = img.convertToFormat(QImage::Format_RGBA8888_Premultiplied);
                 buffer = m_server_buffer_integration->createServerBufferFromImage(img, QtWayland::ServerBuffer::RGBA32);
+                byteCount = img.sizeInBytes();
             }
             //qDebug() << "createServerBufferFromImage" << buffer;
         }
     }
-    if (buffer)
+    if (buffer) {
         m_server_buffers.insert(key, BufferInfo(buffer));
+        m_cache.insert(key, byteCount);
+        enforceMemoryBudget(key);
+    }
 
     //qDebug() << ">>>>" << key << buffer;
 
@@ -308,6 +334,11 @@ void QWaylandTextureSharingExtension::requestBuffer(const QString &key)
 }
 
 void QWaylandTextureSharingExtension::zqt_texture_sharing_v1_request_image(Resource *resource, const QString &key)
+{
+    provideImage(resource, key);
+}
+
+void QWaylandTextureSharingExtension::provideImage(Resource *resource, const QString &key)
 {
     //qDebug() << "texture_sharing_request_image" << key;
     auto *buffer = getBuffer(key);
@@ -325,6 +356,135 @@ void QWaylandTextureSharingExtension::zqt_texture_sharing_v1_request_image(Resou
     //dumpBufferInfo();
 }
 
+void QWaylandTextureSharingExtension::zqt_texture_sharing_v1_request_images(Resource *resource, uint32_t serial, const QByteArray &keys)
+{
+    //qDebug() << "texture_sharing_request_images" << serial << keys.size();
+    const bool useAtlas = m_atlas_threshold > 0
+            && resource->version() >= ZQT_TEXTURE_SHARING_V1_PROVIDE_BUFFER_REGION_SINCE_VERSION
+            && initServerBufferIntegration();
+
+    QList<QPair<QString, QImage>> atlasImages;
+    QStringList cachedAtlasKeys;
+    const QList<QByteArray> keyList = keys.split('\0');
+    for (const QByteArray &utf8Key : keyList) {
+        if (utf8Key.isEmpty())
+            continue;
+        const QString key = QString::fromUtf8(utf8Key);
+        if (useAtlas) {
+            auto region = m_atlas_regions.constFind(key);
+            if (region != m_atlas_regions.constEnd()) {
+                m_cache.touch(region->atlasKey);
+                cachedAtlasKeys.append(key);
+                continue;
+            }
+            QImage image = loadAtlasCandidate(key);
+            if (!image.isNull()) {
+                atlasImages.append(qMakePair(key, image));
+                continue;
+            }
+        }
+        provideImage(resource, key);
+    }
+
+    if (!atlasImages.isEmpty() || !cachedAtlasKeys.isEmpty())
+        provideAtlasImages(resource, atlasImages, cachedAtlasKeys);
+
+    send_images_done(resource->handle, serial);
+}
+
+// Returns the image for key if it should go into an atlas, or a null image for
+// images that already have their own buffer, are too large, compressed or
+// provided through customPixelData().
+QImage QWaylandTextureSharingExtension::loadAtlasCandidate(const QString &key)
+{
+    if (m_server_buffers.contains(key))
+        return QImage();
+
+    QByteArray pixelData;
+    QSize size;
+    uint glInternalFormat = GL_NONE;
+    if (customPixelData(key, &pixelData, &size, &glInternalFormat))
+        return QImage();
+
+    QString pathName = getExistingFilePath(key);
+    if (pathName.isEmpty())
+        return QImage();
+
+    QFile f(pathName);
+    if (f.open(QIODevice::ReadOnly) && QTextureFileReader(&f, pathName).canRead())
+        return QImage();
+    f.close();
+
+    QImageReader reader(pathName);
+    const QSize imageSize = reader.size();
+    if (!imageSize.isValid() || imageSize.width() > m_atlas_threshold || imageSize.height() > m_atlas_threshold)
+        return QImage();
+
+    return reader.read().convertToFormat(QImage::Format_RGBA8888_Premultiplied);
+}
+
+// Packs the images into as few atlas server buffers as possible and sends the
+// region of every new image as well as of the keys in atlasKeys, which are
+// already in an atlas.
+void QWaylandTextureSharingExtension::provideAtlasImages(Resource *resource, const QList<QPair<QString, QImage>> &images, QStringList atlasKeys)
+{
+    QStringList rejectedKeys;
+    const QList<QtWayland::TextureAtlasPacker::Atlas> atlases = QtWayland::TextureAtlasPacker::pack(images, s_atlas_size, &rejectedKeys);
+
+    for (const QString &key : std::as_const(rejectedKeys))
+        provideImage(resource, key);
+
+    for (const auto &atlas : atlases) {
+        const QImage &atlasImage = atlas.image;
+        const auto &placed = atlas.regions;
+
+        auto *buffer = m_server_buffer_integration->createServerBufferFromImage(atlasImage, QtWayland::ServerBuffer::RGBA32);
+        if (!buffer) {
+            qWarning() << "QWaylandTextureSharingExtension: could not create atlas buffer";
+            for (const auto &region : std::as_const(placed))
+                send_image_failed(resource->handle, region.first, QString());
+            continue;
+        }
+
+        const QString atlasKey = QChar(0) + QStringLiteral("atlas-%1").arg(++m_atlas_serial);
+        m_atlas_buffers.insert(atlasKey, BufferInfo(buffer));
+        m_cache.insert(atlasKey, atlasImage.sizeInBytes());
+        m_cache.recordMisses(placed.size());
+
+        for (const auto &region : std::as_const(placed)) {
+            m_atlas_regions.insert(region.first, AtlasRegion{atlasKey, region.second});
+            atlasKeys.append(region.first);
+        }
+    }
+
+    for (const QString &key : std::as_const(atlasKeys)) {
+        const AtlasRegion region = m_atlas_regions.value(key);
+        auto *buffer = m_atlas_buffers.value(region.atlasKey).buffer;
+        struct ::wl_resource *buffer_resource = buffer ? buffer->resourceForClient(resource->client()) : nullptr;
+        if (buffer_resource) {
+            const QRect &r = region.rect;
+            send_provide_buffer_region(resource->handle, buffer_resource, key, r.x(), r.y(), r.width(), r.height());
+        } else {
+            qWarning() << "QWaylandTextureSharingExtension: no atlas buffer resource for client";
+            send_image_failed(resource->handle, key, QString());
+        }
+    }
+
+    enforceMemoryBudget();
+}
+
+void QWaylandTextureSharingExtension::removeAtlas(const QString &atlasKey)
+{
+    delete m_atlas_buffers.take(atlasKey).buffer;
+
+    for (auto it = m_atlas_regions.begin(); it != m_atlas_regions.end(); ) {
+        if (it->atlasKey == atlasKey)
+            it = m_atlas_regions.erase(it);
+        else
+            ++it;
+    }
+}
+
 void QWaylandTextureSharingExtension::zqt_texture_sharing_v1_abandon_image(Resource *resource, const QString &key)
 {
     Q_UNUSED(resource);
@@ -358,7 +518,7 @@ bool QWaylandTextureSharingExtension::initServerBufferIntegration()
     return true;
 }
 
-QtWayland::ServerBuffer *QWaylandTextureSharingExtension::getCompressedBuffer(const QString &pathName)
+QtWayland::ServerBuffer *QWaylandTextureSharingExtension::getCompressedBuffer(const QString &pathName, qint64 *byteCount)
 {
     QFile f(pathName);
     if (!f.open(QIODevice::ReadOnly))
@@ -378,28 +538,113 @@ QtWayland::ServerBuffer *QWaylandTextureSharingExtension::getCompressedBuffer(co
         return nullptr;
     }
 
+    *byteCount = td.getDataView().size();
     return m_server_buffer_integration->createServerBufferFromData(td.getDataView(), td.size(),
                                                                    td.glInternalFormat());
 }
 
 void QWaylandTextureSharingExtension::cleanupBuffers()
 {
-    for (auto it = m_server_buffers.begin(); it != m_server_buffers.end(); ) {
-        auto *buffer = it.value().buffer;
-        if (!it.value().usedLocally && !buffer->bufferInUse()) {
-            //qDebug() << "deleting buffer for" << it.key();
-            it = m_server_buffers.erase(it);
-            delete buffer;
-        } else {
-            ++it;
+    // With a memory budget, buffers nobody uses any more are kept as a cache
+    // and only evicted (least recently used first) when the budget is exceeded.
+    if (m_cache.memoryBudget() > 0) {
+        enforceMemoryBudget();
+        return;
+    }
+
+    const QStringList keys = m_server_buffers.keys() + m_atlas_buffers.keys();
+    for (const QString &key : keys) {
+        if (isEvictable(key)) {
+            //qDebug() << "deleting buffer for" << key;
+            evictBuffer(key);
         }
     }
     //dumpBufferInfo();
 }
 
+void QWaylandTextureSharingExtension::setAtlasThreshold(int threshold)
+{
+    threshold = qBound(0, threshold, s_atlas_size - 2 * QtWayland::TextureAtlasPacker::Gutter);
+    if (m_atlas_threshold == threshold)
+        return;
+
+    m_atlas_threshold = threshold;
+    emit atlasThresholdChanged();
+}
+
+void QWaylandTextureSharingExtension::setMemoryBudget(qint64 bytes)
+{
+    if (!m_cache.setMemoryBudget(bytes))
+        return;
+
+    emit memoryBudgetChanged();
+    enforceMemoryBudget();
+}
+
+bool QWaylandTextureSharingExtension::isEvictable(const QString &cacheKey) const
+{
+    auto it = m_server_buffers.constFind(cacheKey);
+    if (it != m_server_buffers.constEnd())
+        return it->isEvictable();
+    it = m_atlas_buffers.constFind(cacheKey);
+    return it != m_atlas_buffers.constEnd() && it->isEvictable();
+}
+
+void QWaylandTextureSharingExtension::evictBuffer(const QString &cacheKey)
+{
+    if (m_atlas_buffers.contains(cacheKey))
+        removeAtlas(cacheKey);
+    else
+        delete m_server_buffers.take(cacheKey).buffer;
+    m_cache.evict(cacheKey);
+}
+
+void QWaylandTextureSharingExtension::enforceMemoryBudget(const QString &protectedKey)
+{
+    const QStringList keys = m_cache.keysToEvict([this](const QString &key) { return isEvictable(key); },
+                                                 protectedKey);
+    for (const QString &key : keys) {
+        //qDebug() << "evicting buffer for" << key;
+        evictBuffer(key);
+    }
+
+    if (m_cache.isOverBudget())
+        emit memoryBudgetExceeded(m_cache.memoryUsage(), m_cache.memoryBudget());
+}
+
+QWaylandTextureSharingExtension::BufferStatistics QWaylandTextureSharingExtension::bufferStatistics() const
+{
+    const QtWayland::TextureSharingCache::Statistics cacheStats = m_cache.statistics();
+    BufferStatistics stats;
+    stats.bufferCount = m_server_buffers.size();
+    for (const auto &info : m_server_buffers) {
+        if (info.isEvictable())
+            ++stats.evictableCount;
+    }
+    stats.atlasCount = m_atlas_buffers.size();
+    stats.atlasImageCount = m_atlas_regions.size();
+    for (const auto &info : m_atlas_buffers) {
+        if (info.isEvictable())
+            ++stats.evictableCount;
+    }
+    stats.memoryUsage = cacheStats.memoryUsage;
+    stats.memoryBudget = cacheStats.memoryBudget;
+    stats.hits = cacheStats.hits;
+    stats.misses = cacheStats.misses;
+    stats.evictions = cacheStats.evictions;
+    return stats;
+}
+
 void QWaylandTextureSharingExtension::dumpBufferInfo()
 {
-    qDebug() << "shared buffers:" << m_server_buffers.size();
+    const BufferStatistics stats = bufferStatistics();
+    qDebug() << "shared buffers:" << stats.bufferCount
+             << "atlases:" << stats.atlasCount << "(" << stats.atlasImageCount << "images )"
+             << "evictable:" << stats.evictableCount
+             << "memory:" << stats.memoryUsage << "/" << stats.memoryBudget
+             << "hits:" << stats.hits << "misses:" << stats.misses
+             << "hit rate:" << stats.hitRate()
+             << "evictions:" << stats.evictions;
     for (auto it = m_server_buffers.cbegin(); it != m_server_buffers.cend(); ++it)
         qDebug() << "    " << it.key() << ":" << it.value().buffer << "in use" << it.value().buffer->bufferInUse() << "usedLocally" << it.value().usedLocally ;
 }
@@ -28,6 +28,7 @@
 
 #include <QtWaylandCompositor/private/qwaylandcompositor_p.h>
 #include <QtWaylandCompositor/private/qwlserverbufferintegration_p.h>
+#include <QtWaylandCompositor/private/qwltexturesharingcache_p.h>
 
 #include <QtWaylandCompositor/private/qwayland-server-qt-texture-sharing-unstable-v1.h>
 
@@ -60,7 +61,24 @@ class Q_WAYLANDCOMPOSITOR_EXPORT QWaylandTextureSharingExtension
 {
     Q_OBJECT
     Q_PROPERTY(QString imageSearchPath WRITE setImageSearchPath)
+    Q_PROPERTY(qint64 memoryBudget READ memoryBudget WRITE setMemoryBudget NOTIFY memoryBudgetChanged)
+    Q_PROPERTY(int atlasThreshold READ atlasThreshold WRITE setAtlasThreshold NOTIFY atlasThresholdChanged)
 public:
+    struct BufferStatistics
+    {
+        int bufferCount = 0;
+        int atlasCount = 0;
+        int atlasImageCount = 0;
+        int evictableCount = 0;
+        qint64 memoryUsage = 0;
+        qint64 memoryBudget = 0;
+        quint64 hits = 0;
+        quint64 misses = 0;
+        quint64 evictions = 0;
+
+        qreal hitRate() const { return hits + misses ? qreal(hits) / qreal(hits + misses) : 0; }
+    };
+
     QWaylandTextureSharingExtension();
     QWaylandTextureSharingExtension(QWaylandCompositor *compositor);
     ~QWaylandTextureSharingExtension() override;
@@ -69,6 +87,14 @@ public:
 
     void setImageSearchPath(const QString &path);
 
+    qint64 memoryBudget() const { return m_cache.memoryBudget(); }
+    void setMemoryBudget(qint64 bytes);
+    qint64 memoryUsage() const { return m_cache.memoryUsage(); }
+    BufferStatistics bufferStatistics() const;
+
+    int atlasThreshold() const { return m_atlas_threshold; }
+    void setAtlasThreshold(int threshold);
+
     static QWaylandTextureSharingExtension *self() { return s_self; }
 
 public slots:
@@ -76,6 +102,9 @@ public slots:
 
 signals:
      void bufferResult(const QString &key, QtWayland::ServerBuffer *buffer);
+     void memoryBudgetChanged();
+     void memoryBudgetExceeded(qint64 usage, qint64 budget);
+     void atlasThresholdChanged();
 
 protected slots:
     void cleanupBuffers();
@@ -83,6 +112,7 @@ protected slots:
 protected:
     void zqt_texture_sharing_v1_request_image(Resource *resource, const QString &key) override;
     void zqt_texture_sharing_v1_abandon_image(Resource *resource, const QString &key) override;
+    void zqt_texture_sharing_v1_request_images(Resource *resource, uint32_t serial, const QByteArray &keys) override;
     void zqt_texture_sharing_v1_destroy_resource(Resource *resource) override;
 
     virtual bool customPixelData(const QString &key, QByteArray *data, QSize *size, uint *glInternalFormat)
@@ -97,22 +127,47 @@ protected:
 private:
     QtWayland::ServerBuffer *getBuffer(const QString &key);
     bool initServerBufferIntegration();
-    QtWayland::ServerBuffer *getCompressedBuffer(const QString &key);
+    QtWayland::ServerBuffer *getCompressedBuffer(const QString &key, qint64 *byteCount);
     QString getExistingFilePath(const QString &key) const;
     void dumpBufferInfo();
+    void enforceMemoryBudget(const QString &protectedKey = QString());
+    bool isEvictable(const QString &cacheKey) const;
+    void evictBuffer(const QString &cacheKey);
+    void provideImage(Resource *resource, const QString &key);
+    QImage loadAtlasCandidate(const QString &key);
+    void provideAtlasImages(Resource *resource, const QList<QPair<QString, QImage>> &images, QStringList atlasKeys);
+    void removeAtlas(const QString &atlasKey);
 
     struct BufferInfo
     {
         BufferInfo(QtWayland::ServerBuffer *b = nullptr) : buffer(b) {}
         QtWayland::ServerBuffer *buffer = nullptr;
         bool usedLocally = false;
+
+        bool isEvictable() const { return !usedLocally && !buffer->bufferInUse(); }
     };
 
     QStringList m_image_dirs;
     QStringList m_image_suffixes;
     QHash<QString, BufferInfo> m_server_buffers;
+
+    struct AtlasRegion
+    {
+        QString atlasKey;
+        QRect rect;
+    };
+
+    QHash<QString, BufferInfo> m_atlas_buffers;
+    QHash<QString, AtlasRegion> m_atlas_regions;
+    static constexpr int s_atlas_size = 1024;
+    int m_atlas_threshold = 0; // 0 means atlasing is disabled
+    int m_atlas_serial = 0;
     QtWayland::ServerBufferIntegration *m_server_buffer_integration = nullptr;
 
+    // Atlas buffers are in the cache under their atlas key, which starts with a
+    // NUL character and therefore never clashes with an image key.
+    QtWayland::TextureSharingCache m_cache;
+
     static QWaylandTextureSharingExtension *s_self;
 };
 
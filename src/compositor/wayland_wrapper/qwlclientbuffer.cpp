@@ -30,6 +30,7 @@ ClientBuffer::~ClientBuffer()
 {
     if (m_buffer && m_committed && !m_destroyed)
         sendRelease();
+    signalReleaseFence();
 }
 
 void ClientBuffer::sendRelease()
@@ -37,6 +38,23 @@ void ClientBuffer::sendRelease()
     Q_ASSERT(m_buffer);
     wl_buffer_send_release(m_buffer);
     m_committed = false;
+    signalReleaseFence();
+}
+
+void ClientBuffer::setReleaseFence(const QSharedPointer<Fence> &fence)
+{
+    // a fence from an earlier commit that was never released is done as well
+    if (m_releaseFence != fence)
+        signalReleaseFence();
+    m_releaseFence = fence;
+}
+
+void ClientBuffer::signalReleaseFence()
+{
+    if (m_releaseFence) {
+        m_releaseFence->signal();
+        m_releaseFence.reset();
+    }
 }
 
 void ClientBuffer::setDestroyed()
@@ -44,6 +62,8 @@ void ClientBuffer::setDestroyed()
     m_destroyed = true;
     m_committed = false;
     m_buffer = nullptr;
+    // nobody is going to read from the buffer anymore
+    signalReleaseFence();
 
     if (!m_refCount.loadAcquire())
         delete this;
@@ -76,8 +96,9 @@ QWaylandBufferRef::BufferFormatEgl ClientBuffer::bufferFormatEgl() const
     return QWaylandBufferRef::BufferFormatEgl_Null;
 }
 
-SharedMemoryBuffer::SharedMemoryBuffer(wl_resource *bufferResource)
+SharedMemoryBuffer::SharedMemoryBuffer(wl_resource *bufferResource, QWaylandCompositor *compositor)
     : ClientBuffer(bufferResource)
+    , m_compositor(compositor)
 {
 
 }
@@ -122,6 +143,14 @@ QImage SharedMemoryBuffer::image() const
     return QImage();
 }
 
+void SharedMemoryBuffer::contentsCopied()
+{
+    if (m_compositor && m_compositor->retainSharedMemoryBuffers())
+        return;
+    if (isCommitted() && m_buffer)
+        sendRelease();
+}
+
 #if QT_CONFIG(opengl)
 QOpenGLTexture *SharedMemoryBuffer::toOpenGlTexture(int plane)
 {
@@ -150,8 +179,7 @@ QOpenGLTexture *SharedMemoryBuffer::toOpenGlTexture(int plane)
                 glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, image.width(), image.height(), 0, GL_RGB, GL_UNSIGNED_BYTE, image.constBits());
             }
             //we can release the buffer after uploading, since we have a copy
-            if (isCommitted())
-                sendRelease();
+            contentsCopied();
         }
         return m_shmTexture;
     }
@@ -19,10 +19,12 @@
 #include <QtGui/qopengl.h>
 #include <QImage>
 #include <QAtomicInt>
+#include <QtCore/QSharedPointer>
 
 #include <QtWaylandCompositor/QWaylandSurface>
 #include <QtWaylandCompositor/QWaylandBufferRef>
 #include <QtCore/private/qglobal_p.h>
+#include <QtWaylandCompositor/private/qwlfence_p.h>
 
 #include <wayland-server-core.h>
 
@@ -71,6 +73,14 @@ public:
     virtual QOpenGLTexture *toOpenGlTexture(int plane = 0) = 0;
 #endif
 
+    // Signalled together with the next release of this buffer
+    void setReleaseFence(const QSharedPointer<Fence> &fence);
+    QSharedPointer<Fence> releaseFence() const { return m_releaseFence; }
+
+    // Called once the contents have been copied somewhere the compositor
+    // renders from, so the client may get the buffer back early.
+    virtual void contentsCopied() { }
+
     static bool hasContent(ClientBuffer *buffer) { return buffer && buffer->waylandBufferHandle(); }
     static bool hasProtectedContent(ClientBuffer *buffer) { return buffer && buffer->isProtected(); }
 
@@ -85,8 +95,11 @@ protected:
     bool m_textureDirty = false;
 
 private:
+    void signalReleaseFence();
+
     bool m_committed = false;
     bool m_destroyed = false;
+    QSharedPointer<Fence> m_releaseFence;
 
     QAtomicInt m_refCount;
 
@@ -97,16 +110,20 @@ private:
 class Q_WAYLANDCOMPOSITOR_EXPORT SharedMemoryBuffer : public ClientBuffer
 {
 public:
-    SharedMemoryBuffer(struct ::wl_resource *bufferResource);
+    SharedMemoryBuffer(struct ::wl_resource *bufferResource, QWaylandCompositor *compositor = nullptr);
 
     QSize size() const override;
     QWaylandSurface::Origin origin() const  override;
     QImage image() const override;
+    void contentsCopied() override;
 
 #if QT_CONFIG(opengl)
     QOpenGLTexture *toOpenGlTexture(int plane = 0) override;
+#endif
 
 private:
+    QWaylandCompositor *m_compositor = nullptr;
+#if QT_CONFIG(opengl)
     QOpenGLTexture *m_shmTexture = nullptr;
 #endif
 };
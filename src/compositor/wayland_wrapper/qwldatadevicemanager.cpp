@@ -14,20 +14,122 @@
 
 #include <QtCore/QDebug>
 #include <QtCore/QSocketNotifier>
+#include <QtCore/QTimer>
 #include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/syscall.h>
 #include <QtCore/private/qcore_unix_p.h>
-#include <QtCore/QFile>
+#ifdef Q_OS_LINUX
+#include <sys/sendfile.h>
+#endif
+
+// from linux/memfd.h:
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC             0x0001U
+#endif
+#ifndef MFD_ALLOW_SEALING
+#define MFD_ALLOW_SEALING       0x0002U
+#endif
+// from linux/fcntl.h:
+#ifndef F_ADD_SEALS
+#define F_ADD_SEALS             (1024 + 9)
+#endif
+#ifndef F_SEAL_SEAL
+#define F_SEAL_SEAL             0x0001
+#define F_SEAL_SHRINK           0x0002
+#define F_SEAL_GROW             0x0004
+#define F_SEAL_WRITE            0x0008
+#endif
 
 QT_BEGIN_NAMESPACE
 
 namespace QtWayland {
 
+// retained types larger than this are kept in a memfd
+static constexpr qsizetype RetainedSpillThreshold = 256 * 1024;
+
+RetainedMimeData::~RetainedMimeData()
+{
+    clear();
+}
+
+void RetainedMimeData::clear()
+{
+    for (const File &file : std::as_const(m_files))
+        close(file.fd);
+    m_files.clear();
+    m_fileFormats.clear();
+    QMimeData::clear();
+}
+
+void RetainedMimeData::setFile(const QString &mimeType, int fd, qint64 size)
+{
+    removeFormat(mimeType);
+    auto it = m_files.find(mimeType);
+    if (it != m_files.end())
+        close(it->fd);
+    else
+        m_fileFormats.append(mimeType);
+    m_files.insert(mimeType, { fd, size });
+}
+
+int RetainedMimeData::fileDescriptor(const QString &mimeType) const
+{
+    return m_files.value(mimeType).fd;
+}
+
+qint64 RetainedMimeData::fileSize(const QString &mimeType) const
+{
+    return m_files.value(mimeType).size;
+}
+
+QStringList RetainedMimeData::formats() const
+{
+    return QMimeData::formats() + m_fileFormats;
+}
+
+bool RetainedMimeData::hasFormat(const QString &mimeType) const
+{
+    return m_files.contains(mimeType) || QMimeData::hasFormat(mimeType);
+}
+
+// Files are only read back when someone in the compositor asks for them
+QVariant RetainedMimeData::retrieveData(const QString &mimeType, QMetaType type) const
+{
+    auto it = m_files.constFind(mimeType);
+    if (it == m_files.cend())
+        return QMimeData::retrieveData(mimeType, type);
+
+    QByteArray data(it->size, Qt::Uninitialized);
+    qint64 offset = 0;
+    while (offset < it->size) {
+        const qint64 n = pread(it->fd, data.data() + offset, it->size - offset, offset);
+        if (n <= 0) {
+            if (n == -1 && errno == EINTR)
+                continue;
+            qWarning("Clipboard: Failed to read retained %s", qPrintable(mimeType));
+            return QVariant();
+        }
+        offset += n;
+    }
+    return data;
+}
+
 DataDeviceManager::DataDeviceManager(QWaylandCompositor *compositor)
     : wl_data_device_manager(compositor->display(), 1)
     , m_compositor(compositor)
 {
 }
 
+DataDeviceManager::~DataDeviceManager()
+{
+    const auto writes = m_retainedWrites;
+    for (RetainedWrite *write : writes)
+        finishWriteToClient(write);
+    discardRetainedRead();
+}
+
 void DataDeviceManager::setCurrentSelectionSource(DataSource *source)
 {
     if (m_current_selection_source && source
@@ -39,6 +141,7 @@ void DataDeviceManager::setCurrentSelectionSource(DataSource *source)
     m_compositorOwnsSelection = false;
 
     finishReadFromClient();
+    discardRetainedRead();
 
     m_current_selection_source = source;
     if (source)
@@ -49,30 +152,63 @@ void DataDeviceManager::setCurrentSelectionSource(DataSource *source)
     //    1. supply the selection after the offering client is gone
     //    2. make it possible for the compositor to participate in copy-paste
     // The downside is decreased performance, therefore this mode has to be enabled
-    // explicitly in the compositors.
+    // explicitly in the compositors. The most useful types are read first, and
+    // the compositor can bound the amount of data that is kept.
     if (source && m_compositor->retainedSelectionEnabled()) {
         m_retainedData.clear();
+        m_retainedTypes = retainOrder(source->mimeTypes());
         m_retainedReadIndex = 0;
+        m_retainedSize = 0;
         retain();
     }
 }
 
 void DataDeviceManager::sourceDestroyed(DataSource *source)
 {
-    if (m_current_selection_source == source)
+    if (m_current_selection_source == source) {
         finishReadFromClient();
+        discardRetainedRead();
+    }
+}
+
+static int retainPriority(const QString &mimeType)
+{
+    if (mimeType == QLatin1String("text/plain;charset=utf-8"))
+        return 0;
+    if (mimeType == QLatin1String("text/plain"))
+        return 1;
+    if (mimeType == QLatin1String("text/uri-list"))
+        return 2;
+    if (mimeType.startsWith(QLatin1String("text/")))
+        return 3;
+    if (mimeType == QLatin1String("image/png"))
+        return 4;
+    if (mimeType.startsWith(QLatin1String("image/")))
+        return 5;
+    return 6;
+}
+
+// Text is cheap and what is pasted most, so it is retained before images
+// and anything else, which are the first to be dropped if a size limit is
+// exceeded.
+QStringList DataDeviceManager::retainOrder(const QStringList &mimeTypes)
+{
+    QStringList ordered = mimeTypes;
+    std::stable_sort(ordered.begin(), ordered.end(), [](const QString &a, const QString &b) {
+        return retainPriority(a) < retainPriority(b);
+    });
+    return ordered;
 }
 
 void DataDeviceManager::retain()
 {
-    QList<QString> offers = m_current_selection_source->mimeTypes();
     finishReadFromClient();
-    if (m_retainedReadIndex >= offers.size()) {
+    discardRetainedRead();
+    if (m_retainedReadIndex >= m_retainedTypes.size()) {
         QWaylandCompositorPrivate::get(m_compositor)->feedRetainedSelectionData(&m_retainedData);
         return;
     }
-    QString mimeType = offers.at(m_retainedReadIndex);
-    m_retainedReadBuf.clear();
+    QString mimeType = m_retainedTypes.at(m_retainedReadIndex);
     int fd[2];
     if (pipe(fd) == -1) {
         qWarning("Clipboard: Failed to create pipe");
@@ -101,9 +237,55 @@ void DataDeviceManager::finishReadFromClient(bool exhausted)
     }
 }
 
+// Moves the type being read into a memfd, which it is read into directly
+// from then on.
+bool DataDeviceManager::spillRetainedRead()
+{
+    int fd = -1;
+#ifdef SYS_memfd_create
+    fd = syscall(SYS_memfd_create, "wayland-retained-selection", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+#endif
+    if (fd == -1)
+        return false;
+
+    if (qt_safe_write(fd, m_retainedReadBuf.constData(), m_retainedReadBuf.size()) != m_retainedReadBuf.size()) {
+        close(fd);
+        return false;
+    }
+    m_retainedReadFile = fd;
+    m_retainedReadBuf.clear();
+    return true;
+}
+
+void DataDeviceManager::finishRetainedType()
+{
+    const QString mimeType = m_retainedTypes.at(m_retainedReadIndex);
+    if (m_retainedReadFile != -1) {
+        // receivers get the file as it is now, nothing can change it anymore
+        fcntl(m_retainedReadFile, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL);
+        m_retainedData.setFile(mimeType, m_retainedReadFile, m_retainedReadSize);
+        m_retainedReadFile = -1;
+    } else {
+        m_retainedData.setData(mimeType, m_retainedReadBuf);
+    }
+    m_retainedSize += m_retainedReadSize;
+    m_retainedReadBuf.clear();
+    m_retainedReadSize = 0;
+}
+
+void DataDeviceManager::discardRetainedRead()
+{
+    if (m_retainedReadFile != -1) {
+        close(m_retainedReadFile);
+        m_retainedReadFile = -1;
+    }
+    m_retainedReadBuf.clear();
+    m_retainedReadSize = 0;
+}
+
 void DataDeviceManager::readFromClient(int fd)
 {
-    static char buf[4096];
+    static char buf[64 * 1024];
     int obsCount = m_obsoleteRetainedReadNotifiers.size();
     for (int i = 0; i < obsCount; ++i) {
         QSocketNotifier *sn = m_obsoleteRetainedReadNotifiers.at(i);
@@ -123,19 +305,205 @@ void DataDeviceManager::readFromClient(int fd)
             return;
         }
     }
-    int n = QT_READ(fd, buf, sizeof buf);
-    if (n <= 0) {
+
+    qint64 n = -1;
+    bool writeFailed = false;
+#ifdef Q_OS_LINUX
+    // spilled data is moved from the pipe to the memfd in the kernel
+    if (m_retainedReadFile != -1) {
+        n = splice(fd, nullptr, m_retainedReadFile, nullptr, 1024 * 1024, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        // anything but an empty pipe or a file system without splice
+        // support, like a full memfd, loses data
+        writeFailed = n == -1 && errno != EINVAL && errno != EAGAIN && errno != EWOULDBLOCK;
+    }
+    if (m_retainedReadFile == -1 || (n == -1 && errno == EINVAL)) {
+#else
+    {
+#endif
+        n = QT_READ(fd, buf, sizeof buf);
+        if (n > 0 && m_retainedReadFile != -1)
+            writeFailed = qt_safe_write(m_retainedReadFile, buf, n) != n;
+    }
+
+    if (n <= 0 && !writeFailed) {
         if (n != -1 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
             finishReadFromClient(true);
-            QList<QString> offers = m_current_selection_source->mimeTypes();
-            QString mimeType = offers.at(m_retainedReadIndex);
-            m_retainedData.setData(mimeType, m_retainedReadBuf);
+            finishRetainedType();
             ++m_retainedReadIndex;
             retain();
         }
-    } else {
+        return;
+    }
+
+    if (n > 0)
+        m_retainedReadSize += n;
+    const qint64 maximumTypeSize = m_compositor->retainedSelectionMaximumTypeSize();
+    const qint64 maximumSize = m_compositor->retainedSelectionMaximumSize();
+    const bool overBudget = (maximumTypeSize > 0 && m_retainedReadSize > maximumTypeSize)
+            || (maximumSize > 0 && m_retainedSize + m_retainedReadSize > maximumSize);
+    if (overBudget || writeFailed) {
+        const QString mimeType = m_retainedTypes.at(m_retainedReadIndex);
+        if (overBudget)
+            qWarning("Clipboard: Not retaining %s, it exceeds the size limit", qPrintable(mimeType));
+        else
+            qWarning("Clipboard: Not retaining %s, failed to store it: %s", qPrintable(mimeType),
+                     qPrintable(qt_error_string(errno)));
+        // retain() discards what was read of this type. The pipe is handed
+        // to the obsolete notifiers, which read the rest and drop it until
+        // the client closes its end, so the client doesn't get SIGPIPE.
+        ++m_retainedReadIndex;
+        retain();
+        return;
+    }
+
+    if (m_retainedReadFile == -1) {
         m_retainedReadBuf.append(buf, n);
+        if (m_retainedReadBuf.size() > RetainedSpillThreshold)
+            spillRetainedRead();
+    }
+}
+
+// Writes as much of the retained selection as the client's pipe takes, and
+// the rest whenever the client read some of it. A client that stops reading
+// can't block the compositor, the transfer is cancelled if it makes no
+// progress for m_retainedWriteTimeout.
+void DataDeviceManager::writeToClient(int fd, const QByteArray &data, int file, qint64 fileSize)
+{
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+
+    auto *write = new RetainedWrite;
+    write->fd = fd;
+    write->data = data;
+    // the retained file may be replaced before the transfer is done
+    if (file != -1) {
+        write->file = fcntl(file, F_DUPFD_CLOEXEC, 0);
+        write->fileSize = fileSize;
+    }
+    m_retainedWrites.append(write);
+    if (writeRetainedData(write)) {
+        finishWriteToClient(write);
+        return;
+    }
+
+    write->notifier = new QSocketNotifier(fd, QSocketNotifier::Write, this);
+    connect(write->notifier, &QSocketNotifier::activated, this, [this, write]() {
+        const qsizetype offset = write->offset;
+        if (writeRetainedData(write))
+            finishWriteToClient(write);
+        else if (write->offset != offset)
+            write->timeout->start();
+    });
+
+    write->timeout = new QTimer(this);
+    write->timeout->setSingleShot(true);
+    write->timeout->setInterval(m_retainedWriteTimeout);
+    connect(write->timeout, &QTimer::timeout, this, [this, write]() {
+        qWarning("Clipboard: Client stopped reading the selection, cancelling the transfer after %lld of %lld bytes",
+                 qlonglong(write->offset), qlonglong(write->file != -1 ? write->fileSize : write->data.size()));
+        finishWriteToClient(write);
+    });
+    write->timeout->start();
+}
+
+namespace {
+// Writing to a pipe the client already closed raises SIGPIPE, which would
+// kill the compositor. The signal is blocked for the calling thread while
+// writing, and one raised by the write is taken off the pending signals
+// before it is unblocked again.
+class SigPipeBlocker
+{
+public:
+    SigPipeBlocker()
+    {
+        sigemptyset(&m_sigPipe);
+        sigaddset(&m_sigPipe, SIGPIPE);
+        sigset_t pending;
+        sigpending(&pending);
+        m_wasPending = sigismember(&pending, SIGPIPE) == 1;
+        pthread_sigmask(SIG_BLOCK, &m_sigPipe, &m_oldMask);
+    }
+
+    ~SigPipeBlocker()
+    {
+        if (m_raised && !m_wasPending) {
+            const int savedErrno = errno;
+            const struct timespec noWait = { 0, 0 };
+            int ret;
+            do {
+                ret = sigtimedwait(&m_sigPipe, nullptr, &noWait);
+            } while (ret == -1 && errno == EINTR);
+            errno = savedErrno;
+        }
+        pthread_sigmask(SIG_SETMASK, &m_oldMask, nullptr);
+    }
+
+    void setRaised() { m_raised = true; }
+
+private:
+    sigset_t m_sigPipe;
+    sigset_t m_oldMask;
+    bool m_wasPending = false;
+    bool m_raised = false;
+};
+}
+
+// Returns true when the transfer is over, because everything was written or
+// the client closed its end.
+bool DataDeviceManager::writeRetainedData(RetainedWrite *write)
+{
+    SigPipeBlocker sigPipeBlocker;
+    auto writeFailed = [&sigPipeBlocker]() {
+        if (errno == EPIPE) {
+            // the client closed its end, it doesn't want the rest
+            sigPipeBlocker.setRaised();
+            return true;
+        }
+        return errno != EAGAIN && errno != EWOULDBLOCK;
+    };
+
+#ifdef Q_OS_LINUX
+    // spilled data goes from the memfd to the client without a copy in here
+    if (write->file != -1) {
+        while (write->offset < write->fileSize) {
+            off_t offset = write->offset;
+            const qint64 n = sendfile(write->fd, write->file, &offset, write->fileSize - write->offset);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n < 0)
+                return writeFailed();
+            if (n == 0)
+                return true;
+            write->offset += n;
+        }
+        return true;
+    }
+#endif
+    while (write->offset < write->data.size()) {
+        const qint64 n = qt_safe_write(write->fd, write->data.constData() + write->offset,
+                                       write->data.size() - write->offset);
+        if (n < 0)
+            return writeFailed();
+        write->offset += n;
     }
+    return true;
+}
+
+void DataDeviceManager::finishWriteToClient(RetainedWrite *write)
+{
+    m_retainedWrites.removeOne(write);
+    // this may be called from the notifier's or the timer's own signal
+    if (write->notifier) {
+        write->notifier->setEnabled(false);
+        write->notifier->deleteLater();
+    }
+    if (write->timeout) {
+        write->timeout->stop();
+        write->timeout->deleteLater();
+    }
+    close(write->fd);
+    if (write->file != -1)
+        close(write->file);
+    delete write;
 }
 
 DataSource *DataDeviceManager::currentSelectionSource()
@@ -220,13 +588,20 @@ void DataDeviceManager::comp_receive(wl_client *client, wl_resource *resource, c
     Q_UNUSED(client);
     DataDeviceManager *self = static_cast<DataDeviceManager *>(wl_resource_get_user_data(resource));
     //qDebug("client %p wants data for type %s from compositor", client, mime_type);
-    QByteArray content = QWaylandMimeHelper::getByteArray(&self->m_retainedData, QString::fromLatin1(mime_type));
-    if (!content.isEmpty()) {
-        QFile f;
-        if (f.open(fd, QIODevice::WriteOnly))
-            f.write(content);
+    const QString mimeType = QString::fromLatin1(mime_type);
+#ifdef Q_OS_LINUX
+    const int file = self->m_retainedData.fileDescriptor(mimeType);
+    if (file != -1) {
+        self->writeToClient(fd, QByteArray(), file, self->m_retainedData.fileSize(mimeType));
+        return;
+    }
+#endif
+    QByteArray content = QWaylandMimeHelper::getByteArray(&self->m_retainedData, mimeType);
+    if (content.isEmpty()) {
+        close(fd);
+        return;
     }
-    close(fd);
+    self->writeToClient(fd, content);
 }
 
 void DataDeviceManager::comp_destroy(wl_client *, wl_resource *)
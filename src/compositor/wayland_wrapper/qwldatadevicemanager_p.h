@@ -15,6 +15,7 @@
 // We mean it.
 //
 
+#include <QtCore/QHash>
 #include <QtCore/QList>
 #include <QtCore/QMap>
 #include <QtGui/QClipboard>
@@ -30,18 +31,48 @@ QT_REQUIRE_CONFIG(wayland_datadevice);
 QT_BEGIN_NAMESPACE
 
 class QSocketNotifier;
+class QTimer;
 
 namespace QtWayland {
 
 class DataDevice;
 class DataSource;
 
+// Retained selection data. Large payloads are kept in sealed memfds instead
+// of memory, and are only read back when the compositor asks for them.
+class RetainedMimeData : public QMimeData
+{
+public:
+    ~RetainedMimeData() override;
+
+    void clear();
+
+    void setFile(const QString &mimeType, int fd, qint64 size);
+    int fileDescriptor(const QString &mimeType) const;
+    qint64 fileSize(const QString &mimeType) const;
+
+    QStringList formats() const override;
+    bool hasFormat(const QString &mimeType) const override;
+
+protected:
+    QVariant retrieveData(const QString &mimeType, QMetaType type) const override;
+
+private:
+    struct File {
+        int fd = -1;
+        qint64 size = 0;
+    };
+    QStringList m_fileFormats;
+    QHash<QString, File> m_files;
+};
+
 class DataDeviceManager : public QObject, public QtWaylandServer::wl_data_device_manager
 {
     Q_OBJECT
 
 public:
     DataDeviceManager(QWaylandCompositor *compositor);
+    ~DataDeviceManager() override;
 
     void setCurrentSelectionSource(DataSource *source);
     DataSource *currentSelectionSource();
@@ -54,6 +85,11 @@ public:
     bool offerFromCompositorToClient(wl_resource *clientDataDeviceResource);
     void offerRetainedSelection(wl_resource *clientDataDeviceResource);
 
+    int retainedSelectionWriteTimeout() const { return m_retainedWriteTimeout; }
+    void setRetainedSelectionWriteTimeout(int msecs) { m_retainedWriteTimeout = msecs; }
+
+    static QStringList retainOrder(const QStringList &mimeTypes);
+
 protected:
     void data_device_manager_create_data_source(Resource *resource, uint32_t id) override;
     void data_device_manager_get_data_device(Resource *resource, uint32_t id, struct ::wl_resource *seat) override;
@@ -62,19 +98,43 @@ private Q_SLOTS:
     void readFromClient(int fd);
 
 private:
+    struct RetainedWrite {
+        int fd = -1;
+        QByteArray data;
+        // a duplicate of a retained memfd, written with sendfile()
+        int file = -1;
+        qint64 fileSize = 0;
+        qint64 offset = 0;
+        QSocketNotifier *notifier = nullptr;
+        QTimer *timeout = nullptr;
+    };
+
     void retain();
     void finishReadFromClient(bool exhausted = false);
+    bool spillRetainedRead();
+    void finishRetainedType();
+    void discardRetainedRead();
+    void writeToClient(int fd, const QByteArray &data, int file = -1, qint64 fileSize = 0);
+    bool writeRetainedData(RetainedWrite *write);
+    void finishWriteToClient(RetainedWrite *write);
 
     QWaylandCompositor *m_compositor = nullptr;
     QList<DataDevice *> m_data_device_list;
 
     DataSource *m_current_selection_source = nullptr;
 
-    QMimeData m_retainedData;
+    RetainedMimeData m_retainedData;
+    QStringList m_retainedTypes;
     QSocketNotifier *m_retainedReadNotifier = nullptr;
     QList<QSocketNotifier *> m_obsoleteRetainedReadNotifiers;
     int m_retainedReadIndex = 0;
     QByteArray m_retainedReadBuf;
+    // the memfd the current type is spilled into, if it got large
+    int m_retainedReadFile = -1;
+    qint64 m_retainedReadSize = 0;
+    qint64 m_retainedSize = 0;
+    QList<RetainedWrite *> m_retainedWrites;
+    int m_retainedWriteTimeout = 5000;
 
     bool m_compositorOwnsSelection = false;
 
@@ -0,0 +1,64 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#include "qwlfence_p.h"
+
+#include <QtCore/private/qcore_unix_p.h>
+
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <unistd.h>
+
+QT_BEGIN_NAMESPACE
+
+namespace QtWayland {
+
+Fence::Fence(int fd)
+    : m_fd(fd)
+{
+}
+
+Fence::~Fence()
+{
+    if (m_fd != -1)
+        qt_safe_close(m_fd);
+}
+
+bool Fence::isSignaled() const
+{
+    return wait(0);
+}
+
+bool Fence::wait(int timeoutMs) const
+{
+    if (m_fd == -1)
+        return true;
+
+    struct pollfd pfd = { m_fd, POLLIN, 0 };
+    int ret;
+    do {
+        ret = ::poll(&pfd, 1, timeoutMs);
+    } while (ret == -1 && (errno == EINTR || errno == EAGAIN));
+    return ret > 0 && (pfd.revents & POLLIN);
+}
+
+SoftwareFence::SoftwareFence()
+    : Fence(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))
+{
+    if (!isValid())
+        qErrnoWarning("Could not create an eventfd for a software fence");
+}
+
+void SoftwareFence::signal()
+{
+    if (!isValid())
+        return;
+
+    // the counter is never read back, so the fd stays readable from now on
+    const quint64 value = 1;
+    qt_safe_write(fd(), &value, sizeof(value));
+}
+
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,66 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#ifndef QWLFENCE_P_H
+#define QWLFENCE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtWaylandCompositor/qtwaylandcompositorglobal.h>
+#include <QtCore/private/qglobal_p.h>
+
+QT_BEGIN_NAMESPACE
+
+namespace QtWayland {
+
+// A fence backed by a file descriptor that becomes readable once the fence
+// has signalled, such as a sync_file exported from a dma-fence. The fence
+// owns the file descriptor.
+class Q_WAYLANDCOMPOSITOR_EXPORT Fence
+{
+public:
+    virtual ~Fence();
+
+    int fd() const { return m_fd; }
+    bool isValid() const { return m_fd != -1; }
+
+    bool isSignaled() const;
+    bool wait(int timeoutMs = -1) const;
+
+    // Signals the fence from the CPU, as the compositor does with release
+    // fences once it is done with a buffer.
+    virtual void signal() = 0;
+
+protected:
+    explicit Fence(int fd);
+
+private:
+    Q_DISABLE_COPY(Fence)
+    int m_fd = -1;
+};
+
+// A fence signalled from the CPU, built on an eventfd. It stands in for
+// GPU fences where there are none, and lets the fence handling be tested
+// without a GPU.
+class Q_WAYLANDCOMPOSITOR_EXPORT SoftwareFence : public Fence
+{
+public:
+    SoftwareFence();
+
+    void signal() override;
+};
+
+}
+
+QT_END_NAMESPACE
+
+#endif // QWLFENCE_P_H
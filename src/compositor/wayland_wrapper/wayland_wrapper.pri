@@ -5,11 +5,13 @@ WAYLANDSERVERSOURCES += \
 HEADERS += \
     wayland_wrapper/qwlbuffermanager_p.h \
     wayland_wrapper/qwlclientbuffer_p.h \
+    wayland_wrapper/qwlfence_p.h \
     wayland_wrapper/qwlregion_p.h
 
 SOURCES += \
     wayland_wrapper/qwlbuffermanager.cpp \
     wayland_wrapper/qwlclientbuffer.cpp \
+    wayland_wrapper/qwlfence.cpp \
     wayland_wrapper/qwlregion.cpp
 
 qtConfig(wayland-datadevice) {
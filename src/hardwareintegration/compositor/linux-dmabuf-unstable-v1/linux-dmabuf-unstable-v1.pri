@@ -7,8 +7,10 @@ WAYLANDSERVERSOURCES += $$PWD/../../../3rdparty/protocol/linux-dmabuf-unstable-v
 
 SOURCES += \
     $$PWD/linuxdmabufclientbufferintegration.cpp \
-    $$PWD/linuxdmabuf.cpp
+    $$PWD/linuxdmabuf.cpp \
+    $$PWD/linuxdmabufimagecache.cpp
 
 HEADERS += \
     $$PWD/linuxdmabufclientbufferintegration.h \
-    $$PWD/linuxdmabuf.h
+    $$PWD/linuxdmabuf.h \
+    $$PWD/linuxdmabufimagecache.h
@@ -8,24 +8,159 @@
 
 #include <drm_fourcc.h>
 #include <drm_mode.h>
+#include <fcntl.h>
+#include <limits>
+#include <sys/mman.h>
+#include <sys/syscall.h>
 #include <unistd.h>
 
+// from linux/memfd.h:
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC             0x0001U
+#endif
+#ifndef MFD_ALLOW_SEALING
+#define MFD_ALLOW_SEALING       0x0002U
+#endif
+// from linux/fcntl.h:
+#ifndef F_ADD_SEALS
+#define F_ADD_SEALS             (1024 + 9)
+#endif
+#ifndef F_SEAL_SEAL
+#define F_SEAL_SEAL             0x0001
+#define F_SEAL_SHRINK           0x0002
+#define F_SEAL_GROW             0x0004
+#define F_SEAL_WRITE            0x0008
+#endif
+
 QT_BEGIN_NAMESPACE
 
-LinuxDmabuf::LinuxDmabuf(wl_display *display, LinuxDmabufClientBufferIntegration *clientBufferIntegration)
-    : zwp_linux_dmabuf_v1(display, 3 /*version*/)
-    , m_clientBufferIntegration(clientBufferIntegration)
+// one entry of the zwp_linux_dmabuf_feedback_v1 format table
+struct FormatTableEntry {
+    uint32_t format;
+    uint32_t padding;
+    uint64_t modifier;
+};
+static_assert(sizeof(FormatTableEntry) == 16, "The format table layout is defined by the protocol");
+
+LinuxDmabuf::LinuxDmabuf(LinuxDmabufClientBufferIntegration *clientBufferIntegration)
+    : m_clientBufferIntegration(clientBufferIntegration)
+{
+}
+
+LinuxDmabuf::~LinuxDmabuf()
 {
+    resetFormatTable();
 }
 
-void LinuxDmabuf::setSupportedModifiers(const QHash<uint32_t, QList<uint64_t>> &modifiers)
+void LinuxDmabuf::setMainDevice(dev_t device)
+{
+    m_mainDevice = QByteArray(reinterpret_cast<const char *>(&device), sizeof(device));
+}
+
+void LinuxDmabuf::setSupportedModifiers(const QHash<uint32_t, QList<uint64_t>> &modifiers,
+                                        const QHash<uint32_t, QList<uint64_t>> &externalOnlyModifiers)
 {
     Q_ASSERT(resourceMap().isEmpty());
     m_modifiers = modifiers;
+    buildFormatTable(externalOnlyModifiers);
+}
+
+// Creates the global. Version 4 clients only learn about the formats through
+// the format table, so it is only advertised when there is one.
+void LinuxDmabuf::initialize(wl_display *display)
+{
+    const bool hasFeedback = !m_mainDevice.isEmpty() && m_formatTableFd != -1;
+    if (!m_mainDevice.isEmpty() && !hasFeedback)
+        qCDebug(qLcWaylandCompositorHardwareIntegration) << "There is no dmabuf format table, dmabuf feedback is disabled.";
+    init(display, hasFeedback ? 4 : 3);
+}
+
+void LinuxDmabuf::resetFormatTable()
+{
+    if (m_formatTableFd != -1)
+        close(m_formatTableFd);
+    m_formatTableFd = -1;
+    m_formatTableSize = 0;
+    m_preferredTranche.clear();
+    m_fallbackTranche.clear();
+}
+
+// Writes all format/modifier pairs once into a sealed memfd. Every feedback
+// object then only costs a file descriptor and two index arrays, no matter
+// how many pairs the driver supports. Pairs the driver can only import as
+// external textures end up in a second, less preferred tranche.
+void LinuxDmabuf::buildFormatTable(const QHash<uint32_t, QList<uint64_t>> &externalOnlyModifiers)
+{
+    resetFormatTable();
+
+    QList<FormatTableEntry> entries;
+    const qsizetype maxEntries = qsizetype(std::numeric_limits<uint16_t>::max()) + 1;
+    for (auto it = m_modifiers.constBegin(); it != m_modifiers.constEnd() && entries.size() < maxEntries; ++it) {
+        const auto format = it.key();
+        auto modifiers = it.value();
+        if (modifiers.isEmpty())
+            modifiers << DRM_FORMAT_MOD_INVALID;
+        const QList<uint64_t> externalOnly = externalOnlyModifiers.value(format);
+        for (const auto &modifier : std::as_const(modifiers)) {
+            if (entries.size() == maxEntries) {
+                qCWarning(qLcWaylandCompositorHardwareIntegration) << "Too many dmabuf format/modifier pairs for the format table, ignoring the rest";
+                break;
+            }
+            const uint16_t index = uint16_t(entries.size());
+            entries.append({ format, 0, modifier });
+            QByteArray &tranche = externalOnly.contains(modifier) ? m_fallbackTranche : m_preferredTranche;
+            tranche.append(reinterpret_cast<const char *>(&index), sizeof(index));
+        }
+    }
+
+    if (entries.isEmpty())
+        return;
+
+    int fd = -1;
+#ifdef SYS_memfd_create
+    fd = syscall(SYS_memfd_create, "linux-dmabuf-format-table", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+#endif
+    if (fd == -1) {
+        qCWarning(qLcWaylandCompositorHardwareIntegration) << "Could not create the dmabuf format table, feedback is disabled";
+        m_preferredTranche.clear();
+        m_fallbackTranche.clear();
+        return;
+    }
+
+    const size_t size = entries.size() * sizeof(FormatTableEntry);
+    if (ftruncate(fd, size) != 0) {
+        qCWarning(qLcWaylandCompositorHardwareIntegration) << "Could not resize the dmabuf format table, feedback is disabled";
+        close(fd);
+        m_preferredTranche.clear();
+        m_fallbackTranche.clear();
+        return;
+    }
+
+    void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+        qCWarning(qLcWaylandCompositorHardwareIntegration) << "Could not map the dmabuf format table, feedback is disabled";
+        close(fd);
+        m_preferredTranche.clear();
+        m_fallbackTranche.clear();
+        return;
+    }
+    memcpy(data, entries.constData(), size);
+    munmap(data, size);
+
+    // clients map the table read-only, make sure nobody can change it afterwards
+    if (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) != 0)
+        qCDebug(qLcWaylandCompositorHardwareIntegration) << "Could not seal the dmabuf format table";
+
+    m_formatTableFd = fd;
+    m_formatTableSize = uint32_t(size);
 }
 
 void LinuxDmabuf::zwp_linux_dmabuf_v1_bind_resource(Resource *resource)
 {
+    // version 4 clients get the formats through the feedback objects instead
+    if (resource->version() >= ZWP_LINUX_DMABUF_V1_GET_DEFAULT_FEEDBACK_SINCE_VERSION)
+        return;
+
     for (auto it = m_modifiers.constBegin(); it != m_modifiers.constEnd(); ++it) {
         auto format = it.key();
         auto modifiers = it.value();
@@ -51,6 +186,61 @@ void LinuxDmabuf::zwp_linux_dmabuf_v1_create_params(Resource *resource, uint32_t
     new LinuxDmabufParams(m_clientBufferIntegration, r); // deleted by the client, or when it disconnects
 }
 
+void LinuxDmabuf::zwp_linux_dmabuf_v1_get_default_feedback(Resource *resource, uint32_t id)
+{
+    createFeedback(resource, id);
+}
+
+void LinuxDmabuf::zwp_linux_dmabuf_v1_get_surface_feedback(Resource *resource, uint32_t id, struct ::wl_resource *surface)
+{
+    // All buffers end up on the same EGL display, there is nothing a surface
+    // could do better than what the default feedback already tells.
+    Q_UNUSED(surface);
+    createFeedback(resource, id);
+}
+
+void LinuxDmabuf::createFeedback(Resource *resource, uint32_t id)
+{
+    wl_resource *r = wl_resource_create(resource->client(), &zwp_linux_dmabuf_feedback_v1_interface,
+                                        wl_resource_get_version(resource->handle), id);
+    auto *feedback = new LinuxDmabufFeedback(r); // deleted by the client, or when it disconnects
+    sendFeedback(feedback);
+}
+
+void LinuxDmabuf::sendFeedback(LinuxDmabufFeedback *feedback)
+{
+    feedback->send_main_device(m_mainDevice);
+    if (m_formatTableFd != -1) {
+        feedback->send_format_table(m_formatTableFd, m_formatTableSize);
+
+        for (const QByteArray &tranche : { m_preferredTranche, m_fallbackTranche }) {
+            if (tranche.isEmpty())
+                continue;
+            feedback->send_tranche_target_device(m_mainDevice);
+            feedback->send_tranche_flags(0);
+            feedback->send_tranche_formats(tranche);
+            feedback->send_tranche_done();
+        }
+    }
+    feedback->send_done();
+}
+
+LinuxDmabufFeedback::LinuxDmabufFeedback(wl_resource *resource)
+    : zwp_linux_dmabuf_feedback_v1(resource)
+{
+}
+
+void LinuxDmabufFeedback::zwp_linux_dmabuf_feedback_v1_destroy(Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
+void LinuxDmabufFeedback::zwp_linux_dmabuf_feedback_v1_destroy_resource(Resource *resource)
+{
+    Q_UNUSED(resource);
+    delete this;
+}
+
 LinuxDmabufParams::LinuxDmabufParams(LinuxDmabufClientBufferIntegration *clientBufferIntegration, wl_resource *resource)
     : zwp_linux_buffer_params_v1(resource)
     , m_clientBufferIntegration(clientBufferIntegration)
@@ -251,13 +441,21 @@ LinuxDmabufWlBuffer::LinuxDmabufWlBuffer(::wl_client *client, LinuxDmabufClientB
 LinuxDmabufWlBuffer::~LinuxDmabufWlBuffer()
 {
     m_clientBufferIntegration->removeBuffer(resource()->handle);
-    buffer_destroy(resource());
+    freeResources();
 }
 
 void LinuxDmabufWlBuffer::buffer_destroy(Resource *resource)
 {
     Q_UNUSED(resource);
-    for (uint32_t i = 0; i < m_planesNumber; ++i) {
+    // The client is still around and might wrap the same dmabufs into a new
+    // wl_buffer soon (e.g. when recreating its swapchain), keep the images.
+    m_clientBufferIntegration->cacheImages(this);
+    freeResources();
+}
+
+void LinuxDmabufWlBuffer::freeResources()
+{
+    for (uint32_t i = 0; i < MaxDmabufPlanes; ++i) {
         if (m_textures[i] != nullptr) {
             m_clientBufferIntegration->deleteGLTextureWhenPossible(m_textures[i]);
             m_textures[i] = nullptr;
@@ -266,6 +464,8 @@ void LinuxDmabufWlBuffer::buffer_destroy(Resource *resource)
             m_clientBufferIntegration->deleteImage(m_eglImages[i]);
             m_eglImages[i] = EGL_NO_IMAGE_KHR;
         }
+    }
+    for (uint32_t i = 0; i < m_planesNumber; ++i) {
         if (m_planes[i].fd != -1)
             close(m_planes[i].fd);
         m_planes[i].fd = -1;
@@ -287,6 +487,20 @@ void LinuxDmabufWlBuffer::initTexture(uint32_t plane, QOpenGLTexture *texture)
     m_textures[plane] = texture;
 }
 
+EGLImageKHR LinuxDmabufWlBuffer::takeImage(uint32_t plane)
+{
+    EGLImageKHR image = m_eglImages.at(plane);
+    m_eglImages[plane] = EGL_NO_IMAGE_KHR;
+    return image;
+}
+
+QOpenGLTexture *LinuxDmabufWlBuffer::takeTexture(uint32_t plane)
+{
+    QOpenGLTexture *texture = m_textures.at(plane);
+    m_textures[plane] = nullptr;
+    return texture;
+}
+
 void LinuxDmabufWlBuffer::buffer_destroy_resource(Resource *resource)
 {
     Q_UNUSED(resource);
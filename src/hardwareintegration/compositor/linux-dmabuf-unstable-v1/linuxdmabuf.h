@@ -17,6 +17,8 @@
 
 #include <array>
 
+#include <sys/types.h>
+
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
 
@@ -45,6 +47,7 @@ QT_BEGIN_NAMESPACE
 class QWaylandCompositor;
 class QWaylandResource;
 class LinuxDmabufParams;
+class LinuxDmabufFeedback;
 class LinuxDmabufClientBufferIntegration;
 
 struct Plane {
@@ -57,17 +60,46 @@ struct Plane {
 class LinuxDmabuf : public QtWaylandServer::zwp_linux_dmabuf_v1
 {
 public:
-    explicit LinuxDmabuf(wl_display *display, LinuxDmabufClientBufferIntegration *clientBufferIntegration);
+    explicit LinuxDmabuf(LinuxDmabufClientBufferIntegration *clientBufferIntegration);
+    ~LinuxDmabuf() override;
 
-    void setSupportedModifiers(const QHash<uint32_t, QList<uint64_t>> &modifiers);
+    void setMainDevice(dev_t device);
+    void setSupportedModifiers(const QHash<uint32_t, QList<uint64_t>> &modifiers,
+                               const QHash<uint32_t, QList<uint64_t>> &externalOnlyModifiers = {});
+    void initialize(wl_display *display);
 
 protected:
     void zwp_linux_dmabuf_v1_bind_resource(Resource *resource) override;
     void zwp_linux_dmabuf_v1_create_params(Resource *resource, uint32_t params_id) override;
+    void zwp_linux_dmabuf_v1_get_default_feedback(Resource *resource, uint32_t id) override;
+    void zwp_linux_dmabuf_v1_get_surface_feedback(Resource *resource, uint32_t id, struct ::wl_resource *surface) override;
 
 private:
+    void createFeedback(Resource *resource, uint32_t id);
+    void sendFeedback(LinuxDmabufFeedback *feedback);
+    void buildFormatTable(const QHash<uint32_t, QList<uint64_t>> &externalOnlyModifiers);
+    void resetFormatTable();
+
     QHash<uint32_t, QList<uint64_t>> m_modifiers; // key=DRM format, value=supported DRM modifiers for format
     LinuxDmabufClientBufferIntegration *m_clientBufferIntegration;
+
+    // version 4: all format/modifier pairs live in one sealed, shared table,
+    // tranches refer to it through 16-bit indices
+    QByteArray m_mainDevice;
+    int m_formatTableFd = -1;
+    uint32_t m_formatTableSize = 0;
+    QByteArray m_preferredTranche;
+    QByteArray m_fallbackTranche;
+};
+
+class LinuxDmabufFeedback : public QtWaylandServer::zwp_linux_dmabuf_feedback_v1
+{
+public:
+    explicit LinuxDmabufFeedback(wl_resource *resource);
+
+protected:
+    void zwp_linux_dmabuf_feedback_v1_destroy(Resource *resource) override;
+    void zwp_linux_dmabuf_feedback_v1_destroy_resource(Resource *resource) override;
 };
 
 class LinuxDmabufParams : public QtWaylandServer::zwp_linux_buffer_params_v1
@@ -110,6 +142,8 @@ public:
     inline uint32_t planesNumber() const { return m_planesNumber; }
     inline EGLImageKHR image(uint32_t plane) { return m_eglImages.at(plane); }
     inline QOpenGLTexture *texture(uint32_t plane) const { return m_textures.at(plane); }
+    EGLImageKHR takeImage(uint32_t plane);
+    QOpenGLTexture *takeTexture(uint32_t plane);
     void buffer_destroy_resource(Resource *resource) override;
 
     static const uint32_t MaxDmabufPlanes = 4;
@@ -15,8 +15,13 @@
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
 #include <unistd.h>
+#include <sys/stat.h>
 #include <drm_fourcc.h>
 
+#ifndef EGL_DRM_RENDER_NODE_FILE_EXT
+#define EGL_DRM_RENDER_NODE_FILE_EXT 0x3377
+#endif
+
 QT_BEGIN_NAMESPACE
 
 static QWaylandBufferRef::BufferFormatEgl formatFromDrmFormat(EGLint format) {
@@ -236,11 +241,16 @@ LinuxDmabufClientBufferIntegration::LinuxDmabufClientBufferIntegration()
     formatConversion.plane[1] = secondPlane;
 
     m_yuvFormats.insert(DRM_FORMAT_YUYV, formatConversion);
+
+    m_imageCache.reset(new LinuxDmabufImageCache(this));
+    if (qEnvironmentVariableIsSet("QT_WAYLAND_DMABUF_IMAGE_CACHE_SIZE"))
+        m_imageCache->setMaxSize(qEnvironmentVariableIntValue("QT_WAYLAND_DMABUF_IMAGE_CACHE_SIZE"));
 }
 
 LinuxDmabufClientBufferIntegration::~LinuxDmabufClientBufferIntegration()
 {
     m_importedBuffers.clear();
+    m_imageCache.reset();
 
     if (egl_unbind_wayland_display != nullptr && m_displayBound) {
         Q_ASSERT(m_wlDisplay != nullptr);
@@ -251,8 +261,6 @@ LinuxDmabufClientBufferIntegration::~LinuxDmabufClientBufferIntegration()
 
 void LinuxDmabufClientBufferIntegration::initializeHardware(struct ::wl_display *display)
 {
-    m_linuxDmabuf.reset(new LinuxDmabuf(display, this));
-
     const bool ignoreBindDisplay = !qgetenv("QT_WAYLAND_IGNORE_BIND_DISPLAY").isEmpty() && qgetenv("QT_WAYLAND_IGNORE_BIND_DISPLAY").toInt() != 0;
 
     // initialize hardware extensions
@@ -307,10 +315,56 @@ void LinuxDmabufClientBufferIntegration::initializeHardware(struct ::wl_display
 
     // request and sent formats/modifiers only after egl_display is bound
     QHash<uint32_t, QList<uint64_t>> modifiers;
+    QHash<uint32_t, QList<uint64_t>> externalOnlyModifiers;
     for (const auto &format : supportedDrmFormats()) {
-        modifiers[format] = supportedDrmModifiers(format);
+        modifiers[format] = supportedDrmModifiers(format, &externalOnlyModifiers[format]);
     }
-    m_linuxDmabuf->setSupportedModifiers(modifiers);
+
+    // version 4 feedback needs to name the device the buffers are imported on
+    dev_t mainDevice = 0;
+    const bool hasMainDevice = queryMainDevice(&mainDevice);
+    m_linuxDmabuf.reset(new LinuxDmabuf(this));
+    if (hasMainDevice)
+        m_linuxDmabuf->setMainDevice(mainDevice);
+    else
+        qCDebug(qLcWaylandCompositorHardwareIntegration) << "Could not find the DRM device of the EGL display, dmabuf feedback is disabled.";
+    // the format table decides which version is advertised, build it first
+    m_linuxDmabuf->setSupportedModifiers(modifiers, externalOnlyModifiers);
+    m_linuxDmabuf->initialize(display);
+}
+
+bool LinuxDmabufClientBufferIntegration::queryMainDevice(dev_t *device)
+{
+    const char *clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (!clientExtensions || !strstr(clientExtensions, "EGL_EXT_device_query"))
+        return false;
+
+    auto queryDisplayAttrib = reinterpret_cast<PFNEGLQUERYDISPLAYATTRIBEXTPROC>(eglGetProcAddress("eglQueryDisplayAttribEXT"));
+    auto queryDeviceString = reinterpret_cast<PFNEGLQUERYDEVICESTRINGEXTPROC>(eglGetProcAddress("eglQueryDeviceStringEXT"));
+    if (!queryDisplayAttrib || !queryDeviceString)
+        return false;
+
+    EGLAttrib attrib = 0;
+    if (!queryDisplayAttrib(m_eglDisplay, EGL_DEVICE_EXT, &attrib))
+        return false;
+    auto eglDevice = reinterpret_cast<EGLDeviceEXT>(attrib);
+
+    const char *deviceExtensions = queryDeviceString(eglDevice, EGL_EXTENSIONS);
+    const char *deviceFile = nullptr;
+    // prefer the render node, clients don't need a primary node to allocate buffers
+    if (deviceExtensions && strstr(deviceExtensions, "EGL_EXT_device_drm_render_node"))
+        deviceFile = queryDeviceString(eglDevice, EGL_DRM_RENDER_NODE_FILE_EXT);
+    if (!deviceFile && deviceExtensions && strstr(deviceExtensions, "EGL_EXT_device_drm"))
+        deviceFile = queryDeviceString(eglDevice, EGL_DRM_DEVICE_FILE_EXT);
+    if (!deviceFile)
+        return false;
+
+    struct stat deviceStat;
+    if (stat(deviceFile, &deviceStat) != 0)
+        return false;
+
+    *device = deviceStat.st_rdev;
+    return true;
 }
 
 QList<uint32_t> LinuxDmabufClientBufferIntegration::supportedDrmFormats()
@@ -331,7 +385,7 @@ QList<uint32_t> LinuxDmabufClientBufferIntegration::supportedDrmFormats()
     return QList<uint32_t>();
 }
 
-QList<uint64_t> LinuxDmabufClientBufferIntegration::supportedDrmModifiers(uint32_t format)
+QList<uint64_t> LinuxDmabufClientBufferIntegration::supportedDrmModifiers(uint32_t format, QList<uint64_t> *externalOnly)
 {
     if (!egl_query_dmabuf_modifiers_ext)
         return QList<uint64_t>();
@@ -342,7 +396,14 @@ QList<uint64_t> LinuxDmabufClientBufferIntegration::supportedDrmModifiers(uint32
 
     if (success && count > 0) {
         QList<uint64_t> modifiers(count);
-        if (egl_query_dmabuf_modifiers_ext(m_eglDisplay, format, count, modifiers.data(), nullptr, &count)) {
+        QVarLengthArray<EGLBoolean> externalOnlyFlags(count);
+        if (egl_query_dmabuf_modifiers_ext(m_eglDisplay, format, count, modifiers.data(), externalOnlyFlags.data(), &count)) {
+            if (externalOnly) {
+                for (EGLint i = 0; i < count; ++i) {
+                    if (externalOnlyFlags[i])
+                        externalOnly->append(modifiers[i]);
+                }
+            }
             return modifiers;
         }
     }
@@ -380,6 +441,19 @@ bool LinuxDmabufClientBufferIntegration::importBuffer(wl_resource *resource, Lin
         return false;
     }
     m_importedBuffers[resource] = linuxDmabufBuffer;
+
+    LinuxDmabufImageKey key;
+    LinuxDmabufImageCacheEntry entry;
+    if (LinuxDmabufImageKey::fromBuffer(linuxDmabufBuffer, &key) && m_imageCache->take(key, &entry)) {
+        for (uint32_t i = 0; i < LinuxDmabufWlBuffer::MaxDmabufPlanes; ++i) {
+            if (entry.images[i] != EGL_NO_IMAGE_KHR)
+                linuxDmabufBuffer->initImage(i, entry.images[i]);
+            if (entry.textures[i] != nullptr)
+                linuxDmabufBuffer->initTexture(i, entry.textures[i]);
+        }
+        return true;
+    }
+
     if (m_yuvFormats.contains(linuxDmabufBuffer->drmFormat()))
         return initYuvTexture(linuxDmabufBuffer);
     else
@@ -391,6 +465,24 @@ void LinuxDmabufClientBufferIntegration::removeBuffer(wl_resource *resource)
     m_importedBuffers.remove(resource);
 }
 
+void LinuxDmabufClientBufferIntegration::cacheImages(LinuxDmabufWlBuffer *linuxDmabufBuffer)
+{
+    // only successfully imported buffers are worth keeping
+    if (linuxDmabufBuffer->planesNumber() == 0 || linuxDmabufBuffer->image(0) == EGL_NO_IMAGE_KHR)
+        return;
+
+    LinuxDmabufImageKey key;
+    if (!LinuxDmabufImageKey::fromBuffer(linuxDmabufBuffer, &key))
+        return;
+
+    LinuxDmabufImageCacheEntry entry;
+    for (uint32_t i = 0; i < LinuxDmabufWlBuffer::MaxDmabufPlanes; ++i) {
+        entry.images[i] = linuxDmabufBuffer->takeImage(i);
+        entry.textures[i] = linuxDmabufBuffer->takeTexture(i);
+    }
+    m_imageCache->insert(key, entry);
+}
+
 LinuxDmabufClientBuffer::LinuxDmabufClientBuffer(LinuxDmabufClientBufferIntegration *integration,
                                                  wl_resource *bufferResource,
                                                  LinuxDmabufWlBuffer *dmabufBuffer)
@@ -5,6 +5,7 @@
 #define LINUXDMABUFCLIENTBUFFERINTEGRATION_H
 
 #include "linuxdmabuf.h"
+#include "linuxdmabufimagecache.h"
 
 #include <QtWaylandCompositor/private/qwlclientbufferintegration_p.h>
 #include <QtWaylandCompositor/private/qwlclientbuffer_p.h>
@@ -45,6 +46,7 @@ public:
     QtWayland::ClientBuffer *createBufferFor(wl_resource *resource) override;
     bool importBuffer(wl_resource *resource, LinuxDmabufWlBuffer *linuxDmabufBuffer);
     void removeBuffer(wl_resource *resource);
+    void cacheImages(LinuxDmabufWlBuffer *linuxDmabufBuffer);
     void deleteOrphanedTextures();
     void deleteImage(EGLImageKHR image);
     void deleteGLTextureWhenPossible(QOpenGLTexture *texture) { m_orphanedTextures << texture; }
@@ -63,7 +65,8 @@ private:
     bool initSimpleTexture(LinuxDmabufWlBuffer *dmabufBuffer);
     bool initYuvTexture(LinuxDmabufWlBuffer *dmabufBuffer);
     QList<uint32_t> supportedDrmFormats();
-    QList<uint64_t> supportedDrmModifiers(uint32_t format);
+    QList<uint64_t> supportedDrmModifiers(uint32_t format, QList<uint64_t> *externalOnly = nullptr);
+    bool queryMainDevice(dev_t *device);
 
     EGLDisplay m_eglDisplay = EGL_NO_DISPLAY;
     ::wl_display *m_wlDisplay = nullptr;
@@ -73,6 +76,7 @@ private:
     bool m_supportsDmabufModifiers = false;
     QHash<struct ::wl_resource *, LinuxDmabufWlBuffer *> m_importedBuffers;
     QScopedPointer<LinuxDmabuf> m_linuxDmabuf;
+    QScopedPointer<LinuxDmabufImageCache> m_imageCache;
 };
 
 class LinuxDmabufClientBuffer : public QtWayland::ClientBuffer
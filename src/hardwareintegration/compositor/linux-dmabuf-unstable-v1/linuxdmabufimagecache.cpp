@@ -0,0 +1,162 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#include "linuxdmabufimagecache.h"
+#include "linuxdmabufclientbufferintegration.h"
+
+#include <QtWaylandCompositor/QWaylandCompositor>
+
+#include <wayland-server-core.h>
+
+#include <sys/stat.h>
+
+QT_BEGIN_NAMESPACE
+
+bool LinuxDmabufImageKey::fromBuffer(LinuxDmabufWlBuffer *buffer, LinuxDmabufImageKey *key)
+{
+    key->client = buffer->resource()->client();
+    key->drmFormat = buffer->drmFormat();
+    key->size = buffer->size();
+    key->planesNumber = buffer->planesNumber();
+    for (uint32_t i = 0; i < key->planesNumber; ++i) {
+        const Plane &plane = buffer->plane(i);
+        struct stat planeStat;
+        if (plane.fd == -1 || fstat(plane.fd, &planeStat) != 0)
+            return false;
+        key->planes[i].device = planeStat.st_dev;
+        key->planes[i].inode = planeStat.st_ino;
+        key->planes[i].offset = plane.offset;
+        key->planes[i].stride = plane.stride;
+        key->planes[i].modifier = plane.modifiers;
+    }
+    return true;
+}
+
+bool LinuxDmabufImageKey::operator==(const LinuxDmabufImageKey &other) const
+{
+    if (client != other.client || drmFormat != other.drmFormat || size != other.size
+            || planesNumber != other.planesNumber)
+        return false;
+    for (uint32_t i = 0; i < planesNumber; ++i) {
+        if (!(planes[i] == other.planes[i]))
+            return false;
+    }
+    return true;
+}
+
+struct LinuxDmabufImageCache::ClientListener
+{
+    struct wl_listener listener;
+    LinuxDmabufImageCache *cache = nullptr;
+};
+
+LinuxDmabufImageCache::LinuxDmabufImageCache(LinuxDmabufClientBufferIntegration *integration)
+    : m_integration(integration)
+{
+}
+
+LinuxDmabufImageCache::~LinuxDmabufImageCache()
+{
+    clear();
+    qCDebug(qLcWaylandCompositorHardwareIntegration) << "dmabuf image cache:" << m_statistics.hits << "hits,"
+                                                     << m_statistics.misses << "misses,"
+                                                     << m_statistics.evictions << "evictions";
+}
+
+void LinuxDmabufImageCache::setMaxSize(int maxSize)
+{
+    m_maxSize = qMax(0, maxSize);
+    while (m_entries.size() > m_maxSize)
+        evict(0);
+}
+
+bool LinuxDmabufImageCache::take(const LinuxDmabufImageKey &key, LinuxDmabufImageCacheEntry *entry)
+{
+    for (qsizetype i = m_entries.size() - 1; i >= 0; --i) {
+        if (m_entries.at(i).first == key) {
+            *entry = m_entries.takeAt(i).second;
+            ++m_statistics.hits;
+            return true;
+        }
+    }
+    ++m_statistics.misses;
+    return false;
+}
+
+void LinuxDmabufImageCache::insert(const LinuxDmabufImageKey &key, const LinuxDmabufImageCacheEntry &entry)
+{
+    if (m_maxSize == 0) {
+        release(entry);
+        return;
+    }
+
+    watchClient(key.client);
+    m_entries.append(qMakePair(key, entry));
+    while (m_entries.size() > m_maxSize)
+        evict(0);
+}
+
+void LinuxDmabufImageCache::clear()
+{
+    for (const auto &entry : std::as_const(m_entries))
+        release(entry.second);
+    m_entries.clear();
+
+    for (ClientListener *clientListener : std::as_const(m_clients)) {
+        wl_list_remove(&clientListener->listener.link);
+        delete clientListener;
+    }
+    m_clients.clear();
+}
+
+void LinuxDmabufImageCache::release(const LinuxDmabufImageCacheEntry &entry)
+{
+    for (uint32_t i = 0; i < LinuxDmabufWlBuffer::MaxDmabufPlanes; ++i) {
+        if (entry.textures[i] != nullptr)
+            m_integration->deleteGLTextureWhenPossible(entry.textures[i]);
+        if (entry.images[i] != EGL_NO_IMAGE_KHR)
+            m_integration->deleteImage(entry.images[i]);
+    }
+}
+
+void LinuxDmabufImageCache::evict(qsizetype index)
+{
+    release(m_entries.takeAt(index).second);
+    ++m_statistics.evictions;
+}
+
+void LinuxDmabufImageCache::watchClient(::wl_client *client)
+{
+    if (m_clients.contains(client))
+        return;
+
+    auto *clientListener = new ClientListener;
+    clientListener->cache = this;
+    clientListener->listener.notify = handleClientDestroyed;
+    wl_client_add_destroy_listener(client, &clientListener->listener);
+    m_clients.insert(client, clientListener);
+}
+
+// Entries are only ever shared between buffers of the same client, and are
+// dropped together with it.
+void LinuxDmabufImageCache::removeClient(::wl_client *client)
+{
+    for (qsizetype i = m_entries.size() - 1; i >= 0; --i) {
+        if (m_entries.at(i).first.client == client)
+            release(m_entries.takeAt(i).second);
+    }
+
+    if (ClientListener *clientListener = m_clients.take(client)) {
+        wl_list_remove(&clientListener->listener.link);
+        delete clientListener;
+    }
+}
+
+void LinuxDmabufImageCache::handleClientDestroyed(struct wl_listener *listener, void *data)
+{
+    ClientListener *clientListener = reinterpret_cast<ClientListener *>(
+            wl_container_of(listener, (ClientListener *)nullptr, listener));
+    clientListener->cache->removeClient(static_cast<::wl_client *>(data));
+}
+
+QT_END_NAMESPACE
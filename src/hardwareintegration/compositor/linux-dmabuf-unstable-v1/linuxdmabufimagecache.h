@@ -0,0 +1,100 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only
+
+#ifndef LINUXDMABUFIMAGECACHE_H
+#define LINUXDMABUFIMAGECACHE_H
+
+#include "linuxdmabuf.h"
+
+#include <QtCore/QList>
+#include <QtCore/QHash>
+#include <QtCore/QSize>
+
+#include <sys/types.h>
+
+struct wl_client;
+
+QT_BEGIN_NAMESPACE
+
+class QOpenGLTexture;
+class LinuxDmabufClientBufferIntegration;
+
+// Identifies the memory behind a dmabuf-based wl_buffer independently of the
+// file descriptors the client happened to send, so that a buffer which is
+// re-wrapped into a new wl_buffer can reuse the EGLImages of the old one.
+struct LinuxDmabufImageKey
+{
+    struct PlaneKey {
+        dev_t device = 0;
+        ino_t inode = 0;
+        uint32_t offset = 0;
+        uint32_t stride = 0;
+        uint64_t modifier = 0;
+
+        bool operator==(const PlaneKey &other) const
+        {
+            return device == other.device && inode == other.inode && offset == other.offset
+                    && stride == other.stride && modifier == other.modifier;
+        }
+    };
+
+    static bool fromBuffer(LinuxDmabufWlBuffer *buffer, LinuxDmabufImageKey *key);
+
+    bool operator==(const LinuxDmabufImageKey &other) const;
+    bool operator!=(const LinuxDmabufImageKey &other) const { return !(*this == other); }
+
+    ::wl_client *client = nullptr;
+    uint32_t drmFormat = 0;
+    QSize size;
+    uint32_t planesNumber = 0;
+    std::array<PlaneKey, LinuxDmabufWlBuffer::MaxDmabufPlanes> planes;
+};
+
+// The EGLImages and textures imported for one buffer
+struct LinuxDmabufImageCacheEntry
+{
+    std::array<EGLImageKHR, LinuxDmabufWlBuffer::MaxDmabufPlanes> images = { {EGL_NO_IMAGE_KHR, EGL_NO_IMAGE_KHR, EGL_NO_IMAGE_KHR, EGL_NO_IMAGE_KHR} };
+    std::array<QOpenGLTexture *, LinuxDmabufWlBuffer::MaxDmabufPlanes> textures = { {nullptr, nullptr, nullptr, nullptr} };
+};
+
+class LinuxDmabufImageCache
+{
+public:
+    struct Statistics {
+        quint64 hits = 0;
+        quint64 misses = 0;
+        quint64 evictions = 0;
+    };
+
+    explicit LinuxDmabufImageCache(LinuxDmabufClientBufferIntegration *integration);
+    ~LinuxDmabufImageCache();
+
+    void setMaxSize(int maxSize);
+    int maxSize() const { return m_maxSize; }
+    int size() const { return int(m_entries.size()); }
+    Statistics statistics() const { return m_statistics; }
+
+    bool take(const LinuxDmabufImageKey &key, LinuxDmabufImageCacheEntry *entry);
+    void insert(const LinuxDmabufImageKey &key, const LinuxDmabufImageCacheEntry &entry);
+    void clear();
+
+private:
+    struct ClientListener;
+
+    void release(const LinuxDmabufImageCacheEntry &entry);
+    void evict(qsizetype index);
+    void watchClient(::wl_client *client);
+    void removeClient(::wl_client *client);
+    static void handleClientDestroyed(struct wl_listener *listener, void *data);
+
+    LinuxDmabufClientBufferIntegration *m_integration = nullptr;
+    int m_maxSize = 16;
+    Statistics m_statistics;
+    // least recently used first, the cache is small enough for linear lookups
+    QList<QPair<LinuxDmabufImageKey, LinuxDmabufImageCacheEntry>> m_entries;
+    QHash<::wl_client *, ClientListener *> m_clients;
+};
+
+QT_END_NAMESPACE
+
+#endif // LINUXDMABUFIMAGECACHE_H
@@ -14,12 +14,15 @@
 #include <QtGui/QGuiApplication>
 #include <QtGui/private/qguiapplication_p.h>
 #include <QtQuick/private/qsgrhisupport_p.h>
+#include <QtQuick/private/qsgtexture_p.h>
+#include <QtGui/private/qrhi_p.h>
 #include <QtGui/qpa/qplatformnativeinterface.h>
 #include <QtGui/QWindow>
 #include <QOpenGLTexture>
 #include <QImageReader>
 
 #include <QTimer>
+#include <QMutex>
 
 #include "texturesharingextension_p.h"
 
@@ -70,11 +73,154 @@ private:
     QPointer<SharedTextureRegistry> m_registry;
 };
 
+// The texture of a shared atlas in a window. It keeps the server buffer alive,
+// so the buffer address it is cached under cannot be reused by another buffer
+// while the texture exists.
+struct SharedAtlasTexture
+{
+    QSharedPointer<QtWaylandClient::QWaylandServerBuffer> buffer;
+    QQuickWindow *window = nullptr;
+    QScopedPointer<QSGTexture> texture;
+};
+
+// Refers to a region of a shared atlas texture. All sub-textures of the same
+// atlas in a window share one QSGTexture, so that the scene graph can batch them.
+class SharedAtlasSubTexture : public QSGTexture
+{
+public:
+    SharedAtlasSubTexture(const QSharedPointer<SharedAtlasTexture> &atlas, const QRect &rect)
+        : m_atlas(atlas), m_rect(rect)
+    {
+        const QSizeF atlasSize = atlas->texture->textureSize();
+        m_subRect = QRectF(rect.x() / atlasSize.width(), rect.y() / atlasSize.height(),
+                           rect.width() / atlasSize.width(), rect.height() / atlasSize.height());
+    }
+
+    qint64 comparisonKey() const override { return m_atlas->texture->comparisonKey(); }
+    QRhiTexture *rhiTexture() const override { return m_atlas->texture->rhiTexture(); }
+    QSize textureSize() const override { return m_rect.size(); }
+    bool hasAlphaChannel() const override { return true; }
+    bool hasMipmaps() const override { return false; }
+    QRectF normalizedTextureSubRect() const override { return m_subRect; }
+    bool isAtlasTexture() const override { return true; }
+
+    // Used when the texture is tiled or mipmapped: the region is copied into a
+    // texture of its own.
+    QSGTexture *removedFromAtlas(QRhiResourceUpdateBatch *resourceUpdates) const override
+    {
+        if (m_standalone)
+            return m_standalone.data();
+
+        if (!resourceUpdates) {
+            qWarning("SharedAtlasSubTexture::removedFromAtlas(): no QRhiResourceUpdateBatch provided");
+            return nullptr;
+        }
+
+        QRhi *rhi = m_atlas->window->rhi();
+        QRhiTexture *atlasTexture = m_atlas->texture->rhiTexture();
+        if (!rhi || !atlasTexture)
+            return nullptr;
+
+        QRhiTexture *texture = rhi->newTexture(atlasTexture->format(), m_rect.size());
+        if (!texture->create()) {
+            delete texture;
+            return nullptr;
+        }
+
+        QRhiTextureCopyDescription desc;
+        desc.setSourceTopLeft(m_rect.topLeft());
+        desc.setPixelSize(m_rect.size());
+        resourceUpdates->copyTexture(texture, atlasTexture, desc);
+
+        m_standalone.reset(new QSGPlainTexture);
+        m_standalone->setTexture(texture);
+        m_standalone->setOwnsTexture(true);
+        m_standalone->setTextureSize(m_rect.size());
+        m_standalone->setHasAlphaChannel(true);
+        m_standalone->setFiltering(filtering());
+        m_standalone->setMipmapFiltering(mipmapFiltering());
+        m_standalone->setHorizontalWrapMode(horizontalWrapMode());
+        m_standalone->setVerticalWrapMode(verticalWrapMode());
+        return m_standalone.data();
+    }
+
+private:
+    QSharedPointer<SharedAtlasTexture> m_atlas;
+    QRect m_rect;
+    QRectF m_subRect;
+    mutable QScopedPointer<QSGPlainTexture> m_standalone;
+};
+
+struct SharedAtlasTextureCache
+{
+    QMutex mutex;
+    QHash<QPair<const QtWaylandClient::QWaylandServerBuffer *, QQuickWindow *>, QWeakPointer<SharedAtlasTexture>> textures;
+};
+
+Q_GLOBAL_STATIC(SharedAtlasTextureCache, sharedAtlasTextureCache)
+
+class SharedAtlasTextureFactory : public QQuickTextureFactory
+{
+public:
+    SharedAtlasTextureFactory(const SharedTextureRegistry::AtlasRegion &region, const QString &id, SharedTextureRegistry *registry)
+        : m_region(region), m_id(id), m_registry(registry)
+    {
+    }
+
+    ~SharedAtlasTextureFactory() override
+    {
+        if (m_registry)
+            m_registry->abandonBuffer(m_id);
+    }
+
+    QSize textureSize() const override
+    {
+        return m_region.rect.size();
+    }
+
+    int textureByteCount() const override
+    {
+        return m_region.rect.width() * m_region.rect.height() * 4;
+    }
+
+    QSGTexture *createTexture(QQuickWindow *window) const override
+    {
+        auto *cache = sharedAtlasTextureCache();
+        QMutexLocker locker(&cache->mutex);
+        const auto key = qMakePair(static_cast<const QtWaylandClient::QWaylandServerBuffer *>(m_region.buffer.data()), window);
+        QSharedPointer<SharedAtlasTexture> atlas = cache->textures.value(key).toStrongRef();
+        if (!atlas) {
+            QOpenGLTexture *texture = m_region.buffer->toOpenGlTexture();
+            atlas.reset(new SharedAtlasTexture);
+            atlas->buffer = m_region.buffer;
+            atlas->window = window;
+            atlas->texture.reset(QNativeInterface::QSGOpenGLTexture::fromNative(texture->textureId(),
+                                                                                window,
+                                                                                m_region.buffer->size(),
+                                                                                QQuickWindow::TextureHasAlphaChannel));
+            for (auto it = cache->textures.begin(); it != cache->textures.end(); ) {
+                if (it.value().isNull())
+                    it = cache->textures.erase(it);
+                else
+                    ++it;
+            }
+            cache->textures.insert(key, atlas);
+        }
+        return new SharedAtlasSubTexture(atlas, m_region.rect);
+    }
+
+private:
+    SharedTextureRegistry::AtlasRegion m_region;
+    QString m_id;
+    QPointer<SharedTextureRegistry> m_registry;
+};
+
 
 SharedTextureRegistry::SharedTextureRegistry()
     : m_extension(new TextureSharingExtension)
 {
     connect(m_extension, &TextureSharingExtension::bufferReceived, this, &SharedTextureRegistry::receiveBuffer);
+    connect(m_extension, &TextureSharingExtension::bufferRegionReceived, this, &SharedTextureRegistry::receiveBufferRegion);
     connect(m_extension, &TextureSharingExtension::activeChanged, this, &SharedTextureRegistry::handleExtensionActive);
 }
 
@@ -88,6 +234,16 @@ const QtWaylandClient::QWaylandServerBuffer *SharedTextureRegistry::bufferForId(
     return m_buffers.value(id);
 }
 
+SharedTextureRegistry::AtlasRegion SharedTextureRegistry::atlasRegionForId(const QString &id) const
+{
+    return m_atlasRegions.value(id);
+}
+
+bool SharedTextureRegistry::hasImage(const QString &id) const
+{
+    return m_buffers.contains(id) || m_atlasRegions.contains(id);
+}
+
 void SharedTextureRegistry::requestBuffer(const QString &id)
 {
     if (!m_extension->isActive()) {
@@ -95,12 +251,28 @@ void SharedTextureRegistry::requestBuffer(const QString &id)
         m_pendingBuffers << id;
         return;
     }
-    m_extension->requestImage(id);
+
+    // Requests made during the same event loop iteration (typically a whole
+    // QML scene being loaded) are sent to the compositor as one batch.
+    if (m_batchedBuffers.contains(id))
+        return;
+    if (m_batchedBuffers.isEmpty())
+        QMetaObject::invokeMethod(this, &SharedTextureRegistry::flushRequests, Qt::QueuedConnection);
+    m_batchedBuffers << id;
+}
+
+void SharedTextureRegistry::flushRequests()
+{
+    if (m_batchedBuffers.isEmpty())
+        return;
+    m_extension->requestImages(m_batchedBuffers);
+    m_batchedBuffers.clear();
 }
 
 void SharedTextureRegistry::abandonBuffer(const QString &id)
 {
     m_buffers.remove(id);
+    m_atlasRegions.remove(id);
     m_extension->abandonImage(id);
 }
 
@@ -108,9 +280,11 @@ void SharedTextureRegistry::abandonBuffer(const QString &id)
 void SharedTextureRegistry::handleExtensionActive()
 {
     //qDebug() << "handleExtensionActive, queue:" << m_pendingBuffers;
-    if (m_extension->isActive())
+    if (m_extension->isActive()) {
         while (!m_pendingBuffers.isEmpty())
             requestBuffer(m_pendingBuffers.takeFirst());
+        flushRequests();
+    }
 }
 
 bool SharedTextureRegistry::preinitialize()
@@ -138,6 +312,21 @@ void SharedTextureRegistry::receiveBuffer(QtWaylandClient::QWaylandServerBuffer
     emit replyReceived(id);
 }
 
+void SharedTextureRegistry::receiveBufferRegion(QtWaylandClient::QWaylandServerBuffer *buffer, const QString &id, const QRect &rect)
+{
+    if (buffer) {
+        // The atlas buffer is deleted when the last image using it is abandoned
+        QSharedPointer<QtWaylandClient::QWaylandServerBuffer> atlas = m_atlasBuffers.value(buffer).toStrongRef();
+        if (!atlas) {
+            m_atlasBuffers.removeIf([](const auto &it) { return it.value().isNull(); });
+            atlas.reset(buffer);
+            m_atlasBuffers.insert(buffer, atlas);
+        }
+        m_atlasRegions.insert(id, AtlasRegion{atlas, rect});
+    }
+    emit replyReceived(id);
+}
+
 class SharedTextureImageResponse : public QQuickImageResponse
 {
     Q_OBJECT
@@ -145,7 +334,7 @@ public:
     SharedTextureImageResponse(SharedTextureRegistry *registry, const QString &id)
         : m_id(id), m_registry(registry)
     {
-        if (!m_registry || m_registry->bufferForId(id)) {
+        if (!m_registry || m_registry->hasImage(id)) {
             // Shortcut: no server roundtrip needed, just let the event loop call the slot
             QMetaObject::invokeMethod(this, "doResponse", Qt::QueuedConnection, Q_ARG(QString, id));
 
@@ -159,6 +348,10 @@ public:
     QQuickTextureFactory *textureFactory() const override
     {
         if (m_registry) {
+            const SharedTextureRegistry::AtlasRegion region = m_registry->atlasRegionForId(m_id);
+            if (region.buffer)
+                return new SharedAtlasTextureFactory(region, m_id, m_registry);
+
             const QtWaylandClient::QWaylandServerBuffer *buffer = m_registry->bufferForId(m_id);
             if (buffer) {
                 //qDebug() << "Creating shared buffer texture for" << m_id;
@@ -19,7 +19,9 @@
 #include <QQuickImageProvider>
 #include <QtQuick/QSGTexture>
 #include <QScopedPointer>
+#include <QSharedPointer>
 #include <QHash>
+#include <QRect>
 
 #include <QtWaylandClient/private/qwaylandserverbufferintegration_p.h>
 
@@ -34,7 +36,15 @@ public:
     SharedTextureRegistry();
     ~SharedTextureRegistry() override;
 
+    struct AtlasRegion
+    {
+        QSharedPointer<QtWaylandClient::QWaylandServerBuffer> buffer;
+        QRect rect;
+    };
+
     const QtWaylandClient::QWaylandServerBuffer *bufferForId(const QString &id) const;
+    AtlasRegion atlasRegionForId(const QString &id) const;
+    bool hasImage(const QString &id) const;
     void requestBuffer(const QString &id);
     void abandonBuffer(const QString &id);
 
@@ -42,17 +52,22 @@ public:
 
 public slots:
     void receiveBuffer(QtWaylandClient::QWaylandServerBuffer *buffer, const QString &id);
+    void receiveBufferRegion(QtWaylandClient::QWaylandServerBuffer *buffer, const QString &id, const QRect &rect);
 
 signals:
     void replyReceived(const QString &id);
 
 private slots:
     void handleExtensionActive();
+    void flushRequests();
 
 private:
     TextureSharingExtension *m_extension = nullptr;
     QHash<QString, QtWaylandClient::QWaylandServerBuffer *> m_buffers;
+    QHash<QString, AtlasRegion> m_atlasRegions;
+    QHash<QtWaylandClient::QWaylandServerBuffer *, QWeakPointer<QtWaylandClient::QWaylandServerBuffer>> m_atlasBuffers;
     QStringList m_pendingBuffers;
+    QStringList m_batchedBuffers;
 };
 
 class SharedTextureProvider : public QQuickAsyncImageProvider
@@ -0,0 +1,58 @@
+// Copyright (C) 2019 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "texturesharingbatches_p.h"
+
+QT_BEGIN_NAMESPACE
+
+// Packs the keys, each NUL-terminated, into as few batches of at most
+// maxBatchSize bytes as possible, keeping their order.
+TextureSharingBatches::Split TextureSharingBatches::split(const QStringList &keys, qsizetype maxBatchSize)
+{
+    Split result;
+    QByteArray batch;
+    for (const QString &key : keys) {
+        const QByteArray utf8 = key.toUtf8();
+        if (utf8.size() + 1 > maxBatchSize) {
+            result.singleKeys.append(key);
+            continue;
+        }
+        if (batch.size() + utf8.size() + 1 > maxBatchSize) {
+            result.batches.append(batch);
+            batch.clear();
+        }
+        batch.append(utf8);
+        batch.append('\0');
+    }
+    if (!batch.isEmpty())
+        result.batches.append(batch);
+    return result;
+}
+
+void TextureSharingBatches::add(uint serial, const QByteArray &batch)
+{
+    QStringList &keys = m_outstanding[serial];
+    const QList<QByteArray> utf8Keys = batch.split('\0');
+    for (const QByteArray &utf8 : utf8Keys) {
+        if (!utf8.isEmpty())
+            keys.append(QString::fromUtf8(utf8));
+    }
+}
+
+// The compositor replies in the order of the requests, so a reply belongs to
+// the oldest batch that still waits for the key.
+void TextureSharingBatches::replyReceived(const QString &key)
+{
+    for (auto it = m_outstanding.begin(); it != m_outstanding.end(); ++it) {
+        if (it->removeOne(key))
+            return;
+    }
+}
+
+// Returns the keys of the batch that got no reply
+QStringList TextureSharingBatches::finish(uint serial)
+{
+    return m_outstanding.take(serial);
+}
+
+QT_END_NAMESPACE
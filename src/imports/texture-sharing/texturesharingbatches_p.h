@@ -0,0 +1,53 @@
+// Copyright (C) 2019 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#ifndef TEXTURESHARINGBATCHES_H
+#define TEXTURESHARINGBATCHES_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QList>
+#include <QtCore/QMap>
+#include <QtCore/QStringList>
+
+QT_BEGIN_NAMESPACE
+
+// Splits image requests into request_images batches and keeps track of the
+// keys of every batch that the compositor has not replied to yet.
+class TextureSharingBatches
+{
+public:
+    // Stay well below the maximum size of a Wayland message
+    static constexpr qsizetype MaxBatchSize = 3072;
+
+    struct Split
+    {
+        QList<QByteArray> batches;
+        QStringList singleKeys; // too long for a batch, sent with request_image
+    };
+
+    static Split split(const QStringList &keys, qsizetype maxBatchSize = MaxBatchSize);
+
+    void add(uint serial, const QByteArray &batch);
+    void replyReceived(const QString &key);
+    QStringList finish(uint serial);
+
+    bool isEmpty() const { return m_outstanding.isEmpty(); }
+
+private:
+    QMap<uint, QStringList> m_outstanding;
+};
+
+QT_END_NAMESPACE
+
+#endif // TEXTURESHARINGBATCHES_H
@@ -15,7 +15,7 @@
 QT_BEGIN_NAMESPACE
 
 TextureSharingExtension::TextureSharingExtension()
-    : QWaylandClientExtensionTemplate(/* Supported protocol version */ 1 )
+    : QWaylandClientExtensionTemplate(/* Supported protocol version */ 3 )
 {
         auto *wayland_integration = static_cast<QtWaylandClient::QWaylandIntegration *>(QGuiApplicationPrivate::platformIntegration());
         m_server_buffer_integration = wayland_integration->serverBufferIntegration();
@@ -27,20 +27,61 @@ TextureSharingExtension::TextureSharingExtension()
 
 void TextureSharingExtension::zqt_texture_sharing_v1_provide_buffer(struct ::qt_server_buffer *buffer, const QString &key)
 {
+    m_batches.replyReceived(key);
     QtWaylandClient::QWaylandServerBuffer *serverBuffer = m_server_buffer_integration->serverBuffer(buffer);
     emit bufferReceived(serverBuffer, key);
 }
 
+void TextureSharingExtension::zqt_texture_sharing_v1_provide_buffer_region(struct ::qt_server_buffer *buffer, const QString &key,
+                                                                           int32_t x, int32_t y, int32_t width, int32_t height)
+{
+    m_batches.replyReceived(key);
+    QtWaylandClient::QWaylandServerBuffer *serverBuffer = m_server_buffer_integration->serverBuffer(buffer);
+    emit bufferRegionReceived(serverBuffer, key, QRect(x, y, width, height));
+}
+
 void TextureSharingExtension::zqt_texture_sharing_v1_image_failed(const QString &key, const QString &message)
 {
+    m_batches.replyReceived(key);
     qWarning() << "TextureSharingExtension" << key << "not found" << message;
     emit bufferReceived(nullptr, key);
 }
+
+// Keys of the batch the compositor did not reply to would otherwise never
+// complete, so they are failed here.
+void TextureSharingExtension::zqt_texture_sharing_v1_images_done(uint32_t serial)
+{
+    const QStringList missing = m_batches.finish(serial);
+    for (const QString &key : missing) {
+        qWarning() << "TextureSharingExtension" << key << "not provided by the compositor";
+        emit bufferReceived(nullptr, key);
+    }
+}
+
 void TextureSharingExtension::requestImage(const QString &key)
 {
     request_image(key);
 }
 
+// Sends the keys in as few request_images messages as the wire format allows,
+// falling back to one request_image per key on version 1 compositors.
+void TextureSharingExtension::requestImages(const QStringList &keys)
+{
+    if (zqt_texture_sharing_v1::version() < ZQT_TEXTURE_SHARING_V1_REQUEST_IMAGES_SINCE_VERSION) {
+        for (const QString &key : keys)
+            request_image(key);
+        return;
+    }
+
+    const TextureSharingBatches::Split split = TextureSharingBatches::split(keys);
+    for (const QString &key : split.singleKeys)
+        request_image(key);
+    for (const QByteArray &batch : split.batches) {
+        m_batches.add(++m_batchSerial, batch);
+        request_images(m_batchSerial, batch);
+    }
+}
+
 void TextureSharingExtension::abandonImage(const QString &key)
 {
     abandon_image(key);
@@ -19,6 +19,7 @@
 #include <QtWaylandClient/private/qwayland-wayland.h>
 #include <QtWaylandClient/qwaylandclientextension.h>
 #include "qwayland-qt-texture-sharing-unstable-v1.h"
+#include "texturesharingbatches_p.h"
 #include "private/qglobal_p.h"
 
 QT_BEGIN_NAMESPACE
@@ -37,15 +38,22 @@ public:
 
 public slots:
     void requestImage(const QString &key);
+    void requestImages(const QStringList &keys);
     void abandonImage(const QString &key);
 
 signals:
     void bufferReceived(QtWaylandClient::QWaylandServerBuffer *buffer, const QString &key);
+    void bufferRegionReceived(QtWaylandClient::QWaylandServerBuffer *buffer, const QString &key, const QRect &rect);
 
 private:
     void zqt_texture_sharing_v1_provide_buffer(struct ::qt_server_buffer *buffer, const QString &key) override;
+    void zqt_texture_sharing_v1_provide_buffer_region(struct ::qt_server_buffer *buffer, const QString &key,
+                                                      int32_t x, int32_t y, int32_t width, int32_t height) override;
     void zqt_texture_sharing_v1_image_failed(const QString &key, const QString &message) override;
+    void zqt_texture_sharing_v1_images_done(uint32_t serial) override;
     QtWaylandClient::QWaylandServerBufferIntegration *m_server_buffer_integration = nullptr;
+    uint m_batchSerial = 0;
+    TextureSharingBatches m_batches;
 };
 
 QT_END_NAMESPACE
@@ -52,6 +52,9 @@ private:
     QRectF maximizeButtonRect() const;
     QRectF minimizeButtonRect() const;
 
+    void paintFrame(QPainter *p, const QRect &wg) const;
+    void paintButton(QPainter *p, Button button, const QRectF &rect, const QColor &color) const;
+
     QColor m_foregroundColor;
     QColor m_foregroundInactiveColor;
     QColor m_backgroundColor;
@@ -102,32 +105,126 @@ QMargins QWaylandBradientDecoration::margins(MarginsType marginsType) const
     return QMargins(3, 30, 3, 3);
 }
 
+// The frame is the same for every window, only stretched to its width. It is
+// rendered once as a rounded rectangle with just one pixel of content, whose
+// middle row and column are repeated.
+void QWaylandBradientDecoration::paintFrame(QPainter *p, const QRect &wg) const
+{
+    const QMargins m = margins();
+    const QSize size(m.left() + 1 + m.right(), m.top() + 1 + m.bottom());
+    const QColor backgroundColor = m_backgroundColor;
+    const QImage frame = cachedPart("bradient/frame/" + backgroundColor.name(QColor::HexArgb).toLatin1(), size,
+                                    [backgroundColor](QPainter *painter, const QSize &size) {
+        painter->setRenderHint(QPainter::Antialiasing);
+        QPainterPath roundedRect;
+        roundedRect.addRoundedRect(QRect(QPoint(), size), 3, 3);
+        painter->fillPath(roundedRect, backgroundColor);
+    });
+
+    const qreal scale = frame.devicePixelRatio();
+    auto source = [scale](qreal x, qreal y, qreal w, qreal h) {
+        return QRectF(x * scale, y * scale, w * scale, h * scale);
+    };
+    const int middle = wg.width() - m.left() - m.right();
+    const int bottom = (wg.bottom() + 1) - m.bottom();
+    const int right = (wg.right() + 1) - m.right();
+
+    // Top and bottom, with their rounded corners
+    p->drawImage(QRectF(wg.left(), wg.top(), m.left(), m.top()), frame, source(0, 0, m.left(), m.top()));
+    p->drawImage(QRectF(wg.left() + m.left(), wg.top(), middle, m.top()), frame, source(m.left(), 0, 1, m.top()));
+    p->drawImage(QRectF(right, wg.top(), m.right(), m.top()), frame, source(m.left() + 1, 0, m.right(), m.top()));
+    p->drawImage(QRectF(wg.left(), bottom, m.left(), m.bottom()), frame, source(0, m.top() + 1, m.left(), m.bottom()));
+    p->drawImage(QRectF(wg.left() + m.left(), bottom, middle, m.bottom()), frame, source(m.left(), m.top() + 1, 1, m.bottom()));
+    p->drawImage(QRectF(right, bottom, m.right(), m.bottom()), frame, source(m.left() + 1, m.top() + 1, m.right(), m.bottom()));
+
+    // Left and right
+    const int height = wg.height() - m.top() - m.bottom();
+    p->fillRect(QRect(wg.left(), m.top(), m.left(), height), m_backgroundColor);
+    p->fillRect(QRect(right, wg.top() + m.top(), m.right(), height), m_backgroundColor);
+}
+
+// The button glyphs only depend on their state and color, they are rendered
+// once and shared by all windows.
+void QWaylandBradientDecoration::paintButton(QPainter *p, Button button, const QRectF &rect, const QColor &color) const
+{
+    const bool maximized = window()->windowStates().testFlag(Qt::WindowMaximized);
+    const QColor backgroundColor = m_backgroundColor;
+
+    QByteArray key = "bradient/";
+    switch (button) {
+    case Close:
+        key += "close";
+        break;
+    case Maximize:
+        key += maximized ? "restore" : "maximize";
+        break;
+    case Minimize:
+        key += "minimize";
+        break;
+    case None:
+        return;
+    }
+    key += '/' + color.name(QColor::HexArgb).toLatin1() + '/' + backgroundColor.name(QColor::HexArgb).toLatin1();
+
+    const QImage glyph = cachedPart(key, rect.size().toSize(),
+                                    [button, maximized, color, backgroundColor](QPainter *painter, const QSize &size) {
+        const QRectF buttonRect(QPointF(), size);
+        QPen pen(color);
+        painter->setPen(pen);
+
+        switch (button) {
+        case Close: {
+            painter->setRenderHint(QPainter::Antialiasing);
+            qreal crossSize = buttonRect.height() / 2.3;
+            QPointF crossCenter(buttonRect.center());
+            QRectF crossRect(crossCenter.x() - crossSize / 2, crossCenter.y() - crossSize / 2, crossSize, crossSize);
+            pen.setWidth(2);
+            painter->setPen(pen);
+            painter->drawLine(crossRect.topLeft(), crossRect.bottomRight());
+            painter->drawLine(crossRect.bottomLeft(), crossRect.topRight());
+            break;
+        }
+        case Maximize: {
+            QRectF rect = buttonRect.adjusted(4, 5, -4, -5);
+            if (maximized) {
+                qreal inset = 2;
+                QRectF rect1 = rect.adjusted(inset, 0, 0, -inset);
+                QRectF rect2 = rect.adjusted(0, inset, -inset, 0);
+                painter->drawRect(rect1);
+                painter->setBrush(backgroundColor); // need to cover up some lines from the other rect
+                painter->drawRect(rect2);
+            } else {
+                painter->drawRect(rect);
+                painter->drawLine(rect.left(), rect.top() + 1, rect.right(), rect.top() + 1);
+            }
+            break;
+        }
+        case Minimize: {
+            QRectF rect = buttonRect.adjusted(5, 5, -5, -5);
+            pen.setWidth(2);
+            painter->setPen(pen);
+            painter->drawLine(rect.bottomLeft(), rect.bottomRight());
+            break;
+        }
+        case None:
+            break;
+        }
+    });
+
+    p->drawImage(rect.topLeft(), glyph);
+}
+
 void QWaylandBradientDecoration::paint(QPaintDevice *device)
 {
     bool active = window()->handle()->isActive();
     QRect wg = waylandWindow()->windowContentGeometry();
-    QRect clips[] =
-    {
-        QRect(wg.left(), wg.top(), wg.width(), margins().top()),
-        QRect(wg.left(), (wg.bottom() + 1) - margins().bottom(), wg.width(), margins().bottom()),
-        QRect(wg.left(), margins().top(), margins().left(), wg.height() - margins().top() - margins().bottom()),
-        QRect((wg.right() + 1) - margins().right(), wg.top() + margins().top(), margins().right(), wg.height() - margins().top() - margins().bottom())
-    };
-
-    QRect top = clips[0];
+    QRect top(wg.left(), wg.top(), wg.width(), margins().top());
 
     QPainter p(device);
     p.setRenderHint(QPainter::Antialiasing);
 
     // Title bar
-    QPainterPath roundedRect;
-    roundedRect.addRoundedRect(wg, 3, 3);
-    for (int i = 0; i < 4; ++i) {
-        p.save();
-        p.setClipRect(clips[i]);
-        p.fillPath(roundedRect, m_backgroundColor);
-        p.restore();
-    }
+    paintFrame(&p, wg);
 
     // Window icon
     QIcon icon = waylandWindow()->windowIcon();
@@ -166,49 +263,11 @@ void QWaylandBradientDecoration::paint(QPaintDevice *device)
         p.restore();
     }
 
-    QRectF rect;
-
-    // Default pen
-    QPen pen(active ? m_foregroundColor : m_foregroundInactiveColor);
-    p.setPen(pen);
-
-    // Close button
-    p.save();
-    rect = closeButtonRect();
-    qreal crossSize = rect.height() / 2.3;
-    QPointF crossCenter(rect.center());
-    QRectF crossRect(crossCenter.x() - crossSize / 2, crossCenter.y() - crossSize / 2, crossSize, crossSize);
-    pen.setWidth(2);
-    p.setPen(pen);
-    p.drawLine(crossRect.topLeft(), crossRect.bottomRight());
-    p.drawLine(crossRect.bottomLeft(), crossRect.topRight());
-    p.restore();
-
-    // Maximize button
-    p.save();
-    p.setRenderHint(QPainter::Antialiasing, false);
-    rect = maximizeButtonRect().adjusted(4, 5, -4, -5);
-    if ((window()->windowStates() & Qt::WindowMaximized)) {
-        qreal inset = 2;
-        QRectF rect1 = rect.adjusted(inset, 0, 0, -inset);
-        QRectF rect2 = rect.adjusted(0, inset, -inset, 0);
-        p.drawRect(rect1);
-        p.setBrush(m_backgroundColor); // need to cover up some lines from the other rect
-        p.drawRect(rect2);
-    } else {
-        p.drawRect(rect);
-        p.drawLine(rect.left(), rect.top() + 1, rect.right(), rect.top() + 1);
-    }
-    p.restore();
-
-    // Minimize button
-    p.save();
-    p.setRenderHint(QPainter::Antialiasing, false);
-    rect = minimizeButtonRect().adjusted(5, 5, -5, -5);
-    pen.setWidth(2);
-    p.setPen(pen);
-    p.drawLine(rect.bottomLeft(), rect.bottomRight());
-    p.restore();
+    // Buttons
+    const QColor color = active ? m_foregroundColor : m_foregroundInactiveColor;
+    paintButton(&p, Close, closeButtonRect(), color);
+    paintButton(&p, Maximize, maximizeButtonRect(), color);
+    paintButton(&p, Minimize, minimizeButtonRect(), color);
 }
 
 bool QWaylandBradientDecoration::clickButton(Qt::MouseButtons b, Button btn)
@@ -0,0 +1,207 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#include "mockcompositor.h"
+
+#include <QtWaylandClient/private/qwaylandabstractdecoration_p.h>
+#include <QtWaylandClient/private/qwaylandwindow_p.h>
+
+#include <QtGui/QPainter>
+#include <QtGui/QRasterWindow>
+
+using namespace MockCompositor;
+using namespace QtWaylandClient;
+
+// Paints the whole surface in the frame color, with a marker in the top left
+// corner so that the placement of the edges can be checked.
+class TestDecoration : public QWaylandAbstractDecoration
+{
+public:
+    QMargins margins(MarginsType marginsType = Full) const override
+    {
+        if (marginsType == ShadowsOnly)
+            return QMargins();
+        return QMargins(3, 30, 3, 3);
+    }
+    bool handleMouse(QWaylandInputDevice *, const QPointF &, const QPointF &, Qt::MouseButtons, Qt::KeyboardModifiers) override { return false; }
+    bool handleTouch(QWaylandInputDevice *, const QPointF &, const QPointF &, QEventPoint::State, Qt::KeyboardModifiers) override { return false; }
+
+    // Parts are filled with a single color, painting them is counted
+    QImage part(const QByteArray &key, const QSize &size, const QColor &color = Qt::green)
+    {
+        return cachedPart(key, size, [&](QPainter *painter, const QSize &size) {
+            ++partPaintCount;
+            painter->fillRect(QRect(QPoint(), size), color);
+        });
+    }
+
+    int paintCount = 0;
+    int partPaintCount = 0;
+
+protected:
+    void paint(QPaintDevice *device) override
+    {
+        ++paintCount;
+        QPainter p(device);
+        p.fillRect(QRect(QPoint(), waylandWindow()->surfaceSize()), Qt::red);
+        p.fillRect(QRect(0, 0, 10, 10), Qt::blue);
+    }
+};
+
+class DecorationCompositor : public DefaultCompositor {
+public:
+    explicit DecorationCompositor()
+    {
+        exec([this] {
+            m_config.autoConfigure = true;
+        });
+    }
+};
+
+class tst_decoration : public QObject, private DecorationCompositor
+{
+    Q_OBJECT
+private slots:
+    void cleanup() { QTRY_VERIFY2(isClean(), qPrintable(dirtyMessage())); }
+    void edgeImages();
+    void edgeImagesCachedUntilInputsChange();
+    void partsSharedBetweenDecorations();
+    void partCacheBudget();
+};
+
+void tst_decoration::edgeImages()
+{
+    QRasterWindow window;
+    window.resize(64, 48);
+    window.show();
+    QCOMPOSITOR_TRY_VERIFY(xdgToplevel());
+
+    auto *waylandWindow = static_cast<QWaylandWindow *>(window.handle());
+    QVERIFY(waylandWindow);
+    TestDecoration decoration;
+    decoration.setWaylandWindow(waylandWindow);
+
+    const qreal scale = waylandWindow->scale();
+    for (Qt::Edge edge : { Qt::TopEdge, Qt::LeftEdge, Qt::RightEdge, Qt::BottomEdge }) {
+        const QRect rect = decoration.edgeRect(edge);
+        const QImage &image = decoration.edgeImage(edge);
+        QVERIFY(!rect.isEmpty());
+        QCOMPARE(image.size(), rect.size() * scale);
+        // Only the top edge covers the marker
+        const QColor expected = edge == Qt::TopEdge ? Qt::blue : Qt::red;
+        QCOMPARE(image.pixelColor(0, 0), expected);
+        QCOMPARE(image.pixelColor(image.width() - 1, image.height() - 1), QColor(Qt::red));
+    }
+    QCOMPARE(decoration.paintCount, 1);
+    QVERIFY(!decoration.isDirty());
+}
+
+void tst_decoration::edgeImagesCachedUntilInputsChange()
+{
+    QRasterWindow window;
+    window.resize(64, 48);
+    window.show();
+    QCOMPOSITOR_TRY_VERIFY(xdgToplevel());
+
+    auto *waylandWindow = static_cast<QWaylandWindow *>(window.handle());
+    TestDecoration decoration;
+    decoration.setWaylandWindow(waylandWindow);
+
+    decoration.edgeImage(Qt::TopEdge);
+    QCOMPARE(decoration.paintCount, 1);
+
+    // Nothing the decoration is painted from changed
+    decoration.update();
+    QVERIFY(decoration.isDirty());
+    decoration.edgeImage(Qt::TopEdge);
+    QCOMPARE(decoration.paintCount, 1);
+    QVERIFY(!decoration.isDirty());
+
+    decoration.updateActiveState();
+    decoration.edgeImage(Qt::TopEdge);
+    QCOMPARE(decoration.paintCount, 1);
+
+    window.setTitle(QStringLiteral("Renamed"));
+    decoration.update();
+    decoration.edgeImage(Qt::TopEdge);
+    QCOMPARE(decoration.paintCount, 2);
+
+    window.resize(80, 60);
+    decoration.update();
+    const QImage &top = decoration.edgeImage(Qt::TopEdge);
+    QCOMPARE(decoration.paintCount, 3);
+    QCOMPARE(top.size(), decoration.edgeRect(Qt::TopEdge).size() * waylandWindow->scale());
+
+    decoration.invalidate();
+    decoration.edgeImage(Qt::TopEdge);
+    QCOMPARE(decoration.paintCount, 4);
+}
+
+void tst_decoration::partsSharedBetweenDecorations()
+{
+    QRasterWindow window1;
+    window1.resize(64, 48);
+    window1.show();
+    QRasterWindow window2;
+    window2.resize(64, 48);
+    window2.show();
+    QCOMPOSITOR_TRY_VERIFY(xdgToplevel(1));
+
+    TestDecoration decoration1;
+    decoration1.setWaylandWindow(static_cast<QWaylandWindow *>(window1.handle()));
+    TestDecoration decoration2;
+    decoration2.setWaylandWindow(static_cast<QWaylandWindow *>(window2.handle()));
+
+    const QImage part1 = decoration1.part("tst_decoration/shared", QSize(16, 16));
+    QCOMPARE(decoration1.partPaintCount, 1);
+    QCOMPARE(part1.pixelColor(8, 8), QColor(Qt::green));
+
+    // Repeated decorations get the part rendered by the first one
+    const QImage part2 = decoration2.part("tst_decoration/shared", QSize(16, 16));
+    QCOMPARE(decoration2.partPaintCount, 0);
+    QCOMPARE(part2, part1);
+    decoration1.part("tst_decoration/shared", QSize(16, 16));
+    QCOMPARE(decoration1.partPaintCount, 1);
+
+    // The size is part of the key
+    decoration2.part("tst_decoration/shared", QSize(16, 20));
+    QCOMPARE(decoration2.partPaintCount, 1);
+}
+
+void tst_decoration::partCacheBudget()
+{
+    // Without a window the parts are rendered at scale 1, so a 512x512 part
+    // costs 1 MiB of the 4 MiB budget.
+    TestDecoration decoration;
+    const QSize size(512, 512);
+    const auto key = [](int i) { return "tst_decoration/budget" + QByteArray::number(i); };
+
+    for (int i = 0; i < 4; ++i)
+        decoration.part(key(i), size);
+    QCOMPARE(decoration.partPaintCount, 4);
+
+    // Four of them fit the budget
+    for (int i = 0; i < 4; ++i)
+        decoration.part(key(i), size);
+    QCOMPARE(decoration.partPaintCount, 4);
+
+    // A fifth one evicts the least recently used
+    decoration.part(key(4), size);
+    QCOMPARE(decoration.partPaintCount, 5);
+    for (int i = 4; i > 0; --i)
+        decoration.part(key(i), size);
+    QCOMPARE(decoration.partPaintCount, 5);
+    decoration.part(key(0), size);
+    QCOMPARE(decoration.partPaintCount, 6);
+
+    // Parts larger than the whole budget are never kept, and don't evict others
+    const QImage large = decoration.part("tst_decoration/large", QSize(2048, 1024), Qt::blue);
+    QCOMPARE(large.pixelColor(0, 0), QColor(Qt::blue));
+    decoration.part("tst_decoration/large", QSize(2048, 1024), Qt::blue);
+    QCOMPARE(decoration.partPaintCount, 8);
+    decoration.part(key(0), size);
+    QCOMPARE(decoration.partPaintCount, 8);
+}
+
+QCOMPOSITOR_TEST_MAIN(tst_decoration)
+#include "tst_decoration.moc"
@@ -0,0 +1,161 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#include "viewport.h"
+#include "mockcompositor.h"
+
+#include <qwayland-server-fractional-scale-v1.h>
+
+#include <QtGui/QRasterWindow>
+
+using namespace MockCompositor;
+
+class FractionalScaleManagerV1;
+class FractionalScaleV1 : public QObject, public QtWaylandServer::wp_fractional_scale_v1
+{
+    Q_OBJECT
+public:
+    explicit FractionalScaleV1(FractionalScaleManagerV1 *manager, Surface *surface, wl_client *client, int id, int version)
+        : QtWaylandServer::wp_fractional_scale_v1(client, id, version)
+        , m_manager(manager)
+        , m_surface(surface)
+    {
+    }
+    void sendPreferredScale(qreal scale)
+    {
+        // The scale is sent in 120ths
+        send_preferred_scale(uint(qRound(scale * 120)));
+    }
+    FractionalScaleManagerV1 *m_manager = nullptr;
+    Surface *m_surface = nullptr;
+
+protected:
+    void wp_fractional_scale_v1_destroy_resource(Resource *resource) override;
+    void wp_fractional_scale_v1_destroy(Resource *resource) override
+    {
+        wl_resource_destroy(resource->handle);
+    }
+};
+
+class FractionalScaleManagerV1 : public Global, public QtWaylandServer::wp_fractional_scale_manager_v1
+{
+    Q_OBJECT
+public:
+    explicit FractionalScaleManagerV1(CoreCompositor *compositor, int version = 1)
+        : QtWaylandServer::wp_fractional_scale_manager_v1(compositor->m_display, version)
+    {}
+    bool isClean() override { return m_fractionalScales.empty(); }
+    FractionalScaleV1 *fractionalScaleFor(Surface *surface) const { return m_fractionalScales.value(surface, nullptr); }
+
+    QMap<Surface *, FractionalScaleV1 *> m_fractionalScales;
+
+protected:
+    void wp_fractional_scale_manager_v1_destroy(Resource *resource) override
+    {
+        wl_resource_destroy(resource->handle);
+    }
+    void wp_fractional_scale_manager_v1_get_fractional_scale(Resource *resource, uint32_t id, wl_resource *surfaceResource) override
+    {
+        auto *surface = fromResource<Surface>(surfaceResource);
+        QVERIFY(surface);
+        QVERIFY(!fractionalScaleFor(surface));
+        m_fractionalScales[surface] = new FractionalScaleV1(this, surface, resource->client(), id, resource->version());
+    }
+};
+
+void FractionalScaleV1::wp_fractional_scale_v1_destroy_resource(Resource *resource)
+{
+    Q_UNUSED(resource);
+    int removed = m_manager->m_fractionalScales.remove(m_surface);
+    Q_ASSERT(removed == 1);
+    delete this;
+}
+
+class FractionalScaleCompositor : public DefaultCompositor {
+public:
+    explicit FractionalScaleCompositor()
+    {
+        exec([this] {
+            m_config.autoConfigure = true;
+            add<Viewporter>();
+            add<FractionalScaleManagerV1>();
+        });
+    }
+    FractionalScaleV1 *fractionalScale(int i = 0) { return get<FractionalScaleManagerV1>()->fractionalScaleFor(surface(i)); }
+    Viewport *viewport(int i = 0) { return get<Viewporter>()->viewportFor(surface(i)); }
+};
+
+class tst_fractionalscalev1 : public QObject, private FractionalScaleCompositor
+{
+    Q_OBJECT
+private slots:
+    void cleanup() { QTRY_VERIFY2(isClean(), qPrintable(dirtyMessage())); }
+    void integerScaleUntilPreferred();
+    void preferredScale_data();
+    void preferredScale();
+    void changePreferredScale();
+};
+
+void tst_fractionalscalev1::integerScaleUntilPreferred()
+{
+    QRasterWindow window;
+    window.resize(100, 50);
+    window.show();
+    QCOMPOSITOR_TRY_VERIFY(fractionalScale());
+    QCOMPOSITOR_TRY_VERIFY(xdgToplevel() && xdgToplevel()->surface()->m_committed.buffer);
+
+    // No viewport is needed before the compositor has sent a preferred scale
+    QCOMPOSITOR_COMPARE(get<Viewporter>()->m_viewports.size(), 0);
+    QCOMPARE(window.devicePixelRatio(), 1.0);
+}
+
+void tst_fractionalscalev1::preferredScale_data()
+{
+    QTest::addColumn<qreal>("scale");
+
+    QTest::newRow("1.25") << 1.25;
+    QTest::newRow("1.5") << 1.5;
+    QTest::newRow("1.75") << 1.75;
+}
+
+void tst_fractionalscalev1::preferredScale()
+{
+    QFETCH(qreal, scale);
+
+    QRasterWindow window;
+    window.resize(100, 50);
+    window.show();
+    QCOMPOSITOR_TRY_VERIFY(fractionalScale());
+    QCOMPOSITOR_TRY_VERIFY(xdgToplevel());
+
+    exec([=] { fractionalScale()->sendPreferredScale(scale); });
+    QTRY_COMPARE(window.devicePixelRatio(), scale);
+
+    // The buffer has exactly the preferred density, and the viewport maps it to the surface size
+    const QSize surfaceSize = window.frameGeometry().size();
+    QCOMPOSITOR_TRY_VERIFY(viewport());
+    QCOMPOSITOR_TRY_COMPARE(viewport()->m_committed.destination, surfaceSize);
+    QCOMPOSITOR_TRY_COMPARE(xdgToplevel()->surface()->m_committed.buffer->size(), surfaceSize * scale);
+    QCOMPOSITOR_COMPARE(xdgToplevel()->surface()->m_committed.bufferScale, 1);
+}
+
+void tst_fractionalscalev1::changePreferredScale()
+{
+    QRasterWindow window;
+    window.resize(100, 50);
+    window.show();
+    QCOMPOSITOR_TRY_VERIFY(fractionalScale());
+    QCOMPOSITOR_TRY_VERIFY(xdgToplevel());
+    const QSize surfaceSize = window.frameGeometry().size();
+
+    exec([=] { fractionalScale()->sendPreferredScale(1.5); });
+    QCOMPOSITOR_TRY_COMPARE(xdgToplevel()->surface()->m_committed.buffer->size(), surfaceSize * 1.5);
+
+    exec([=] { fractionalScale()->sendPreferredScale(1.25); });
+    QTRY_COMPARE(window.devicePixelRatio(), 1.25);
+    QCOMPOSITOR_TRY_COMPARE(xdgToplevel()->surface()->m_committed.buffer->size(), surfaceSize * 1.25);
+    QCOMPOSITOR_COMPARE(viewport()->m_committed.destination, surfaceSize);
+}
+
+QCOMPOSITOR_TEST_MAIN(tst_fractionalscalev1)
+#include "tst_fractionalscalev1.moc"
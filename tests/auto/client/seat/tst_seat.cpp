@@ -5,6 +5,7 @@
 #include <QtOpenGL/QOpenGLWindow>
 #include <QtGui/QRasterWindow>
 #include <QtGui/QEventPoint>
+#include <QtCore/QThread>
 
 using namespace MockCompositor;
 
@@ -42,6 +43,7 @@ private slots:
     void continuousScroll();
     void wheelDiscreteScroll_data();
     void wheelDiscreteScroll();
+    void motionCoalescedUntilDelivered();
 
     // Touch tests
     void createsTouch();
@@ -384,6 +386,60 @@ void tst_seat::continuousScroll()
     // Sending axis_stop is not mandatory when axis source != finger
 }
 
+class MotionWindow : public QRasterWindow {
+public:
+    MotionWindow()
+    {
+        resize(64, 64);
+        show();
+    }
+    void enterEvent(QEnterEvent *event) override
+    {
+        QRasterWindow::enterEvent(event);
+        ++m_enterCount;
+    }
+    void mouseMoveEvent(QMouseEvent *event) override
+    {
+        QRasterWindow::mouseMoveEvent(event);
+        m_movePositions.append(event->position());
+    }
+    int m_enterCount = 0;
+    QList<QPointF> m_movePositions;
+};
+
+void tst_seat::motionCoalescedUntilDelivered()
+{
+#ifndef TST_SEAT_INPUT_THREAD
+    QSKIP("Motion is only coalesced across frames when it is read on the input thread");
+#endif
+    MotionWindow window;
+    QCOMPOSITOR_TRY_VERIFY(xdgSurface() && xdgSurface()->m_committedConfigureSerial);
+
+    exec([=] {
+        auto *surface = xdgSurface()->m_surface;
+        pointer()->sendEnter(surface, {16, 16});
+        pointer()->sendFrame(surface->resource()->client());
+    });
+    QTRY_COMPARE(window.m_enterCount, 1);
+
+    const int frames = 10;
+    exec([=] {
+        auto *c = client();
+        for (int i = 1; i <= frames; ++i) {
+            pointer()->sendMotion(c, {16.0 + i, 16.0 + i});
+            pointer()->sendFrame(c);
+        }
+    });
+
+    // Keep the GUI thread busy while the input thread reads every frame
+    QThread::msleep(200);
+
+    const QPointF last(16 + frames - window.frameMargins().left(), 16 + frames - window.frameMargins().top());
+    QTRY_VERIFY(!window.m_movePositions.isEmpty());
+    QTRY_COMPARE(window.m_movePositions.last(), last);
+    QVERIFY(window.m_movePositions.size() < frames);
+}
+
 void tst_seat::createsTouch()
 {
     QCOMPOSITOR_TRY_COMPARE(touch()->resourceMap().size(), 1);
@@ -633,5 +689,10 @@ void tst_seat::tapAndMoveInSameFrame()
     QTRY_COMPARE(window.m_events.last().touchPoints.first().state(), QEventPoint::State::Released);
 }
 
+#ifdef TST_SEAT_INPUT_THREAD
+// Needs to be set before the QGuiApplication is created
+[[maybe_unused]] static const bool inputThread = qputenv("QT_WAYLAND_INPUT_THREAD", "1");
+#endif
+
 QCOMPOSITOR_TEST_MAIN(tst_seat)
 #include "tst_seat.moc"
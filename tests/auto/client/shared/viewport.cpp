@@ -0,0 +1,68 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#include "viewport.h"
+
+namespace MockCompositor {
+
+Viewport::Viewport(Viewporter *viewporter, Surface *surface, wl_client *client, int id, int version)
+    : QtWaylandServer::wp_viewport(client, id, version)
+    , m_viewporter(viewporter)
+    , m_surface(surface)
+{
+    connect(surface, &Surface::commit, this, [this] { m_committed = m_pending; });
+}
+
+void Viewport::wp_viewport_destroy_resource(Resource *resource)
+{
+    Q_UNUSED(resource);
+    int removed = m_viewporter->m_viewports.remove(m_surface);
+    Q_ASSERT(removed == 1);
+    delete this;
+}
+
+void Viewport::wp_viewport_destroy(Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
+void Viewport::wp_viewport_set_source(Resource *resource, wl_fixed_t x, wl_fixed_t y, wl_fixed_t width, wl_fixed_t height)
+{
+    Q_UNUSED(resource);
+    const QRectF source(wl_fixed_to_double(x), wl_fixed_to_double(y),
+                        wl_fixed_to_double(width), wl_fixed_to_double(height));
+    if (source == QRectF(-1, -1, -1, -1)) {
+        m_pending.source = QRectF();
+        return;
+    }
+    QVERIFY(source.x() >= 0 && source.y() >= 0);
+    QVERIFY(source.width() > 0 && source.height() > 0);
+    m_pending.source = source;
+}
+
+void Viewport::wp_viewport_set_destination(Resource *resource, int32_t width, int32_t height)
+{
+    Q_UNUSED(resource);
+    if (width == -1 && height == -1) {
+        m_pending.destination = QSize();
+        return;
+    }
+    QVERIFY(width > 0 && height > 0);
+    m_pending.destination = QSize(width, height);
+}
+
+void Viewporter::wp_viewporter_destroy(Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
+void Viewporter::wp_viewporter_get_viewport(Resource *resource, uint32_t id, wl_resource *surface)
+{
+    auto *s = fromResource<Surface>(surface);
+    QVERIFY(s);
+    // Creating a second viewport for the same surface is a protocol error
+    QVERIFY(!viewportFor(s));
+    m_viewports[s] = new Viewport(this, s, resource->client(), id, resource->version());
+}
+
+} // namespace MockCompositor
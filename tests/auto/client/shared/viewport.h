@@ -0,0 +1,54 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#ifndef MOCKCOMPOSITOR_VIEWPORT_H
+#define MOCKCOMPOSITOR_VIEWPORT_H
+
+#include "coreprotocol.h"
+
+#include <qwayland-server-viewporter.h>
+
+namespace MockCompositor {
+
+class Viewporter;
+
+class Viewport : public QObject, public QtWaylandServer::wp_viewport
+{
+    Q_OBJECT
+public:
+    explicit Viewport(Viewporter *viewporter, Surface *surface, wl_client *client, int id, int version);
+
+    Viewporter *m_viewporter = nullptr;
+    Surface *m_surface = nullptr;
+    struct DoubleBufferedState {
+        QRectF source; // invalid means unset
+        QSize destination; // invalid means unset
+    } m_pending, m_committed;
+
+protected:
+    void wp_viewport_destroy_resource(Resource *resource) override;
+    void wp_viewport_destroy(Resource *resource) override;
+    void wp_viewport_set_source(Resource *resource, wl_fixed_t x, wl_fixed_t y, wl_fixed_t width, wl_fixed_t height) override;
+    void wp_viewport_set_destination(Resource *resource, int32_t width, int32_t height) override;
+};
+
+class Viewporter : public Global, public QtWaylandServer::wp_viewporter
+{
+    Q_OBJECT
+public:
+    explicit Viewporter(CoreCompositor *compositor, int version = 1)
+        : QtWaylandServer::wp_viewporter(compositor->m_display, version)
+    {}
+    bool isClean() override { return m_viewports.empty(); }
+    Viewport *viewportFor(Surface *surface) const { return m_viewports.value(surface, nullptr); }
+
+    QMap<Surface *, Viewport *> m_viewports;
+
+protected:
+    void wp_viewporter_destroy(Resource *resource) override;
+    void wp_viewporter_get_viewport(Resource *resource, uint32_t id, wl_resource *surface) override;
+};
+
+} // namespace MockCompositor
+
+#endif // MOCKCOMPOSITOR_VIEWPORT_H
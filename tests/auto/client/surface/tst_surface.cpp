@@ -3,6 +3,7 @@
 
 #include "mockcompositor.h"
 #include <QtGui/QRasterWindow>
+#include <QtWaylandClient/private/qwaylandwindow_p.h>
 #if QT_CONFIG(opengl)
 #include <QtOpenGL/QOpenGLWindow>
 #endif
@@ -16,6 +17,7 @@ private slots:
     void cleanup() { QTRY_VERIFY2(isClean(), qPrintable(dirtyMessage())); }
     void createDestroySurface();
     void waitForFrameCallbackRaster();
+    void waitForFrameSyncWithBlockedMainThread();
 #if QT_CONFIG(opengl)
     void waitForFrameCallbackGl();
 #endif
@@ -71,6 +73,32 @@ void tst_surface::waitForFrameCallbackRaster()
     }
 }
 
+// Render threads dispatch the frame callbacks of their window themselves
+void tst_surface::waitForFrameSyncWithBlockedMainThread()
+{
+    QRasterWindow window;
+    window.resize(40, 40);
+    window.show();
+    QCOMPOSITOR_TRY_VERIFY(xdgToplevel());
+    QSignalSpy bufferSpy(exec([=] { return xdgSurface()->m_surface; }), &Surface::bufferCommitted);
+    exec([=] { xdgToplevel()->sendCompleteConfigure(); });
+    QTRY_COMPARE(bufferSpy.size(), 1);
+
+    xdgPingAndWaitForPong();
+    QCOMPOSITOR_VERIFY(!xdgToplevel()->surface()->m_waitingFrameCallbacks.empty());
+
+    auto *waylandWindow = static_cast<QtWaylandClient::QWaylandWindow *>(window.handle());
+    bool frameSynced = false;
+    QThread *renderThread = QThread::create([&] { frameSynced = waylandWindow->waitForFrameSync(5000); });
+    renderThread->start();
+
+    // Neither call processes events on the main thread
+    exec([&] { xdgToplevel()->surface()->sendFrameCallbacks(); });
+    QVERIFY(renderThread->wait());
+    delete renderThread;
+    QVERIFY(frameSynced);
+}
+
 #if QT_CONFIG(opengl)
 void tst_surface::waitForFrameCallbackGl()
 {
@@ -0,0 +1,125 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#include "texturesharingbatches_p.h"
+
+#include <QtTest/QtTest>
+
+class tst_texturesharing : public QObject
+{
+    Q_OBJECT
+private slots:
+    void batchKeys();
+    void batchSplitsAtMaximumSize();
+    void batchSendsLongKeysSeparately();
+    void batchCompletion();
+    void batchDuplicateKeys();
+};
+
+void tst_texturesharing::batchKeys()
+{
+    const auto split = TextureSharingBatches::split({ QStringLiteral("a"), QStringLiteral("bb"), QStringLiteral("images/c.png") });
+    QCOMPARE(split.batches.size(), 1);
+    QCOMPARE(split.batches.first(), QByteArray("a\0bb\0images/c.png\0", 19));
+    QVERIFY(split.singleKeys.isEmpty());
+
+    QVERIFY(TextureSharingBatches::split({}).batches.isEmpty());
+}
+
+void tst_texturesharing::batchSplitsAtMaximumSize()
+{
+    const qsizetype maxSize = TextureSharingBatches::MaxBatchSize;
+    QCOMPARE(maxSize, 3072);
+
+    // Three keys of 1023 bytes and their terminators fill a batch exactly
+    QStringList keys;
+    for (char c : { 'a', 'b', 'c', 'd' })
+        keys << QString(1023, QLatin1Char(c));
+
+    auto split = TextureSharingBatches::split(keys.mid(0, 3));
+    QCOMPARE(split.batches.size(), 1);
+    QCOMPARE(split.batches.first().size(), maxSize);
+
+    split = TextureSharingBatches::split(keys);
+    QCOMPARE(split.batches.size(), 2);
+    QCOMPARE(split.batches.at(0).size(), maxSize);
+    QCOMPARE(split.batches.at(1), keys.at(3).toUtf8() + '\0');
+
+    // No batch is ever larger than the maximum, and the order is kept
+    keys.clear();
+    for (int i = 0; i < 1000; ++i)
+        keys << QStringLiteral("images/icon-%1.png").arg(i);
+    split = TextureSharingBatches::split(keys);
+    QVERIFY(split.batches.size() > 1);
+    QStringList received;
+    for (const QByteArray &batch : std::as_const(split.batches)) {
+        QVERIFY(batch.size() <= maxSize);
+        QVERIFY(batch.endsWith('\0'));
+        const QList<QByteArray> utf8Keys = batch.chopped(1).split('\0');
+        for (const QByteArray &utf8 : utf8Keys)
+            received << QString::fromUtf8(utf8);
+    }
+    QCOMPARE(received, keys);
+}
+
+void tst_texturesharing::batchSendsLongKeysSeparately()
+{
+    const qsizetype maxSize = TextureSharingBatches::MaxBatchSize;
+
+    // The size is counted in UTF-8 bytes, including the terminator
+    const QString fits(maxSize - 1, QLatin1Char('x'));
+    const QString tooLong(maxSize, QLatin1Char('y'));
+    const QString tooLongUtf8((maxSize + 1) / 2, QChar(0xe9));
+    QCOMPARE(tooLongUtf8.toUtf8().size() + 1, maxSize + 1);
+
+    const auto split = TextureSharingBatches::split({ QStringLiteral("a"), tooLong, fits, tooLongUtf8, QStringLiteral("b") });
+    QCOMPARE(split.singleKeys, (QStringList{ tooLong, tooLongUtf8 }));
+    QCOMPARE(split.batches.size(), 3);
+    QCOMPARE(split.batches.at(0), QByteArray("a\0", 2));
+    QCOMPARE(split.batches.at(1), fits.toUtf8() + '\0');
+    QCOMPARE(split.batches.at(2), QByteArray("b\0", 2));
+}
+
+void tst_texturesharing::batchCompletion()
+{
+    TextureSharingBatches batches;
+    QVERIFY(batches.isEmpty());
+
+    batches.add(1, QByteArray("a\0b\0c\0", 6));
+    batches.add(2, QByteArray("d\0", 2));
+    QVERIFY(!batches.isEmpty());
+
+    batches.replyReceived(QStringLiteral("a"));
+    batches.replyReceived(QStringLiteral("c"));
+    batches.replyReceived(QStringLiteral("unknown"));
+
+    // images_done fails the keys that got no reply
+    QCOMPARE(batches.finish(1), QStringList{ QStringLiteral("b") });
+    QVERIFY(batches.finish(1).isEmpty());
+
+    batches.replyReceived(QStringLiteral("d"));
+    QVERIFY(batches.finish(2).isEmpty());
+    QVERIFY(batches.isEmpty());
+
+    // images_done for a serial that was never sent is ignored
+    QVERIFY(batches.finish(42).isEmpty());
+}
+
+void tst_texturesharing::batchDuplicateKeys()
+{
+    TextureSharingBatches batches;
+
+    // The same key may be requested again in a later batch before the
+    // first reply arrives. Replies come in order, so the first one belongs
+    // to the first batch.
+    batches.add(1, QByteArray("a\0", 2));
+    batches.add(2, QByteArray("a\0b\0", 4));
+
+    batches.replyReceived(QStringLiteral("a"));
+    QVERIFY(batches.finish(1).isEmpty());
+    batches.replyReceived(QStringLiteral("b"));
+    QCOMPARE(batches.finish(2), QStringList{ QStringLiteral("a") });
+}
+
+QTEST_GUILESS_MAIN(tst_texturesharing)
+#include "tst_texturesharing.moc"
@@ -0,0 +1,116 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#include "viewport.h"
+#include "mockcompositor.h"
+
+#include <QtGui/QRasterWindow>
+#include <QtGui/qpa/qplatformnativeinterface.h>
+
+using namespace MockCompositor;
+
+class ViewporterCompositor : public DefaultCompositor {
+public:
+    explicit ViewporterCompositor()
+    {
+        exec([this] {
+            m_config.autoConfigure = true;
+            add<Viewporter>();
+        });
+    }
+    Viewport *viewport(int i = 0) { return get<Viewporter>()->viewportFor(surface(i)); }
+};
+
+class tst_viewporter : public QObject, private ViewporterCompositor
+{
+    Q_OBJECT
+private slots:
+    void cleanup() { QTRY_VERIFY2(isClean(), qPrintable(dirtyMessage())); }
+    void noViewportByDefault();
+    void bufferScale();
+    void sourceCrop();
+    void unsetBufferScale();
+};
+
+static void setWindowProperty(QWindow *window, const QString &name, const QVariant &value)
+{
+    QGuiApplication::platformNativeInterface()->setWindowProperty(window->handle(), name, value);
+}
+
+void tst_viewporter::noViewportByDefault()
+{
+    QRasterWindow window;
+    window.resize(64, 48);
+    window.show();
+    QCOMPOSITOR_TRY_VERIFY(xdgToplevel());
+    QCOMPOSITOR_TRY_VERIFY(xdgToplevel()->surface()->m_committed.buffer);
+
+    QCOMPOSITOR_COMPARE(get<Viewporter>()->m_viewports.size(), 0);
+    QCOMPOSITOR_COMPARE(xdgToplevel()->surface()->m_committed.buffer->size(), window.frameGeometry().size());
+}
+
+void tst_viewporter::bufferScale()
+{
+    QRasterWindow window;
+    window.resize(400, 320);
+    window.create();
+    setWindowProperty(&window, "viewportBufferScale", 0.5);
+    window.show();
+    QCOMPOSITOR_TRY_VERIFY(xdgToplevel());
+    QCOMPOSITOR_TRY_VERIFY(viewport());
+
+    QCOMPARE(window.devicePixelRatio(), 0.5);
+
+    const QSize surfaceSize = window.frameGeometry().size();
+    QCOMPOSITOR_TRY_COMPARE(viewport()->m_committed.destination, surfaceSize);
+    QCOMPOSITOR_TRY_VERIFY(xdgToplevel()->surface()->m_committed.buffer);
+    exec([&] {
+        Surface *s = xdgToplevel()->surface();
+        QCOMPARE(s->m_committed.bufferScale, 1);
+        QCOMPARE(s->m_committed.buffer->size(), surfaceSize * 0.5);
+        QVERIFY(!viewport()->m_committed.source.isValid());
+    });
+
+    window.resize(200, 160);
+    const QSize resizedSurfaceSize = window.frameGeometry().size();
+    QCOMPOSITOR_TRY_COMPARE(viewport()->m_committed.destination, resizedSurfaceSize);
+    QCOMPOSITOR_TRY_COMPARE(xdgToplevel()->surface()->m_committed.buffer->size(), resizedSurfaceSize * 0.5);
+}
+
+void tst_viewporter::sourceCrop()
+{
+    QRasterWindow window;
+    window.resize(400, 320);
+    window.create();
+    setWindowProperty(&window, "viewportBufferScale", 0.5);
+    setWindowProperty(&window, "viewportSource", QRectF(10, 20, 100, 80));
+    window.show();
+    QCOMPOSITOR_TRY_VERIFY(viewport());
+
+    // The source is given in surface coordinates and sent in buffer coordinates
+    QCOMPOSITOR_TRY_COMPARE(viewport()->m_committed.source, QRectF(5, 10, 50, 40));
+    QCOMPOSITOR_TRY_COMPARE(viewport()->m_committed.destination, window.frameGeometry().size());
+
+    setWindowProperty(&window, "viewportSource", QRectF());
+    QCOMPOSITOR_TRY_VERIFY(!viewport()->m_committed.source.isValid());
+}
+
+void tst_viewporter::unsetBufferScale()
+{
+    QRasterWindow window;
+    window.resize(400, 320);
+    window.create();
+    setWindowProperty(&window, "viewportBufferScale", 0.5);
+    window.show();
+    QCOMPOSITOR_TRY_VERIFY(viewport());
+    QCOMPOSITOR_TRY_VERIFY(xdgToplevel()->surface()->m_committed.buffer);
+
+    setWindowProperty(&window, "viewportBufferScale", QVariant());
+    QCOMPOSITOR_TRY_COMPARE(get<Viewporter>()->m_viewports.size(), 0);
+    QCOMPARE(window.devicePixelRatio(), 1.0);
+    window.requestUpdate();
+    QCOMPOSITOR_TRY_COMPARE(xdgToplevel()->surface()->m_committed.buffer->size(), window.frameGeometry().size());
+}
+
+QCOMPOSITOR_TEST_MAIN(tst_viewporter)
+#include "tst_viewporter.moc"
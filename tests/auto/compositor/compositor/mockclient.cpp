@@ -148,6 +148,8 @@ void MockClient::handleGlobal(uint32_t id, const QByteArray &interface)
         wl_output_add_listener(output, &outputListener, this);
     } else if (interface == "wl_shm") {
         shm = static_cast<wl_shm *>(wl_registry_bind(registry, id, &wl_shm_interface, 1));
+    } else if (interface == "wl_data_device_manager") {
+        dataDeviceManager = static_cast<wl_data_device_manager *>(wl_registry_bind(registry, id, &wl_data_device_manager_interface, 1));
     } else if (interface == "wp_viewporter") {
         viewporter = static_cast<wp_viewporter *>(wl_registry_bind(registry, id, &wp_viewporter_interface, 1));
     } else if (interface == "wl_shell") {
@@ -161,6 +163,12 @@ void MockClient::handleGlobal(uint32_t id, const QByteArray &interface)
         m_seats << new MockSeat(s);
     } else if (interface == "zwp_idle_inhibit_manager_v1") {
         idleInhibitManager = static_cast<zwp_idle_inhibit_manager_v1 *>(wl_registry_bind(registry, id, &zwp_idle_inhibit_manager_v1_interface, 1));
+    } else if (interface == "wp_fractional_scale_manager_v1") {
+        fractionalScaleManager = static_cast<wp_fractional_scale_manager_v1 *>(wl_registry_bind(registry, id, &wp_fractional_scale_manager_v1_interface, 1));
+    } else if (interface == "zwlr_screencopy_manager_v1") {
+        screencopyManager = static_cast<zwlr_screencopy_manager_v1 *>(wl_registry_bind(registry, id, &zwlr_screencopy_manager_v1_interface, 3));
+    } else if (interface == "qt_text_input_method_manager_v1") {
+        textInputMethodManager = static_cast<qt_text_input_method_manager_v1 *>(wl_registry_bind(registry, id, &qt_text_input_method_manager_v1_interface, 1));
     } else if (interface == "zxdg_output_manager_v1") {
         xdgOutputManager = new QtWayland::zxdg_output_manager_v1(registry, id, 2);
     }
@@ -254,9 +262,20 @@ ShmBuffer::ShmBuffer(const QSize &size, wl_shm *shm)
     shm_pool = wl_shm_create_pool(shm,fd,alloc);
     handle = wl_shm_pool_create_buffer(shm_pool,0, size.width(), size.height(),
                                    stride, WL_SHM_FORMAT_ARGB8888);
+    wl_buffer_add_listener(handle, &bufferListener, this);
     close(fd);
 }
 
+const wl_buffer_listener ShmBuffer::bufferListener = {
+    ShmBuffer::handleRelease
+};
+
+void ShmBuffer::handleRelease(void *data, wl_buffer *buffer)
+{
+    Q_UNUSED(buffer);
+    static_cast<ShmBuffer *>(data)->releaseCount++;
+}
+
 ShmBuffer::~ShmBuffer()
 {
     munmap(image.bits(), image.sizeInBytes());
@@ -6,6 +6,9 @@
 #include <wayland-ivi-application-client-protocol.h>
 #include "wayland-viewporter-client-protocol.h"
 #include "wayland-idle-inhibit-unstable-v1-client-protocol.h"
+#include "wayland-fractional-scale-v1-client-protocol.h"
+#include "wayland-wlr-screencopy-unstable-v1-client-protocol.h"
+#include "wayland-qt-text-input-method-unstable-v1-client-protocol.h"
 
 #include <QObject>
 #include <QImage>
@@ -27,6 +30,10 @@ public:
     struct wl_buffer *handle = nullptr;
     struct wl_shm_pool *shm_pool = nullptr;
     QImage image;
+    int releaseCount = 0;
+
+    static void handleRelease(void *data, wl_buffer *buffer);
+    static const wl_buffer_listener bufferListener;
 };
 
 class MockClient : public QObject
@@ -50,12 +57,16 @@ public:
     QMap<uint, wl_output *> m_outputs;
     QMap<wl_output *, MockXdgOutputV1 *> m_xdgOutputs;
     wl_shm *shm = nullptr;
+    wl_data_device_manager *dataDeviceManager = nullptr;
     wl_registry *registry = nullptr;
     wl_shell *wlshell = nullptr;
     xdg_wm_base *xdgWmBase = nullptr;
     wp_viewporter *viewporter = nullptr;
     ivi_application *iviApplication = nullptr;
     zwp_idle_inhibit_manager_v1 *idleInhibitManager = nullptr;
+    wp_fractional_scale_manager_v1 *fractionalScaleManager = nullptr;
+    zwlr_screencopy_manager_v1 *screencopyManager = nullptr;
+    qt_text_input_method_manager_v1 *textInputMethodManager = nullptr;
     QtWayland::zxdg_output_manager_v1 *xdgOutputManager = nullptr;
 
     QList<MockSeat *> m_seats;
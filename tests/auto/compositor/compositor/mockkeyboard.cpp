@@ -42,6 +42,7 @@ void keyboardKey(void *keyboard, struct wl_keyboard *wl_keyboard, uint32_t seria
     auto kb = static_cast<MockKeyboard *>(keyboard);
     kb->m_lastKeyCode = key;
     kb->m_lastKeyState = state;
+    kb->m_keyEvents.append({key, state, kb->m_modsDepressed});
 }
 
 void keyboardModifiers(void *keyboard, struct wl_keyboard *wl_keyboard, uint32_t serial, uint32_t mods_depressed, uint32_t mods_latched, uint32_t mods_locked, uint32_t group)
@@ -49,10 +50,10 @@ void keyboardModifiers(void *keyboard, struct wl_keyboard *wl_keyboard, uint32_t
     Q_UNUSED(keyboard);
     Q_UNUSED(wl_keyboard);
     Q_UNUSED(serial);
-    Q_UNUSED(mods_depressed);
     Q_UNUSED(mods_latched);
     Q_UNUSED(mods_locked);
     auto kb = static_cast<MockKeyboard *>(keyboard);
+    kb->m_modsDepressed = mods_depressed;
     kb->m_group = group;
 }
 
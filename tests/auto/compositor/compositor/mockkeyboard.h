@@ -5,6 +5,7 @@
 #define MOCKKEYBOARD_H
 
 #include <QObject>
+#include <QList>
 #include "wayland-wayland-client-protocol.h"
 
 class MockKeyboard : public QObject
@@ -20,6 +21,18 @@ public:
     uint m_lastKeyCode = 0;
     uint m_lastKeyState = 0;
     uint m_group = 0;
+    uint m_modsDepressed = 0;
+
+    struct KeyEvent {
+        uint code;
+        uint state;
+        uint modsDepressed; // when the key event arrived
+        bool operator==(const KeyEvent &other) const
+        {
+            return code == other.code && state == other.state && modsDepressed == other.modsDepressed;
+        }
+    };
+    QList<KeyEvent> m_keyEvents;
 };
 
 #endif // MOCKKEYBOARD_H
@@ -12,7 +12,13 @@
 #include "qwaylandview.h"
 #include "qwaylandbufferref.h"
 #include "qwaylandseat.h"
+#include "qwaylandpointer.h"
 
+#include <QtGui/QPainter>
+#if QT_CONFIG(opengl)
+#include <QtGui/QOffscreenSurface>
+#include <QtGui/QOpenGLContext>
+#endif
 #include <QtGui/QScreen>
 #include <QtWaylandCompositor/QWaylandXdgShell>
 #include <QtWaylandCompositor/private/qwaylandkeyboard_p.h>
@@ -23,14 +29,37 @@
 #include <QtWaylandCompositor/QWaylandKeymap>
 #include <QtWaylandCompositor/QWaylandViewporter>
 #include <QtWaylandCompositor/QWaylandIdleInhibitManagerV1>
+#include <QtWaylandCompositor/QWaylandFractionalScaleManagerV1>
+#include <QtWaylandCompositor/QWaylandScreencopyManagerV1>
 #include <QtWaylandCompositor/QWaylandXdgOutputManagerV1>
+#include <QtWaylandCompositor/QWaylandQtTextInputMethodManager>
+#include <QtWaylandCompositor/QWaylandSurfaceGrabber>
 #include <qwayland-xdg-shell.h>
 #include <qwayland-ivi-application.h>
+#include <QtWaylandCompositor/private/qwaylandbufferref_p.h>
 #include <QtWaylandCompositor/private/qwaylandoutput_p.h>
 #include <QtWaylandCompositor/private/qwaylandsurface_p.h>
-
+#include <QtWaylandCompositor/private/qwaylandsurfacegrabber_p.h>
+#include <QtWaylandCompositor/private/qwlfence_p.h>
+#include <QtWaylandCompositor/private/qwaylandcompositor_p.h>
+#include <QtWaylandCompositor/private/qwaylandseat_p.h>
+#include <QtWaylandCompositor/private/qwaylandqttextinputmethod_p.h>
+#include <QtWaylandCompositor/private/qwldatadevicemanager_p.h>
+#include <QtWaylandCompositor/private/qwltextureatlaspacker_p.h>
+#include <QtWaylandCompositor/private/qwltexturesharingcache_p.h>
+
+#include <QtCore/QMimeData>
+#include <QtCore/QRegularExpression>
+#include <QtCore/QSet>
+#include <QtCore/QThread>
 #include <QtTest/QtTest>
 
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <thread>
+
 class tst_WaylandCompositor : public QObject
 {
     Q_OBJECT
@@ -42,11 +71,16 @@ private slots:
     void simpleKeyboard();
     void keyboardKeymaps();
     void keyboardLayoutSwitching();
+    void keyboardTypeText();
 #endif
     void keyboardGrab();
     void seatCreation();
     void seatKeyboardFocus();
     void seatMouseFocus();
+    void seatMotionCompression();
+    void seatRelease();
+    void retainedSelectionSlowReader();
+    void retainedSelectionBudget();
     void inputRegion();
     void defaultInputRegionHiDpi();
     void singleClient();
@@ -59,6 +93,14 @@ private slots:
     void mapSurface();
     void mapSurfaceHiDpi();
     void frameCallback();
+    void viewAdvance();
+    void viewBufferHandoffStress();
+    void acquireFenceDefersCommit();
+    void releaseFenceSignalled();
+    void shmBufferReleaseAfterCopy_data();
+    void shmBufferReleaseAfterCopy();
+    void streamingGrabber();
+    void streamingGrabberAsynchronousReadback();
     void pixelFormats();
     void outputs();
     void customSurface();
@@ -66,6 +108,7 @@ private slots:
     void advertisesXdgShellSupport();
     void createsXdgSurfaces();
     void reportsXdgSurfaceWindowGeometry();
+    void acquireFenceDefersXdgCommit();
     void setsXdgAppId();
     void sendsXdgConfigure();
 
@@ -88,11 +131,29 @@ private slots:
     void viewportDestinationNoSurfaceError();
     void viewportSourceNoSurfaceError();
     void viewportHiDpi();
+    void viewportDeferredCommit();
 
     void idleInhibit();
 
+    void fractionalScale_data();
+    void fractionalScale();
+    void fractionalScaleFollowsOutput();
+
+    void screencopy();
+
     void xdgOutput();
 
+    void qtTextInputMethodUpdates();
+
+    void textureSharingCacheEviction();
+    void textureSharingCacheProtectedKey();
+    void textureSharingCacheBudget_data();
+    void textureSharingCacheBudget();
+    void textureSharingCacheStatistics();
+    void textureAtlasPacking();
+    void textureAtlasRegions();
+    void textureAtlasGutter();
+
 private:
     QTemporaryDir m_tmpRuntimeDir;
 };
@@ -287,6 +348,55 @@ void tst_WaylandCompositor::keyboardLayoutSwitching()
     QTRY_COMPARE(mockKeyboard->m_lastKeyCode, 44u);
 }
 
+void tst_WaylandCompositor::keyboardTypeText()
+{
+    TestCompositor compositor;
+    compositor.create();
+    QWaylandSeat* seat = compositor.defaultSeat();
+    seat->keymap()->setLayout("us");
+    MockClient client;
+    QTRY_COMPARE(client.m_seats.size(), 1);
+    MockKeyboard *mockKeyboard = client.m_seats.at(0)->keyboard();
+    client.createSurface();
+    QTRY_COMPARE(compositor.surfaces.size(), 1);
+    seat->setKeyboardFocus(compositor.surfaces.at(0));
+
+    using KeyEvent = MockKeyboard::KeyEvent;
+    const uint pressed = WL_KEYBOARD_KEY_STATE_PRESSED;
+    const uint released = WL_KEYBOARD_KEY_STATE_RELEASED;
+    const uint shift = 1; // Shift is the first modifier of the keymap
+    const uint shiftCode = 42, aCode = 30, bCode = 48, oneCode = 2;
+
+    // Shift is held around the characters that need it, and only those
+    QVERIFY(seat->typeText("Ab"));
+    const QList<KeyEvent> typedAb = {
+        { shiftCode, pressed, 0 },
+        { aCode, pressed, shift },
+        { aCode, released, shift },
+        { shiftCode, released, shift },
+        { bCode, pressed, 0 },
+        { bCode, released, 0 },
+    };
+    QTRY_COMPARE(mockKeyboard->m_keyEvents, typedAb);
+    QCOMPARE(mockKeyboard->m_modsDepressed, 0u);
+
+    mockKeyboard->m_keyEvents.clear();
+    QVERIFY(seat->typeText("!a"));
+    const QList<KeyEvent> typedBangA = {
+        { shiftCode, pressed, 0 },
+        { oneCode, pressed, shift },
+        { oneCode, released, shift },
+        { shiftCode, released, shift },
+        { aCode, pressed, 0 },
+        { aCode, released, 0 },
+    };
+    QTRY_COMPARE(mockKeyboard->m_keyEvents, typedBangA);
+    QCOMPARE(mockKeyboard->m_modsDepressed, 0u);
+
+    QVERIFY(!seat->typeText(QString::fromUtf8("\u00e9z")));
+    QTRY_COMPARE(mockKeyboard->m_lastKeyCode, 44u); // z
+}
+
 #endif // QT_CONFIG(xkbcommon)
 
 void tst_WaylandCompositor::keyboardGrab()
@@ -629,6 +739,389 @@ void tst_WaylandCompositor::frameCallback()
     wl_surface_destroy(surface);
 }
 
+void tst_WaylandCompositor::viewAdvance()
+{
+    QWaylandView view;
+    QVERIFY(!view.advance());
+
+    view.bufferCommitted(QWaylandBufferRef(), QRegion(0, 0, 1, 1));
+    QVERIFY(view.currentDamage().isEmpty());
+    QVERIFY(view.advance());
+    QCOMPARE(view.currentDamage(), QRegion(0, 0, 1, 1));
+    QVERIFY(!view.advance());
+    QCOMPARE(view.currentDamage(), QRegion(0, 0, 1, 1));
+
+    // only the latest commit is rendered
+    view.bufferCommitted(QWaylandBufferRef(), QRegion(1, 1, 1, 1));
+    view.bufferCommitted(QWaylandBufferRef(), QRegion(2, 2, 1, 1));
+    QVERIFY(view.advance());
+    QCOMPARE(view.currentDamage(), QRegion(2, 2, 1, 1));
+
+    // a locked buffer stays current
+    view.setBufferLocked(true);
+    view.bufferCommitted(QWaylandBufferRef(), QRegion(3, 3, 1, 1));
+    QVERIFY(!view.advance());
+    QCOMPARE(view.currentDamage(), QRegion(2, 2, 1, 1));
+    view.setBufferLocked(false);
+    QVERIFY(view.advance());
+    QCOMPARE(view.currentDamage(), QRegion(3, 3, 1, 1));
+
+    // A forced advance after discarding the buffer brings back the latest
+    // commit, so that a secondary view which allows discarding its front
+    // buffer does not go blank.
+    TestCompositor compositor;
+    compositor.create();
+    MockClient client;
+    wl_surface *surface = client.createSurface();
+    QTRY_COMPARE(compositor.surfaces.size(), 1);
+    QWaylandSurface *waylandSurface = compositor.surfaces.at(0);
+
+    QWaylandView primary;
+    QWaylandView secondary;
+    primary.setSurface(waylandSurface);
+    secondary.setSurface(waylandSurface);
+    primary.setPrimary();
+    secondary.setAllowDiscardFrontBuffer(true);
+
+    ShmBuffer first(QSize(16, 16), client.shm);
+    first.image.fill(Qt::red);
+    wl_surface_attach(surface, first.handle, 0, 0);
+    wl_surface_damage(surface, 0, 0, 16, 16);
+    wl_surface_commit(surface);
+    QTRY_VERIFY(waylandSurface->hasContent());
+
+    QVERIFY(primary.advance());
+    QVERIFY(secondary.advance());
+    QCOMPARE(secondary.currentBuffer().image(), first.image);
+
+    secondary.discardCurrentBuffer();
+    QVERIFY(!secondary.currentBuffer().hasBuffer());
+    QVERIFY(secondary.advance());
+    QCOMPARE(secondary.currentBuffer().image(), first.image);
+    QVERIFY(!secondary.advance());
+    QCOMPARE(secondary.currentBuffer().image(), first.image);
+
+    // Discarding twice still keeps the latest commit
+    secondary.discardCurrentBuffer();
+    secondary.discardCurrentBuffer();
+    QVERIFY(secondary.advance());
+    QCOMPARE(secondary.currentBuffer().image(), first.image);
+
+    // When the primary view moves on, the secondary one lets go of the old
+    // buffer and picks up the new one on its next advance
+    QSignalSpy damagedSpy(waylandSurface, &QWaylandSurface::damaged);
+    ShmBuffer second(QSize(16, 16), client.shm);
+    second.image.fill(Qt::blue);
+    wl_surface_attach(surface, second.handle, 0, 0);
+    wl_surface_damage(surface, 0, 0, 16, 16);
+    wl_surface_commit(surface);
+    QTRY_COMPARE(damagedSpy.size(), 1);
+    QVERIFY(primary.advance());
+    QCOMPARE(primary.currentBuffer().image(), second.image);
+    QVERIFY(!secondary.currentBuffer().hasBuffer());
+    QVERIFY(secondary.advance());
+    QCOMPARE(secondary.currentBuffer().image(), second.image);
+
+    primary.setSurface(nullptr);
+    secondary.setSurface(nullptr);
+    wl_surface_destroy(surface);
+}
+
+// Commits on this thread while another one advances, the way the threaded
+// scene graph render loop uses the view.
+void tst_WaylandCompositor::viewBufferHandoffStress()
+{
+    QWaylandView view;
+    const int commits = 200000;
+    QAtomicInt done = 0;
+    int lastSeen = -1;
+    int advances = 0;
+    bool consistent = true;
+
+    QScopedPointer<QThread> renderThread(QThread::create([&] {
+        for (;;) {
+            const bool finished = done.loadAcquire();
+            if (view.advance()) {
+                const QRegion damage = view.currentDamage();
+                const int i = damage.boundingRect().x();
+                // states must come in order and never be torn
+                if (i < lastSeen || damage != QRegion(i, i, 1, 1))
+                    consistent = false;
+                lastSeen = i;
+                ++advances;
+            }
+            if (finished)
+                break;
+        }
+    }));
+    renderThread->start();
+
+    for (int i = 0; i < commits; ++i)
+        view.bufferCommitted(QWaylandBufferRef(), QRegion(i, i, 1, 1));
+    done.storeRelease(1);
+
+    QVERIFY(renderThread->wait());
+    QVERIFY(consistent);
+    QVERIFY(advances > 0);
+    QCOMPARE(lastSeen, commits - 1);
+}
+
+void tst_WaylandCompositor::acquireFenceDefersCommit()
+{
+    TestCompositor compositor;
+    compositor.create();
+
+    MockClient client;
+
+    wl_surface *surface = client.createSurface();
+    QTRY_COMPARE(compositor.surfaces.size(), 1);
+    QWaylandSurface *waylandSurface = compositor.surfaces.at(0);
+    auto *surfacePrivate = QWaylandSurfacePrivate::get(waylandSurface);
+
+    QSignalSpy damagedSpy(waylandSurface, &QWaylandSurface::damaged);
+
+    auto fence = QSharedPointer<QtWayland::SoftwareFence>::create();
+    QVERIFY(fence->isValid());
+    QVERIFY(!fence->isSignaled());
+    surfacePrivate->setAcquireFence(fence);
+
+    QSize size(32, 32);
+    ShmBuffer buffer(size, client.shm);
+    wl_surface_attach(surface, buffer.handle, 0, 0);
+    wl_surface_damage(surface, 0, 0, size.width(), size.height());
+    wl_surface_commit(surface);
+    QTRY_VERIFY(surfacePrivate->hasDeferredCommits());
+    QVERIFY(!waylandSurface->hasContent());
+
+    // a commit without a fence still has to wait for the one before it
+    wl_surface_damage(surface, 0, 0, 1, 1);
+    wl_surface_commit(surface);
+    QTest::qWait(50);
+    QVERIFY(!waylandSurface->hasContent());
+    QCOMPARE(damagedSpy.size(), 0);
+
+    fence->signal();
+    QTRY_VERIFY(waylandSurface->hasContent());
+    QTRY_COMPARE(damagedSpy.size(), 2);
+    QCOMPARE(damagedSpy.at(0).at(0).value<QRegion>(), QRegion(0, 0, 32, 32));
+    QCOMPARE(damagedSpy.at(1).at(0).value<QRegion>(), QRegion(0, 0, 1, 1));
+    QVERIFY(!surfacePrivate->hasDeferredCommits());
+
+    wl_surface_destroy(surface);
+}
+
+void tst_WaylandCompositor::releaseFenceSignalled()
+{
+    TestCompositor compositor;
+    compositor.create();
+    compositor.setRetainSharedMemoryBuffers(true);
+
+    MockClient client;
+
+    wl_surface *surface = client.createSurface();
+    QTRY_COMPARE(compositor.surfaces.size(), 1);
+    QWaylandSurface *waylandSurface = compositor.surfaces.at(0);
+    auto *surfacePrivate = QWaylandSurfacePrivate::get(waylandSurface);
+
+    auto fence = QSharedPointer<QtWayland::SoftwareFence>::create();
+    surfacePrivate->setReleaseFence(fence);
+
+    QSize size(32, 32);
+    ShmBuffer first(size, client.shm);
+    wl_surface_attach(surface, first.handle, 0, 0);
+    wl_surface_commit(surface);
+    QTRY_VERIFY(waylandSurface->hasContent());
+    QVERIFY(!fence->isSignaled());
+
+    // the compositor is done with the first buffer once it is replaced
+    ShmBuffer second(size, client.shm);
+    wl_surface_attach(surface, second.handle, 0, 0);
+    wl_surface_commit(surface);
+    QTRY_VERIFY(fence->isSignaled());
+
+    wl_surface_destroy(surface);
+}
+
+void tst_WaylandCompositor::shmBufferReleaseAfterCopy_data()
+{
+    QTest::addColumn<bool>("retain");
+
+    QTest::newRow("release") << false;
+    QTest::newRow("retain") << true;
+}
+
+void tst_WaylandCompositor::shmBufferReleaseAfterCopy()
+{
+    QFETCH(bool, retain);
+
+    TestCompositor compositor;
+    compositor.create();
+    compositor.setRetainSharedMemoryBuffers(retain);
+
+    MockClient client;
+
+    wl_surface *surface = client.createSurface();
+    QTRY_COMPARE(compositor.surfaces.size(), 1);
+    QWaylandSurface *waylandSurface = compositor.surfaces.at(0);
+
+    QWaylandView view;
+    view.setSurface(waylandSurface);
+
+    QSize size(32, 32);
+    ShmBuffer first(size, client.shm);
+    wl_surface_attach(surface, first.handle, 0, 0);
+    wl_surface_commit(surface);
+    QTRY_VERIFY(waylandSurface->hasContent());
+    QVERIFY(view.advance());
+
+    // what the texture provider does once it has its own copy of the pixels
+    QWaylandBufferRef ref = view.currentBuffer();
+    QVERIFY(ref.isSharedMemory());
+    QtWayland::ClientBuffer *clientBuffer = QWaylandBufferRefPrivate::get(ref);
+    clientBuffer->contentsCopied();
+    QCOMPARE(clientBuffer->isCommitted(), retain);
+    compositor.flushClients();
+    if (!retain)
+        QTRY_COMPARE(first.releaseCount, 1);
+
+    // a retained buffer is released once a newer one replaces it
+    QSignalSpy redrawSpy(waylandSurface, &QWaylandSurface::redraw);
+    ShmBuffer second(size, client.shm);
+    wl_surface_attach(surface, second.handle, 0, 0);
+    wl_surface_commit(surface);
+    QTRY_COMPARE(redrawSpy.size(), 1);
+    QVERIFY(view.advance());
+    ref = QWaylandBufferRef();
+    compositor.flushClients();
+    QTRY_COMPARE(first.releaseCount, 1);
+    QCOMPARE(second.releaseCount, 0);
+
+    wl_surface_destroy(surface);
+}
+
+void tst_WaylandCompositor::streamingGrabber()
+{
+    TestCompositor compositor;
+    compositor.create();
+
+    MockClient client;
+
+    wl_surface *surface = client.createSurface();
+    QTRY_COMPARE(compositor.surfaces.size(), 1);
+    QWaylandSurface *waylandSurface = compositor.surfaces.at(0);
+    QSignalSpy damagedSpy(waylandSurface, &QWaylandSurface::damaged);
+
+    QSize size(32, 32);
+    ShmBuffer buffer(size, client.shm);
+    buffer.image.fill(Qt::red);
+    wl_surface_attach(surface, buffer.handle, 0, 0);
+    wl_surface_damage(surface, 0, 0, size.width(), size.height());
+    wl_surface_commit(surface);
+    QTRY_COMPARE(damagedSpy.size(), 1);
+
+    QWaylandSurfaceGrabber grabber(waylandSurface);
+    grabber.setStreaming(true);
+    QVERIFY(grabber.isStreaming());
+    QSignalSpy successSpy(&grabber, &QWaylandSurfaceGrabber::success);
+    QSignalSpy frameSpy(&grabber, &QWaylandSurfaceGrabber::frameReady);
+
+    // the first frame is complete
+    grabber.grab();
+    QTRY_COMPARE(frameSpy.size(), 1);
+    QCOMPARE(frameSpy.at(0).at(1).value<QRegion>(), QRegion(0, 0, 32, 32));
+    QCOMPARE(frameSpy.at(0).at(0).value<QImage>().pixelColor(20, 20), QColor(Qt::red));
+
+    // only damaged parts are updated
+    buffer.image.fill(Qt::blue);
+    wl_surface_attach(surface, buffer.handle, 0, 0);
+    wl_surface_damage(surface, 0, 0, 4, 4);
+    wl_surface_commit(surface);
+    QTRY_COMPARE(damagedSpy.size(), 2);
+
+    grabber.grab();
+    QTRY_COMPARE(frameSpy.size(), 2);
+    QCOMPARE(frameSpy.at(1).at(1).value<QRegion>(), QRegion(0, 0, 4, 4));
+    const QImage frame = frameSpy.at(1).at(0).value<QImage>();
+    QCOMPARE(frame.pixelColor(1, 1), QColor(Qt::blue));
+    QCOMPARE(frame.pixelColor(20, 20), QColor(Qt::red));
+    QCOMPARE(successSpy.size(), 0);
+
+    wl_surface_destroy(surface);
+}
+
+void tst_WaylandCompositor::streamingGrabberAsynchronousReadback()
+{
+#if QT_CONFIG(opengl)
+    QOffscreenSurface offscreenSurface;
+    offscreenSurface.create();
+    QScopedPointer<QOpenGLContext> context(new QOpenGLContext);
+    if (!context->create() || !context->makeCurrent(&offscreenSurface))
+        QSKIP("No OpenGL context available");
+
+    TestCompositor compositor;
+    compositor.create();
+
+    MockClient client;
+
+    wl_surface *surface = client.createSurface();
+    QTRY_COMPARE(compositor.surfaces.size(), 1);
+    QWaylandSurface *waylandSurface = compositor.surfaces.at(0);
+    auto *surfacePrivate = QWaylandSurfacePrivate::get(waylandSurface);
+    QSignalSpy damagedSpy(waylandSurface, &QWaylandSurface::damaged);
+
+    QSize size(32, 32);
+    ShmBuffer first(size, client.shm);
+    first.image.fill(Qt::red);
+    wl_surface_attach(surface, first.handle, 0, 0);
+    wl_surface_damage(surface, 0, 0, size.width(), size.height());
+    wl_surface_commit(surface);
+    QTRY_COMPARE(damagedSpy.size(), 1);
+
+    QWaylandSurfaceGrabberReadback readback;
+    QVERIFY(readback.start(surfacePrivate->bufferRef, QRegion(0, 0, 32, 32)));
+    if (!readback.isAsynchronous())
+        QSKIP("No pixel buffer objects or fence syncs");
+    QVERIFY(readback.hasPendingTransfers());
+    QVERIFY(!readback.isFull());
+
+    // The next grab starts while the first one may still be in flight, and
+    // its frame comes out first
+    ShmBuffer second(size, client.shm);
+    second.image.fill(Qt::blue);
+    wl_surface_attach(surface, second.handle, 0, 0);
+    wl_surface_damage(surface, 0, 0, 4, 4);
+    wl_surface_commit(surface);
+    QTRY_COMPARE(damagedSpy.size(), 2);
+
+    QVERIFY(readback.start(surfacePrivate->bufferRef, QRegion(0, 0, 4, 4)));
+    QVERIFY(readback.isFull());
+
+    QWaylandSurfaceGrabberReadback::Result result;
+    QVERIFY(readback.takeResult(&result, true));
+    QCOMPARE(result.damage, QRegion(0, 0, 32, 32));
+    QCOMPARE(result.rect, QRect(0, 0, 32, 32));
+    QCOMPARE(result.size, size);
+    QCOMPARE(result.pixels.pixelColor(0, 0), QColor(Qt::red));
+
+    QVERIFY(readback.takeResult(&result, true));
+    QCOMPARE(result.damage, QRegion(0, 0, 4, 4));
+    QCOMPARE(result.rect, QRect(0, 0, 4, 4));
+    QCOMPARE(result.pixels.pixelColor(0, 0), QColor(Qt::blue));
+    QVERIFY(!readback.hasPendingTransfers());
+    QVERIFY(!readback.takeResult(&result, false));
+
+    // A context that goes away takes the transfers in flight with it
+    QVERIFY(readback.start(surfacePrivate->bufferRef, QRegion(0, 0, 4, 4)));
+    QVERIFY(readback.hasPendingTransfers());
+    context.reset();
+    QVERIFY(!readback.hasPendingTransfers());
+
+    wl_surface_destroy(surface);
+#else
+    QSKIP("Built without OpenGL support");
+#endif
+}
+
 void tst_WaylandCompositor::pixelFormats()
 {
     TestCompositor compositor;
@@ -847,6 +1340,372 @@ void tst_WaylandCompositor::seatMouseFocus()
     delete view;
 }
 
+void tst_WaylandCompositor::seatMotionCompression()
+{
+    TestCompositor compositor(true);
+    compositor.create();
+
+    MockClient client;
+    wl_surface *surface = client.createSurface();
+    QTRY_COMPARE(compositor.surfaces.size(), 1);
+
+    QWaylandSurface *waylandSurface = compositor.surfaces.at(0);
+    QWaylandView view;
+    view.setSurface(waylandSurface);
+
+    QWaylandSeat *seat = compositor.defaultSeat();
+    QWaylandPointer *pointer = seat->pointer();
+    QVERIFY(pointer);
+    QSignalSpy compressionSpy(pointer, &QWaylandPointer::motionCompressionEnabledChanged);
+    pointer->setMotionCompressionEnabled(true);
+    QCOMPARE(compressionSpy.size(), 1);
+
+    QTRY_COMPARE(client.m_seats.size(), 1);
+    MockPointer *mockPointer = client.m_seats.first()->pointer();
+    seat->sendMouseMoveEvent(&view, QPointF(1, 1));
+    QCOMPARE(mockPointer->m_motionCount, 0);
+    compositor.defaultOutput()->sendFrameCallbacks();
+    QTRY_COMPARE(mockPointer->m_enteredSurface, surface);
+    QTRY_COMPARE(mockPointer->m_motionCount, 1);
+
+    // Only the latest position is sent once the output shows a frame
+    const int motionCount = mockPointer->m_motionCount;
+    for (int i = 2; i <= 10; ++i)
+        seat->sendMouseMoveEvent(&view, QPointF(i, i));
+    compositor.defaultOutput()->sendFrameCallbacks();
+    QTRY_COMPARE(mockPointer->m_motionCount, motionCount + 1);
+    QCOMPARE(mockPointer->m_position, QPointF(10, 10));
+
+    // Pending motion goes out before buttons
+    seat->sendMouseMoveEvent(&view, QPointF(20, 20));
+    seat->sendMousePressEvent(Qt::LeftButton);
+    seat->sendMouseReleaseEvent(Qt::LeftButton);
+    compositor.flushClients();
+    QTRY_COMPARE(mockPointer->m_motionCount, motionCount + 2);
+    QCOMPARE(mockPointer->m_position, QPointF(20, 20));
+
+    // Without frames the motion is sent after the refresh interval of the output
+    seat->sendMouseMoveEvent(&view, QPointF(30, 30));
+    seat->sendMouseMoveEvent(&view, QPointF(31, 31));
+    QTRY_COMPARE(mockPointer->m_motionCount, motionCount + 3);
+    QCOMPARE(mockPointer->m_position, QPointF(31, 31));
+
+    pointer->setMotionCompressionEnabled(false);
+    seat->sendMouseMoveEvent(&view, QPointF(40, 40));
+    seat->sendMouseMoveEvent(&view, QPointF(41, 41));
+    compositor.flushClients();
+    QTRY_COMPARE(mockPointer->m_motionCount, motionCount + 5);
+
+    wl_surface_destroy(surface);
+    QTRY_VERIFY(!seat->mouseFocus());
+}
+
+struct SelectionEvents
+{
+    wl_data_offer *offer = nullptr;
+    QStringList mimeTypes;
+};
+
+static const wl_data_offer_listener selectionOfferListener = {
+    [](void *data, wl_data_offer *, const char *mimeType) {
+        static_cast<SelectionEvents *>(data)->mimeTypes.append(QString::fromLatin1(mimeType));
+    },
+    [](void *, wl_data_offer *, uint32_t) {},
+    [](void *, wl_data_offer *, uint32_t) {}
+};
+
+static const wl_data_device_listener selectionDataDeviceListener = {
+    [](void *data, wl_data_device *, wl_data_offer *offer) {
+        static_cast<SelectionEvents *>(data)->mimeTypes.clear();
+        wl_data_offer_add_listener(offer, &selectionOfferListener, data);
+    },
+    [](void *, wl_data_device *, uint32_t, wl_surface *, wl_fixed_t, wl_fixed_t, wl_data_offer *) {},
+    [](void *, wl_data_device *) {},
+    [](void *, wl_data_device *, uint32_t, wl_fixed_t, wl_fixed_t) {},
+    [](void *, wl_data_device *) {},
+    [](void *data, wl_data_device *, wl_data_offer *offer) {
+        static_cast<SelectionEvents *>(data)->offer = offer;
+    }
+};
+
+void tst_WaylandCompositor::retainedSelectionSlowReader()
+{
+    TestCompositor compositor(true);
+    compositor.create();
+
+    MockClient client;
+    QTRY_VERIFY(client.dataDeviceManager);
+    QTRY_COMPARE(client.m_seats.size(), 1);
+    client.createSurface();
+    QTRY_COMPARE(compositor.surfaces.size(), 1);
+
+    SelectionEvents selection;
+    wl_data_device *dataDevice = wl_data_device_manager_get_data_device(client.dataDeviceManager,
+                                                                        client.m_seats.first()->m_seat);
+    wl_data_device_add_listener(dataDevice, &selectionDataDeviceListener, &selection);
+    QWaylandSeat *seat = compositor.defaultSeat();
+    QTRY_VERIFY(QWaylandSeatPrivate::get(seat)->dataDevice());
+    seat->setKeyboardFocus(compositor.surfaces.at(0));
+
+    // Many times what fits into a pipe
+    QByteArray content(8 * 1024 * 1024, Qt::Uninitialized);
+    for (qsizetype i = 0; i < content.size(); ++i)
+        content[i] = char(i % 251);
+    QMimeData mimeData;
+    mimeData.setData(QStringLiteral("application/octet-stream"), content);
+    compositor.overrideSelection(&mimeData);
+    QTRY_VERIFY(selection.offer);
+    QCOMPARE(selection.mimeTypes, QStringList(QStringLiteral("application/octet-stream")));
+
+    // The compositor and the client share this thread, writing to the
+    // pipe must not block until everything was read
+    int fds[2];
+    QCOMPARE(pipe(fds), 0);
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL, 0) | O_NONBLOCK);
+    wl_data_offer_receive(selection.offer, "application/octet-stream", fds[1]);
+    wl_display_flush(client.display);
+    close(fds[1]);
+
+    QByteArray received;
+    QElapsedTimer elapsed;
+    elapsed.start();
+    char buffer[16 * 1024];
+    for (;;) {
+        QTest::qWait(1);
+        const ssize_t n = read(fds[0], buffer, sizeof(buffer));
+        if (n == 0)
+            break;
+        if (n > 0)
+            received.append(buffer, n);
+        QVERIFY(elapsed.elapsed() < 60000);
+    }
+    close(fds[0]);
+    QCOMPARE(received.size(), content.size());
+    QVERIFY(received == content);
+
+    // A client that stops reading is cut off
+    QtWayland::DataDeviceManager *manager = QWaylandCompositorPrivate::get(&compositor)->dataDeviceManager();
+    manager->setRetainedSelectionWriteTimeout(100);
+    QCOMPARE(pipe(fds), 0);
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL, 0) | O_NONBLOCK);
+    wl_data_offer_receive(selection.offer, "application/octet-stream", fds[1]);
+    wl_display_flush(client.display);
+    close(fds[1]);
+
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression(QStringLiteral("stopped reading the selection")));
+    QTest::qWait(500);
+    received.clear();
+    for (;;) {
+        const ssize_t n = read(fds[0], buffer, sizeof(buffer));
+        QVERIFY(n >= 0);
+        if (n == 0)
+            break;
+        received.append(buffer, n);
+    }
+    close(fds[0]);
+    QVERIFY(received.size() > 0);
+    QVERIFY(received.size() < content.size());
+
+    // A client that closes its end in the middle of the transfer ends it,
+    // neither SIGPIPE nor the timeout hit
+    QTest::failOnWarning(QRegularExpression(QStringLiteral("stopped reading the selection")));
+    QCOMPARE(pipe(fds), 0);
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL, 0) | O_NONBLOCK);
+    wl_data_offer_receive(selection.offer, "application/octet-stream", fds[1]);
+    wl_display_flush(client.display);
+    close(fds[1]);
+
+    received.clear();
+    elapsed.restart();
+    while (received.isEmpty()) {
+        QTest::qWait(1);
+        const ssize_t n = read(fds[0], buffer, sizeof(buffer));
+        QVERIFY(n != 0);
+        if (n > 0)
+            received.append(buffer, n);
+        QVERIFY(elapsed.elapsed() < 60000);
+    }
+    close(fds[0]);
+    QTest::qWait(500);
+
+    wl_data_offer_destroy(selection.offer);
+    wl_data_device_destroy(dataDevice);
+}
+
+class RetainedSelectionCompositor : public TestCompositor
+{
+    Q_OBJECT
+public:
+    RetainedSelectionCompositor() : TestCompositor(true) { setRetainedSelectionEnabled(true); }
+
+    int retainedCount = 0;
+    QStringList retainedFormats;
+    QHash<QString, QByteArray> retainedData;
+
+protected:
+    void retainedSelectionReceived(QMimeData *mimeData) override
+    {
+        retainedFormats = mimeData->formats();
+        for (const QString &format : std::as_const(retainedFormats))
+            retainedData.insert(format, mimeData->data(format));
+        ++retainedCount;
+    }
+};
+
+struct SelectionSource
+{
+    ~SelectionSource()
+    {
+        for (std::thread &writer : writers)
+            writer.join();
+    }
+
+    QHash<QString, QByteArray> data;
+    std::vector<std::thread> writers;
+};
+
+static const wl_data_source_listener selectionSourceListener = {
+    [](void *, wl_data_source *, const char *) {},
+    [](void *data, wl_data_source *, const char *mimeType, int32_t fd) {
+        // The compositor reads in the same thread
+        auto *source = static_cast<SelectionSource *>(data);
+        const QByteArray content = source->data.value(QString::fromLatin1(mimeType));
+        source->writers.emplace_back([fd, content]() {
+            qsizetype offset = 0;
+            while (offset < content.size()) {
+                const ssize_t n = write(fd, content.constData() + offset, content.size() - offset);
+                if (n <= 0)
+                    break;
+                offset += n;
+            }
+            close(fd);
+        });
+    },
+    [](void *, wl_data_source *) {},
+    [](void *, wl_data_source *) {},
+    [](void *, wl_data_source *) {},
+    [](void *, wl_data_source *, uint32_t) {}
+};
+
+static QByteArray makeSelectionData(qsizetype size, int seed)
+{
+    QByteArray data(size, Qt::Uninitialized);
+    for (qsizetype i = 0; i < size; ++i)
+        data[i] = char((i + seed) % 251);
+    return data;
+}
+
+void tst_WaylandCompositor::retainedSelectionBudget()
+{
+    RetainedSelectionCompositor compositor;
+    compositor.create();
+    QCOMPARE(compositor.retainedSelectionMaximumTypeSize(), qint64(0));
+    compositor.setRetainedSelectionMaximumTypeSize(2 * 1024 * 1024);
+
+    MockClient client;
+    QTRY_VERIFY(client.dataDeviceManager);
+    QTRY_COMPARE(client.m_seats.size(), 1);
+    client.createSurface();
+    QTRY_COMPARE(compositor.surfaces.size(), 1);
+
+    SelectionEvents selection;
+    wl_data_device *dataDevice = wl_data_device_manager_get_data_device(client.dataDeviceManager,
+                                                                        client.m_seats.first()->m_seat);
+    wl_data_device_add_listener(dataDevice, &selectionDataDeviceListener, &selection);
+
+    SelectionSource source;
+    source.data.insert(QStringLiteral("image/png"), makeSelectionData(3 * 1024 * 1024, 1));
+    source.data.insert(QStringLiteral("application/octet-stream"), makeSelectionData(1024 * 1024, 2));
+    source.data.insert(QStringLiteral("text/plain"), QByteArrayLiteral("retained"));
+    wl_data_source *dataSource = wl_data_device_manager_create_data_source(client.dataDeviceManager);
+    wl_data_source_add_listener(dataSource, &selectionSourceListener, &source);
+    wl_data_source_offer(dataSource, "image/png");
+    wl_data_source_offer(dataSource, "application/octet-stream");
+    wl_data_source_offer(dataSource, "text/plain");
+
+    // The image is over the budget for a single type, and the text is read first
+    QTest::ignoreMessage(QtWarningMsg, "Clipboard: Not retaining image/png, it exceeds the size limit");
+    wl_data_device_set_selection(dataDevice, dataSource, 0);
+    QTRY_COMPARE(compositor.retainedCount, 1);
+    QCOMPARE(compositor.retainedFormats, QStringList({ QStringLiteral("text/plain"),
+                                                       QStringLiteral("application/octet-stream") }));
+    QCOMPARE(compositor.retainedData.value(QStringLiteral("text/plain")), QByteArrayLiteral("retained"));
+    QVERIFY(compositor.retainedData.value(QStringLiteral("application/octet-stream"))
+            == source.data.value(QStringLiteral("application/octet-stream")));
+
+    // The selection can still be pasted once its source is gone
+    wl_data_source_destroy(dataSource);
+    compositor.defaultSeat()->setKeyboardFocus(compositor.surfaces.at(0));
+    compositor.surfaces.at(0)->updateSelection();
+    QTRY_COMPARE(selection.mimeTypes.size(), 2);
+
+    int fds[2];
+    QCOMPARE(pipe(fds), 0);
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL, 0) | O_NONBLOCK);
+    wl_data_offer_receive(selection.offer, "application/octet-stream", fds[1]);
+    wl_display_flush(client.display);
+    close(fds[1]);
+
+    QByteArray received;
+    QElapsedTimer elapsed;
+    elapsed.start();
+    char buffer[16 * 1024];
+    for (;;) {
+        QTest::qWait(1);
+        const ssize_t n = read(fds[0], buffer, sizeof(buffer));
+        if (n == 0)
+            break;
+        if (n > 0)
+            received.append(buffer, n);
+        QVERIFY(elapsed.elapsed() < 60000);
+    }
+    close(fds[0]);
+    QVERIFY(received == source.data.value(QStringLiteral("application/octet-stream")));
+
+    wl_data_offer_destroy(selection.offer);
+    wl_data_device_destroy(dataDevice);
+}
+
+void tst_WaylandCompositor::seatRelease()
+{
+    TestCompositor compositor(true);
+    compositor.create();
+
+    MockClient client;
+    QTRY_COMPARE(client.m_seats.size(), 1);
+    auto *seatPrivate = QWaylandSeatPrivate::get(compositor.defaultSeat());
+    QTRY_COMPARE(seatPrivate->resourceMap().size(), 1);
+
+    struct SeatGlobal {
+        uint32_t name = 0;
+        uint32_t version = 0;
+    } seatGlobal;
+    static const wl_registry_listener registryListener = {
+        [](void *data, wl_registry *, uint32_t name, const char *interface, uint32_t version) {
+            if (qstrcmp(interface, "wl_seat") == 0)
+                *static_cast<SeatGlobal *>(data) = { name, version };
+        },
+        [](void *, wl_registry *, uint32_t) {}
+    };
+    wl_registry *registry = wl_display_get_registry(client.display);
+    wl_registry_add_listener(registry, &registryListener, &seatGlobal);
+    wl_display_flush(client.display);
+    QTRY_VERIFY(seatGlobal.name);
+    QVERIFY(seatGlobal.version >= 5);
+
+    auto *seat = static_cast<wl_seat *>(wl_registry_bind(registry, seatGlobal.name, &wl_seat_interface, 5));
+    wl_display_flush(client.display);
+    QTRY_COMPARE(seatPrivate->resourceMap().size(), 2);
+
+    // wl_seat.release is a destructor since version 5
+    wl_seat_release(seat);
+    wl_display_flush(client.display);
+    QTRY_COMPARE(seatPrivate->resourceMap().size(), 1);
+    QCOMPARE(client.error, 0);
+
+    wl_registry_destroy(registry);
+}
+
 void tst_WaylandCompositor::inputRegion()
 {
     TestCompositor compositor(true);
@@ -1011,6 +1870,57 @@ void tst_WaylandCompositor::reportsXdgSurfaceWindowGeometry()
     wl_surface_destroy(surface);
 }
 
+void tst_WaylandCompositor::acquireFenceDefersXdgCommit()
+{
+    XdgTestCompositor compositor;
+    compositor.create();
+
+    QWaylandXdgSurface *xdgSurface = nullptr;
+    QObject::connect(&compositor.xdgShell, &QWaylandXdgShell::xdgSurfaceCreated, [&](QWaylandXdgSurface *s) {
+        xdgSurface = s;
+    });
+
+    MockClient client;
+    wl_surface *surface = client.createSurface();
+    xdg_surface *clientXdgSurface = client.createXdgSurface(surface);
+    xdg_toplevel *clientToplevel = client.createXdgToplevel(clientXdgSurface);
+    QTRY_VERIFY(xdgSurface);
+
+    QWaylandSurface *waylandSurface = xdgSurface->surface();
+    auto *surfacePrivate = QWaylandSurfacePrivate::get(waylandSurface);
+    const QRect initialGeometry = xdgSurface->windowGeometry();
+    QSignalSpy geometrySpy(xdgSurface, &QWaylandXdgSurface::windowGeometryChanged);
+
+    auto fence = QSharedPointer<QtWayland::SoftwareFence>::create();
+    surfacePrivate->setAcquireFence(fence);
+
+    ShmBuffer first(QSize(64, 64), client.shm);
+    wl_surface_attach(surface, first.handle, 0, 0);
+    wl_surface_damage(surface, 0, 0, 64, 64);
+    wl_surface_commit(surface);
+    QTRY_VERIFY(surfacePrivate->hasDeferredCommits());
+
+    // the role only sees the new size once the commits are applied, in order
+    ShmBuffer second(QSize(32, 32), client.shm);
+    wl_surface_attach(surface, second.handle, 0, 0);
+    wl_surface_damage(surface, 0, 0, 32, 32);
+    wl_surface_commit(surface);
+    QTest::qWait(50);
+    QCOMPARE(xdgSurface->windowGeometry(), initialGeometry);
+    QCOMPARE(geometrySpy.size(), 0);
+    QVERIFY(!waylandSurface->hasContent());
+
+    fence->signal();
+    QTRY_COMPARE(xdgSurface->windowGeometry(), QRect(0, 0, 32, 32));
+    QCOMPARE(geometrySpy.size(), 2);
+    QCOMPARE(waylandSurface->bufferSize(), QSize(32, 32));
+    QVERIFY(!surfacePrivate->hasDeferredCommits());
+
+    xdg_toplevel_destroy(clientToplevel);
+    xdg_surface_destroy(clientXdgSurface);
+    wl_surface_destroy(surface);
+}
+
 void tst_WaylandCompositor::setsXdgAppId()
 {
     XdgTestCompositor compositor;
@@ -1696,6 +2606,52 @@ void tst_WaylandCompositor::viewportHiDpi()
     wl_surface_destroy(surface);
 }
 
+// A commit that waits for its acquire fence must be checked against its own
+// viewport state, not against what the client has sent since.
+void tst_WaylandCompositor::viewportDeferredCommit()
+{
+    ViewporterTestCompositor compositor;
+    compositor.create();
+    MockClient client;
+    QTRY_VERIFY(client.viewporter);
+
+    wl_surface *surface = client.createSurface();
+    QTRY_COMPARE(compositor.surfaces.size(), 1);
+    QWaylandSurface *waylandSurface = compositor.surfaces.at(0);
+    auto *surfacePrivate = QWaylandSurfacePrivate::get(waylandSurface);
+
+    auto fence = QSharedPointer<QtWayland::SoftwareFence>::create();
+    QVERIFY(fence->isValid());
+    surfacePrivate->setAcquireFence(fence);
+
+    const QSize bufferSize(64, 64);
+    ShmBuffer buffer(bufferSize, client.shm);
+    wl_surface_attach(surface, buffer.handle, 0, 0);
+    wl_surface_damage(surface, 0, 0, bufferSize.width(), bufferSize.height());
+    wp_viewport *viewport = wp_viewporter_get_viewport(client.viewporter, surface);
+    const QRectF sourceGeometry(0, 0, 32, 32);
+    wp_viewport_set_source(viewport, 0, 0, wl_fixed_from_int(32), wl_fixed_from_int(32));
+    wl_surface_commit(surface);
+    QTRY_VERIFY(surfacePrivate->hasDeferredCommits());
+
+    // Not committed yet, would be out of the buffer and have a non-integer
+    // size without a destination
+    const QRectF nextSource(0, 0, 1000.5, 1000.5);
+    wp_viewport_set_source(viewport, 0, 0,
+                           wl_fixed_from_double(nextSource.width()),
+                           wl_fixed_from_double(nextSource.height()));
+    wl_display_flush(client.display);
+    QTRY_COMPARE(surfacePrivate->pending.sourceGeometry, nextSource);
+
+    fence->signal();
+    QTRY_COMPARE(waylandSurface->sourceGeometry(), sourceGeometry);
+    QCOMPARE(waylandSurface->bufferSize(), bufferSize);
+    QCOMPARE(client.error, 0);
+
+    wp_viewport_destroy(viewport);
+    wl_surface_destroy(surface);
+}
+
 class IdleInhibitCompositor : public TestCompositor
 {
     Q_OBJECT
@@ -1731,6 +2687,241 @@ void tst_WaylandCompositor::idleInhibit()
     QTRY_COMPARE(changedSpy.size(), 1);
 }
 
+class FractionalScaleCompositor : public TestCompositor
+{
+    Q_OBJECT
+public:
+    FractionalScaleCompositor() : viewporter(this), fractionalScaleManager(this) {}
+    QWaylandViewporter viewporter;
+    QWaylandFractionalScaleManagerV1 fractionalScaleManager;
+};
+
+struct PreferredScale
+{
+    uint scale = 0;
+    int count = 0;
+};
+
+static const wp_fractional_scale_v1_listener preferredScaleListener = {
+    [](void *data, wp_fractional_scale_v1 *, uint32_t scale) {
+        auto *preferredScale = static_cast<PreferredScale *>(data);
+        preferredScale->scale = scale;
+        ++preferredScale->count;
+    }
+};
+
+void tst_WaylandCompositor::fractionalScale_data()
+{
+    QTest::addColumn<qreal>("scale");
+
+    QTest::newRow("1.25") << 1.25;
+    QTest::newRow("1.5") << 1.5;
+    QTest::newRow("1.75") << 1.75;
+}
+
+void tst_WaylandCompositor::fractionalScale()
+{
+    QFETCH(qreal, scale);
+
+    FractionalScaleCompositor compositor;
+    compositor.create();
+    QWaylandOutput *output = compositor.defaultOutput();
+    output->setScaleFactor(qCeil(scale));
+    output->setFractionalScaleFactor(scale);
+    QCOMPARE(output->fractionalScaleFactor(), scale);
+
+    MockClient client;
+    QTRY_VERIFY(client.fractionalScaleManager);
+    QTRY_VERIFY(client.viewporter);
+
+    wl_surface *surface = client.createSurface();
+    QTRY_COMPARE(compositor.surfaces.size(), 1);
+    QWaylandSurface *waylandSurface = compositor.surfaces.at(0);
+
+    PreferredScale preferredScale;
+    auto *fractionalScale = wp_fractional_scale_manager_v1_get_fractional_scale(client.fractionalScaleManager, surface);
+    wp_fractional_scale_v1_add_listener(fractionalScale, &preferredScaleListener, &preferredScale);
+
+    // The scale is sent in 120ths
+    QTRY_COMPARE(preferredScale.count, 1);
+    QCOMPARE(preferredScale.scale, uint(qRound(scale * 120)));
+
+    // A client renders at the fractional scale and uses the viewport to get the surface size
+    const QSize surfaceSize(100, 50);
+    const QSize bufferSize = surfaceSize * scale;
+    ShmBuffer buffer(bufferSize, client.shm);
+    wp_viewport *viewport = wp_viewporter_get_viewport(client.viewporter, surface);
+    wp_viewport_set_destination(viewport, surfaceSize.width(), surfaceSize.height());
+    wl_surface_attach(surface, buffer.handle, 0, 0);
+    wl_surface_damage_buffer(surface, 0, 0, bufferSize.width(), bufferSize.height());
+    wl_surface_commit(surface);
+
+    QTRY_COMPARE(waylandSurface->destinationSize(), surfaceSize);
+    QCOMPARE(waylandSurface->bufferSize(), bufferSize);
+    QCOMPARE(waylandSurface->bufferScale(), 1);
+    QCOMPARE(client.error, 0);
+
+    wp_viewport_destroy(viewport);
+    wp_fractional_scale_v1_destroy(fractionalScale);
+    wl_surface_destroy(surface);
+}
+
+void tst_WaylandCompositor::fractionalScaleFollowsOutput()
+{
+    FractionalScaleCompositor compositor;
+    compositor.create();
+    QWaylandOutput *output = compositor.defaultOutput();
+    QSignalSpy scaleSpy(output, &QWaylandOutput::fractionalScaleFactorChanged);
+
+    MockClient client;
+    QTRY_VERIFY(client.fractionalScaleManager);
+
+    wl_surface *surface = client.createSurface();
+    QTRY_COMPARE(compositor.surfaces.size(), 1);
+
+    PreferredScale preferredScale;
+    auto *fractionalScale = wp_fractional_scale_manager_v1_get_fractional_scale(client.fractionalScaleManager, surface);
+    wp_fractional_scale_v1_add_listener(fractionalScale, &preferredScaleListener, &preferredScale);
+    QTRY_COMPARE(preferredScale.count, 1);
+    QCOMPARE(preferredScale.scale, 120u);
+
+    output->setFractionalScaleFactor(1.5);
+    QCOMPARE(scaleSpy.size(), 1);
+    QTRY_COMPARE(preferredScale.count, 2);
+    QCOMPARE(preferredScale.scale, 180u);
+
+    // Setting the same effective scale again sends nothing
+    output->setFractionalScaleFactor(1.5);
+    QCOMPARE(scaleSpy.size(), 1);
+
+    // Unsetting it makes it follow the integer scale factor
+    output->setScaleFactor(2);
+    QCOMPARE(scaleSpy.size(), 1);
+    output->setFractionalScaleFactor(0);
+    QCOMPARE(scaleSpy.size(), 2);
+    QCOMPARE(output->fractionalScaleFactor(), 2.0);
+    QTRY_COMPARE(preferredScale.count, 3);
+    QCOMPARE(preferredScale.scale, 240u);
+
+    output->setScaleFactor(3);
+    QCOMPARE(scaleSpy.size(), 3);
+    QTRY_COMPARE(preferredScale.count, 4);
+    QCOMPARE(preferredScale.scale, 360u);
+
+    // Only one fractional scale object per surface is allowed
+    wp_fractional_scale_manager_v1_get_fractional_scale(client.fractionalScaleManager, surface);
+    QTRY_COMPARE(client.error, EPROTO);
+    QCOMPARE(client.protocolError.interface, &wp_fractional_scale_manager_v1_interface);
+    QCOMPARE(static_cast<wp_fractional_scale_manager_v1_error>(client.protocolError.code),
+             WP_FRACTIONAL_SCALE_MANAGER_V1_ERROR_FRACTIONAL_SCALE_EXISTS);
+}
+
+class ScreencopyCompositor : public TestCompositor
+{
+    Q_OBJECT
+public:
+    ScreencopyCompositor() : screencopyManager(this) {}
+    QWaylandScreencopyManagerV1 screencopyManager;
+};
+
+struct ScreencopyFrame
+{
+    QSize bufferSize;
+    QRegion damage;
+    bool bufferDone = false;
+    bool ready = false;
+    bool failed = false;
+};
+
+static const zwlr_screencopy_frame_v1_listener screencopyFrameListener = {
+    [](void *data, zwlr_screencopy_frame_v1 *, uint32_t, uint32_t width, uint32_t height, uint32_t) {
+        static_cast<ScreencopyFrame *>(data)->bufferSize = QSize(width, height);
+    },
+    [](void *, zwlr_screencopy_frame_v1 *, uint32_t) {},
+    [](void *data, zwlr_screencopy_frame_v1 *, uint32_t, uint32_t, uint32_t) {
+        static_cast<ScreencopyFrame *>(data)->ready = true;
+    },
+    [](void *data, zwlr_screencopy_frame_v1 *) {
+        static_cast<ScreencopyFrame *>(data)->failed = true;
+    },
+    [](void *data, zwlr_screencopy_frame_v1 *, uint32_t x, uint32_t y, uint32_t width, uint32_t height) {
+        static_cast<ScreencopyFrame *>(data)->damage += QRect(x, y, width, height);
+    },
+    [](void *, zwlr_screencopy_frame_v1 *, uint32_t, uint32_t, uint32_t) {},
+    [](void *data, zwlr_screencopy_frame_v1 *) {
+        static_cast<ScreencopyFrame *>(data)->bufferDone = true;
+    }
+};
+
+void tst_WaylandCompositor::screencopy()
+{
+    ScreencopyCompositor compositor;
+    compositor.create();
+    QWaylandOutput *output = compositor.defaultOutput();
+    const QWaylandOutputMode mode(QSize(128, 64), 60000);
+    output->addMode(mode, true);
+    output->setCurrentMode(mode);
+    QSignalSpy captureSpy(&compositor.screencopyManager, &QWaylandScreencopyManagerV1::captureRequested);
+
+    MockClient client;
+    QTRY_VERIFY(client.screencopyManager);
+    wl_output *clientOutput = client.m_outputs.first();
+
+    ScreencopyFrame first;
+    auto *frame = zwlr_screencopy_manager_v1_capture_output(client.screencopyManager, 0, clientOutput);
+    zwlr_screencopy_frame_v1_add_listener(frame, &screencopyFrameListener, &first);
+    QTRY_VERIFY(first.bufferDone);
+    QCOMPARE(first.bufferSize, mode.size());
+
+    // Nothing is captured until a client has a buffer to copy into
+    QCOMPARE(captureSpy.size(), 0);
+    ShmBuffer buffer(mode.size(), client.shm);
+    buffer.image.fill(Qt::black);
+    zwlr_screencopy_frame_v1_copy(frame, buffer.handle);
+    QTRY_COMPARE(captureSpy.size(), 1);
+    QCOMPARE(captureSpy.at(0).at(0).value<QWaylandOutput *>(), output);
+    QVERIFY(compositor.screencopyManager.hasPendingCaptures(output));
+
+    QImage contents(mode.size(), QImage::Format_RGB32);
+    contents.fill(Qt::red);
+    compositor.screencopyManager.submitFrame(output, contents);
+    QVERIFY(!compositor.screencopyManager.hasPendingCaptures(output));
+    QTRY_VERIFY(first.ready);
+    QVERIFY(!first.failed);
+    QCOMPARE(buffer.image.pixel(10, 10) & 0xffffff, QColor(Qt::red).rgb() & 0xffffff);
+    zwlr_screencopy_frame_v1_destroy(frame);
+
+    // Copying with damage waits until something changed
+    ScreencopyFrame second;
+    frame = zwlr_screencopy_manager_v1_capture_output(client.screencopyManager, 0, clientOutput);
+    zwlr_screencopy_frame_v1_add_listener(frame, &screencopyFrameListener, &second);
+    QTRY_VERIFY(second.bufferDone);
+    zwlr_screencopy_frame_v1_copy_with_damage(frame, buffer.handle);
+    QTRY_COMPARE(captureSpy.size(), 2);
+    compositor.screencopyManager.submitFrame(output, contents);
+    QTRY_COMPARE(captureSpy.size(), 3);
+    QVERIFY(!second.ready);
+
+    QPainter painter(&contents);
+    painter.fillRect(QRect(100, 10, 8, 8), Qt::blue);
+    painter.end();
+    compositor.screencopyManager.submitFrame(output, contents);
+    QTRY_VERIFY(second.ready);
+    QVERIFY(second.damage.contains(QRect(100, 10, 8, 8)));
+    QVERIFY(!second.damage.contains(QPoint(10, 10)));
+    QCOMPARE(buffer.image.pixel(104, 14) & 0xffffff, QColor(Qt::blue).rgb() & 0xffffff);
+    zwlr_screencopy_frame_v1_destroy(frame);
+
+    // A buffer of the wrong size is a protocol error
+    ShmBuffer smallBuffer(QSize(16, 16), client.shm);
+    frame = zwlr_screencopy_manager_v1_capture_output(client.screencopyManager, 0, clientOutput);
+    zwlr_screencopy_frame_v1_copy(frame, smallBuffer.handle);
+    QTRY_COMPARE(client.error, EPROTO);
+    QCOMPARE(client.protocolError.interface, &zwlr_screencopy_frame_v1_interface);
+    QCOMPARE(static_cast<zwlr_screencopy_frame_v1_error>(client.protocolError.code),
+             ZWLR_SCREENCOPY_FRAME_V1_ERROR_INVALID_BUFFER);
+}
+
 class XdgOutputCompositor : public TestCompositor
 {
     Q_OBJECT
@@ -1794,5 +2985,342 @@ void tst_WaylandCompositor::xdgOutput()
     QTRY_COMPARE(xdgOutput->logicalSize, QSize(1000, 1000));
 }
 
+class QtTextInputMethodCompositor : public TestCompositor
+{
+    Q_OBJECT
+public:
+    QtTextInputMethodCompositor() : textInputMethodManager(this) {}
+    QWaylandQtTextInputMethodManager textInputMethodManager;
+};
+
+void tst_WaylandCompositor::qtTextInputMethodUpdates()
+{
+    QtTextInputMethodCompositor compositor;
+    compositor.create();
+    MockClient client;
+    QTRY_VERIFY(client.textInputMethodManager);
+    QTRY_COMPARE(client.m_seats.size(), 1);
+
+    client.createSurface();
+    QTRY_COMPARE(compositor.surfaces.size(), 1);
+    QWaylandSurface *waylandSurface = compositor.surfaces.at(0);
+
+    auto *textInputMethod = qt_text_input_method_manager_v1_get_text_input_method(
+            client.textInputMethodManager, client.m_seats.at(0)->m_seat);
+    QVERIFY(textInputMethod);
+
+    // The public class is not exported, reach it through the seat
+    QWaylandSeat *seat = compositor.defaultSeat();
+    auto findTextInputMethod = [seat]() -> QWaylandCompositorExtension * {
+        const auto extensions = seat->extensions();
+        for (QWaylandCompositorExtension *extension : extensions) {
+            if (qstrcmp(extension->extensionInterface()->name, "qt_text_input_method_v1") == 0)
+                return extension;
+        }
+        return nullptr;
+    };
+    QTRY_VERIFY(findTextInputMethod());
+    QWaylandCompositorExtension *extension = findTextInputMethod();
+    auto *d = static_cast<QWaylandQtTextInputMethodPrivate *>(QWaylandCompositorExtensionPrivate::get(extension));
+    QSignalSpy updateSpy(extension, SIGNAL(updateInputMethod(Qt::InputMethodQueries)));
+
+    auto sendUpdate = [&](Qt::InputMethodQueries queries, const QString &text, int cursorPosition) {
+        qt_text_input_method_v1_start_update(textInputMethod, int(queries));
+        if (queries & Qt::ImHints)
+            qt_text_input_method_v1_update_hints(textInputMethod, 0);
+        if (queries & Qt::ImSurroundingText)
+            qt_text_input_method_v1_update_surrounding_text(textInputMethod, text.toUtf8().constData(), 0);
+        if (queries & Qt::ImCursorPosition)
+            qt_text_input_method_v1_update_cursor_position(textInputMethod, cursorPosition);
+        qt_text_input_method_v1_end_update(textInputMethod);
+        wl_display_flush(client.display);
+    };
+    auto lastQueries = [&updateSpy]() {
+        return updateSpy.last().at(0).value<Qt::InputMethodQueries>();
+    };
+    const Qt::InputMethodQueries textQueries = Qt::ImHints | Qt::ImSurroundingText | Qt::ImCursorPosition;
+
+    // Everything is passed on after a focus change, even values that match
+    // the defaults, because the input method still has the previous ones
+    d->setFocus(waylandSurface);
+    sendUpdate(textQueries, QString(), 0);
+    QTRY_COMPARE(updateSpy.size(), 1);
+    QCOMPARE(lastQueries(), textQueries);
+
+    // Only the values that changed are passed on
+    sendUpdate(textQueries, QStringLiteral("abc"), 0);
+    QTRY_COMPARE(updateSpy.size(), 2);
+    QCOMPARE(lastQueries(), Qt::InputMethodQueries(Qt::ImSurroundingText));
+
+    // An update without changes is dropped, the next one is passed on
+    sendUpdate(textQueries, QStringLiteral("abc"), 0);
+    sendUpdate(textQueries, QStringLiteral("abc"), 2);
+    QTRY_COMPARE(updateSpy.size(), 3);
+    QCOMPARE(lastQueries(), Qt::InputMethodQueries(Qt::ImCursorPosition));
+
+    // Properties that are not tracked are always passed on
+    sendUpdate(Qt::ImHints | Qt::ImPlatformData, QString(), 0);
+    QTRY_COMPARE(updateSpy.size(), 4);
+    QCOMPARE(lastQueries(), Qt::InputMethodQueries(Qt::ImPlatformData));
+
+    // Moving the focus away and back resets the values, all of them are
+    // passed on again
+    d->setFocus(nullptr);
+    d->setFocus(waylandSurface);
+    sendUpdate(textQueries, QStringLiteral("abc"), 2);
+    QTRY_COMPARE(updateSpy.size(), 5);
+    QCOMPARE(lastQueries(), textQueries);
+
+    qt_text_input_method_v1_destroy(textInputMethod);
+}
+
+void tst_WaylandCompositor::textureSharingCacheEviction()
+{
+    QtWayland::TextureSharingCache cache;
+    QSet<QString> inUse;
+    auto isEvictable = [&inUse](const QString &key) { return !inUse.contains(key); };
+
+    cache.insert(QStringLiteral("a"), 100);
+    cache.insert(QStringLiteral("b"), 100);
+    cache.insert(QStringLiteral("c"), 100);
+    cache.insert(QStringLiteral("d"), 100);
+    QCOMPARE(cache.memoryUsage(), qint64(400));
+
+    // Without a budget nothing is ever evicted
+    QVERIFY(!cache.isOverBudget());
+    QVERIFY(cache.keysToEvict(isEvictable).isEmpty());
+
+    // Least recently used first, and only as many as needed
+    cache.touch(QStringLiteral("a"));
+    QVERIFY(cache.setMemoryBudget(250));
+    QVERIFY(cache.isOverBudget());
+    QCOMPARE(cache.keysToEvict(isEvictable), (QStringList{ QStringLiteral("b"), QStringLiteral("c") }));
+
+    // Buffers in use are skipped
+    inUse.insert(QStringLiteral("b"));
+    QCOMPARE(cache.keysToEvict(isEvictable), (QStringList{ QStringLiteral("c"), QStringLiteral("d") }));
+
+    cache.evict(QStringLiteral("c"));
+    cache.evict(QStringLiteral("d"));
+    QCOMPARE(cache.memoryUsage(), qint64(200));
+    QVERIFY(!cache.isOverBudget());
+    QVERIFY(!cache.contains(QStringLiteral("c")));
+    QVERIFY(cache.keysToEvict(isEvictable).isEmpty());
+
+    // Nothing left to evict: the caller has to report the budget as exceeded
+    QVERIFY(cache.setMemoryBudget(50));
+    QCOMPARE(cache.keysToEvict(isEvictable), QStringList{ QStringLiteral("a") });
+    cache.evict(QStringLiteral("a"));
+    QVERIFY(cache.keysToEvict(isEvictable).isEmpty());
+    QVERIFY(cache.isOverBudget());
+}
+
+void tst_WaylandCompositor::textureSharingCacheProtectedKey()
+{
+    QtWayland::TextureSharingCache cache;
+    auto isEvictable = [](const QString &) { return true; };
+
+    cache.setMemoryBudget(150);
+    cache.insert(QStringLiteral("old"), 100);
+    cache.insert(QStringLiteral("new"), 100);
+
+    // The buffer that was just created is never evicted to make room for itself
+    QCOMPARE(cache.keysToEvict(isEvictable, QStringLiteral("new")), QStringList{ QStringLiteral("old") });
+    cache.touch(QStringLiteral("old"));
+    QCOMPARE(cache.keysToEvict(isEvictable, QStringLiteral("new")), QStringList{ QStringLiteral("old") });
+    QCOMPARE(cache.keysToEvict(isEvictable), QStringList{ QStringLiteral("new") });
+    QCOMPARE(cache.keysToEvict(isEvictable, QStringLiteral("old")), QStringList{ QStringLiteral("new") });
+
+    cache.setMemoryBudget(50);
+    QCOMPARE(cache.keysToEvict(isEvictable, QStringLiteral("new")), QStringList{ QStringLiteral("old") });
+}
+
+void tst_WaylandCompositor::textureSharingCacheBudget_data()
+{
+    QTest::addColumn<QByteArray>("value");
+    QTest::addColumn<bool>("valid");
+    QTest::addColumn<qint64>("budget");
+
+    QTest::newRow("zero") << QByteArray("0") << true << qint64(0);
+    QTest::newRow("bytes") << QByteArray("1048576") << true << qint64(1048576);
+    QTest::newRow("large") << QByteArray("8589934592") << true << qint64(8589934592);
+    QTest::newRow("whitespace") << QByteArray(" 4096 ") << true << qint64(4096);
+    QTest::newRow("negative") << QByteArray("-1") << false << qint64(0);
+    QTest::newRow("suffix") << QByteArray("64M") << false << qint64(0);
+    QTest::newRow("text") << QByteArray("unlimited") << false << qint64(0);
+    QTest::newRow("empty") << QByteArray() << false << qint64(0);
+}
+
+void tst_WaylandCompositor::textureSharingCacheBudget()
+{
+    QFETCH(QByteArray, value);
+    QFETCH(bool, valid);
+    QFETCH(qint64, budget);
+
+    qint64 parsed = -1;
+    QCOMPARE(QtWayland::TextureSharingCache::parseMemoryBudget(value, &parsed), valid);
+    if (valid)
+        QCOMPARE(parsed, budget);
+    else
+        QCOMPARE(parsed, qint64(-1));
+
+    QtWayland::TextureSharingCache cache;
+    QVERIFY(!cache.setMemoryBudget(-100));
+    QCOMPARE(cache.memoryBudget(), qint64(0));
+    QVERIFY(cache.setMemoryBudget(100));
+    QVERIFY(!cache.setMemoryBudget(100));
+    QCOMPARE(cache.memoryBudget(), qint64(100));
+}
+
+void tst_WaylandCompositor::textureSharingCacheStatistics()
+{
+    QtWayland::TextureSharingCache cache;
+    auto isEvictable = [](const QString &) { return true; };
+
+    cache.recordMisses();
+    cache.insert(QStringLiteral("a"), 10);
+    cache.recordMisses(3);
+    cache.insert(QStringLiteral("atlas-1"), 30);
+    cache.touch(QStringLiteral("a"));
+    cache.touch(QStringLiteral("a"));
+    cache.touch(QStringLiteral("atlas-1"));
+    cache.touch(QStringLiteral("unknown"));
+
+    auto stats = cache.statistics();
+    QCOMPARE(stats.entryCount, 2);
+    QCOMPARE(stats.memoryUsage, qint64(40));
+    QCOMPARE(stats.memoryBudget, qint64(0));
+    QCOMPARE(stats.hits, quint64(3));
+    QCOMPARE(stats.misses, quint64(4));
+    QCOMPARE(stats.evictions, quint64(0));
+
+    // Replacing an entry only accounts for the difference
+    cache.insert(QStringLiteral("a"), 20);
+    QCOMPARE(cache.memoryUsage(), qint64(50));
+
+    cache.setMemoryBudget(30);
+    const QStringList evict = cache.keysToEvict(isEvictable);
+    QCOMPARE(evict, QStringList{ QStringLiteral("atlas-1") });
+    for (const QString &key : evict)
+        cache.evict(key);
+    cache.evict(QStringLiteral("unknown"));
+
+    stats = cache.statistics();
+    QCOMPARE(stats.entryCount, 1);
+    QCOMPARE(stats.memoryUsage, qint64(20));
+    QCOMPARE(stats.memoryBudget, qint64(30));
+    QCOMPARE(stats.evictions, quint64(1));
+}
+
+static QImage atlasTestImage(const QSize &size, QRgb color)
+{
+    QImage image(size, QImage::Format_RGBA8888_Premultiplied);
+    image.fill(color);
+    return image;
+}
+
+void tst_WaylandCompositor::textureAtlasPacking()
+{
+    using QtWayland::TextureAtlasPacker;
+    const int atlasSize = 64;
+    const int g = TextureAtlasPacker::Gutter;
+
+    QList<QPair<QString, QImage>> images;
+    for (int i = 0; i < 40; ++i) {
+        const QSize size(4 + (i * 7) % 13, 3 + (i * 5) % 11);
+        images.append(qMakePair(QStringLiteral("image%1").arg(i), atlasTestImage(size, qRgba(i, 0, 0, 255))));
+    }
+    images.append(qMakePair(QStringLiteral("tooWide"), atlasTestImage(QSize(atlasSize - 2 * g + 1, 4), qRgba(0, 0, 0, 255))));
+    images.append(qMakePair(QStringLiteral("empty"), QImage()));
+    images.append(qMakePair(QStringLiteral("largest"), atlasTestImage(QSize(atlasSize - 2 * g, atlasSize - 2 * g), qRgba(0, 0, 0, 255))));
+
+    QStringList rejected;
+    const QList<TextureAtlasPacker::Atlas> atlases = TextureAtlasPacker::pack(images, atlasSize, &rejected);
+    QCOMPARE(rejected, (QStringList{ QStringLiteral("tooWide"), QStringLiteral("empty") }));
+    QVERIFY(atlases.size() >= 2);
+
+    QStringList packedKeys;
+    for (const auto &atlas : atlases) {
+        QVERIFY(!atlas.regions.isEmpty());
+        QVERIFY(atlas.image.width() <= atlasSize);
+        QVERIFY(atlas.image.height() <= atlasSize);
+        const QRect bounds(QPoint(0, 0), atlas.image.size());
+        for (qsizetype i = 0; i < atlas.regions.size(); ++i) {
+            const QRect withGutter = atlas.regions.at(i).second.adjusted(-g, -g, g, g);
+            QVERIFY(bounds.contains(withGutter));
+            for (qsizetype j = i + 1; j < atlas.regions.size(); ++j)
+                QVERIFY(!withGutter.intersects(atlas.regions.at(j).second.adjusted(-g, -g, g, g)));
+            packedKeys.append(atlas.regions.at(i).first);
+        }
+    }
+
+    // Every image is packed exactly once, the tallest first
+    QCOMPARE(packedKeys.size(), images.size() - rejected.size());
+    QCOMPARE(QSet<QString>(packedKeys.cbegin(), packedKeys.cend()).size(), packedKeys.size());
+    QCOMPARE(packedKeys.first(), QStringLiteral("largest"));
+    QCOMPARE(atlases.first().regions.size(), 1);
+
+    QVERIFY(TextureAtlasPacker::pack({}, atlasSize).isEmpty());
+}
+
+// The rectangles sent in provide_buffer_region are where the pixels of each
+// image are in the atlas
+void tst_WaylandCompositor::textureAtlasRegions()
+{
+    using QtWayland::TextureAtlasPacker;
+
+    const QList<QPair<QString, QImage>> images = {
+        { QStringLiteral("red"), atlasTestImage(QSize(10, 6), qRgba(255, 0, 0, 255)) },
+        { QStringLiteral("green"), atlasTestImage(QSize(5, 8), qRgba(0, 255, 0, 255)) },
+        { QStringLiteral("blue"), atlasTestImage(QSize(7, 7), qRgba(0, 0, 255, 255)) },
+        { QStringLiteral("translucent"), atlasTestImage(QSize(3, 2), qRgba(0, 0, 64, 128)) },
+    };
+
+    const QList<TextureAtlasPacker::Atlas> atlases = TextureAtlasPacker::pack(images, 1024);
+    QCOMPARE(atlases.size(), 1);
+    const TextureAtlasPacker::Atlas &atlas = atlases.first();
+    QCOMPARE(atlas.regions.size(), images.size());
+
+    for (const auto &region : atlas.regions) {
+        const auto image = std::find_if(images.cbegin(), images.cend(), [&region](const auto &image) {
+            return image.first == region.first;
+        });
+        QVERIFY(image != images.cend());
+        QCOMPARE(region.second.size(), image->second.size());
+        QCOMPARE(atlas.image.copy(region.second), image->second);
+    }
+}
+
+void tst_WaylandCompositor::textureAtlasGutter()
+{
+    using QtWayland::TextureAtlasPacker;
+    const int g = TextureAtlasPacker::Gutter;
+
+    QImage image(4, 3, QImage::Format_RGBA8888_Premultiplied);
+    for (int y = 0; y < image.height(); ++y) {
+        for (int x = 0; x < image.width(); ++x)
+            image.setPixel(x, y, qRgba(x * 60, y * 100, 10, 255));
+    }
+    const QImage other = atlasTestImage(QSize(4, 3), qRgba(0, 0, 0, 0));
+
+    const auto atlases = TextureAtlasPacker::pack({ { QStringLiteral("image"), image },
+                                                    { QStringLiteral("other"), other } }, 1024);
+    QCOMPARE(atlases.size(), 1);
+    const auto &atlas = atlases.first();
+    const QRect rect = atlas.regions.first().first == QStringLiteral("image")
+            ? atlas.regions.at(0).second : atlas.regions.at(1).second;
+
+    // The gutter repeats the edge pixels of the image, not its neighbours or
+    // transparency, so that filtering at the edges of the region stays within
+    // the image
+    for (int y = -g; y < rect.height() + g; ++y) {
+        for (int x = -g; x < rect.width() + g; ++x) {
+            const int sx = qBound(0, x, rect.width() - 1);
+            const int sy = qBound(0, y, rect.height() - 1);
+            QCOMPARE(atlas.image.pixel(rect.x() + x, rect.y() + y), image.pixel(sx, sy));
+        }
+    }
+}
+
 #include <tst_compositor.moc>
 QTEST_MAIN(tst_WaylandCompositor);
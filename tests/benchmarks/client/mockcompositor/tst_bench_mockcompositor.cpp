@@ -0,0 +1,389 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#include "mockcompositor.h"
+#include "benchmarkhelpers.h"
+
+#include <QtCore/QTimer>
+#include <QtGui/QClipboard>
+#include <QtGui/QPainter>
+#include <QtGui/QRasterWindow>
+#ifdef QT_QUICK_LIB
+#include <QtQuick/QQuickWindow>
+#endif
+
+#include <atomic>
+
+#include <sys/resource.h>
+
+using namespace MockCompositor;
+
+constexpr int dataDeviceVersion = 3;
+
+class BenchmarkCompositor : public DefaultCompositor
+{
+public:
+    explicit BenchmarkCompositor()
+    {
+        exec([this] {
+            m_config.autoConfigure = true;
+            add<DataDeviceManager>(dataDeviceVersion);
+        });
+    }
+    DataDevice *dataDevice() { return get<DataDeviceManager>()->deviceFor(get<Seat>()); }
+    void flush() { wl_display_flush_clients(m_display); }
+};
+
+class FillWindow : public QRasterWindow
+{
+public:
+    explicit FillWindow(const QSize &size) { resize(size); }
+    void paintEvent(QPaintEvent *event) override
+    {
+        QPainter p(this);
+        p.fillRect(event->rect(), (++m_paints % 2) ? Qt::red : Qt::blue);
+    }
+    void mouseMoveEvent(QMouseEvent *) override { m_lastMoveNs = m_timer ? m_timer->nsecsElapsed() : 0; }
+
+    int m_paints = 0;
+    const QElapsedTimer *m_timer = nullptr;
+    qint64 m_lastMoveNs = -1;
+};
+
+class tst_bench_mockcompositor : public QObject, private BenchmarkCompositor
+{
+    Q_OBJECT
+public:
+    tst_bench_mockcompositor() : m_report(QStringLiteral("tst_bench_mockcompositor")) {}
+
+private slots:
+    void initTestCase();
+    void cleanup() { QTRY_VERIFY2(isClean(), qPrintable(dirtyMessage())); }
+    void cleanupTestCase() { m_report.write(); }
+    void timeToFirstFrameRaster();
+#ifdef QT_QUICK_LIB
+    void timeToFirstFrameQuick();
+#endif
+    void shmFlushThroughput_data();
+    void shmFlushThroughput();
+    void frameCallbackLatency();
+    void inputDispatchLatency();
+    void inputDispatchWakeups();
+    void clipboardThroughput_data();
+    void clipboardThroughput();
+
+private:
+    template <typename WindowType>
+    void measureTimeToFirstFrame(QList<double> *samples);
+    void waitForFirstFrame(FillWindow &window, std::atomic<int> *commits);
+
+    BenchmarkReport m_report;
+};
+
+void tst_bench_mockcompositor::initTestCase()
+{
+#ifdef QT_QUICK_LIB
+    // Renders through QBackingStore, so the scene graph does not depend on EGL
+    QQuickWindow::setGraphicsApi(QSGRendererInterface::Software);
+#endif
+    QCOMPOSITOR_TRY_VERIFY(pointer());
+    QCOMPOSITOR_TRY_VERIFY(keyboard());
+    QCOMPOSITOR_TRY_VERIFY(dataDevice());
+}
+
+// Time from QWindow::show() until the compositor sees the first committed buffer
+template <typename WindowType>
+void tst_bench_mockcompositor::measureTimeToFirstFrame(QList<double> *samples)
+{
+    const int iterations = benchmarkIterations(20);
+    for (int i = 0; i < iterations; ++i) {
+        QElapsedTimer timer;
+        std::atomic<qint64> firstFrameNs{-1};
+        auto connection = exec([&] {
+            return QObject::connect(get<WlCompositor>(), &WlCompositor::surfaceCreated, [&](Surface *surface) {
+                QObject::connect(surface, &Surface::bufferCommitted, [&] {
+                    qint64 expected = -1;
+                    firstFrameNs.compare_exchange_strong(expected, timer.nsecsElapsed());
+                });
+            });
+        });
+
+        {
+            WindowType window;
+            window.resize(256, 256);
+            timer.start();
+            window.show();
+            QVERIFY(spinUntil([&] { return firstFrameNs >= 0; }));
+            *samples << firstFrameNs / 1000000.0;
+        }
+
+        exec([&] { QObject::disconnect(connection); });
+        QCOMPOSITOR_TRY_VERIFY(!surface());
+    }
+}
+
+void tst_bench_mockcompositor::timeToFirstFrameRaster()
+{
+    class Window : public QRasterWindow {
+    public:
+        void paintEvent(QPaintEvent *) override { QPainter(this).fillRect(QRect(QPoint(), size()), Qt::green); }
+    };
+    QList<double> samples;
+    measureTimeToFirstFrame<Window>(&samples);
+    if (QTest::currentTestFailed())
+        return;
+    m_report.addSamples(QStringLiteral("timeToFirstFrame"), QStringLiteral("QRasterWindow"),
+                        QStringLiteral("ms"), samples);
+}
+
+#ifdef QT_QUICK_LIB
+void tst_bench_mockcompositor::timeToFirstFrameQuick()
+{
+    QList<double> samples;
+    measureTimeToFirstFrame<QQuickWindow>(&samples);
+    if (QTest::currentTestFailed())
+        return;
+    m_report.addSamples(QStringLiteral("timeToFirstFrame"), QStringLiteral("QQuickWindow"),
+                        QStringLiteral("ms"), samples);
+}
+#endif
+
+void tst_bench_mockcompositor::waitForFirstFrame(FillWindow &window, std::atomic<int> *commits)
+{
+    window.show();
+    QCOMPOSITOR_TRY_VERIFY(xdgToplevel());
+    exec([&] {
+        QObject::connect(xdgToplevel()->surface(), &Surface::bufferCommitted, [commits] { ++*commits; });
+    });
+    QTRY_VERIFY(*commits >= 1 || exec([&] { return xdgToplevel()->surface()->m_committed.buffer != nullptr; }));
+    *commits = 0;
+}
+
+void tst_bench_mockcompositor::shmFlushThroughput_data()
+{
+    QTest::addColumn<int>("damageSize");
+    QTest::newRow("16x16") << 16;
+    QTest::newRow("64x64") << 64;
+    QTest::newRow("256x256") << 256;
+    QTest::newRow("1024x1024") << 1024;
+}
+
+// Repaints a damaged square per frame and measures how many frames (and bytes
+// of damage) the client gets to the compositor per second.
+void tst_bench_mockcompositor::shmFlushThroughput()
+{
+    QFETCH(int, damageSize);
+
+    std::atomic<int> commits{0};
+    FillWindow window(QSize(1024, 1024));
+    waitForFirstFrame(window, &commits);
+    if (QTest::currentTestFailed())
+        return;
+
+    const int frames = benchmarkIterations(20) * 5;
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < frames; ++i) {
+        window.update(QRect((i * 7) % (1024 - damageSize + 1), 0, damageSize, damageSize));
+        exec([&] {
+            xdgToplevel()->surface()->sendFrameCallbacks();
+            flush();
+        });
+        QVERIFY(spinUntil([&] { return commits > i; }));
+    }
+    const double seconds = timer.nsecsElapsed() / 1e9;
+
+    const QString tag = QString::fromLatin1(QTest::currentDataTag());
+    m_report.addValue(QStringLiteral("shmFlushFramesPerSecond"), tag, QStringLiteral("frames/s"), frames / seconds);
+    m_report.addValue(QStringLiteral("shmFlushDamageThroughput"), tag, QStringLiteral("MB/s"),
+                      double(damageSize) * damageSize * 4 * frames / seconds / (1024 * 1024));
+}
+
+// Time from the compositor sending wl_callback.done until the next buffer
+// commit of a window that has an update pending.
+void tst_bench_mockcompositor::frameCallbackLatency()
+{
+    std::atomic<int> commits{0};
+    FillWindow window(QSize(256, 256));
+    waitForFirstFrame(window, &commits);
+    if (QTest::currentTestFailed())
+        return;
+
+    QList<double> samples;
+    const int iterations = benchmarkIterations(20) * 5;
+    for (int i = 0; i < iterations; ++i) {
+        window.update();
+        xdgPingAndWaitForPong(); // Make sure the update is waiting for the frame callback
+        QElapsedTimer timer;
+        exec([&] {
+            timer.start();
+            xdgToplevel()->surface()->sendFrameCallbacks();
+            flush();
+        });
+        QVERIFY(spinUntil([&] { return commits > i; }));
+        samples << elapsedMs(timer);
+    }
+    m_report.addSamples(QStringLiteral("frameCallbackToCommitLatency"), QString(), QStringLiteral("ms"), samples);
+}
+
+// Time from wl_pointer.motion + wl_pointer.frame being sent until the
+// corresponding QMouseEvent reaches the window.
+void tst_bench_mockcompositor::inputDispatchLatency()
+{
+    std::atomic<int> commits{0};
+    FillWindow window(QSize(256, 256));
+    waitForFirstFrame(window, &commits);
+    if (QTest::currentTestFailed())
+        return;
+
+    QElapsedTimer timer;
+    timer.start();
+    window.m_timer = &timer;
+
+    exec([&] {
+        pointer()->sendEnter(xdgToplevel()->surface(), {1, 1});
+        pointer()->sendFrame(client());
+    });
+    xdgPingAndWaitForPong(); // Make sure the client has processed the enter event
+
+    QList<double> samples;
+    const int iterations = benchmarkIterations(20) * 10;
+    for (int i = 0; i < iterations; ++i) {
+        window.m_lastMoveNs = -1;
+        qint64 sentNs = 0;
+        exec([&] {
+            sentNs = timer.nsecsElapsed();
+            pointer()->sendMotion(client(), QPointF(2 + i % 200, 2 + i % 100));
+            pointer()->sendFrame(client());
+            flush();
+        });
+        QVERIFY(spinUntil([&] { return window.m_lastMoveNs >= 0; }));
+        samples << (window.m_lastMoveNs - sentNs) / 1000000.0;
+    }
+    m_report.addSamples(QStringLiteral("pointerMotionDispatchLatency"), QString(), QStringLiteral("ms"), samples);
+}
+
+// Like inputDispatchLatency, but the client blocks in its event dispatcher
+// until the event arrives, and the context switches of the whole process are
+// counted per event. Run with and without QT_WAYLAND_DISPATCHER_EVENT_READING=1
+// to compare reading events from the event dispatcher to the event thread.
+void tst_bench_mockcompositor::inputDispatchWakeups()
+{
+    std::atomic<int> commits{0};
+    FillWindow window(QSize(256, 256));
+    waitForFirstFrame(window, &commits);
+    if (QTest::currentTestFailed())
+        return;
+
+    QElapsedTimer timer;
+    timer.start();
+    window.m_timer = &timer;
+
+    exec([&] {
+        pointer()->sendEnter(xdgToplevel()->surface(), {1, 1});
+        pointer()->sendFrame(client());
+    });
+    xdgPingAndWaitForPong();
+
+    const QString tag = qEnvironmentVariableIntValue("QT_WAYLAND_DISPATCHER_EVENT_READING")
+            ? QStringLiteral("dispatcher") : QStringLiteral("eventThread");
+    const auto contextSwitches = [] {
+        rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_nvcsw + usage.ru_nivcsw;
+    };
+
+    QList<double> latencies;
+    QList<double> switches;
+    const int iterations = benchmarkIterations(20) * 10;
+    for (int i = 0; i < iterations; ++i) {
+        window.m_lastMoveNs = -1;
+        // Only there to wake up the dispatcher if the event never arrives
+        QTimer watchdog;
+        watchdog.start(5000);
+        QDeadlineTimer deadline(5000);
+
+        const long switchesBefore = contextSwitches();
+        qint64 sentNs = 0;
+        exec([&] {
+            sentNs = timer.nsecsElapsed();
+            pointer()->sendMotion(client(), QPointF(2 + i % 200, 2 + i % 100));
+            pointer()->sendFrame(client());
+            flush();
+        });
+        while (window.m_lastMoveNs < 0 && !deadline.hasExpired())
+            QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+        QVERIFY(window.m_lastMoveNs >= 0);
+
+        latencies << (window.m_lastMoveNs - sentNs) / 1000000.0;
+        switches << double(contextSwitches() - switchesBefore);
+    }
+    m_report.addSamples(QStringLiteral("blockingPointerMotionDispatchLatency"), tag, QStringLiteral("ms"), latencies);
+    m_report.addSamples(QStringLiteral("pointerMotionContextSwitches"), tag, QStringLiteral("switches"), switches);
+}
+
+void tst_bench_mockcompositor::clipboardThroughput_data()
+{
+    QTest::addColumn<int>("size");
+    QTest::newRow("64KiB") << 64 * 1024;
+    QTest::newRow("1MiB") << 1024 * 1024;
+    QTest::newRow("16MiB") << 16 * 1024 * 1024;
+}
+
+// Time to read a selection of the given size offered by the compositor
+void tst_bench_mockcompositor::clipboardThroughput()
+{
+    QFETCH(int, size);
+
+    std::atomic<int> commits{0};
+    FillWindow window(QSize(64, 64));
+    waitForFirstFrame(window, &commits);
+    if (QTest::currentTestFailed())
+        return;
+
+    exec([&] { keyboard()->sendEnter(xdgToplevel()->surface()); });
+
+    const QByteArray payload(size, 'x');
+    QList<double> samples;
+    const int iterations = benchmarkIterations(20) / 2 + 1;
+    for (int i = 0; i < iterations; ++i) {
+        // A new MIME type per offer, so we can tell when the client has seen it
+        const QString mimeType = QStringLiteral("application/x-qtwayland-benchmark-%1").arg(i);
+        exec([&] {
+            auto *offer = dataDevice()->sendDataOffer(client(), {mimeType});
+            QObject::connect(offer, &DataOffer::receive, [payload](QString, int fd) {
+                QFile file;
+                file.open(fd, QIODevice::WriteOnly, QFile::FileHandleFlag::AutoCloseHandle);
+                file.write(payload);
+                file.close();
+            });
+            dataDevice()->sendSelection(offer);
+        });
+        QTRY_VERIFY(QGuiApplication::clipboard()->mimeData()->hasFormat(mimeType));
+
+        QElapsedTimer timer;
+        timer.start();
+        const QByteArray data = QGuiApplication::clipboard()->mimeData()->data(mimeType);
+        const double ms = elapsedMs(timer);
+        QCOMPARE(data.size(), size);
+        samples << size / (1024.0 * 1024.0) / (ms / 1000.0);
+    }
+    m_report.addSamples(QStringLiteral("clipboardReadThroughput"), QString::fromLatin1(QTest::currentDataTag()),
+                        QStringLiteral("MB/s"), samples);
+}
+
+int main(int argc, char **argv)
+{
+    QTemporaryDir tmpRuntimeDir;
+    setenv("XDG_RUNTIME_DIR", tmpRuntimeDir.path().toLocal8Bit(), 1);
+    setenv("XDG_CURRENT_DESKTOP", "qtwaylandtests", 1);
+    setenv("QT_QPA_PLATFORM", "wayland", 1);
+    // Decorations would add extra commits and repaints to every measurement
+    setenv("QT_WAYLAND_DISABLE_WINDOWDECORATION", "1", 1);
+    tst_bench_mockcompositor tc;
+    QGuiApplication app(argc, argv);
+    QTEST_SET_MAIN_SOURCE_PATH
+    return QTest::qExec(&tc, argc, argv);
+}
+
+#include "tst_bench_mockcompositor.moc"
@@ -0,0 +1,293 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#include "mockclient.h"
+#include "mockseat.h"
+#include "testcompositor.h"
+#include "benchmarkhelpers.h"
+
+#include "qwaylandbufferref.h"
+#include "qwaylandseat.h"
+
+#include <QtWaylandCompositor/private/qwaylandcompositor_p.h>
+#include <QtWaylandCompositor/private/qwaylandsurface_p.h>
+#include <QtWaylandCompositor/private/qwlbuffermanager_p.h>
+
+#include <QtGui/QGuiApplication>
+#include <QtTest/QtTest>
+
+#include <wayland-server-core.h>
+
+#include <sys/resource.h>
+#include <time.h>
+
+// A client with a number of surfaces, each with an SHM buffer attached
+struct SyntheticClient
+{
+    explicit SyntheticClient(int surfaceCount)
+    {
+        for (int i = 0; i < surfaceCount; ++i) {
+            surfaces << client.createSurface();
+            buffers << new ShmBuffer(QSize(64, 64), client.shm);
+        }
+    }
+
+    ~SyntheticClient()
+    {
+        for (wl_surface *surface : std::as_const(surfaces))
+            wl_surface_destroy(surface);
+        qDeleteAll(buffers);
+        wl_display_flush(client.display);
+    }
+
+    void commitAll()
+    {
+        for (int i = 0; i < surfaces.size(); ++i) {
+            wl_surface_attach(surfaces[i], buffers[i]->handle, 0, 0);
+            wl_surface_damage(surfaces[i], 0, 0, 64, 64);
+            wl_callback_destroy(wl_surface_frame(surfaces[i]));
+            wl_surface_commit(surfaces[i]);
+        }
+        wl_display_flush(client.display);
+    }
+
+    MockClient client;
+    QList<wl_surface *> surfaces;
+    QList<ShmBuffer *> buffers;
+};
+
+static qint64 residentSetSize()
+{
+    QFile status(QStringLiteral("/proc/self/status"));
+    if (!status.open(QIODevice::ReadOnly))
+        return 0;
+    const QList<QByteArray> lines = status.readAll().split('\n');
+    for (const QByteArray &line : lines) {
+        if (line.startsWith("VmRSS:"))
+            return line.mid(6).trimmed().split(' ').first().toLongLong() * 1024;
+    }
+    return 0;
+}
+
+static double threadCpuMs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+class tst_bench_compositor : public QObject
+{
+    Q_OBJECT
+public:
+    tst_bench_compositor() : m_report(QStringLiteral("tst_bench_compositor")) {}
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase() { m_report.write(); }
+    void scaling_data();
+    void scaling();
+    void sustainedCommits_data();
+    void sustainedCommits();
+
+private:
+    void dispatchCompositor(TestCompositor &compositor);
+    bool createClients(TestCompositor &compositor, int clientCount, int surfacesPerClient,
+                       QList<SyntheticClient *> *clients);
+
+    BenchmarkReport m_report;
+};
+
+void tst_bench_compositor::initTestCase()
+{
+    // Every client uses a socket on both ends of the connection
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+// Runs the compositor side only, so that its cost can be timed separately from the clients
+void tst_bench_compositor::dispatchCompositor(TestCompositor &compositor)
+{
+    wl_event_loop_dispatch(wl_display_get_event_loop(compositor.display()), 0);
+    compositor.flushClients();
+}
+
+bool tst_bench_compositor::createClients(TestCompositor &compositor, int clientCount, int surfacesPerClient,
+                                         QList<SyntheticClient *> *clients)
+{
+    for (int i = 0; i < clientCount; ++i)
+        *clients << new SyntheticClient(surfacesPerClient);
+    return QTest::qWaitFor([&] { return compositor.surfaces.size() == clientCount * surfacesPerClient; }, 30000);
+}
+
+static void addClientCountRows()
+{
+    QTest::addColumn<int>("clientCount");
+    const int maxClients = qEnvironmentVariableIsSet("QT_WAYLAND_BENCHMARK_MAX_CLIENTS")
+            ? qMax(1, qEnvironmentVariableIntValue("QT_WAYLAND_BENCHMARK_MAX_CLIENTS")) : 1000;
+    for (int count = 1; count < maxClients; count *= 10)
+        QTest::addRow("%d clients", count) << count;
+    QTest::addRow("%d clients", maxClients) << maxClients;
+}
+
+void tst_bench_compositor::scaling_data()
+{
+    addClientCountRows();
+}
+
+// Measures the per-surface cost of commits, frame callbacks, buffer lookups,
+// memory and keyboard focus changes as the number of clients grows.
+void tst_bench_compositor::scaling()
+{
+    QFETCH(int, clientCount);
+    const int surfacesPerClient = qMax(1, qEnvironmentVariableIntValue("QT_WAYLAND_BENCHMARK_SURFACES_PER_CLIENT"));
+    const int surfaceCount = clientCount * surfacesPerClient;
+    const QString tag = QString::fromLatin1(QTest::currentDataTag());
+
+    TestCompositor compositor(true);
+    compositor.create();
+    QCoreApplication::processEvents();
+
+    // Memory: measured in-process, so this includes the client side of the connections
+    const qint64 rssBefore = residentSetSize();
+    QList<SyntheticClient *> clients;
+    QVERIFY(createClients(compositor, clientCount, surfacesPerClient, &clients));
+    const qint64 rssDelta = residentSetSize() - rssBefore;
+    m_report.addValue(QStringLiteral("memoryPerClient"), tag, QStringLiteral("KiB"), rssDelta / 1024.0 / clientCount);
+    m_report.addValue(QStringLiteral("memoryPerSurface"), tag, QStringLiteral("KiB"), rssDelta / 1024.0 / surfaceCount);
+
+    int redraws = 0;
+    for (QWaylandSurface *surface : std::as_const(compositor.surfaces))
+        connect(surface, &QWaylandSurface::redraw, this, [&redraws] { ++redraws; });
+
+    QList<double> commitSamples;
+    QList<double> frameCallbackSamples;
+    QList<double> bufferLookupSamples;
+    QList<double> focusSamples;
+
+    const int rounds = benchmarkIterations(10);
+    for (int round = 0; round < rounds; ++round) {
+        // Commit handling
+        redraws = 0;
+        for (SyntheticClient *client : std::as_const(clients))
+            client->commitAll();
+        QElapsedTimer timer;
+        timer.start();
+        QDeadlineTimer deadline(30000);
+        while (redraws < surfaceCount && !deadline.hasExpired())
+            dispatchCompositor(compositor);
+        QCOMPARE(redraws, surfaceCount);
+        commitSamples << timer.nsecsElapsed() / 1000.0 / surfaceCount;
+
+        // Frame callback dispatch
+        timer.start();
+        for (QWaylandSurface *surface : std::as_const(compositor.surfaces)) {
+            surface->frameStarted();
+            surface->sendFrameCallbacks();
+        }
+        compositor.flushClients();
+        frameCallbackSamples << timer.nsecsElapsed() / 1000.0 / surfaceCount;
+
+        // BufferManager lookups of the attached buffers
+        auto *bufferManager = QWaylandCompositorPrivate::get(&compositor)->bufferManager();
+        QList<wl_resource *> bufferResources;
+        for (QWaylandSurface *surface : std::as_const(compositor.surfaces))
+            bufferResources << QWaylandSurfacePrivate::get(surface)->bufferRef.wl_buffer();
+        timer.start();
+        for (wl_resource *resource : std::as_const(bufferResources))
+            QVERIFY(bufferManager->getBuffer(resource));
+        bufferLookupSamples << timer.nsecsElapsed() / 1000.0 / surfaceCount;
+
+        // Keyboard focus changes across all surfaces
+        QWaylandSeat *seat = compositor.defaultSeat();
+        timer.start();
+        for (QWaylandSurface *surface : std::as_const(compositor.surfaces))
+            seat->setKeyboardFocus(surface);
+        compositor.flushClients();
+        focusSamples << timer.nsecsElapsed() / 1000.0 / surfaceCount;
+
+        // Let the clients read their events, so their sockets don't fill up
+        QCoreApplication::processEvents();
+    }
+
+    m_report.addSamples(QStringLiteral("commitHandling"), tag, QStringLiteral("us/commit"), commitSamples);
+    m_report.addSamples(QStringLiteral("frameCallbackDispatch"), tag, QStringLiteral("us/surface"), frameCallbackSamples);
+    m_report.addSamples(QStringLiteral("bufferManagerLookup"), tag, QStringLiteral("us/lookup"), bufferLookupSamples);
+    m_report.addSamples(QStringLiteral("keyboardFocusChange"), tag, QStringLiteral("us/change"), focusSamples);
+
+    qDeleteAll(clients);
+    QTRY_VERIFY(compositor.surfaces.isEmpty());
+}
+
+void tst_bench_compositor::sustainedCommits_data()
+{
+    addClientCountRows();
+}
+
+// Every client commits all its surfaces at a fixed rate (QT_WAYLAND_BENCHMARK_COMMIT_RATE,
+// in Hz) while the compositor runs its normal event loop. The CPU time is that of the
+// whole process, since the clients run in the same thread.
+void tst_bench_compositor::sustainedCommits()
+{
+    QFETCH(int, clientCount);
+    const int surfacesPerClient = qMax(1, qEnvironmentVariableIntValue("QT_WAYLAND_BENCHMARK_SURFACES_PER_CLIENT"));
+    const int surfaceCount = clientCount * surfacesPerClient;
+    const int rate = qEnvironmentVariableIsSet("QT_WAYLAND_BENCHMARK_COMMIT_RATE")
+            ? qMax(1, qEnvironmentVariableIntValue("QT_WAYLAND_BENCHMARK_COMMIT_RATE")) : 60;
+    const int duration = 1000;
+    const QString tag = QStringLiteral("%1, %2 Hz").arg(QString::fromLatin1(QTest::currentDataTag())).arg(rate);
+
+    TestCompositor compositor(true);
+    compositor.create();
+
+    QList<SyntheticClient *> clients;
+    QVERIFY(createClients(compositor, clientCount, surfacesPerClient, &clients));
+
+    int redraws = 0;
+    for (QWaylandSurface *surface : std::as_const(compositor.surfaces))
+        connect(surface, &QWaylandSurface::redraw, this, [&redraws] { ++redraws; });
+
+    QTimer commitTimer;
+    commitTimer.setTimerType(Qt::PreciseTimer);
+    commitTimer.setInterval(1000 / rate);
+    connect(&commitTimer, &QTimer::timeout, this, [&] {
+        for (SyntheticClient *client : std::as_const(clients))
+            client->commitAll();
+    });
+
+    const double cpuBefore = threadCpuMs();
+    QElapsedTimer timer;
+    timer.start();
+    commitTimer.start();
+    QTest::qWait(duration);
+    commitTimer.stop();
+    const double seconds = timer.nsecsElapsed() / 1e9;
+    const double cpuMs = threadCpuMs() - cpuBefore;
+
+    QVERIFY(redraws > 0);
+    m_report.addValue(QStringLiteral("sustainedCommitsPerSecond"), tag, QStringLiteral("commits/s"), redraws / seconds);
+    m_report.addValue(QStringLiteral("sustainedCommitsTarget"), tag, QStringLiteral("commits/s"), double(rate) * surfaceCount);
+    m_report.addValue(QStringLiteral("sustainedCpuPerCommit"), tag, QStringLiteral("us/commit"), cpuMs * 1000.0 / redraws);
+    m_report.addValue(QStringLiteral("sustainedCpuLoad"), tag, QStringLiteral("%"), cpuMs / 10.0 / seconds);
+
+    qDeleteAll(clients);
+    QTRY_VERIFY(compositor.surfaces.isEmpty());
+}
+
+int main(int argc, char **argv)
+{
+    QTemporaryDir tmpRuntimeDir;
+    if (!qEnvironmentVariableIsSet("XDG_RUNTIME_DIR"))
+        qputenv("XDG_RUNTIME_DIR", tmpRuntimeDir.path().toLocal8Bit());
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QGuiApplication app(argc, argv);
+    tst_bench_compositor tc;
+    QTEST_SET_MAIN_SOURCE_PATH
+    return QTest::qExec(&tc, argc, argv);
+}
+
+#include "tst_bench_compositor.moc"
@@ -0,0 +1,112 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#ifndef BENCHMARKHELPERS_H
+#define BENCHMARKHELPERS_H
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDebug>
+#include <QtCore/QDeadlineTimer>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QList>
+#include <QtCore/QSysInfo>
+#include <QtCore/QTextStream>
+#include <QtCore/QThread>
+
+#include <algorithm>
+
+// Collects benchmark samples and writes them as JSON, so that results can be
+// compared across releases. The report is written to the file named by
+// QT_WAYLAND_BENCHMARK_JSON, or to stdout if that variable is not set.
+class BenchmarkReport
+{
+public:
+    explicit BenchmarkReport(const QString &suite) : m_suite(suite) {}
+
+    void addSamples(const QString &name, const QString &tag, const QString &unit, QList<double> samples)
+    {
+        if (samples.isEmpty())
+            return;
+
+        std::sort(samples.begin(), samples.end());
+        double sum = 0;
+        for (double sample : std::as_const(samples))
+            sum += sample;
+
+        QJsonObject result;
+        result[QLatin1String("name")] = name;
+        if (!tag.isEmpty())
+            result[QLatin1String("tag")] = tag;
+        result[QLatin1String("unit")] = unit;
+        result[QLatin1String("samples")] = samples.size();
+        result[QLatin1String("min")] = samples.first();
+        result[QLatin1String("max")] = samples.last();
+        result[QLatin1String("median")] = samples.at(samples.size() / 2);
+        result[QLatin1String("mean")] = sum / samples.size();
+        m_results.append(result);
+    }
+
+    void addValue(const QString &name, const QString &tag, const QString &unit, double value)
+    {
+        addSamples(name, tag, unit, { value });
+    }
+
+    void write() const
+    {
+        QJsonObject report;
+        report[QLatin1String("suite")] = m_suite;
+        report[QLatin1String("qtVersion")] = QLatin1String(qVersion());
+        report[QLatin1String("platform")] = QSysInfo::prettyProductName();
+        report[QLatin1String("cpu")] = QSysInfo::currentCpuArchitecture();
+        report[QLatin1String("results")] = m_results;
+
+        const QByteArray json = QJsonDocument(report).toJson();
+        const QString fileName = qEnvironmentVariable("QT_WAYLAND_BENCHMARK_JSON");
+        if (fileName.isEmpty()) {
+            QTextStream(stdout) << json;
+            return;
+        }
+
+        QFile file(fileName);
+        if (file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+            file.write(json);
+        else
+            qWarning() << "Could not write benchmark report to" << fileName << file.errorString();
+    }
+
+private:
+    QString m_suite;
+    QJsonArray m_results;
+};
+
+inline double elapsedMs(const QElapsedTimer &timer)
+{
+    return timer.nsecsElapsed() / 1000000.0;
+}
+
+inline int benchmarkIterations(int defaultIterations)
+{
+    const int iterations = qEnvironmentVariableIntValue("QT_WAYLAND_BENCHMARK_ITERATIONS");
+    return iterations > 0 ? iterations : defaultIterations;
+}
+
+// Like QTest::qWaitFor(), but busy-waits instead of sleeping between polls,
+// which would otherwise dominate the latencies being measured.
+template <typename Predicate>
+bool spinUntil(Predicate predicate, int timeout = 5000)
+{
+    QDeadlineTimer deadline(timeout);
+    while (!predicate()) {
+        if (deadline.hasExpired())
+            return false;
+        QCoreApplication::processEvents();
+        QThread::yieldCurrentThread();
+    }
+    return true;
+}
+
+#endif // BENCHMARKHELPERS_H
@@ -4,9 +4,11 @@ CONFIG += wayland-scanner
 WAYLANDCLIENTSOURCES += $$PWD/../../../../src/extensions/qt-texture-sharing-unstable-v1.xml
 
 SOURCES += main.cpp \
+    $$PWD/../../../../src/imports/texture-sharing/texturesharingbatches.cpp \
     $$PWD/../../../../src/imports/texture-sharing/texturesharingextension.cpp
 
 HEADERS += \
+    $$PWD/../../../../src/imports/texture-sharing/texturesharingbatches_p.h \
     $$PWD/../../../../src/imports/texture-sharing/texturesharingextension.h
 
 INCLUDEPATH += $$PWD/../../../../src/imports/texture-sharing/